@@ -0,0 +1,156 @@
+#!/usr/bin/awk -f
+#
+# blogc: A blog compiler.
+# Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+#
+# This program can be distributed under the terms of the BSD License.
+# See the file LICENSE.
+#
+# generates a perfect hash table for the mime types listed in
+# src/blogc-runserver/mime-types.txt, using the hash and displace method:
+# the extensions are split in buckets by hash(0, ext), and each bucket gets
+# the smallest seed that places all its extensions in free slots of the table
+# with hash(seed, ext). the hash function must match mime_hash() from
+# src/blogc-runserver/mime.c. only posix awk is used, and all the numbers fit
+# exactly in doubles.
+
+function fail(msg) {
+    print "gen-mime-table.awk: " msg > "/dev/stderr"
+    failed = 1
+    exit 1
+}
+
+function hash(seed, str,    h, m, i) {
+    h = seed
+    m = 16777619 + 2 * seed
+    for (i = 1; i <= length(str); i++)
+        h = (h * m + ord[substr(str, i, 1)]) % 16777216
+    return h
+}
+
+function c_string(str) {
+    if (str == "")
+        return "NULL"
+    return "\"" str "\""
+}
+
+BEGIN {
+    for (i = 1; i < 128; i++)
+        ord[sprintf("%c", i)] = i
+    n = 0
+    num_indexes = 0
+    max_len = 0
+}
+
+/^[ \t]*(#|$)/ {
+    next
+}
+
+{
+    if (NF < 2)
+        fail(FILENAME ":" FNR ": missing mime type")
+    ext = tolower($1)
+    if (ext !~ /^[a-z0-9_+-]+$/)
+        fail(FILENAME ":" FNR ": invalid extension: " $1)
+    if (ext in seen)
+        fail(FILENAME ":" FNR ": duplicated extension: " $1)
+    seen[ext] = 1
+    n++
+    exts[n] = ext
+    types[n] = $2
+    compress[n] = "false"
+    for (i = 3; i <= NF; i++) {
+        if ($i == "index")
+            indexes[++num_indexes] = "index." ext
+        else if ($i == "compress")
+            compress[n] = "true"
+        else
+            fail(FILENAME ":" FNR ": invalid flag: " $i)
+    }
+    if (length(ext) > max_len)
+        max_len = length(ext)
+}
+
+END {
+    if (failed)
+        exit 1
+    if (n == 0)
+        fail("no mime types found")
+
+    num_buckets = int((n + 1) / 2)
+    table_len = 2 * n + 1
+
+    for (b = 0; b < num_buckets; b++) {
+        bucket_len[b] = 0
+        seeds[b] = 0
+    }
+    for (i = 1; i <= n; i++) {
+        b = hash(0, exts[i]) % num_buckets
+        bucket[b, ++bucket_len[b]] = i
+    }
+    for (s = 0; s < table_len; s++)
+        slots[s] = 0
+
+    # biggest buckets first, while the table is still mostly empty.
+    for (b = 0; b < num_buckets; b++)
+        order[b] = b
+    for (i = 1; i < num_buckets; i++) {
+        b = order[i]
+        for (j = i - 1; j >= 0 && bucket_len[order[j]] < bucket_len[b]; j--)
+            order[j + 1] = order[j]
+        order[j + 1] = b
+    }
+
+    for (o = 0; o < num_buckets; o++) {
+        b = order[o]
+        if (bucket_len[b] == 0)
+            break
+        for (seed = 1; seed < 65536; seed++) {
+            ok = 1
+            for (i = 1; i <= bucket_len[b] && ok; i++) {
+                s = hash(seed, exts[bucket[b, i]]) % table_len
+                if (slots[s] != 0)
+                    ok = 0
+                for (j = 1; j < i && ok; j++)
+                    if (tried[j] == s)
+                        ok = 0
+                tried[i] = s
+            }
+            if (ok)
+                break
+        }
+        if (!ok)
+            fail("failed to find a seed for bucket " b)
+        seeds[b] = seed
+        for (i = 1; i <= bucket_len[b]; i++)
+            slots[tried[i]] = bucket[b, i]
+    }
+
+    print "/* generated by build-aux/gen-mime-table.awk, do not edit. */"
+    print ""
+    print "#define MIME_EXTENSION_MAX_LEN " max_len
+    print "#define MIME_SEEDS_LEN " num_buckets
+    print "#define MIME_TABLE_LEN " table_len
+    print ""
+    print "static const uint16_t mime_seeds[MIME_SEEDS_LEN] = {"
+    for (b = 0; b < num_buckets; b++)
+        print "    " seeds[b] ","
+    print "};"
+    print ""
+    print "static const struct mime_type mime_table[MIME_TABLE_LEN] = {"
+    for (s = 0; s < table_len; s++) {
+        i = slots[s]
+        if (i == 0)
+            print "    {NULL, NULL, false},"
+        else
+            print "    {" c_string(exts[i]) ", " c_string(types[i]) ", " \
+                compress[i] "},"
+    }
+    print "};"
+    print ""
+    print "static const char *mime_indexes[] = {"
+    for (i = 1; i <= num_indexes; i++)
+        print "    " c_string(indexes[i]) ","
+    print "    NULL,"
+    print "};"
+}
@@ -63,9 +63,9 @@ bm_atom_deploy(bm_settings_t *settings, bc_error_t **err)
         return NULL;
     }
 
-    const char *atom_prefix = bc_trie_lookup(settings->settings, "atom_prefix");
-    const char *atom_ext = bc_trie_lookup(settings->settings, "atom_ext");
-    const char *post_prefix = bc_trie_lookup(settings->settings, "post_prefix");
+    const char *atom_prefix = bc_hashmap_lookup(settings->settings, "atom_prefix");
+    const char *atom_ext = bc_hashmap_lookup(settings->settings, "atom_ext");
+    const char *post_prefix = bc_hashmap_lookup(settings->settings, "post_prefix");
 
     char *content = bc_strdup_printf(atom_template, atom_prefix, atom_ext,
         atom_prefix, atom_ext, post_prefix, post_prefix);
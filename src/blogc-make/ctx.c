@@ -9,6 +9,7 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <dirent.h>
+#include <fcntl.h>
 #include <libgen.h>
 #include <time.h>
 #include <stdlib.h>
@@ -17,9 +18,11 @@
 #include "../common/error.h"
 #include "../common/file.h"
 #include "../common/utils.h"
+#include "../blogc/loader.h"
 #include "atom.h"
 #include "settings.h"
 #include "exec.h"
+#include "manifest.h"
 #include "ctx.h"
 
 
@@ -150,6 +153,53 @@ bm_filectx_reload(bm_filectx_t *ctx)
 }
 
 
+// sets the mtime of the file to the mtime of the newest of the inputs, so it
+// isn't older than them anymore, but doesn't look newer than it really is.
+void
+bm_filectx_touch(bm_filectx_t *ctx, bc_slist_t *inputs)
+{
+    if (ctx == NULL || !ctx->readable)
+        return;
+
+    struct timespec times[2] = {
+        {.tv_sec = 0, .tv_nsec = UTIME_OMIT},
+        {.tv_sec = ctx->tv_sec, .tv_nsec = ctx->tv_nsec},
+    };
+    for (bc_slist_t *l = inputs; l != NULL; l = l->next) {
+        bm_filectx_t *fctx = l->data;
+        if (fctx == NULL || !fctx->readable)
+            continue;
+        if (fctx->tv_sec > times[1].tv_sec ||
+            (fctx->tv_sec == times[1].tv_sec &&
+             fctx->tv_nsec > times[1].tv_nsec))
+        {
+            times[1].tv_sec = fctx->tv_sec;
+            times[1].tv_nsec = fctx->tv_nsec;
+        }
+    }
+
+    if (0 == utimensat(AT_FDCWD, ctx->path, times, 0))
+        bm_filectx_reload(ctx);
+}
+
+
+bm_filectx_t*
+bm_filectx_dup(bm_filectx_t *fctx)
+{
+    if (fctx == NULL)
+        return NULL;
+
+    bm_filectx_t *rv = bc_malloc(sizeof(bm_filectx_t));
+    rv->path = bc_strdup(fctx->path);
+    rv->short_path = bc_strdup(fctx->short_path);
+    rv->slug = bc_strdup(fctx->slug);
+    rv->tv_sec = fctx->tv_sec;
+    rv->tv_nsec = fctx->tv_nsec;
+    rv->readable = fctx->readable;
+    return rv;
+}
+
+
 void
 bm_filectx_free(bm_filectx_t *fctx)
 {
@@ -162,6 +212,46 @@ bm_filectx_free(bm_filectx_t *fctx)
 }
 
 
+static void
+bm_source_free(bm_source_t *src)
+{
+    if (src == NULL)
+        return;
+    bc_hashmap_free(src->source);
+    free(src);
+}
+
+
+// the sources are kept across rescans, but the ones of posts and pages that
+// were renamed or removed would never be used again, so they are dropped.
+static void
+prune_sources(bm_ctx_t *ctx)
+{
+    bc_hashmap_t *sources = bc_hashmap_new((bc_free_func_t) bm_source_free);
+    bc_slist_t *lists[] = {ctx->posts_fctx, ctx->pages_fctx};
+
+    pthread_mutex_lock(&ctx->sources_mutex);
+    for (size_t i = 0; i < 2; i++) {
+        for (bc_slist_t *l = lists[i]; l != NULL; l = l->next) {
+            bm_filectx_t *fctx = l->data;
+            bm_source_t *src = bc_hashmap_lookup(ctx->sources, fctx->path);
+            if (src == NULL || src->source == NULL)
+                continue;
+
+            // the parsed source moves to the new store, the old entry is
+            // freed empty.
+            bm_source_t *tmp = bc_malloc(sizeof(bm_source_t));
+            *tmp = *src;
+            src->source = NULL;
+            bc_hashmap_insert(sources, fctx->path, tmp);
+        }
+    }
+    bc_hashmap_free(ctx->sources);
+    ctx->sources = sources;
+    pthread_mutex_unlock(&ctx->sources_mutex);
+}
+
+
 bm_ctx_t*
 bm_ctx_new(bm_ctx_t *base, const char *settings_file, const char *argv0,
     bc_error_t **err)
@@ -190,11 +280,19 @@ bm_ctx_new(bm_ctx_t *base, const char *settings_file, const char *argv0,
     bm_ctx_t *rv = NULL;
     if (base == NULL) {
         rv = bc_malloc(sizeof(bm_ctx_t));
-        rv->blogc = bm_exec_find_binary(argv0, "blogc", "BLOGC");
+        // blogc is rendered in-process by default. an external binary is
+        // only used if explicitly requested.
+        rv->blogc = NULL;
+        if (getenv("BLOGC") != NULL)
+            rv->blogc = bm_exec_find_binary(argv0, "blogc", "BLOGC");
         rv->blogc_runserver = bm_exec_find_binary(argv0, "blogc-runserver",
             "BLOGC_RUNSERVER");
         rv->dev = false;
         rv->verbose = false;
+        rv->jobs = NULL;
+        rv->sources = bc_hashmap_new((bc_free_func_t) bm_source_free);
+        pthread_mutex_init(&rv->sources_mutex, NULL);
+        rv->manifest = NULL;
     }
     else {
         bm_ctx_free_internal(base);
@@ -218,22 +316,29 @@ bm_ctx_new(bm_ctx_t *base, const char *settings_file, const char *argv0,
             rv->short_output_dir);
     }
 
+    if (rv->manifest == NULL) {
+        char *manifest = bc_strdup_printf("%s/%s", rv->output_dir,
+            BM_MANIFEST_FILENAME);
+        rv->manifest = bm_manifest_new(manifest);
+        free(manifest);
+    }
+
     // can't return null and set error after this!
 
-    const char *template_dir = bc_trie_lookup(settings->settings,
+    const char *template_dir = bc_hashmap_lookup(settings->settings,
         "template_dir");
 
     char *main_template = bc_strdup_printf("%s/%s", template_dir,
-        bc_trie_lookup(settings->settings, "main_template"));
+        bc_hashmap_lookup(settings->settings, "main_template"));
     rv->main_template_fctx = bm_filectx_new(rv, main_template, NULL, NULL);
     free(main_template);
 
     rv->atom_template_fctx = bm_filectx_new(rv, atom_template, NULL, NULL);
     free(atom_template);
 
-    const char *content_dir = bc_trie_lookup(settings->settings, "content_dir");
-    const char *post_prefix = bc_trie_lookup(settings->settings, "post_prefix");
-    const char *source_ext = bc_trie_lookup(settings->settings, "source_ext");
+    const char *content_dir = bc_hashmap_lookup(settings->settings, "content_dir");
+    const char *post_prefix = bc_hashmap_lookup(settings->settings, "post_prefix");
+    const char *source_ext = bc_hashmap_lookup(settings->settings, "source_ext");
 
     rv->posts_fctx = NULL;
     if (settings->posts != NULL) {
@@ -265,33 +370,45 @@ bm_ctx_new(bm_ctx_t *base, const char *settings_file, const char *argv0,
         }
     }
 
+    if (base != NULL)
+        prune_sources(rv);
+
     return rv;
 }
 
 
 bool
-bm_ctx_reload(bm_ctx_t **ctx)
+bm_ctx_rescan(bm_ctx_t **ctx)
 {
     if (*ctx == NULL || (*ctx)->settings_fctx == NULL)
         return false;
 
-    if (bm_filectx_changed((*ctx)->settings_fctx, NULL, NULL)) {
-        // reload everything! we could just reload settings_fctx, as this
-        // would force rebuilding everything, but we need to know new/deleted
-        // files
-
-        // needs to dup path, because it may be freed when reloading.
-        char *tmp = bc_strdup((*ctx)->settings_fctx->path);
-        bc_error_t *err = NULL;
-        *ctx = bm_ctx_new(*ctx, tmp, NULL, &err);
-        free(tmp);
-        if (err != NULL) {
-            bc_error_print(err, "blogc-make");
-            bc_error_free(err);
-            return false;
-        }
-        return true;
+    // needs to dup path, because it may be freed when reloading.
+    char *tmp = bc_strdup((*ctx)->settings_fctx->path);
+    bc_error_t *err = NULL;
+    bm_ctx_t *rv = bm_ctx_new(*ctx, tmp, NULL, &err);
+    free(tmp);
+    if (err != NULL) {
+        // the context is left untouched on errors, keep it to retry later
+        bc_error_print(err, "blogc-make");
+        bc_error_free(err);
+        return false;
     }
+    *ctx = rv;
+    return true;
+}
+
+
+bool
+bm_ctx_reload(bm_ctx_t **ctx)
+{
+    if (*ctx == NULL || (*ctx)->settings_fctx == NULL)
+        return false;
+
+    // reload everything! we could just reload settings_fctx, as this would
+    // force rebuilding everything, but we need to know new/deleted files
+    if (bm_filectx_changed((*ctx)->settings_fctx, NULL, NULL))
+        return bm_ctx_rescan(ctx);
 
     bm_filectx_reload((*ctx)->main_template_fctx);
     bm_filectx_reload((*ctx)->atom_template_fctx);
@@ -309,6 +426,52 @@ bm_ctx_reload(bm_ctx_t **ctx)
 }
 
 
+bc_hashmap_t*
+bm_ctx_get_source(bm_ctx_t *ctx, bm_filectx_t *fctx, bc_error_t **err)
+{
+    if (ctx == NULL || fctx == NULL || err == NULL || *err != NULL)
+        return NULL;
+
+    pthread_mutex_lock(&ctx->sources_mutex);
+    bm_source_t *src = bc_hashmap_lookup(ctx->sources, fctx->path);
+    if (src != NULL && src->tv_sec == fctx->tv_sec &&
+        src->tv_nsec == fctx->tv_nsec)
+    {
+        pthread_mutex_unlock(&ctx->sources_mutex);
+        return src->source;
+    }
+    pthread_mutex_unlock(&ctx->sources_mutex);
+
+    // parse without holding the lock, so parallel jobs can parse different
+    // sources at the same time
+    bc_hashmap_t *s = blogc_source_parse_from_file(fctx->path, false, err);
+    if (s == NULL)
+        return NULL;
+
+    pthread_mutex_lock(&ctx->sources_mutex);
+
+    // another job may have parsed the same source in the meantime. its entry
+    // may be in use already, so we must not replace it.
+    src = bc_hashmap_lookup(ctx->sources, fctx->path);
+    if (src != NULL && src->tv_sec == fctx->tv_sec &&
+        src->tv_nsec == fctx->tv_nsec)
+    {
+        pthread_mutex_unlock(&ctx->sources_mutex);
+        bc_hashmap_free(s);
+        return src->source;
+    }
+
+    // replacing the entry frees the stale source, if any
+    src = bc_malloc(sizeof(bm_source_t));
+    src->source = s;
+    src->tv_sec = fctx->tv_sec;
+    src->tv_nsec = fctx->tv_nsec;
+    bc_hashmap_insert(ctx->sources, fctx->path, src);
+    pthread_mutex_unlock(&ctx->sources_mutex);
+    return s;
+}
+
+
 void
 bm_ctx_free_internal(bm_ctx_t *ctx)
 {
@@ -348,8 +511,12 @@ bm_ctx_free(bm_ctx_t *ctx)
 {
     if (ctx == NULL)
         return;
+    bm_jobs_free(ctx->jobs);  // jobs may still reference the context
     bm_ctx_free_internal(ctx);
     free(ctx->blogc);
     free(ctx->blogc_runserver);
+    bc_hashmap_free(ctx->sources);
+    pthread_mutex_destroy(&ctx->sources_mutex);
+    bm_manifest_free(ctx->manifest);
     free(ctx);
 }
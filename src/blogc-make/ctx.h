@@ -10,8 +10,10 @@
 #define _MAKE_CTX_H
 
 #include <sys/stat.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <time.h>
+#include "jobs.h"
 #include "settings.h"
 #include "../common/error.h"
 #include "../common/utils.h"
@@ -43,6 +45,12 @@ typedef struct {
     bool readable;
 } bm_filectx_t;
 
+typedef struct {
+    bc_hashmap_t *source;
+    time_t tv_sec;
+    long tv_nsec;
+} bm_source_t;
+
 typedef struct {
     char *blogc;
     char *blogc_runserver;
@@ -50,6 +58,9 @@ typedef struct {
     bool dev;
     bool verbose;
 
+    // NULL if the build should run serially
+    bm_jobs_t *jobs;
+
     bm_settings_t *settings;
 
     char *root_dir;
@@ -63,6 +74,15 @@ typedef struct {
     bc_slist_t *posts_fctx;
     bc_slist_t *pages_fctx;
     bc_slist_t *copy_fctx;
+
+    // parsed sources, indexed by path. this is kept across reloads, entries
+    // are refreshed when the mtime of the source file changes.
+    bc_hashmap_t *sources;
+    pthread_mutex_t sources_mutex;
+
+    // content hashes of inputs and outputs, persisted in the output
+    // directory. like the sources, this is kept across reloads.
+    struct bm_manifest *manifest;
 } bm_ctx_t;
 
 bm_filectx_t* bm_filectx_new(bm_ctx_t *ctx, const char *filename, const char *slug,
@@ -70,10 +90,15 @@ bm_filectx_t* bm_filectx_new(bm_ctx_t *ctx, const char *filename, const char *sl
 bc_slist_t* bm_filectx_new_r(bc_slist_t *l, bm_ctx_t *ctx, const char *filename);
 bool bm_filectx_changed(bm_filectx_t *ctx, time_t *tv_sec, long *tv_nsec);
 void bm_filectx_reload(bm_filectx_t *ctx);
+void bm_filectx_touch(bm_filectx_t *ctx, bc_slist_t *inputs);
+bm_filectx_t* bm_filectx_dup(bm_filectx_t *fctx);
 void bm_filectx_free(bm_filectx_t *fctx);
 bm_ctx_t* bm_ctx_new(bm_ctx_t *base, const char *settings_file,
     const char *argv0, bc_error_t **err);
+bool bm_ctx_rescan(bm_ctx_t **ctx);
 bool bm_ctx_reload(bm_ctx_t **ctx);
+bc_hashmap_t* bm_ctx_get_source(bm_ctx_t *ctx, bm_filectx_t *fctx,
+    bc_error_t **err);
 void bm_ctx_free_internal(bm_ctx_t *ctx);
 void bm_ctx_free(bm_ctx_t *ctx);
 
@@ -6,6 +6,10 @@
  * See the file LICENSE.
  */
 
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif /* HAVE_CONFIG_H */
+
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -13,26 +17,28 @@
 #include <sys/stat.h>
 #include <dirent.h>
 #include <fcntl.h>
+#include <locale.h>
 #include <unistd.h>
 #include <libgen.h>
 #include <errno.h>
+#include "../blogc/loader.h"
+#include "../blogc/renderer.h"
 #include "../common/error.h"
 #include "../common/file.h"
 #include "../common/utils.h"
 #include "exec-native.h"
 #include "ctx.h"
+#include "settings.h"
 
+#ifndef PACKAGE_VERSION
+#define PACKAGE_VERSION "Unknown"
+#endif
 
-int
-bm_exec_native_cp(bm_filectx_t *source, bm_filectx_t *dest, bool verbose)
-{
-    if (verbose)
-        printf("Copying '%s' to '%s'\n", source->path, dest->path);
-    else
-        printf("  COPY     %s\n", dest->short_path);
-    fflush(stdout);
 
-    char *fname = bc_strdup(dest->path);
+static void
+mkdir_recursive(const char *filename)
+{
+    char *fname = bc_strdup(filename);
     for (char *tmp = fname; *tmp != '\0'; tmp++) {
         if (*tmp != '/' && *tmp != '\\')
             continue;
@@ -50,6 +56,19 @@ bm_exec_native_cp(bm_filectx_t *source, bm_filectx_t *dest, bool verbose)
         *tmp = bkp;
     }
     free(fname);
+}
+
+
+int
+bm_exec_native_cp(bm_filectx_t *source, bm_filectx_t *dest, bool verbose)
+{
+    if (verbose)
+        printf("Copying '%s' to '%s'\n", source->path, dest->path);
+    else
+        printf("  COPY     %s\n", dest->short_path);
+    fflush(stdout);
+
+    mkdir_recursive(dest->path);
 
     int fd_from = open(source->path, O_RDONLY);
     if (fd_from < 0) {
@@ -187,3 +206,154 @@ bm_exec_native_rm(const char *output_dir, bm_filectx_t *dest, bool verbose)
 
     return rv;
 }
+
+
+static void
+copy_variable(const char *key, const char *value, bc_hashmap_t *config)
+{
+    bc_hashmap_insert(config, key, bc_strdup(value));
+}
+
+
+static void
+write_output(const char *str, size_t len, void *user_data)
+{
+    bc_file_writer_write(user_data, str, len);
+}
+
+
+int
+bm_exec_native_blogc(bm_ctx_t *ctx, bc_hashmap_t *global_variables,
+    bc_hashmap_t *local_variables, bool listing, bm_filectx_t *template,
+    bm_filectx_t *output, bc_slist_t *sources, bool only_first_source)
+{
+    if (ctx == NULL || template == NULL || output == NULL)
+        return 3;
+
+    if (ctx->verbose)
+        printf("Rendering '%s' with template '%s'\n", output->path,
+            template->path);
+    else
+        printf("  BLOGC    %s\n", output->short_path);
+    fflush(stdout);
+
+    // this builds the same configuration map that blogc(1) would build from
+    // the `-D` arguments passed by bm_exec_build_blogc_cmd(), in the same
+    // order, so later values override earlier ones.
+    bc_hashmap_t *config = bc_hashmap_new(free);
+    bc_hashmap_insert(config, "BLOGC_VERSION", bc_strdup(PACKAGE_VERSION));
+
+    if (ctx->settings != NULL) {
+        if (ctx->settings->tags != NULL)
+            bc_hashmap_insert(config, "MAKE_TAGS",
+                bc_strv_join(ctx->settings->tags, " "));
+        bc_hashmap_foreach(ctx->settings->global,
+            (bc_hashmap_foreach_func_t) copy_variable, config);
+    }
+
+    bc_hashmap_foreach(global_variables, (bc_hashmap_foreach_func_t) copy_variable,
+        config);
+    bc_hashmap_foreach(local_variables, (bc_hashmap_foreach_func_t) copy_variable,
+        config);
+
+    if (ctx->dev) {
+        bc_hashmap_insert(config, "MAKE_ENV_DEV", bc_strdup("1"));
+        bc_hashmap_insert(config, "MAKE_ENV", bc_strdup("dev"));
+    }
+
+    // blogc(1) is called with LC_ALL set to the configured locale. we can't
+    // call setlocale() here, because it is process-wide, so we switch the
+    // locale of the current thread only. if the locale is not available we
+    // just keep the current one, like blogc(1) would do.
+    locale_t loc = (locale_t) 0;
+    locale_t old_loc = (locale_t) 0;
+    const char *locale = NULL;
+    if (ctx->settings != NULL)
+        locale = bc_hashmap_lookup(ctx->settings->settings, "locale");
+    if (locale != NULL) {
+        loc = newlocale(LC_ALL_MASK, locale, (locale_t) 0);
+        if (loc != (locale_t) 0)
+            old_loc = uselocale(loc);
+    }
+
+    int rv = 0;
+    bc_error_t *err = NULL;
+    bc_slist_t *parsed = NULL;
+    bc_slist_t *s = NULL;
+    bc_slist_t *tmpl = NULL;
+    bc_arena_t *arena = NULL;
+
+    // sources are parsed only once per build, and shared by all the rules
+    for (bc_slist_t *l = sources; l != NULL; l = l->next) {
+        bm_filectx_t *fctx = l->data;
+        bc_hashmap_t *src = bm_ctx_get_source(ctx, fctx, &err);
+        if (src == NULL) {
+            bc_error_t *tmp_err = err;
+            err = bc_error_new_printf(BLOGC_ERROR_LOADER,
+                "An error occurred while parsing source file: %s\n\n%s",
+                fctx->path, tmp_err->msg);
+            bc_error_free(tmp_err);
+            bc_error_print(err, "blogc-make");
+            rv = 3;
+            goto cleanup;
+        }
+        parsed = bc_slist_append(parsed, src);
+        if (only_first_source)
+            break;
+    }
+
+    s = blogc_source_filter(config, parsed, &err);
+    if (err != NULL) {
+        bc_error_print(err, "blogc-make");
+        rv = 3;
+        goto cleanup;
+    }
+
+    // the template AST only lives while rendering this output, release it all
+    // at once.
+    arena = bc_arena_new(0);
+    tmpl = blogc_template_parse_from_file(template->path, arena, false,
+        &err);
+    if (err != NULL) {
+        bc_error_print(err, "blogc-make");
+        rv = 3;
+        goto cleanup;
+    }
+
+    mkdir_recursive(output->path);
+
+    int fd = open(output->path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd == -1) {
+        fprintf(stderr, "blogc-make: error: failed to open output file "
+            "(%s): %s\n", output->path, strerror(errno));
+        rv = 3;
+        goto cleanup;
+    }
+
+    bc_file_writer_t *writer = bc_file_writer_new(fd);
+    blogc_render_to_sink(tmpl, s, config, listing, write_output, writer);
+    if (!bc_file_writer_flush(writer)) {
+        fprintf(stderr, "blogc-make: error: failed to write output file "
+            "(%s): %s\n", output->path, strerror(writer->error));
+        rv = 3;
+    }
+    bc_file_writer_free(writer);
+
+    if (0 != close(fd) && rv == 0) {
+        fprintf(stderr, "blogc-make: error: failed to write output file "
+            "(%s): %s\n", output->path, strerror(errno));
+        rv = 3;
+    }
+
+cleanup:
+    if (loc != (locale_t) 0) {
+        uselocale(old_loc);
+        freelocale(loc);
+    }
+    bc_arena_free(arena);
+    bc_slist_free(s);
+    bc_slist_free(parsed);
+    bc_error_free(err);
+    bc_hashmap_free(config);
+    return rv;
+}
@@ -11,10 +11,14 @@
 
 #include <stdbool.h>
 #include "../common/error.h"
+#include "../common/utils.h"
 #include "ctx.h"
 
 int bm_exec_native_cp(bm_filectx_t *source, bm_filectx_t *dest, bool verbose);
 bool bm_exec_native_is_empty_dir(const char *dir, bc_error_t **err);
 int bm_exec_native_rm(const char *output_dir, bm_filectx_t *dest, bool verbose);
+int bm_exec_native_blogc(bm_ctx_t *ctx, bc_hashmap_t *global_variables,
+    bc_hashmap_t *local_variables, bool listing, bm_filectx_t *template,
+    bm_filectx_t *output, bc_slist_t *sources, bool only_first_source);
 
 #endif /* _MAKE_EXEC_NATIVE_H */
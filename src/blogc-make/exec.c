@@ -10,6 +10,8 @@
 #include <config.h>
 #endif /* HAVE_CONFIG_H */
 
+#include <fcntl.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -24,6 +26,7 @@
 #include "../common/utils.h"
 #include "ctx.h"
 #include "exec.h"
+#include "exec-native.h"
 #include "settings.h"
 
 
@@ -72,6 +75,22 @@ bm_exec_find_binary(const char *argv0, const char *bin, const char *env)
 }
 
 
+static pthread_mutex_t exec_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+static int
+pipe_cloexec(int fd[2])
+{
+    if (-1 == pipe(fd))
+        return -1;
+
+    // dup2() clears the flag for the child's stdio, so this is safe
+    fcntl(fd[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fd[1], F_SETFD, FD_CLOEXEC);
+    return 0;
+}
+
+
 int
 bm_exec_command(const char *cmd, const char *input, char **output,
     char **error, bc_error_t **err)
@@ -79,30 +98,38 @@ bm_exec_command(const char *cmd, const char *input, char **output,
     if (err == NULL || *err != NULL)
         return 3;
 
+    // when building in parallel, other threads may fork while we are setting
+    // up the pipes. the pipes must not leak to other children, or we would
+    // never see the EOF.
+    pthread_mutex_lock(&exec_mutex);
+
     int fd_in[2];
-    if (-1 == pipe(fd_in)) {
+    if (-1 == pipe_cloexec(fd_in)) {
         *err = bc_error_new_printf(BLOGC_MAKE_ERROR_EXEC,
             "Failed to create stdin pipe: %s", strerror(errno));
+        pthread_mutex_unlock(&exec_mutex);
         return 3;
     }
 
     int fd_out[2];
-    if (-1 == pipe(fd_out)) {
+    if (-1 == pipe_cloexec(fd_out)) {
         *err = bc_error_new_printf(BLOGC_MAKE_ERROR_EXEC,
             "Failed to create stdout pipe: %s", strerror(errno));
         close(fd_in[0]);
         close(fd_in[1]);
+        pthread_mutex_unlock(&exec_mutex);
         return 3;
     }
 
     int fd_err[2];
-    if (-1 == pipe(fd_err)) {
+    if (-1 == pipe_cloexec(fd_err)) {
         *err = bc_error_new_printf(BLOGC_MAKE_ERROR_EXEC,
             "Failed to create stderr pipe: %s", strerror(errno));
         close(fd_in[0]);
         close(fd_in[1]);
         close(fd_out[0]);
         close(fd_out[1]);
+        pthread_mutex_unlock(&exec_mutex);
         return 3;
     }
 
@@ -116,6 +143,7 @@ bm_exec_command(const char *cmd, const char *input, char **output,
         close(fd_out[1]);
         close(fd_err[0]);
         close(fd_err[1]);
+        pthread_mutex_unlock(&exec_mutex);
         return 3;
     }
 
@@ -142,6 +170,8 @@ bm_exec_command(const char *cmd, const char *input, char **output,
     }
 
     // parent
+    pthread_mutex_unlock(&exec_mutex);
+
     close(fd_in[0]);
     close(fd_out[1]);
     close(fd_err[1]);
@@ -218,14 +248,14 @@ list_variables(const char *key, const char *value, bc_string_t *str)
 
 char*
 bm_exec_build_blogc_cmd(const char *blogc_bin, bm_settings_t *settings,
-    bc_trie_t *global_variables, bc_trie_t *local_variables, bool listing,
+    bc_hashmap_t *global_variables, bc_hashmap_t *local_variables, bool listing,
     const char *template, const char *output, bool dev, bool sources_stdin)
 {
     bc_string_t *rv = bc_string_new();
 
     const char *locale = NULL;
     if (settings != NULL) {
-        locale = bc_trie_lookup(settings->settings, "locale");
+        locale = bc_hashmap_lookup(settings->settings, "locale");
     }
     if (locale != NULL) {
         char *tmp = bc_shell_quote(locale);
@@ -242,12 +272,12 @@ bm_exec_build_blogc_cmd(const char *blogc_bin, bm_settings_t *settings,
             free(tags);
         }
 
-        bc_trie_foreach(settings->global,
-            (bc_trie_foreach_func_t) list_variables, rv);
+        bc_hashmap_foreach(settings->global,
+            (bc_hashmap_foreach_func_t) list_variables, rv);
     }
 
-    bc_trie_foreach(global_variables, (bc_trie_foreach_func_t) list_variables, rv);
-    bc_trie_foreach(local_variables, (bc_trie_foreach_func_t) list_variables, rv);
+    bc_hashmap_foreach(global_variables, (bc_hashmap_foreach_func_t) list_variables, rv);
+    bc_hashmap_foreach(local_variables, (bc_hashmap_foreach_func_t) list_variables, rv);
 
     if (dev) {
         bc_string_append(rv, " -D MAKE_ENV_DEV=1 -D MAKE_ENV='dev'");
@@ -278,13 +308,18 @@ bm_exec_build_blogc_cmd(const char *blogc_bin, bm_settings_t *settings,
 
 
 int
-bm_exec_blogc(bm_ctx_t *ctx, bc_trie_t *global_variables, bc_trie_t *local_variables,
+bm_exec_blogc(bm_ctx_t *ctx, bc_hashmap_t *global_variables, bc_hashmap_t *local_variables,
     bool listing, bm_filectx_t *template, bm_filectx_t *output, bc_slist_t *sources,
     bool only_first_source)
 {
     if (ctx == NULL)
         return 3;
 
+    // no external binary was requested, render everything in-process
+    if (ctx->blogc == NULL)
+        return bm_exec_native_blogc(ctx, global_variables, local_variables,
+            listing, template, output, sources, only_first_source);
+
     bc_string_t *input = bc_string_new();
     for (bc_slist_t *l = sources; l != NULL; l = l->next) {
         bc_string_append_printf(input, "%s\n", ((bm_filectx_t*) l->data)->path);
@@ -23,7 +23,7 @@
 
 typedef struct {
     bm_ctx_t *ctx;
-    bc_trie_t *args;
+    bc_hashmap_t *args;
 } bm_httpd_t;
 
 
@@ -32,8 +32,8 @@ httpd_thread(void *arg)
 {
     bm_httpd_t *httpd = arg;
 
-    int rv = bm_exec_blogc_runserver(httpd->ctx, bc_trie_lookup(httpd->args, "host"),
-        bc_trie_lookup(httpd->args, "port"), bc_trie_lookup(httpd->args, "threads"));
+    int rv = bm_exec_blogc_runserver(httpd->ctx, bc_hashmap_lookup(httpd->args, "host"),
+        bc_hashmap_lookup(httpd->args, "port"), bc_hashmap_lookup(httpd->args, "threads"));
 
     free(httpd);
 
@@ -46,7 +46,7 @@ httpd_thread(void *arg)
 
 int
 bm_httpd_run(bm_ctx_t **ctx, bm_rule_exec_func_t rule_exec, bc_slist_t *outputs,
-    bc_trie_t *args)
+    bc_hashmap_t *args)
 {
     // this is here to avoid that the httpd starts running in the middle of the
     // first build, as the reloader and the httpd are started in parallel.
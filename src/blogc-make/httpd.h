@@ -14,6 +14,6 @@
 #include "rules.h"
 
 int bm_httpd_run(bm_ctx_t **ctx, bm_rule_exec_func_t rule_exec, bc_slist_t *outputs,
-    bc_trie_t *args);
+    bc_hashmap_t *args);
 
 #endif /* _MAKE_HTTPD_H */
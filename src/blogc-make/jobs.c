@@ -0,0 +1,178 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../common/utils.h"
+#include "jobs.h"
+
+// we are not going to unit-test these functions, then printing errors
+// directly is not a big issue
+
+
+static void
+job_free(bm_job_t *job)
+{
+    if (job == NULL)
+        return;
+    if (job->free_func != NULL)
+        job->free_func(job->data);
+    free(job);
+}
+
+
+static void*
+worker_thread(void *arg)
+{
+    bm_jobs_t *jobs = arg;
+
+    pthread_mutex_lock(&jobs->mutex);
+    while (1) {
+        while (jobs->head == NULL && !jobs->stop)
+            pthread_cond_wait(&jobs->cond_job, &jobs->mutex);
+
+        if (jobs->head == NULL)  // stopping, and nothing left to do
+            break;
+
+        bm_job_t *job = jobs->head;
+        jobs->head = job->next;
+        if (jobs->head == NULL)
+            jobs->tail = NULL;
+
+        // after the first failure, we just drain the queue, like the serial
+        // build would stop after the first failed rule.
+        if (jobs->rv == 0) {
+            pthread_mutex_unlock(&jobs->mutex);
+            int rv = job->func(job->data);
+            pthread_mutex_lock(&jobs->mutex);
+            if (rv != 0 && jobs->rv == 0)
+                jobs->rv = rv;
+        }
+
+        pthread_mutex_unlock(&jobs->mutex);
+        job_free(job);
+        pthread_mutex_lock(&jobs->mutex);
+
+        if (--jobs->pending == 0)
+            pthread_cond_broadcast(&jobs->cond_done);
+    }
+    pthread_mutex_unlock(&jobs->mutex);
+
+    return NULL;
+}
+
+
+bm_jobs_t*
+bm_jobs_new(size_t num_threads)
+{
+    if (num_threads == 0)
+        return NULL;
+
+    bm_jobs_t *rv = bc_malloc(sizeof(bm_jobs_t));
+    pthread_mutex_init(&rv->mutex, NULL);
+    pthread_cond_init(&rv->cond_job, NULL);
+    pthread_cond_init(&rv->cond_done, NULL);
+    rv->threads = bc_malloc(num_threads * sizeof(pthread_t));
+    rv->num_threads = 0;
+    rv->head = NULL;
+    rv->tail = NULL;
+    rv->pending = 0;
+    rv->rv = 0;
+    rv->stop = false;
+
+    for (size_t i = 0; i < num_threads; i++) {
+        int err;
+        if (0 != (err = pthread_create(&rv->threads[i], NULL, worker_thread, rv))) {
+            fprintf(stderr, "blogc-make: error: failed to create job "
+                "thread: %s\n", strerror(err));
+            bm_jobs_free(rv);
+            return NULL;
+        }
+        rv->num_threads++;
+    }
+
+    return rv;
+}
+
+
+int
+bm_jobs_add(bm_jobs_t *jobs, bm_job_func_t func, void *data,
+    bc_free_func_t free_func)
+{
+    if (jobs == NULL || func == NULL)
+        return 3;
+
+    bm_job_t *job = bc_malloc(sizeof(bm_job_t));
+    job->func = func;
+    job->data = data;
+    job->free_func = free_func;
+    job->next = NULL;
+
+    pthread_mutex_lock(&jobs->mutex);
+    int rv = jobs->rv;
+    if (rv == 0) {
+        if (jobs->tail == NULL)
+            jobs->head = job;
+        else
+            jobs->tail->next = job;
+        jobs->tail = job;
+        jobs->pending++;
+        pthread_cond_signal(&jobs->cond_job);
+    }
+    pthread_mutex_unlock(&jobs->mutex);
+
+    // some job already failed, don't bother running this one
+    if (rv != 0)
+        job_free(job);
+
+    return rv;
+}
+
+
+int
+bm_jobs_wait(bm_jobs_t *jobs)
+{
+    if (jobs == NULL)
+        return 0;
+
+    pthread_mutex_lock(&jobs->mutex);
+    while (jobs->pending > 0)
+        pthread_cond_wait(&jobs->cond_done, &jobs->mutex);
+
+    // reset the status, so the pool can be reused by the next build
+    int rv = jobs->rv;
+    jobs->rv = 0;
+    pthread_mutex_unlock(&jobs->mutex);
+
+    return rv;
+}
+
+
+void
+bm_jobs_free(bm_jobs_t *jobs)
+{
+    if (jobs == NULL)
+        return;
+
+    pthread_mutex_lock(&jobs->mutex);
+    jobs->stop = true;
+    pthread_cond_broadcast(&jobs->cond_job);
+    pthread_mutex_unlock(&jobs->mutex);
+
+    for (size_t i = 0; i < jobs->num_threads; i++)
+        pthread_join(jobs->threads[i], NULL);
+
+    pthread_cond_destroy(&jobs->cond_done);
+    pthread_cond_destroy(&jobs->cond_job);
+    pthread_mutex_destroy(&jobs->mutex);
+    free(jobs->threads);
+    free(jobs);
+}
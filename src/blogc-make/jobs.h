@@ -0,0 +1,45 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+#ifndef _MAKE_JOBS_H
+#define _MAKE_JOBS_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../common/utils.h"
+
+typedef int (*bm_job_func_t) (void *data);
+
+typedef struct _bm_job_t {
+    bm_job_func_t func;
+    void *data;
+    bc_free_func_t free_func;
+    struct _bm_job_t *next;
+} bm_job_t;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond_job;
+    pthread_cond_t cond_done;
+    pthread_t *threads;
+    size_t num_threads;
+    bm_job_t *head;
+    bm_job_t *tail;
+    size_t pending;
+    int rv;
+    bool stop;
+} bm_jobs_t;
+
+bm_jobs_t* bm_jobs_new(size_t num_threads);
+int bm_jobs_add(bm_jobs_t *jobs, bm_job_func_t func, void *data,
+    bc_free_func_t free_func);
+int bm_jobs_wait(bm_jobs_t *jobs);
+void bm_jobs_free(bm_jobs_t *jobs);
+
+#endif /* _MAKE_JOBS_H */
@@ -17,6 +17,7 @@
 #include "../common/error.h"
 #include "../common/utils.h"
 #include "ctx.h"
+#include "jobs.h"
 #include "rules.h"
 
 
@@ -25,7 +26,7 @@ print_help(void)
 {
     printf(
         "usage:\n"
-        "    blogc-make [-h] [-v] [-D] [-V] [-f FILE] [RULE ...]\n"
+        "    blogc-make [-h] [-v] [-D] [-V] [-f FILE] [-j JOBS] [RULE ...]\n"
         "               - A simple build tool for blogc.\n"
         "\n"
         "positional arguments:\n"
@@ -38,7 +39,8 @@ print_help(void)
         "    -v            show version and exit\n"
         "    -D            build for development environment\n"
         "    -V            be verbose when executing commands\n"
-        "    -f FILE       read FILE as blogcfile\n");
+        "    -f FILE       read FILE as blogcfile\n"
+        "    -j JOBS       build up to JOBS outputs in parallel (default: 1)\n");
     bm_rule_print_help();
 }
 
@@ -46,7 +48,8 @@ print_help(void)
 static void
 print_usage(void)
 {
-    printf("usage: blogc-make [-h] [-v] [-D] [-V] [-f FILE] [RULE ...]\n");
+    printf("usage: blogc-make [-h] [-v] [-D] [-V] [-f FILE] [-j JOBS] "
+        "[RULE ...]\n");
 }
 
 
@@ -66,8 +69,12 @@ main(int argc, char **argv)
     bool verbose = false;
     bool dev = false;
     char *blogcfile = NULL;
+    size_t jobs = 1;
     bm_ctx_t *ctx = NULL;
 
+    char *ptr;
+    char *endptr;
+
     for (size_t i = 1; i < argc; i++) {
         if (argv[i][0] == '-') {
             switch (argv[i][1]) {
@@ -89,6 +96,24 @@ main(int argc, char **argv)
                     else if (i + 1 < argc)
                         blogcfile = bc_strdup(argv[++i]);
                     break;
+                case 'j':
+                    if (argv[i][2] != '\0')
+                        ptr = argv[i] + 2;
+                    else if (i + 1 < argc)
+                        ptr = argv[++i];
+                    else
+                        ptr = "";
+                    jobs = strtoul(ptr, &endptr, 10);
+                    if (*ptr == '\0' || *endptr != '\0' || jobs <= 0 ||
+                        jobs > 1000)
+                    {
+                        print_usage();
+                        fprintf(stderr, "blogc-make: error: invalid value for "
+                            "-j. Must be integer > 0 and <= 1000\n");
+                        rv = 3;
+                        goto cleanup;
+                    }
+                    break;
 #ifdef MAKE_EMBEDDED
                 case 'm':
                     // no-op, for embedding into blogc binary.
@@ -121,6 +146,15 @@ main(int argc, char **argv)
     ctx->dev = dev;
     ctx->verbose = verbose;
 
+    // with a single job we just build everything serially, in this thread
+    if (jobs > 1) {
+        ctx->jobs = bm_jobs_new(jobs);
+        if (ctx->jobs == NULL) {
+            rv = 3;
+            goto cleanup;
+        }
+    }
+
     rv = bm_rule_executor(ctx, rules);
 
 cleanup:
@@ -0,0 +1,636 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../common/error.h"
+#include "../common/file.h"
+#include "../common/utils.h"
+#include "ctx.h"
+#include "manifest.h"
+
+#ifndef PACKAGE_VERSION
+#define PACKAGE_VERSION "Unknown"
+#endif
+
+// the manifest is a text file, with a header line, followed by the hashes of
+// the input files, `F <hash> <mtime sec> <mtime nsec> <path>`, and the digests
+// of the outputs, `O <digest> <output>`. a manifest with an unknown header is
+// ignored, and everything goes back to the mtime checks.
+#define MANIFEST_HEADER "blogc-make manifest 1"
+#define MANIFEST_BUFFER_SIZE 16384
+
+// FNV-1a, 64 bits
+#define HASH_INIT 14695981039346656037ULL
+#define HASH_PRIME 1099511628211ULL
+
+typedef struct {
+    uint64_t hash;
+    long long tv_sec;
+    long tv_nsec;
+} manifest_file_t;
+
+// what the listing outputs need to know about the posts: the posts, in the
+// order they are listed in the settings file, and which of them have each tag.
+// it is learned once per build, when the first listing output is checked.
+typedef struct {
+    size_t *posts;
+    size_t len;
+    size_t size;
+} manifest_tag_t;
+
+typedef struct {
+    bc_slist_t *sources;
+    bm_filectx_t **posts;
+    size_t len;
+    bc_hashmap_t *tags;
+    bool failed;
+} manifest_posts_t;
+
+struct bm_manifest {
+    char *path;
+    bc_hashmap_t *files;
+    bc_hashmap_t *outputs;
+    bool dirty;
+    pthread_mutex_t mutex;
+    manifest_posts_t *posts;
+    pthread_mutex_t posts_mutex;
+};
+
+
+static uint64_t
+hash_bytes(uint64_t hash, const void *data, size_t len)
+{
+    const unsigned char *p = data;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= HASH_PRIME;
+    }
+    return hash;
+}
+
+
+// the terminating NUL is hashed too, so consecutive strings can't be mixed up.
+static uint64_t
+hash_str(uint64_t hash, const char *str)
+{
+    if (str == NULL)
+        str = "";
+    return hash_bytes(hash, str, strlen(str) + 1);
+}
+
+
+static uint64_t
+hash_u64(uint64_t hash, uint64_t value)
+{
+    for (size_t i = 0; i < 8; i++) {
+        hash ^= (value >> (8 * i)) & 0xff;
+        hash *= HASH_PRIME;
+    }
+    return hash;
+}
+
+
+static bool
+hash_file(const char *path, uint64_t *hash)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return false;
+
+    uint64_t rv = HASH_INIT;
+    char buffer[MANIFEST_BUFFER_SIZE];
+    ssize_t n;
+    while (0 < (n = read(fd, buffer, MANIFEST_BUFFER_SIZE)))
+        rv = hash_bytes(rv, buffer, n);
+    close(fd);
+
+    if (n < 0)
+        return false;
+    *hash = rv;
+    return true;
+}
+
+
+bm_manifest_t*
+bm_manifest_new(const char *path)
+{
+    if (path == NULL)
+        return NULL;
+
+    bm_manifest_t *rv = bc_malloc(sizeof(bm_manifest_t));
+    rv->path = bc_strdup(path);
+    rv->files = bc_hashmap_new(free);
+    rv->outputs = bc_hashmap_new(free);
+    rv->dirty = false;
+    pthread_mutex_init(&rv->mutex, NULL);
+    rv->posts = NULL;
+    pthread_mutex_init(&rv->posts_mutex, NULL);
+
+    // a missing manifest is fine, it is created by the first build
+    size_t len;
+    bc_error_t *err = NULL;
+    char *content = bc_file_get_contents(path, false, &len, &err);
+    if (err != NULL) {
+        bc_error_free(err);
+        return rv;
+    }
+
+    char **lines = bc_str_split(content, '\n', 0);
+    free(content);
+    if (lines[0] == NULL || 0 != strcmp(lines[0], MANIFEST_HEADER)) {
+        bc_strv_free(lines);
+        return rv;
+    }
+
+    for (size_t i = 1; lines[i] != NULL; i++) {
+        char *line = lines[i];
+        char *end;
+        if (line[0] == 'F' && line[1] == ' ') {
+            manifest_file_t f;
+            f.hash = strtoull(line + 2, &end, 16);
+            if (*end != ' ')
+                continue;
+            f.tv_sec = strtoll(end + 1, &end, 10);
+            if (*end != ' ')
+                continue;
+            f.tv_nsec = strtol(end + 1, &end, 10);
+            if (*end != ' ' || end[1] == '\0')
+                continue;
+            manifest_file_t *tmp = bc_malloc(sizeof(manifest_file_t));
+            *tmp = f;
+            bc_hashmap_insert(rv->files, end + 1, tmp);
+        }
+        else if (line[0] == 'O' && line[1] == ' ') {
+            end = strchr(line + 2, ' ');
+            if (end == NULL || end[1] == '\0')
+                continue;
+            bc_hashmap_insert(rv->outputs, end + 1,
+                bc_strndup(line + 2, end - line - 2));
+        }
+    }
+
+    bc_strv_free(lines);
+    return rv;
+}
+
+
+static void
+free_tag(manifest_tag_t *tag)
+{
+    free(tag->posts);
+    free(tag);
+}
+
+
+static void
+free_posts(manifest_posts_t *posts)
+{
+    if (posts == NULL)
+        return;
+    free(posts->posts);
+    bc_hashmap_free(posts->tags);
+    free(posts);
+}
+
+
+void
+bm_manifest_free(bm_manifest_t *manifest)
+{
+    if (manifest == NULL)
+        return;
+    free(manifest->path);
+    bc_hashmap_free(manifest->files);
+    bc_hashmap_free(manifest->outputs);
+    pthread_mutex_destroy(&manifest->mutex);
+    free_posts(manifest->posts);
+    pthread_mutex_destroy(&manifest->posts_mutex);
+    free(manifest);
+}
+
+
+// hashes of files are kept by path, and reused while the mtime doesn't change.
+// generated files, like the atom template, live out of the root directory and
+// get a new name every time, so they aren't kept.
+static bool
+file_hash(bm_manifest_t *manifest, bm_ctx_t *ctx, bm_filectx_t *fctx,
+    uint64_t *hash)
+{
+    if (fctx == NULL || !fctx->readable)
+        return false;
+
+    size_t len = strlen(ctx->root_dir);
+    bool keep = 0 == strncmp(fctx->path, ctx->root_dir, len) &&
+        fctx->path[len] == '/' && NULL == strchr(fctx->path, '\n');
+
+    if (keep) {
+        pthread_mutex_lock(&manifest->mutex);
+        manifest_file_t *f = bc_hashmap_lookup(manifest->files, fctx->path);
+        if (f != NULL && f->tv_sec == fctx->tv_sec &&
+            f->tv_nsec == fctx->tv_nsec)
+        {
+            *hash = f->hash;
+            pthread_mutex_unlock(&manifest->mutex);
+            return true;
+        }
+        pthread_mutex_unlock(&manifest->mutex);
+    }
+
+    if (!hash_file(fctx->path, hash))
+        return false;
+
+    if (keep) {
+        manifest_file_t *f = bc_malloc(sizeof(manifest_file_t));
+        f->hash = *hash;
+        f->tv_sec = fctx->tv_sec;
+        f->tv_nsec = fctx->tv_nsec;
+        pthread_mutex_lock(&manifest->mutex);
+        bc_hashmap_insert(manifest->files, fctx->path, f);
+        manifest->dirty = true;
+        pthread_mutex_unlock(&manifest->mutex);
+    }
+    return true;
+}
+
+
+typedef struct {
+    const char **keys;
+    size_t len;
+} variable_keys_t;
+
+
+static void
+collect_key(const char *key, void *value, variable_keys_t *keys)
+{
+    keys->keys[keys->len++] = key;
+}
+
+
+static int
+compare_keys(const void *a, const void *b)
+{
+    return strcmp(*(const char**) a, *(const char**) b);
+}
+
+
+// variables are hashed sorted by key, so the order they were set in doesn't
+// matter.
+static uint64_t
+hash_variables(uint64_t hash, bc_hashmap_t *variables)
+{
+    size_t size = bc_hashmap_size(variables);
+    hash = hash_u64(hash, size);
+    if (size == 0)
+        return hash;
+
+    variable_keys_t keys = {
+        .keys = bc_malloc(size * sizeof(char*)),
+        .len = 0,
+    };
+    bc_hashmap_foreach(variables, (bc_hashmap_foreach_func_t) collect_key,
+        &keys);
+    qsort(keys.keys, keys.len, sizeof(char*), compare_keys);
+    for (size_t i = 0; i < keys.len; i++) {
+        hash = hash_str(hash, keys.keys[i]);
+        hash = hash_str(hash, bc_hashmap_lookup(variables, keys.keys[i]));
+    }
+    free(keys.keys);
+    return hash;
+}
+
+
+// tags are split the same way blogc does when filtering the sources. a post
+// that repeats a tag is still listed once.
+static manifest_posts_t*
+new_posts(bm_ctx_t *ctx, bc_slist_t *sources)
+{
+    manifest_posts_t *rv = bc_malloc(sizeof(manifest_posts_t));
+    rv->sources = sources;
+    rv->len = bc_slist_length(sources);
+    rv->posts = bc_malloc(rv->len * sizeof(bm_filectx_t*));
+    rv->tags = bc_hashmap_new((bc_free_func_t) free_tag);
+    rv->failed = false;
+
+    size_t i = 0;
+    for (bc_slist_t *l = sources; l != NULL; l = l->next, i++) {
+        rv->posts[i] = l->data;
+        bc_error_t *err = NULL;
+        bc_hashmap_t *src = bm_ctx_get_source(ctx, rv->posts[i], &err);
+        if (src == NULL) {
+            bc_error_free(err);
+            rv->failed = true;
+            break;
+        }
+
+        const char *tags_str = bc_hashmap_lookup(src, "TAGS");
+        if (tags_str == NULL)
+            continue;
+        char **tags = bc_str_split(tags_str, ' ', 0);
+        for (size_t j = 0; tags[j] != NULL; j++) {
+            if (tags[j][0] == '\0')
+                continue;
+            manifest_tag_t *tag = bc_hashmap_lookup(rv->tags, tags[j]);
+            if (tag == NULL) {
+                tag = bc_malloc(sizeof(manifest_tag_t));
+                tag->posts = NULL;
+                tag->len = 0;
+                tag->size = 0;
+                bc_hashmap_insert(rv->tags, tags[j], tag);
+            }
+            if (tag->len > 0 && tag->posts[tag->len - 1] == i)
+                continue;
+            if (tag->len == tag->size) {
+                tag->size = tag->size == 0 ? 8 : 2 * tag->size;
+                tag->posts = bc_realloc(tag->posts,
+                    tag->size * sizeof(size_t));
+            }
+            tag->posts[tag->len++] = i;
+        }
+        bc_strv_free(tags);
+    }
+
+    return rv;
+}
+
+
+// local variables override the global ones, like in the blogc configuration.
+static const char*
+lookup_variable(bc_hashmap_t *global_variables, bc_hashmap_t *local_variables,
+    const char *key)
+{
+    const char *rv = bc_hashmap_lookup(local_variables, key);
+    if (rv == NULL)
+        rv = bc_hashmap_lookup(global_variables, key);
+    return rv;
+}
+
+
+// listing outputs depend on every post, but only show a few of them: a page,
+// a tag, the latest posts for a feed. the listed posts are picked the same way
+// blogc filters them, from what was learned about the posts in this build,
+// and only them are hashed, together with the number of posts that could be
+// listed, that sets the pagination variables. editing a post that isn't
+// listed keeps the digest.
+static bool
+hash_listing(bm_manifest_t *manifest, bm_ctx_t *ctx,
+    bc_hashmap_t *global_variables, bc_hashmap_t *local_variables,
+    bc_slist_t *sources, uint64_t *hash)
+{
+    if (sources == NULL)
+        return true;
+
+    pthread_mutex_lock(&manifest->posts_mutex);
+    if (manifest->posts != NULL && manifest->posts->sources != sources) {
+        free_posts(manifest->posts);
+        manifest->posts = NULL;
+    }
+    if (manifest->posts == NULL)
+        manifest->posts = new_posts(ctx, sources);
+
+    manifest_posts_t *p = manifest->posts;
+    bool rv = !p->failed;
+    if (!rv)
+        goto cleanup;
+
+    size_t *posts = NULL;
+    size_t len = p->len;
+    const char *filter_tag = lookup_variable(global_variables,
+        local_variables, "FILTER_TAG");
+    if (filter_tag != NULL) {
+        manifest_tag_t *tag = bc_hashmap_lookup(p->tags, filter_tag);
+        posts = tag != NULL ? tag->posts : NULL;
+        len = tag != NULL ? tag->len : 0;
+    }
+
+    size_t start = 0;
+    size_t end = len;
+    const char *filter_page = lookup_variable(global_variables,
+        local_variables, "FILTER_PAGE");
+    if (filter_page != NULL) {
+        const char *filter_per_page = lookup_variable(global_variables,
+            local_variables, "FILTER_PER_PAGE");
+        long page = strtol(filter_page, NULL, 10);
+        if (page <= 0)
+            page = 1;
+        long per_page = strtol(filter_per_page != NULL ? filter_per_page :
+            "10", NULL, 10);
+        if (per_page < 0)
+            per_page = 0;
+        start = (page - 1) * per_page;
+        end = start + per_page;
+    }
+
+    bool reverse = NULL != lookup_variable(global_variables, local_variables,
+        "FILTER_REVERSE");
+
+    *hash = hash_u64(*hash, len);
+    for (size_t i = start; i < end && i < len; i++) {
+        size_t j = reverse ? len - i - 1 : i;
+        if (posts != NULL)
+            j = posts[j];
+        uint64_t h;
+        if (!file_hash(manifest, ctx, p->posts[j], &h)) {
+            rv = false;
+            break;
+        }
+        *hash = hash_str(*hash, p->posts[j]->short_path);
+        *hash = hash_u64(*hash, h);
+    }
+
+cleanup:
+    pthread_mutex_unlock(&manifest->posts_mutex);
+    return rv;
+}
+
+
+// the digest of an output covers everything that goes into building it. the
+// settings file covers the [global] variables, tags, locale and anything else
+// that isn't passed explicitly. returns NULL if some input can't be read, so
+// that blogc gets called and reports the error.
+char*
+bm_manifest_digest(bm_manifest_t *manifest, bm_ctx_t *ctx,
+    bc_hashmap_t *global_variables, bc_hashmap_t *local_variables,
+    bool listing, bm_filectx_t *template, bc_slist_t *sources,
+    bool only_first_source)
+{
+    if (manifest == NULL || ctx == NULL)
+        return NULL;
+
+    uint64_t rv = hash_str(HASH_INIT, PACKAGE_VERSION);
+    rv = hash_str(rv, ctx->blogc);
+    rv = hash_str(rv, ctx->dev ? "dev" : "");
+    rv = hash_str(rv, listing ? "listing" : "");
+
+    uint64_t h;
+    if (!file_hash(manifest, ctx, ctx->settings_fctx, &h))
+        return NULL;
+    rv = hash_u64(rv, h);
+
+    if (template != NULL) {
+        if (!file_hash(manifest, ctx, template, &h))
+            return NULL;
+        rv = hash_u64(rv, h);
+    }
+
+    rv = hash_variables(rv, global_variables);
+    rv = hash_variables(rv, local_variables);
+
+    if (listing) {
+        if (!hash_listing(manifest, ctx, global_variables, local_variables,
+                sources, &rv))
+            return NULL;
+        return bc_strdup_printf("%016" PRIx64, rv);
+    }
+
+    for (bc_slist_t *l = sources; l != NULL; l = l->next) {
+        bm_filectx_t *fctx = l->data;
+        if (!file_hash(manifest, ctx, fctx, &h))
+            return NULL;
+        rv = hash_str(rv, fctx->short_path);
+        rv = hash_u64(rv, h);
+        if (only_first_source)
+            break;
+    }
+
+    return bc_strdup_printf("%016" PRIx64, rv);
+}
+
+
+bool
+bm_manifest_check(bm_manifest_t *manifest, const char *output,
+    const char *digest)
+{
+    if (manifest == NULL || output == NULL || digest == NULL)
+        return false;
+
+    pthread_mutex_lock(&manifest->mutex);
+    const char *d = bc_hashmap_lookup(manifest->outputs, output);
+    bool rv = d != NULL && 0 == strcmp(d, digest);
+    pthread_mutex_unlock(&manifest->mutex);
+    return rv;
+}
+
+
+void
+bm_manifest_record(bm_manifest_t *manifest, const char *output,
+    const char *digest)
+{
+    if (manifest == NULL || output == NULL || digest == NULL ||
+        NULL != strchr(output, '\n'))
+        return;
+
+    pthread_mutex_lock(&manifest->mutex);
+    const char *d = bc_hashmap_lookup(manifest->outputs, output);
+    if (d == NULL || 0 != strcmp(d, digest)) {
+        bc_hashmap_insert(manifest->outputs, output, bc_strdup(digest));
+        manifest->dirty = true;
+    }
+    pthread_mutex_unlock(&manifest->mutex);
+}
+
+
+static void
+list_file(const char *key, manifest_file_t *f, bc_string_t *str)
+{
+    bc_string_append_printf(str, "F %016" PRIx64 " %lld %ld %s\n", f->hash,
+        f->tv_sec, f->tv_nsec, key);
+}
+
+
+static void
+list_output(const char *key, const char *digest, bc_string_t *str)
+{
+    bc_string_append_printf(str, "O %s %s\n", digest, key);
+}
+
+
+// the manifest is written to a temporary file and renamed, so an interrupted
+// build never leaves a truncated manifest behind. saving ends a build, so what
+// was learned about the posts is dropped, as they may change before the next
+// one.
+bool
+bm_manifest_save(bm_manifest_t *manifest)
+{
+    if (manifest == NULL)
+        return true;
+
+    pthread_mutex_lock(&manifest->posts_mutex);
+    free_posts(manifest->posts);
+    manifest->posts = NULL;
+    pthread_mutex_unlock(&manifest->posts_mutex);
+
+    pthread_mutex_lock(&manifest->mutex);
+    if (!manifest->dirty) {
+        pthread_mutex_unlock(&manifest->mutex);
+        return true;
+    }
+    bc_string_t *str = bc_string_new();
+    bc_string_append(str, MANIFEST_HEADER "\n");
+    bc_hashmap_foreach(manifest->files, (bc_hashmap_foreach_func_t) list_file,
+        str);
+    bc_hashmap_foreach(manifest->outputs,
+        (bc_hashmap_foreach_func_t) list_output, str);
+    manifest->dirty = false;
+    pthread_mutex_unlock(&manifest->mutex);
+
+    char *tmp = bc_strdup_printf("%s.tmp", manifest->path);
+    bool rv = false;
+    FILE *fp = fopen(tmp, "w");
+    if (fp != NULL) {
+        size_t n = fwrite(str->str, sizeof(char), str->len, fp);
+        if (0 == fclose(fp) && n == str->len &&
+            0 == rename(tmp, manifest->path))
+            rv = true;
+    }
+    if (!rv) {
+        fprintf(stderr, "blogc-make: warning: failed to save build manifest "
+            "(%s): %s\n", manifest->path, strerror(errno));
+        unlink(tmp);
+    }
+    free(tmp);
+    bc_string_free(str, true);
+    return rv;
+}
+
+
+// forgets everything, and removes the manifest file. used when cleaning the
+// output directory.
+void
+bm_manifest_clear(bm_manifest_t *manifest)
+{
+    if (manifest == NULL)
+        return;
+
+    pthread_mutex_lock(&manifest->posts_mutex);
+    free_posts(manifest->posts);
+    manifest->posts = NULL;
+    pthread_mutex_unlock(&manifest->posts_mutex);
+
+    pthread_mutex_lock(&manifest->mutex);
+    bc_hashmap_free(manifest->files);
+    bc_hashmap_free(manifest->outputs);
+    manifest->files = bc_hashmap_new(free);
+    manifest->outputs = bc_hashmap_new(free);
+    manifest->dirty = false;
+    if (0 != unlink(manifest->path) && errno != ENOENT)
+        fprintf(stderr, "blogc-make: warning: failed to remove build manifest "
+            "(%s): %s\n", manifest->path, strerror(errno));
+    pthread_mutex_unlock(&manifest->mutex);
+}
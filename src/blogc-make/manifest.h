@@ -0,0 +1,33 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+#ifndef _MAKE_MANIFEST_H
+#define _MAKE_MANIFEST_H
+
+#include <stdbool.h>
+#include "../common/utils.h"
+#include "ctx.h"
+
+#define BM_MANIFEST_FILENAME ".blogc-make-manifest"
+
+typedef struct bm_manifest bm_manifest_t;
+
+bm_manifest_t* bm_manifest_new(const char *path);
+void bm_manifest_free(bm_manifest_t *manifest);
+char* bm_manifest_digest(bm_manifest_t *manifest, bm_ctx_t *ctx,
+    bc_hashmap_t *global_variables, bc_hashmap_t *local_variables,
+    bool listing, bm_filectx_t *template, bc_slist_t *sources,
+    bool only_first_source);
+bool bm_manifest_check(bm_manifest_t *manifest, const char *output,
+    const char *digest);
+void bm_manifest_record(bm_manifest_t *manifest, const char *output,
+    const char *digest);
+bool bm_manifest_save(bm_manifest_t *manifest);
+void bm_manifest_clear(bm_manifest_t *manifest);
+
+#endif /* _MAKE_MANIFEST_H */
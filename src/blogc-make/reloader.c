@@ -6,6 +6,10 @@
  * See the file LICENSE.
  */
 
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif /* HAVE_CONFIG_H */
+
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -14,6 +18,16 @@
 #include <unistd.h>
 #include <pthread.h>
 #include <errno.h>
+
+#if defined(HAVE_SYS_INOTIFY_H) && defined(HAVE_POLL_H)
+#define WATCH_INOTIFY
+#include <dirent.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <time.h>
+#endif
+
 #include "../common/utils.h"
 #include "ctx.h"
 #include "rules.h"
@@ -34,9 +48,429 @@ sig_handler(int signum)
 }
 
 
+#ifdef WATCH_INOTIFY
+
+#define WATCH_EVENTS (IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | \
+    IN_MODIFY | IN_MOVED_FROM | IN_MOVED_TO)
+#define WATCH_BUFFER_SIZE 8192
+
+// changes usually come in bursts, e.g. an editor writing a temporary file and
+// renaming it, or a checkout. we wait until no changes are seen for
+// WATCH_DEBOUNCE_MS before rebuilding, but no longer than WATCH_DEBOUNCE_MAX_MS
+// after the first one.
+#define WATCH_DEBOUNCE_MS 100
+#define WATCH_DEBOUNCE_MAX_MS 1000
+
+typedef struct {
+    char *path;
+    bool recursive;
+} watch_t;
+
+typedef struct {
+    int fd;
+
+    // watch descriptors are small integers, mapped to the directories with a
+    // plain array.
+    watch_t *watches;
+    size_t watches_len;
+
+    // paths changed since the last rebuild
+    bc_hashmap_t *changed;
+
+    // something happened that requires reading the settings and listing the
+    // source files again.
+    bool rescan;
+} watcher_t;
+
+
+static void
+watcher_close(watcher_t *w)
+{
+    if (w->fd != -1)
+        close(w->fd);
+    w->fd = -1;
+    for (size_t i = 0; i < w->watches_len; i++)
+        free(w->watches[i].path);
+    free(w->watches);
+    w->watches = NULL;
+    w->watches_len = 0;
+}
+
+
+// inotify watches aren't recursive, every directory below the content,
+// template and copy directories needs its own watch. directories that don't
+// exist are just skipped, creating them changes the root directory, and the
+// watches are set up again.
+static bool
+watcher_add(watcher_t *w, const char *path, bool recursive)
+{
+    int wd = inotify_add_watch(w->fd, path, WATCH_EVENTS | IN_ONLYDIR);
+    if (wd < 0) {
+        if (errno == ENOENT || errno == ENOTDIR)
+            return true;
+        fprintf(stderr, "blogc-make: warning: failed to watch directory "
+            "(%s): %s\n", path, strerror(errno));
+        return false;
+    }
+
+    if ((size_t) wd >= w->watches_len) {
+        size_t len = w->watches_len > 0 ? w->watches_len : 64;
+        while (len <= (size_t) wd)
+            len <<= 1;
+        w->watches = bc_realloc(w->watches, len * sizeof(watch_t));
+        for (size_t i = w->watches_len; i < len; i++) {
+            w->watches[i].path = NULL;
+            w->watches[i].recursive = false;
+        }
+        w->watches_len = len;
+    }
+
+    // the same directory gets the same watch descriptor. the root directory
+    // may be the content directory too, it is watched recursively then.
+    if (w->watches[wd].path != NULL && w->watches[wd].recursive)
+        recursive = true;
+    free(w->watches[wd].path);
+    w->watches[wd].path = bc_strdup(path);
+    w->watches[wd].recursive = recursive;
+
+    if (!recursive)
+        return true;
+
+    DIR *dir = opendir(path);
+    if (dir == NULL)
+        return true;
+
+    bool rv = true;
+    struct dirent *d;
+    while (rv && (d = readdir(dir)) != NULL) {
+        if (0 == strcmp(d->d_name, ".") || 0 == strcmp(d->d_name, ".."))
+            continue;
+        char *child = bc_strdup_printf("%s/%s", path, d->d_name);
+        struct stat st;
+        if (0 == lstat(child, &st) && S_ISDIR(st.st_mode))
+            rv = watcher_add(w, child, true);
+        free(child);
+    }
+    closedir(dir);
+    return rv;
+}
+
+
+static char*
+watcher_path(bm_ctx_t *ctx, const char *filename)
+{
+    return filename[0] == '/' ? bc_strdup(filename) :
+        bc_strdup_printf("%s/%s", ctx->root_dir, filename);
+}
+
+
+// watches are paths built the same way as the paths of the source files, so
+// they can be compared as plain strings.
+static bool
+watcher_setup(watcher_t *w, bm_ctx_t *ctx)
+{
+    watcher_close(w);
+    w->rescan = false;
+
+    w->fd = inotify_init1(IN_CLOEXEC);
+    if (w->fd == -1) {
+        fprintf(stderr, "blogc-make: warning: failed to initialize inotify: "
+            "%s\n", strerror(errno));
+        return false;
+    }
+
+    // the settings file is usually replaced by editors, its directory must be
+    // watched instead.
+    if (!watcher_add(w, ctx->root_dir, false))
+        return false;
+
+    const char *dirs[] = {"content_dir", "template_dir", NULL};
+    for (size_t i = 0; dirs[i] != NULL; i++) {
+        char *path = watcher_path(ctx,
+            bc_hashmap_lookup(ctx->settings->settings, dirs[i]));
+        bool ok = watcher_add(w, path, true);
+        free(path);
+        if (!ok)
+            return false;
+    }
+
+    if (ctx->settings->copy == NULL)
+        return true;
+
+    for (size_t i = 0; ctx->settings->copy[i] != NULL; i++) {
+        char *path = watcher_path(ctx, ctx->settings->copy[i]);
+        struct stat st;
+        bool ok = true;
+        if (0 == stat(path, &st) && S_ISDIR(st.st_mode)) {
+            ok = watcher_add(w, path, true);
+        }
+        else {
+            char *slash = strrchr(path, '/');
+            if (slash != NULL && slash != path) {
+                *slash = '\0';
+                ok = watcher_add(w, path, false);
+            }
+        }
+        free(path);
+        if (!ok)
+            return false;
+    }
+
+    return true;
+}
+
+
+static long long
+now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+// returns the number of events read, 0 on timeout and -1 on errors.
+static int
+watcher_read(watcher_t *w, bm_ctx_t *ctx, int timeout)
+{
+    struct pollfd pfd = {.fd = w->fd, .events = POLLIN};
+    int n = poll(&pfd, 1, timeout);
+    if (n < 0 && errno == EINTR)
+        return 0;
+    if (n <= 0)
+        return n;
+
+    char buffer[WATCH_BUFFER_SIZE]
+        __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t len = read(w->fd, buffer, sizeof(buffer));
+    if (len < 0 && (errno == EINTR || errno == EAGAIN))
+        return 0;
+    if (len <= 0) {
+        fprintf(stderr, "blogc-make: warning: failed to read changes: %s\n",
+            len == 0 ? "EOF" : strerror(errno));
+        return -1;
+    }
+
+    int rv = 0;
+    for (char *p = buffer; p < buffer + len; rv++) {
+        const struct inotify_event *ev = (const struct inotify_event*) p;
+        p += sizeof(struct inotify_event) + ev->len;
+
+        // events were lost, anything may have changed
+        if (ev->mask & IN_Q_OVERFLOW) {
+            w->rescan = true;
+            continue;
+        }
+
+        if (ev->wd < 0 || (size_t) ev->wd >= w->watches_len ||
+            w->watches[ev->wd].path == NULL)
+            continue;
+
+        watch_t *watch = &w->watches[ev->wd];
+
+        if (ev->mask & IN_IGNORED) {
+            free(watch->path);
+            watch->path = NULL;
+            continue;
+        }
+
+        if (ev->len == 0)
+            continue;
+
+        char *path = bc_strdup_printf("%s/%s", watch->path, ev->name);
+
+        // directories created, moved or removed outside of the watched trees
+        // may be the content or template directories, or directories with
+        // files to copy. the output directory is created by the build itself.
+        if (ev->mask & IN_ISDIR) {
+            if (watch->recursive) {
+                if ((ev->mask & (IN_CREATE | IN_MOVED_TO)) &&
+                    !watcher_add(w, path, true))
+                {
+                    free(path);
+                    return -1;
+                }
+            }
+            else if (0 != strcmp(path, ctx->output_dir)) {
+                w->rescan = true;
+            }
+        }
+
+        // only the keys matter, but values can't be NULL
+        bc_hashmap_insert(w->changed, path, w);
+        free(path);
+    }
+    return rv;
+}
+
+
+static bool
+watcher_reload(bc_slist_t *l, const char *path)
+{
+    for (; l != NULL; l = l->next) {
+        bm_filectx_t *fctx = l->data;
+        if (0 == strcmp(fctx->path, path)) {
+            bm_filectx_reload(fctx);
+            return true;
+        }
+    }
+    return false;
+}
+
+
+typedef struct {
+    watcher_t *watcher;
+    bm_ctx_t *ctx;
+    int changed;
+} watcher_changes_t;
+
+
+// only the source files that changed are checked again, instead of all of
+// them, and only the rules built from them are run.
+static void
+watcher_change(const char *path, void *data, watcher_changes_t *c)
+{
+    bm_ctx_t *ctx = c->ctx;
+
+    if (0 == strcmp(path, ctx->settings_fctx->path)) {
+        c->watcher->rescan = true;
+        return;
+    }
+
+    if (0 == strcmp(path, ctx->main_template_fctx->path)) {
+        bm_filectx_reload(ctx->main_template_fctx);
+        c->changed |= BM_RULE_DEPENDS_TEMPLATE;
+        return;
+    }
+
+    if (watcher_reload(ctx->posts_fctx, path)) {
+        c->changed |= BM_RULE_DEPENDS_POSTS;
+        return;
+    }
+    if (watcher_reload(ctx->pages_fctx, path)) {
+        c->changed |= BM_RULE_DEPENDS_PAGES;
+        return;
+    }
+    if (watcher_reload(ctx->copy_fctx, path)) {
+        c->changed |= BM_RULE_DEPENDS_COPY;
+        return;
+    }
+
+    // files created or removed in a directory to copy change the list of
+    // files to copy.
+    if (ctx->settings->copy == NULL)
+        return;
+    for (size_t i = 0; ctx->settings->copy[i] != NULL; i++) {
+        char *copy = watcher_path(ctx, ctx->settings->copy[i]);
+        size_t len = strlen(copy);
+        bool found = 0 == strncmp(path, copy, len) &&
+            (path[len] == '\0' || path[len] == '/');
+        free(copy);
+        if (found) {
+            c->watcher->rescan = true;
+            return;
+        }
+    }
+}
+
+
+// returns false if the source files can't be watched anymore, so that the
+// reloader goes back to checking them every second.
+static bool
+watcher_run(bm_ctx_t **ctx, bm_rule_exec_func_t rule_exec,
+    bc_slist_t *outputs, bc_hashmap_t *args)
+{
+    watcher_t w = {
+        .fd = -1,
+        .watches = NULL,
+        .watches_len = 0,
+        .changed = bc_hashmap_new(NULL),
+        .rescan = false,
+    };
+
+    bool rv = false;
+    bool reload = false;
+    bool full = true;
+    int changed = 0;
+
+    if (!watcher_setup(&w, *ctx))
+        goto cleanup;
+
+    while (running) {
+        if (reload) {
+            if (!bm_ctx_rescan(ctx)) {
+                fprintf(stderr, "blogc-make: warning: failed to reload "
+                    "context. waiting for changes ...\n\n");
+                goto wait;
+            }
+            if (!watcher_setup(&w, *ctx))
+                goto cleanup;
+            reload = false;
+            full = true;
+        }
+
+        // a failed build is retried in full, as any rule may have failed.
+        if (full || changed != 0) {
+            int status = full ? rule_exec(*ctx, outputs, args) :
+                bm_rule_execute_changed(*ctx, changed);
+            full = status != 0;
+            changed = 0;
+            if (full)
+                fprintf(stderr, "blogc-make: warning: failed to rebuild "
+                    "website. waiting for changes ...\n\n");
+        }
+
+wait:
+
+        // the timeout is only needed to notice that the reloader was stopped
+        // from another thread, e.g. when the runserver exits.
+        while (running) {
+            int n = watcher_read(&w, *ctx, 1000);
+            if (n < 0)
+                goto cleanup;
+            if (n > 0)
+                break;
+        }
+
+        long long deadline = now_ms() + WATCH_DEBOUNCE_MAX_MS;
+        while (running) {
+            long long left = deadline - now_ms();
+            if (left <= 0)
+                break;
+            int n = watcher_read(&w, *ctx,
+                left < WATCH_DEBOUNCE_MS ? left : WATCH_DEBOUNCE_MS);
+            if (n < 0)
+                goto cleanup;
+            if (n == 0)
+                break;
+        }
+
+        if (!w.rescan) {
+            watcher_changes_t c = {.watcher = &w, .ctx = *ctx, .changed = 0};
+            bc_hashmap_foreach(w.changed,
+                (bc_hashmap_foreach_func_t) watcher_change, &c);
+            changed |= c.changed;
+        }
+        reload = reload || w.rescan;
+
+        bc_hashmap_free(w.changed);
+        w.changed = bc_hashmap_new(NULL);
+    }
+
+    rv = true;
+
+cleanup:
+    watcher_close(&w);
+    bc_hashmap_free(w.changed);
+    return rv;
+}
+
+#endif /* WATCH_INOTIFY */
+
+
 int
 bm_reloader_run(bm_ctx_t **ctx, bm_rule_exec_func_t rule_exec,
-    bc_slist_t *outputs, bc_trie_t *args)
+    bc_slist_t *outputs, bc_hashmap_t *args)
 {
     // install ^C handler
     struct sigaction current_action;
@@ -66,6 +500,13 @@ bm_reloader_run(bm_ctx_t **ctx, bm_rule_exec_func_t rule_exec,
     running = true;
     pthread_mutex_unlock(&mutex_running);
 
+#ifdef WATCH_INOTIFY
+    if (watcher_run(ctx, rule_exec, outputs, args))
+        return reloader_status_code;
+    fprintf(stderr, "blogc-make: warning: failed to watch source files, "
+        "checking for changes every second\n\n");
+#endif /* WATCH_INOTIFY */
+
     while (running) {
         if (!bm_ctx_reload(ctx)) {
             fprintf(stderr, "blogc-make: warning: failed to reload context. "
@@ -14,7 +14,7 @@
 #include "rules.h"
 
 int bm_reloader_run(bm_ctx_t **ctx, bm_rule_exec_func_t rule_exec,
-    bc_slist_t *outputs, bc_trie_t *args);
+    bc_slist_t *outputs, bc_hashmap_t *args);
 void bm_reloader_stop(int status_code);
 
 #endif /* _MAKE_RELOADER_H */
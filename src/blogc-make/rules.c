@@ -17,38 +17,257 @@
 #include "exec.h"
 #include "exec-native.h"
 #include "httpd.h"
+#include "jobs.h"
+#include "manifest.h"
 #include "reloader.h"
 #include "settings.h"
 #include "rules.h"
 
 
+// JOBS
+//
+// outputs are independent from each other, so when running with -j they are
+// pushed to the job pool instead of being built right away. jobs take copies
+// of everything that may change or be freed before they run. sources and
+// templates are owned by the context and kept untouched until the build ends.
+//
+// outputs are only built if their mtimes say so. the build manifest then
+// checks if the contents of their inputs changed since the last build, so
+// outputs aren't rebuilt after something like a checkout touches every file.
+// listing outputs are newer than every post they depend on only until some
+// post changes, so for them the manifest only checks the posts they list.
+// outputs found up to date by the manifest get the mtime of their newest
+// input, so the next build doesn't need to hash anything again. outputs that
+// must be built are hashed by their jobs.
+
+typedef struct {
+    bm_ctx_t *ctx;
+    bc_hashmap_t *global_variables;
+    bc_hashmap_t *local_variables;
+    bool listing;
+    bm_filectx_t *template;
+    bm_filectx_t *output;
+    bc_slist_t *sources;
+    bool only_first_source;
+    char *digest;
+} blogc_job_t;
+
+typedef struct {
+    bm_ctx_t *ctx;
+    bc_slist_t *source;
+    bm_filectx_t *dest;
+    char *digest;
+} copy_job_t;
+
+
+static void
+copy_variable(const char *key, const char *value, bc_hashmap_t *variables)
+{
+    bc_hashmap_insert(variables, key, bc_strdup(value));
+}
+
+
+static bc_hashmap_t*
+copy_variables(bc_hashmap_t *variables)
+{
+    if (variables == NULL)
+        return NULL;
+    bc_hashmap_t *rv = bc_hashmap_new(free);
+    bc_hashmap_foreach(variables, (bc_hashmap_foreach_func_t) copy_variable, rv);
+    return rv;
+}
+
+
+// the inputs of an output, in the order they are checked.
+static bc_slist_t*
+input_list(bm_filectx_t *settings, bm_filectx_t *template, bc_slist_t *sources,
+    bool only_first_source)
+{
+    bc_slist_t *rv = NULL;
+    if (settings != NULL)
+        rv = bc_slist_append(rv, settings);
+    if (template != NULL)
+        rv = bc_slist_append(rv, template);
+
+    for (bc_slist_t *l = sources; l != NULL; l = l->next) {
+        rv = bc_slist_append(rv, l->data);
+        if (only_first_source)
+            break;
+    }
+    return rv;
+}
+
+
+// outputs that don't exist yet can't be up to date, so their digests are only
+// computed when building them, by the job itself.
+static int
+blogc_job_run(blogc_job_t *job)
+{
+    if (job->digest == NULL)
+        job->digest = bm_manifest_digest(job->ctx->manifest, job->ctx,
+            job->global_variables, job->local_variables, job->listing,
+            job->template, job->sources, job->only_first_source);
+    int rv = bm_exec_blogc(job->ctx, job->global_variables,
+        job->local_variables, job->listing, job->template, job->output,
+        job->sources, job->only_first_source);
+    if (rv == 0)
+        bm_manifest_record(job->ctx->manifest, job->output->short_path,
+            job->digest);
+    return rv;
+}
+
+
+static void
+blogc_job_free(blogc_job_t *job)
+{
+    if (job == NULL)
+        return;
+    bc_hashmap_free(job->global_variables);
+    bc_hashmap_free(job->local_variables);
+    bm_filectx_free(job->output);
+    free(job->digest);
+    free(job);
+}
+
+
+static int
+run_blogc(bm_ctx_t *ctx, bc_hashmap_t *global_variables, bc_hashmap_t *local_variables,
+    bool listing, bm_filectx_t *template, bm_filectx_t *output, bc_slist_t *sources,
+    bool only_first_source)
+{
+    char *digest = NULL;
+    if (output->readable) {
+        digest = bm_manifest_digest(ctx->manifest, ctx, global_variables,
+            local_variables, listing, template, sources, only_first_source);
+        if (bm_manifest_check(ctx->manifest, output->short_path, digest)) {
+            bc_slist_t *inputs = input_list(ctx->settings_fctx, template,
+                sources, only_first_source);
+            bm_filectx_touch(output, inputs);
+            bc_slist_free(inputs);
+            free(digest);
+            return 0;
+        }
+    }
+
+    blogc_job_t job = {
+        .ctx = ctx,
+        .global_variables = global_variables,
+        .local_variables = local_variables,
+        .listing = listing,
+        .template = template,
+        .output = output,
+        .sources = sources,
+        .only_first_source = only_first_source,
+        .digest = digest,
+    };
+
+    if (ctx->jobs == NULL) {
+        int rv = blogc_job_run(&job);
+        free(job.digest);
+        return rv;
+    }
+
+    blogc_job_t *j = bc_malloc(sizeof(blogc_job_t));
+    *j = job;
+    j->global_variables = copy_variables(global_variables);
+    j->local_variables = copy_variables(local_variables);
+    j->output = bm_filectx_dup(output);
+    return bm_jobs_add(ctx->jobs, (bm_job_func_t) blogc_job_run, j,
+        (bc_free_func_t) blogc_job_free);
+}
+
+
+static int
+copy_job_run(copy_job_t *job)
+{
+    if (job->digest == NULL)
+        job->digest = bm_manifest_digest(job->ctx->manifest, job->ctx, NULL,
+            NULL, false, NULL, job->source, true);
+    int rv = bm_exec_native_cp(job->source->data, job->dest,
+        job->ctx->verbose);
+    if (rv == 0)
+        bm_manifest_record(job->ctx->manifest, job->dest->short_path,
+            job->digest);
+    return rv;
+}
+
+
 static void
-posts_ordering(bm_ctx_t *ctx, bc_trie_t *variables, const char *variable)
+copy_job_free(copy_job_t *job)
+{
+    if (job == NULL)
+        return;
+    bm_filectx_free(job->dest);
+    free(job->digest);
+    free(job);
+}
+
+
+static int
+run_cp(bm_ctx_t *ctx, bc_slist_t *source, bm_filectx_t *dest)
+{
+    char *digest = NULL;
+    if (dest->readable) {
+        digest = bm_manifest_digest(ctx->manifest, ctx, NULL, NULL, false,
+            NULL, source, true);
+        if (bm_manifest_check(ctx->manifest, dest->short_path, digest)) {
+            bc_slist_t *inputs = input_list(ctx->settings_fctx, NULL, source,
+                true);
+            bm_filectx_touch(dest, inputs);
+            bc_slist_free(inputs);
+            free(digest);
+            return 0;
+        }
+    }
+
+    copy_job_t job = {
+        .ctx = ctx,
+        .source = source,
+        .dest = dest,
+        .digest = digest,
+    };
+
+    if (ctx->jobs == NULL) {
+        int rv = copy_job_run(&job);
+        free(job.digest);
+        return rv;
+    }
+
+    copy_job_t *j = bc_malloc(sizeof(copy_job_t));
+    *j = job;
+    j->dest = bm_filectx_dup(dest);
+    return bm_jobs_add(ctx->jobs, (bm_job_func_t) copy_job_run, j,
+        (bc_free_func_t) copy_job_free);
+}
+
+
+static void
+posts_ordering(bm_ctx_t *ctx, bc_hashmap_t *variables, const char *variable)
 {
     if (ctx == NULL || ctx->settings == NULL || ctx->settings->settings == NULL)
         return;  // something is wrong, let's not add any variable
 
-    const char *value = bc_trie_lookup(ctx->settings->settings, variable);
+    const char *value = bc_hashmap_lookup(ctx->settings->settings, variable);
     if (value != NULL && ((0 == strcmp(value, "ASC")) || (0 == strcmp(value, "asc"))))
         return;  // user explicitly asked for ASC
 
-    bc_trie_insert(variables, "FILTER_REVERSE", bc_strdup("1"));
+    bc_hashmap_insert(variables, "FILTER_REVERSE", bc_strdup("1"));
 }
 
 
 static void
-posts_pagination(bm_ctx_t *ctx, bc_trie_t *variables, const char *variable)
+posts_pagination(bm_ctx_t *ctx, bc_hashmap_t *variables, const char *variable)
 {
     if (ctx == NULL || ctx->settings == NULL || ctx->settings->settings == NULL)
         return;  // something is wrong, let's not add any variable
 
     long posts_per_page = strtol(
-        bc_trie_lookup(ctx->settings->settings, variable),
+        bc_hashmap_lookup(ctx->settings->settings, variable),
         NULL, 10);  // FIXME: improve
     if (posts_per_page >= 0) {
-        bc_trie_insert(variables, "FILTER_PAGE", bc_strdup("1"));
-        bc_trie_insert(variables, "FILTER_PER_PAGE",
-            bc_strdup(bc_trie_lookup(ctx->settings->settings, variable)));
+        bc_hashmap_insert(variables, "FILTER_PAGE", bc_strdup("1"));
+        bc_hashmap_insert(variables, "FILTER_PER_PAGE",
+            bc_strdup(bc_hashmap_lookup(ctx->settings->settings, variable)));
     }
 }
 
@@ -60,7 +279,7 @@ posts_pagination_enabled(bm_ctx_t *ctx, const  char *variable)
         return false;
 
     long posts_per_page = strtol(
-        bc_trie_lookup(ctx->settings->settings, variable),
+        bc_hashmap_lookup(ctx->settings->settings, variable),
         NULL, 10);  // FIXME: improve
     return posts_per_page != 0;
 }
@@ -78,9 +297,9 @@ index_outputlist(bm_ctx_t *ctx)
         return NULL;
 
     bc_slist_t *rv = NULL;
-    const char *html_ext = bc_trie_lookup(ctx->settings->settings,
+    const char *html_ext = bc_hashmap_lookup(ctx->settings->settings,
         "html_ext");
-    const char *index_prefix = bc_trie_lookup(ctx->settings->settings,
+    const char *index_prefix = bc_hashmap_lookup(ctx->settings->settings,
         "index_prefix");
     bool is_index = (index_prefix == NULL) && (html_ext[0] == '/');
     char *f = bc_strdup_printf("%s%s%s%s", ctx->short_output_dir,
@@ -92,20 +311,20 @@ index_outputlist(bm_ctx_t *ctx)
 }
 
 static int
-index_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_trie_t *args)
+index_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_hashmap_t *args)
 {
     if (ctx == NULL || ctx->settings->posts == NULL)
         return 0;
 
     int rv = 0;
 
-    bc_trie_t *variables = bc_trie_new(free);
+    bc_hashmap_t *variables = bc_hashmap_new(free);
     posts_pagination(ctx, variables, "posts_per_page");
     posts_ordering(ctx, variables, "html_order");
-    bc_trie_insert(variables, "DATE_FORMAT",
-        bc_strdup(bc_trie_lookup(ctx->settings->settings, "date_format")));
-    bc_trie_insert(variables, "MAKE_RULE", bc_strdup("index"));
-    bc_trie_insert(variables, "MAKE_TYPE", bc_strdup("post"));
+    bc_hashmap_insert(variables, "DATE_FORMAT",
+        bc_strdup(bc_hashmap_lookup(ctx->settings->settings, "date_format")));
+    bc_hashmap_insert(variables, "MAKE_RULE", bc_strdup("index"));
+    bc_hashmap_insert(variables, "MAKE_TYPE", bc_strdup("post"));
 
     for (bc_slist_t *l = outputs; l != NULL; l = l->next) {
         bm_filectx_t *fctx = l->data;
@@ -114,14 +333,14 @@ index_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_trie_t *args)
         if (bm_rule_need_rebuild(ctx->posts_fctx, ctx->settings_fctx,
                 ctx->main_template_fctx, fctx, false))
         {
-            rv = bm_exec_blogc(ctx, variables, NULL, true, ctx->main_template_fctx,
+            rv = run_blogc(ctx, variables, NULL, true, ctx->main_template_fctx,
                 fctx, ctx->posts_fctx, false);
             if (rv != 0)
                 break;
         }
     }
 
-    bc_trie_free(variables);
+    bc_hashmap_free(variables);
 
     return rv;
 }
@@ -139,9 +358,9 @@ atom_outputlist(bm_ctx_t *ctx)
         return NULL;
 
     bc_slist_t *rv = NULL;
-    const char *atom_prefix = bc_trie_lookup(ctx->settings->settings,
+    const char *atom_prefix = bc_hashmap_lookup(ctx->settings->settings,
         "atom_prefix");
-    const char *atom_ext = bc_trie_lookup(ctx->settings->settings, "atom_ext");
+    const char *atom_ext = bc_hashmap_lookup(ctx->settings->settings, "atom_ext");
     char *f = bc_strdup_printf("%s/%s%s", ctx->short_output_dir,
         atom_prefix, atom_ext);
     rv = bc_slist_append(rv, bm_filectx_new(ctx, f, NULL, NULL));
@@ -150,19 +369,19 @@ atom_outputlist(bm_ctx_t *ctx)
 }
 
 static int
-atom_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_trie_t *args)
+atom_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_hashmap_t *args)
 {
     if (ctx == NULL || ctx->settings->posts == NULL)
         return 0;
 
     int rv = 0;
 
-    bc_trie_t *variables = bc_trie_new(free);
+    bc_hashmap_t *variables = bc_hashmap_new(free);
     posts_pagination(ctx, variables, "atom_posts_per_page");
     posts_ordering(ctx, variables, "atom_order");
-    bc_trie_insert(variables, "DATE_FORMAT", bc_strdup("%Y-%m-%dT%H:%M:%SZ"));
-    bc_trie_insert(variables, "MAKE_RULE", bc_strdup("atom"));
-    bc_trie_insert(variables, "MAKE_TYPE", bc_strdup("atom"));
+    bc_hashmap_insert(variables, "DATE_FORMAT", bc_strdup("%Y-%m-%dT%H:%M:%SZ"));
+    bc_hashmap_insert(variables, "MAKE_RULE", bc_strdup("atom"));
+    bc_hashmap_insert(variables, "MAKE_TYPE", bc_strdup("atom"));
 
     for (bc_slist_t *l = outputs; l != NULL; l = l->next) {
         bm_filectx_t *fctx = l->data;
@@ -171,14 +390,14 @@ atom_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_trie_t *args)
         if (bm_rule_need_rebuild(ctx->posts_fctx, ctx->settings_fctx, NULL,
                 fctx, false))
         {
-            rv = bm_exec_blogc(ctx, variables, NULL, true, ctx->atom_template_fctx,
+            rv = run_blogc(ctx, variables, NULL, true, ctx->atom_template_fctx,
                 fctx, ctx->posts_fctx, false);
             if (rv != 0)
                 break;
         }
     }
 
-    bc_trie_free(variables);
+    bc_hashmap_free(variables);
 
     return rv;
 }
@@ -196,9 +415,9 @@ atom_tags_outputlist(bm_ctx_t *ctx)
         return NULL;
 
     bc_slist_t *rv = NULL;
-    const char *atom_prefix = bc_trie_lookup(ctx->settings->settings,
+    const char *atom_prefix = bc_hashmap_lookup(ctx->settings->settings,
         "atom_prefix");
-    const char *atom_ext = bc_trie_lookup(ctx->settings->settings, "atom_ext");
+    const char *atom_ext = bc_hashmap_lookup(ctx->settings->settings, "atom_ext");
     for (size_t i = 0; ctx->settings->tags[i] != NULL; i++) {
         char *f = bc_strdup_printf("%s/%s/%s%s", ctx->short_output_dir,
             atom_prefix, ctx->settings->tags[i], atom_ext);
@@ -209,7 +428,7 @@ atom_tags_outputlist(bm_ctx_t *ctx)
 }
 
 static int
-atom_tags_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_trie_t *args)
+atom_tags_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_hashmap_t *args)
 {
     if (ctx == NULL || ctx->settings->posts == NULL || ctx->settings->tags == NULL)
         return 0;
@@ -217,32 +436,32 @@ atom_tags_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_trie_t *args)
     int rv = 0;
     size_t i = 0;
 
-    bc_trie_t *variables = bc_trie_new(free);
+    bc_hashmap_t *variables = bc_hashmap_new(free);
     posts_pagination(ctx, variables, "atom_posts_per_page");
     posts_ordering(ctx, variables, "atom_order");
-    bc_trie_insert(variables, "DATE_FORMAT", bc_strdup("%Y-%m-%dT%H:%M:%SZ"));
-    bc_trie_insert(variables, "MAKE_RULE", bc_strdup("atom_tags"));
-    bc_trie_insert(variables, "MAKE_TYPE", bc_strdup("atom"));
+    bc_hashmap_insert(variables, "DATE_FORMAT", bc_strdup("%Y-%m-%dT%H:%M:%SZ"));
+    bc_hashmap_insert(variables, "MAKE_RULE", bc_strdup("atom_tags"));
+    bc_hashmap_insert(variables, "MAKE_TYPE", bc_strdup("atom"));
 
     for (bc_slist_t *l = outputs; l != NULL; l = l->next, i++) {
         bm_filectx_t *fctx = l->data;
         if (fctx == NULL)
             continue;
 
-        bc_trie_insert(variables, "FILTER_TAG",
+        bc_hashmap_insert(variables, "FILTER_TAG",
             bc_strdup(ctx->settings->tags[i]));
 
         if (bm_rule_need_rebuild(ctx->posts_fctx, ctx->settings_fctx, NULL,
                 fctx, false))
         {
-            rv = bm_exec_blogc(ctx, variables, NULL, true, ctx->atom_template_fctx,
+            rv = run_blogc(ctx, variables, NULL, true, ctx->atom_template_fctx,
                 fctx, ctx->posts_fctx, false);
             if (rv != 0)
                 break;
         }
     }
 
-    bc_trie_free(variables);
+    bc_hashmap_free(variables);
 
     return rv;
 }
@@ -259,7 +478,7 @@ pagination_outputlist(bm_ctx_t *ctx)
     // not using posts_pagination_enabled() here because we need to calculate
     // posts per page here anyway, and the condition is different.
     long posts_per_page = strtol(
-        bc_trie_lookup(ctx->settings->settings, "posts_per_page"),
+        bc_hashmap_lookup(ctx->settings->settings, "posts_per_page"),
         NULL, 10);  // FIXME: improve
     if (posts_per_page <= 0)
         return NULL;
@@ -267,9 +486,9 @@ pagination_outputlist(bm_ctx_t *ctx)
     long num_posts = bc_slist_length(ctx->posts_fctx);
     size_t pages = ceilf(((float) num_posts) / posts_per_page);
 
-    const char *pagination_prefix = bc_trie_lookup(ctx->settings->settings,
+    const char *pagination_prefix = bc_hashmap_lookup(ctx->settings->settings,
         "pagination_prefix");
-    const char *html_ext = bc_trie_lookup(ctx->settings->settings,
+    const char *html_ext = bc_hashmap_lookup(ctx->settings->settings,
         "html_ext");
 
     bc_slist_t *rv = NULL;
@@ -283,7 +502,7 @@ pagination_outputlist(bm_ctx_t *ctx)
 }
 
 static int
-pagination_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_trie_t *args)
+pagination_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_hashmap_t *args)
 {
     if (ctx == NULL || ctx->settings->posts == NULL)
         return 0;
@@ -291,33 +510,33 @@ pagination_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_trie_t *args)
     int rv = 0;
     size_t page = 1;
 
-    bc_trie_t *variables = bc_trie_new(free);
+    bc_hashmap_t *variables = bc_hashmap_new(free);
     // not using posts_pagination because we set FILTER_PAGE anyway, and the
     // first value inserted in that function would be useless
-    bc_trie_insert(variables, "FILTER_PER_PAGE",
-        bc_strdup(bc_trie_lookup(ctx->settings->settings, "posts_per_page")));
+    bc_hashmap_insert(variables, "FILTER_PER_PAGE",
+        bc_strdup(bc_hashmap_lookup(ctx->settings->settings, "posts_per_page")));
     posts_ordering(ctx, variables, "html_order");
-    bc_trie_insert(variables, "DATE_FORMAT",
-        bc_strdup(bc_trie_lookup(ctx->settings->settings, "date_format")));
-    bc_trie_insert(variables, "MAKE_RULE", bc_strdup("pagination"));
-    bc_trie_insert(variables, "MAKE_TYPE", bc_strdup("post"));
+    bc_hashmap_insert(variables, "DATE_FORMAT",
+        bc_strdup(bc_hashmap_lookup(ctx->settings->settings, "date_format")));
+    bc_hashmap_insert(variables, "MAKE_RULE", bc_strdup("pagination"));
+    bc_hashmap_insert(variables, "MAKE_TYPE", bc_strdup("post"));
 
     for (bc_slist_t *l = outputs; l != NULL; l = l->next, page++) {
         bm_filectx_t *fctx = l->data;
         if (fctx == NULL)
             continue;
-        bc_trie_insert(variables, "FILTER_PAGE", bc_strdup_printf("%zu", page));
+        bc_hashmap_insert(variables, "FILTER_PAGE", bc_strdup_printf("%zu", page));
         if (bm_rule_need_rebuild(ctx->posts_fctx, ctx->settings_fctx,
                 ctx->main_template_fctx, fctx, false))
         {
-            rv = bm_exec_blogc(ctx, variables, NULL, true, ctx->main_template_fctx,
+            rv = run_blogc(ctx, variables, NULL, true, ctx->main_template_fctx,
                 fctx, ctx->posts_fctx, false);
             if (rv != 0)
                 break;
         }
     }
 
-    bc_trie_free(variables);
+    bc_hashmap_free(variables);
 
     return rv;
 }
@@ -331,9 +550,9 @@ posts_outputlist(bm_ctx_t *ctx)
     if (ctx == NULL || ctx->settings->posts == NULL)
         return NULL;
 
-    const char *post_prefix = bc_trie_lookup(ctx->settings->settings,
+    const char *post_prefix = bc_hashmap_lookup(ctx->settings->settings,
         "post_prefix");
-    const char *html_ext = bc_trie_lookup(ctx->settings->settings,
+    const char *html_ext = bc_hashmap_lookup(ctx->settings->settings,
         "html_ext");
 
     bc_slist_t *rv = NULL;
@@ -347,20 +566,20 @@ posts_outputlist(bm_ctx_t *ctx)
 }
 
 static int
-posts_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_trie_t *args)
+posts_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_hashmap_t *args)
 {
     if (ctx == NULL || ctx->settings->posts == NULL)
         return 0;
 
     int rv = 0;
 
-    bc_trie_t *variables = bc_trie_new(free);
-    bc_trie_insert(variables, "IS_POST", bc_strdup("1"));
-    bc_trie_insert(variables, "DATE_FORMAT",
-        bc_strdup(bc_trie_lookup(ctx->settings->settings, "date_format")));
+    bc_hashmap_t *variables = bc_hashmap_new(free);
+    bc_hashmap_insert(variables, "IS_POST", bc_strdup("1"));
+    bc_hashmap_insert(variables, "DATE_FORMAT",
+        bc_strdup(bc_hashmap_lookup(ctx->settings->settings, "date_format")));
     posts_ordering(ctx, variables, "html_order");
-    bc_trie_insert(variables, "MAKE_RULE", bc_strdup("posts"));
-    bc_trie_insert(variables, "MAKE_TYPE", bc_strdup("post"));
+    bc_hashmap_insert(variables, "MAKE_RULE", bc_strdup("posts"));
+    bc_hashmap_insert(variables, "MAKE_TYPE", bc_strdup("post"));
 
     bc_slist_t *s, *o;
 
@@ -374,17 +593,17 @@ posts_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_trie_t *args)
         if (bm_rule_need_rebuild(s, ctx->settings_fctx,
                 ctx->main_template_fctx, o_fctx, true))
         {
-            bc_trie_t *local = bc_trie_new(NULL);
-            bc_trie_insert(local, "MAKE_SLUG", s_fctx->slug);  // no need to copy
-            rv = bm_exec_blogc(ctx, variables, local, false, ctx->main_template_fctx,
+            bc_hashmap_t *local = bc_hashmap_new(NULL);
+            bc_hashmap_insert(local, "MAKE_SLUG", s_fctx->slug);  // no need to copy
+            rv = run_blogc(ctx, variables, local, false, ctx->main_template_fctx,
                 o_fctx, s, true);
-            bc_trie_free(local);
+            bc_hashmap_free(local);
             if (rv != 0)
                 break;
         }
     }
 
-    bc_trie_free(variables);
+    bc_hashmap_free(variables);
 
     return rv;
 }
@@ -402,9 +621,9 @@ tags_outputlist(bm_ctx_t *ctx)
         return NULL;
 
     bc_slist_t *rv = NULL;
-    const char *tag_prefix = bc_trie_lookup(ctx->settings->settings,
+    const char *tag_prefix = bc_hashmap_lookup(ctx->settings->settings,
         "tag_prefix");
-    const char *html_ext = bc_trie_lookup(ctx->settings->settings, "html_ext");
+    const char *html_ext = bc_hashmap_lookup(ctx->settings->settings, "html_ext");
     for (size_t i = 0; ctx->settings->tags[i] != NULL; i++) {
         char *f = bc_strdup_printf("%s/%s/%s%s", ctx->short_output_dir,
             tag_prefix, ctx->settings->tags[i], html_ext);
@@ -415,7 +634,7 @@ tags_outputlist(bm_ctx_t *ctx)
 }
 
 static int
-tags_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_trie_t *args)
+tags_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_hashmap_t *args)
 {
     if (ctx == NULL || ctx->settings->posts == NULL || ctx->settings->tags == NULL)
         return 0;
@@ -423,33 +642,33 @@ tags_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_trie_t *args)
     int rv = 0;
     size_t i = 0;
 
-    bc_trie_t *variables = bc_trie_new(free);
+    bc_hashmap_t *variables = bc_hashmap_new(free);
     posts_pagination(ctx, variables, "posts_per_page");
     posts_ordering(ctx, variables, "html_order");
-    bc_trie_insert(variables, "DATE_FORMAT",
-        bc_strdup(bc_trie_lookup(ctx->settings->settings, "date_format")));
-    bc_trie_insert(variables, "MAKE_RULE", bc_strdup("tags"));
-    bc_trie_insert(variables, "MAKE_TYPE", bc_strdup("post"));
+    bc_hashmap_insert(variables, "DATE_FORMAT",
+        bc_strdup(bc_hashmap_lookup(ctx->settings->settings, "date_format")));
+    bc_hashmap_insert(variables, "MAKE_RULE", bc_strdup("tags"));
+    bc_hashmap_insert(variables, "MAKE_TYPE", bc_strdup("post"));
 
     for (bc_slist_t *l = outputs; l != NULL; l = l->next, i++) {
         bm_filectx_t *fctx = l->data;
         if (fctx == NULL)
             continue;
 
-        bc_trie_insert(variables, "FILTER_TAG",
+        bc_hashmap_insert(variables, "FILTER_TAG",
             bc_strdup(ctx->settings->tags[i]));
 
         if (bm_rule_need_rebuild(ctx->posts_fctx, ctx->settings_fctx,
                 ctx->main_template_fctx, fctx, false))
         {
-            rv = bm_exec_blogc(ctx, variables, NULL, true, ctx->main_template_fctx,
+            rv = run_blogc(ctx, variables, NULL, true, ctx->main_template_fctx,
                 fctx, ctx->posts_fctx, false);
             if (rv != 0)
                 break;
         }
     }
 
-    bc_trie_free(variables);
+    bc_hashmap_free(variables);
 
     return rv;
 }
@@ -463,7 +682,7 @@ pages_outputlist(bm_ctx_t *ctx)
     if (ctx == NULL || ctx->settings->pages == NULL)
         return NULL;
 
-    const char *html_ext = bc_trie_lookup(ctx->settings->settings, "html_ext");
+    const char *html_ext = bc_hashmap_lookup(ctx->settings->settings, "html_ext");
 
     bc_slist_t *rv = NULL;
     for (size_t i = 0; ctx->settings->pages[i] != NULL; i++) {
@@ -479,18 +698,18 @@ pages_outputlist(bm_ctx_t *ctx)
 }
 
 static int
-pages_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_trie_t *args)
+pages_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_hashmap_t *args)
 {
     if (ctx == NULL || ctx->settings->pages == NULL)
         return 0;
 
     int rv = 0;
 
-    bc_trie_t *variables = bc_trie_new(free);
-    bc_trie_insert(variables, "DATE_FORMAT",
-        bc_strdup(bc_trie_lookup(ctx->settings->settings, "date_format")));
-    bc_trie_insert(variables, "MAKE_RULE", bc_strdup("pages"));
-    bc_trie_insert(variables, "MAKE_TYPE", bc_strdup("page"));
+    bc_hashmap_t *variables = bc_hashmap_new(free);
+    bc_hashmap_insert(variables, "DATE_FORMAT",
+        bc_strdup(bc_hashmap_lookup(ctx->settings->settings, "date_format")));
+    bc_hashmap_insert(variables, "MAKE_RULE", bc_strdup("pages"));
+    bc_hashmap_insert(variables, "MAKE_TYPE", bc_strdup("page"));
 
     bc_slist_t *s, *o;
 
@@ -504,17 +723,17 @@ pages_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_trie_t *args)
         if (bm_rule_need_rebuild(s, ctx->settings_fctx,
                 ctx->main_template_fctx, o_fctx, true))
         {
-            bc_trie_t *local = bc_trie_new(NULL);
-            bc_trie_insert(local, "MAKE_SLUG", s_fctx->slug); // no need to copy
-            rv = bm_exec_blogc(ctx, variables, local, false, ctx->main_template_fctx,
+            bc_hashmap_t *local = bc_hashmap_new(NULL);
+            bc_hashmap_insert(local, "MAKE_SLUG", s_fctx->slug); // no need to copy
+            rv = run_blogc(ctx, variables, local, false, ctx->main_template_fctx,
                 o_fctx, s, true);
-            bc_trie_free(local);
+            bc_hashmap_free(local);
             if (rv != 0)
                 break;
         }
     }
 
-    bc_trie_free(variables);
+    bc_hashmap_free(variables);
 
     return rv;
 }
@@ -541,7 +760,7 @@ copy_outputlist(bm_ctx_t *ctx)
 }
 
 static int
-copy_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_trie_t *args)
+copy_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_hashmap_t *args)
 {
     if (ctx == NULL || ctx->settings->copy == NULL)
         return 0;
@@ -558,7 +777,7 @@ copy_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_trie_t *args)
             continue;
 
         if (bm_rule_need_rebuild(s, ctx->settings_fctx, NULL, o_fctx, true)) {
-            rv = bm_exec_native_cp(s->data, o_fctx, ctx->verbose);
+            rv = run_cp(ctx, s, o_fctx);
             if (rv != 0)
                 break;
         }
@@ -577,10 +796,14 @@ clean_outputlist(bm_ctx_t *ctx)
 }
 
 static int
-clean_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_trie_t *args)
+clean_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_hashmap_t *args)
 {
     int rv = 0;
 
+    // the manifest goes first, so the output directory can be removed with
+    // the last built file.
+    bm_manifest_clear(ctx->manifest);
+
     for (bc_slist_t *l = outputs; l != NULL; l = l->next) {
         bm_filectx_t *fctx = l->data;
         if (fctx == NULL)
@@ -601,13 +824,13 @@ clean_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_trie_t *args)
 }
 
 
-static int all_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_trie_t *args);
+static int all_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_hashmap_t *args);
 
 
 // RUNSERVER RULE
 
 static int
-runserver_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_trie_t *args)
+runserver_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_hashmap_t *args)
 {
     return bm_httpd_run(&ctx, all_exec, outputs, args);
 }
@@ -616,7 +839,7 @@ runserver_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_trie_t *args)
 // WATCH RULE
 
 static int
-watch_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_trie_t *args)
+watch_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_hashmap_t *args)
 {
     return bm_reloader_run(&ctx, all_exec, outputs, args);
 }
@@ -636,6 +859,7 @@ const bm_rule_t rules[] = {
         .outputlist_func = index_outputlist,
         .exec_func = index_exec,
         .generate_files = true,
+        .depends = BM_RULE_DEPENDS_POSTS | BM_RULE_DEPENDS_TEMPLATE,
     },
     {
         .name = "atom",
@@ -643,6 +867,7 @@ const bm_rule_t rules[] = {
         .outputlist_func = atom_outputlist,
         .exec_func = atom_exec,
         .generate_files = true,
+        .depends = BM_RULE_DEPENDS_POSTS,
     },
     {
         .name = "atom_tags",
@@ -650,6 +875,7 @@ const bm_rule_t rules[] = {
         .outputlist_func = atom_tags_outputlist,
         .exec_func = atom_tags_exec,
         .generate_files = true,
+        .depends = BM_RULE_DEPENDS_POSTS,
     },
     {
         .name = "pagination",
@@ -657,6 +883,7 @@ const bm_rule_t rules[] = {
         .outputlist_func = pagination_outputlist,
         .exec_func = pagination_exec,
         .generate_files = true,
+        .depends = BM_RULE_DEPENDS_POSTS | BM_RULE_DEPENDS_TEMPLATE,
     },
     {
         .name = "posts",
@@ -664,6 +891,7 @@ const bm_rule_t rules[] = {
         .outputlist_func = posts_outputlist,
         .exec_func = posts_exec,
         .generate_files = true,
+        .depends = BM_RULE_DEPENDS_POSTS | BM_RULE_DEPENDS_TEMPLATE,
     },
     {
         .name = "tags",
@@ -671,6 +899,7 @@ const bm_rule_t rules[] = {
         .outputlist_func = tags_outputlist,
         .exec_func = tags_exec,
         .generate_files = true,
+        .depends = BM_RULE_DEPENDS_POSTS | BM_RULE_DEPENDS_TEMPLATE,
     },
     {
         .name = "pages",
@@ -678,6 +907,7 @@ const bm_rule_t rules[] = {
         .outputlist_func = pages_outputlist,
         .exec_func = pages_exec,
         .generate_files = true,
+        .depends = BM_RULE_DEPENDS_PAGES | BM_RULE_DEPENDS_TEMPLATE,
     },
     {
         .name = "copy",
@@ -685,6 +915,7 @@ const bm_rule_t rules[] = {
         .outputlist_func = copy_outputlist,
         .exec_func = copy_exec,
         .generate_files = true,
+        .depends = BM_RULE_DEPENDS_COPY,
     },
     {
         .name = "clean",
@@ -709,36 +940,52 @@ const bm_rule_t rules[] = {
         .exec_func = watch_exec,
         .generate_files = false,
     },
-    {NULL, NULL, NULL, NULL, false},
+    {NULL, NULL, NULL, NULL, false, 0},
 };
 
 
 // ALL RULE
 
 static int
-all_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_trie_t *args)
+all_exec(bm_ctx_t *ctx, bc_slist_t *outputs, bc_hashmap_t *args)
+{
+    return bm_rule_execute_changed(ctx, ~0);
+}
+
+
+// runs the rules that generate files and depend on any of the `changed`
+// sources. all of them are checked for outdated outputs anyway, this just
+// avoids checking rules that can't be affected.
+int
+bm_rule_execute_changed(bm_ctx_t *ctx, int changed)
 {
     for (size_t i = 0; rules[i].name != NULL; i++) {
-        if (!rules[i].generate_files) {
+        if (!rules[i].generate_files || !(rules[i].depends & changed)) {
             continue;
         }
 
         int rv = bm_rule_execute(ctx, &(rules[i]), NULL);
         if (rv != 0) {
+            bm_jobs_wait(ctx->jobs);
+            bm_manifest_save(ctx->manifest);
             return rv;
         }
     }
-    return 0;
+
+    // outputs from all the rules may be building in parallel, wait for them
+    int rv = bm_jobs_wait(ctx->jobs);
+    bm_manifest_save(ctx->manifest);
+    return rv;
 }
 
 
-bc_trie_t*
+bc_hashmap_t*
 bm_rule_parse_args(const char *sep)
 {
     if (sep == NULL || *sep == '\0' || *sep != ':')
         return NULL;
 
-    bc_trie_t *rv = bc_trie_new(free);
+    bc_hashmap_t *rv = bc_hashmap_new(free);
     char *end = (char*) sep + 1;
     char *kv_sep;
     while (NULL != (kv_sep = strchr(end, '='))) {
@@ -748,14 +995,14 @@ bm_rule_parse_args(const char *sep)
         if (kv_sep == NULL)
             kv_sep = strchr(end, '\0');
         char *value = bc_strndup(end, kv_sep - end);
-        bc_trie_insert(rv, key, value);
+        bc_hashmap_insert(rv, key, value);
         free(key);
         if (*kv_sep == '\0')
             break;
         end = kv_sep + 1;
     }
     if (kv_sep == NULL) {
-        bc_trie_free(rv);
+        bc_hashmap_free(rv);
         return NULL;
     }
     return rv;
@@ -776,7 +1023,7 @@ bm_rule_executor(bm_ctx_t *ctx, bc_slist_t *rule_list)
         char *rule_str = l->data;
         char *sep = strchr(rule_str, ':');
 
-        bc_trie_t *args = NULL;
+        bc_hashmap_t *args = NULL;
         if (sep == NULL) {
             sep = strchr(rule_str, '\0');
         }
@@ -795,6 +1042,13 @@ bm_rule_executor(bm_ctx_t *ctx, bc_slist_t *rule_list)
             if (0 == strncmp(rule_str, rules[i].name, sep - rule_str)) {
                 rule = &(rules[i]);
                 rv = bm_rule_execute(ctx, rule, args);
+
+                // rules given in the command line run one after another,
+                // e.g. `clean all` can't overlap.
+                int jobs_rv = bm_jobs_wait(ctx->jobs);
+                if (rv == 0)
+                    rv = jobs_rv;
+                bm_manifest_save(ctx->manifest);
                 if (rv != 0)
                     return rv;
             }
@@ -811,7 +1065,7 @@ bm_rule_executor(bm_ctx_t *ctx, bc_slist_t *rule_list)
 
 
 int
-bm_rule_execute(bm_ctx_t *ctx, const bm_rule_t *rule, bc_trie_t *args)
+bm_rule_execute(bm_ctx_t *ctx, const bm_rule_t *rule, bc_hashmap_t *args)
 {
     if (ctx == NULL || rule == NULL)
         return 3;
@@ -838,17 +1092,7 @@ bm_rule_need_rebuild(bc_slist_t *sources, bm_filectx_t *settings,
 
     bool rv = false;
 
-    bc_slist_t *s = NULL;
-    if (settings != NULL)
-        s = bc_slist_append(s, settings);
-    if (template != NULL)
-        s = bc_slist_append(s, template);
-
-    for (bc_slist_t *l = sources; l != NULL; l = l->next) {
-        s = bc_slist_append(s, l->data);
-        if (only_first_source)
-            break;
-    }
+    bc_slist_t *s = input_list(settings, template, sources, only_first_source);
 
     for (bc_slist_t *l = s; l != NULL; l = l->next) {
         bm_filectx_t *source = l->data;
@@ -15,7 +15,16 @@
 
 typedef bc_slist_t* (*bm_rule_outputlist_func_t) (bm_ctx_t *ctx);
 typedef int (*bm_rule_exec_func_t) (bm_ctx_t *ctx, bc_slist_t *outputs,
-    bc_trie_t *args);
+    bc_hashmap_t *args);
+
+// sources that rules are built from, so that changes to some of them only
+// rebuild the rules that depend on them.
+typedef enum {
+    BM_RULE_DEPENDS_POSTS = 1 << 0,
+    BM_RULE_DEPENDS_PAGES = 1 << 1,
+    BM_RULE_DEPENDS_COPY = 1 << 2,
+    BM_RULE_DEPENDS_TEMPLATE = 1 << 3,
+} bm_rule_depends_t;
 
 typedef struct {
     const char *name;
@@ -23,11 +32,13 @@ typedef struct {
     bm_rule_outputlist_func_t outputlist_func;
     bm_rule_exec_func_t exec_func;
     bool generate_files;
+    int depends;
 } bm_rule_t;
 
-bc_trie_t* bm_rule_parse_args(const char *sep);
+bc_hashmap_t* bm_rule_parse_args(const char *sep);
 int bm_rule_executor(bm_ctx_t *ctx, bc_slist_t *rule_list);
-int bm_rule_execute(bm_ctx_t *ctx, const bm_rule_t *rule, bc_trie_t *args);
+int bm_rule_execute(bm_ctx_t *ctx, const bm_rule_t *rule, bc_hashmap_t *args);
+int bm_rule_execute_changed(bm_ctx_t *ctx, int changed);
 bool bm_rule_need_rebuild(bc_slist_t *sources, bm_filectx_t *settings,
     bm_filectx_t *template, bm_filectx_t *output, bool only_first_source);
 bc_slist_t* bm_rule_list_built_files(bm_ctx_t *ctx);
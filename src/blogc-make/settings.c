@@ -88,8 +88,8 @@ bm_settings_parse(const char *content, size_t content_len, bc_error_t **err)
 
     bm_settings_t *rv = bc_malloc(sizeof(bm_settings_t));
     rv->root_dir = NULL;
-    rv->global = bc_trie_new(free);
-    rv->settings = bc_trie_new(free);
+    rv->global = bc_hashmap_new(free);
+    rv->settings = bc_hashmap_new(free);
     rv->posts = NULL;
     rv->pages = NULL;
     rv->copy = NULL;
@@ -125,14 +125,14 @@ bm_settings_parse(const char *content, size_t content_len, bc_error_t **err)
                     goto cleanup;
                 }
             }
-            bc_trie_insert(rv->global, global[i],
+            bc_hashmap_insert(rv->global, global[i],
                 bc_strdup(bc_config_get(config, section, global[i])));
         }
     }
     bc_strv_free(global);
 
     for (size_t i = 0; required_global[i] != NULL; i++) {
-        const char *value = bc_trie_lookup(rv->global, required_global[i]);
+        const char *value = bc_hashmap_lookup(rv->global, required_global[i]);
         if (value == NULL || value[0] == '\0') {
             *err = bc_error_new_printf(BLOGC_MAKE_ERROR_SETTINGS,
                 "[%s] key required but not found or empty: %s", section,
@@ -148,7 +148,7 @@ bm_settings_parse(const char *content, size_t content_len, bc_error_t **err)
             config, "settings", default_settings[i].key,
             default_settings[i].default_value);
         if (value != NULL) {
-            bc_trie_insert(rv->settings, default_settings[i].key,
+            bc_hashmap_insert(rv->settings, default_settings[i].key,
                 bc_strdup(value));
         }
     }
@@ -196,8 +196,8 @@ bm_settings_free(bm_settings_t *settings)
     if (settings == NULL)
         return;
     free(settings->root_dir);
-    bc_trie_free(settings->global);
-    bc_trie_free(settings->settings);
+    bc_hashmap_free(settings->global);
+    bc_hashmap_free(settings->settings);
     bc_strv_free(settings->posts);
     bc_strv_free(settings->pages);
     bc_strv_free(settings->copy);
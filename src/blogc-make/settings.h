@@ -15,8 +15,8 @@
 
 typedef struct {
     char *root_dir;
-    bc_trie_t *global;
-    bc_trie_t *settings;
+    bc_hashmap_t *global;
+    bc_hashmap_t *settings;
     char **posts;
     char **pages;
     char **copy;
@@ -0,0 +1,308 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "../common/utils.h"
+#include "access-log.h"
+#include "request-parser.h"
+#include "request.h"
+
+typedef struct {
+    unsigned long seq;
+    time_t time;
+    long long latency;
+    unsigned short status_code;
+    size_t bytes;
+    char ip[BR_ACCESS_LOG_IP_SIZE];
+    char line[BR_ACCESS_LOG_LINE_SIZE];
+    char referer[BR_ACCESS_LOG_HEADER_SIZE];
+    char user_agent[BR_ACCESS_LOG_HEADER_SIZE];
+} entry_t;
+
+// bounded multi-producer single-consumer queue. each slot has a sequence
+// number, that tells the producers if the slot is free for the current lap
+// around the ring, and the consumer if the slot was already written. the
+// request threads never wait for each other or for the logger thread.
+//
+// the logger thread blocks while the queue is empty. it sets `sleeping`
+// before checking the queue one last time, and the producer that clears it
+// wakes the thread up, so only the first entry after the queue got empty
+// takes the mutex.
+struct br_access_log {
+    entry_t *entries;
+    unsigned long head;
+    unsigned long tail;
+    unsigned long dropped;
+    unsigned long reported;
+    FILE *fp;
+    bool close_fp;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool running;
+    bool stopping;
+    bool sleeping;
+    time_t last_time;
+    char time_str[32];
+};
+
+
+br_access_log_t*
+br_access_log_new(const char *path)
+{
+    FILE *fp = stderr;
+    if (path != NULL) {
+        fp = fopen(path, "a");
+        if (fp == NULL)
+            return NULL;
+    }
+
+    br_access_log_t *rv = bc_malloc(sizeof(br_access_log_t));
+    rv->entries = bc_malloc(BR_ACCESS_LOG_QUEUE_SIZE * sizeof(entry_t));
+    for (size_t i = 0; i < BR_ACCESS_LOG_QUEUE_SIZE; i++)
+        rv->entries[i].seq = i;
+    rv->head = 0;
+    rv->tail = 0;
+    rv->dropped = 0;
+    rv->reported = 0;
+    rv->fp = fp;
+    rv->close_fp = path != NULL;
+    pthread_mutex_init(&rv->mutex, NULL);
+    pthread_cond_init(&rv->cond, NULL);
+    rv->running = false;
+    rv->stopping = false;
+    rv->sleeping = false;
+    rv->last_time = 0;
+    rv->time_str[0] = '\0';
+    return rv;
+}
+
+
+void
+br_access_log_free(br_access_log_t *log)
+{
+    if (log == NULL)
+        return;
+    if (log->running) {
+        pthread_mutex_lock(&log->mutex);
+        __atomic_store_n(&log->stopping, true, __ATOMIC_RELEASE);
+        pthread_cond_signal(&log->cond);
+        pthread_mutex_unlock(&log->mutex);
+        pthread_join(log->thread, NULL);
+    }
+    br_access_log_flush(log);
+    if (log->close_fp)
+        fclose(log->fp);
+    pthread_mutex_destroy(&log->mutex);
+    pthread_cond_destroy(&log->cond);
+    free(log->entries);
+    free(log);
+}
+
+
+static void
+copy_str(char *dest, const char *src, size_t size)
+{
+    if (src == NULL)
+        src = "";
+    size_t len = strlen(src);
+    if (len >= size)
+        len = size - 1;
+    memcpy(dest, src, len);
+    dest[len] = '\0';
+}
+
+
+// latency is the time taken to serve the request, in microseconds.
+void
+br_access_log_write(br_access_log_t *log, const char *ip, br_request_t *req,
+    br_response_t *res, long long latency)
+{
+    if (log == NULL)
+        return;
+
+    unsigned long pos = __atomic_load_n(&log->head, __ATOMIC_RELAXED);
+    entry_t *e;
+    while (1) {
+        e = &log->entries[pos & (BR_ACCESS_LOG_QUEUE_SIZE - 1)];
+        unsigned long seq = __atomic_load_n(&e->seq, __ATOMIC_ACQUIRE);
+        long diff = (long) (seq - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&log->head, &pos, pos + 1, true,
+                __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        }
+        else if (diff < 0) {
+            // the logger thread didn't catch up with the previous lap yet.
+            __atomic_add_fetch(&log->dropped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        else {
+            pos = __atomic_load_n(&log->head, __ATOMIC_RELAXED);
+        }
+    }
+
+    e->time = time(NULL);
+    e->latency = latency;
+    e->status_code = res->status_code;
+    e->bytes = res->sent > res->header_len ? res->sent - res->header_len : 0;
+    copy_str(e->ip, ip, sizeof(e->ip));
+    copy_str(e->line, req->line, sizeof(e->line));
+    copy_str(e->referer, br_request_get_header(req, "referer"),
+        sizeof(e->referer));
+    copy_str(e->user_agent, br_request_get_header(req, "user-agent"),
+        sizeof(e->user_agent));
+
+    // sequentially consistent, paired with the logger thread setting
+    // `sleeping` and then checking the queue: either it sees this entry, or
+    // this sees it sleeping.
+    __atomic_store_n(&e->seq, pos + 1, __ATOMIC_SEQ_CST);
+
+    if (__atomic_exchange_n(&log->sleeping, false, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_lock(&log->mutex);
+        pthread_cond_signal(&log->cond);
+        pthread_mutex_unlock(&log->mutex);
+    }
+}
+
+
+// strings are quoted in the log, quotes and control characters are escaped.
+static void
+print_quoted(FILE *fp, const char *str)
+{
+    if (str[0] == '\0') {
+        fputs("\"-\"", fp);
+        return;
+    }
+    fputc('"', fp);
+    for (const char *c = str; *c != '\0'; c++) {
+        unsigned char u = *c;
+        if (u == '"' || u == '\\' || u < 0x20 || u >= 0x7f)
+            fprintf(fp, "\\x%02X", u);
+        else
+            fputc(u, fp);
+    }
+    fputc('"', fp);
+}
+
+
+// combined log format, as used by apache and nginx, plus the time taken to
+// handle the request, in seconds.
+static void
+print_entry(br_access_log_t *log, entry_t *e)
+{
+    if (e->time != log->last_time || log->time_str[0] == '\0') {
+        struct tm tm;
+        localtime_r(&e->time, &tm);
+        strftime(log->time_str, sizeof(log->time_str),
+            "%d/%b/%Y:%H:%M:%S %z", &tm);
+        log->last_time = e->time;
+    }
+
+    fprintf(log->fp, "%s - - [%s] ", e->ip, log->time_str);
+    print_quoted(log->fp, e->line);
+    fprintf(log->fp, " %d %zu ", e->status_code, e->bytes);
+    print_quoted(log->fp, e->referer);
+    fputc(' ', log->fp);
+    print_quoted(log->fp, e->user_agent);
+    fprintf(log->fp, " %lld.%06lld\n", e->latency / 1000000,
+        e->latency % 1000000);
+}
+
+
+// writes all the entries available. must be called only from a single thread,
+// that is the logger thread, if running. returns the number of entries
+// written.
+size_t
+br_access_log_flush(br_access_log_t *log)
+{
+    if (log == NULL)
+        return 0;
+
+    size_t rv = 0;
+    while (1) {
+        entry_t *e =
+            &log->entries[log->tail & (BR_ACCESS_LOG_QUEUE_SIZE - 1)];
+        if (__atomic_load_n(&e->seq, __ATOMIC_ACQUIRE) != log->tail + 1)
+            break;
+        print_entry(log, e);
+        __atomic_store_n(&e->seq, log->tail + BR_ACCESS_LOG_QUEUE_SIZE,
+            __ATOMIC_RELEASE);
+        log->tail++;
+        rv++;
+    }
+
+    unsigned long dropped = br_access_log_dropped(log);
+    if (dropped != log->reported) {
+        fprintf(stderr, "warning: Access log queue is full, %lu entries "
+            "dropped\n", dropped - log->reported);
+        log->reported = dropped;
+    }
+
+    if (rv > 0)
+        fflush(log->fp);
+    return rv;
+}
+
+
+unsigned long
+br_access_log_dropped(br_access_log_t *log)
+{
+    if (log == NULL)
+        return 0;
+    return __atomic_load_n(&log->dropped, __ATOMIC_RELAXED);
+}
+
+
+static bool
+is_empty(br_access_log_t *log)
+{
+    entry_t *e = &log->entries[log->tail & (BR_ACCESS_LOG_QUEUE_SIZE - 1)];
+    return __atomic_load_n(&e->seq, __ATOMIC_SEQ_CST) != log->tail + 1;
+}
+
+
+static void*
+log_thread(void *arg)
+{
+    br_access_log_t *log = arg;
+
+    while (!__atomic_load_n(&log->stopping, __ATOMIC_ACQUIRE)) {
+        if (br_access_log_flush(log) > 0)
+            continue;
+
+        pthread_mutex_lock(&log->mutex);
+        __atomic_store_n(&log->sleeping, true, __ATOMIC_SEQ_CST);
+        if (is_empty(log)) {
+            while (__atomic_load_n(&log->sleeping, __ATOMIC_SEQ_CST) &&
+                    !__atomic_load_n(&log->stopping, __ATOMIC_ACQUIRE))
+                pthread_cond_wait(&log->cond, &log->mutex);
+        }
+        __atomic_store_n(&log->sleeping, false, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&log->mutex);
+    }
+
+    return NULL;
+}
+
+
+bool
+br_access_log_start(br_access_log_t *log)
+{
+    if (log == NULL || log->running)
+        return false;
+    if (0 != pthread_create(&log->thread, NULL, log_thread, log))
+        return false;
+    log->running = true;
+    return true;
+}
@@ -0,0 +1,35 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+#ifndef _ACCESS_LOG_H
+#define _ACCESS_LOG_H
+
+#include <stdbool.h>
+#include "request-parser.h"
+#include "request.h"
+
+// number of entries waiting to be written. must be a power of 2. when the
+// queue is full, new entries are dropped instead of blocking the server.
+#define BR_ACCESS_LOG_QUEUE_SIZE 1024
+
+// longer strings are truncated.
+#define BR_ACCESS_LOG_IP_SIZE 48
+#define BR_ACCESS_LOG_LINE_SIZE 512
+#define BR_ACCESS_LOG_HEADER_SIZE 256
+
+typedef struct br_access_log br_access_log_t;
+
+br_access_log_t* br_access_log_new(const char *path);
+void br_access_log_free(br_access_log_t *log);
+bool br_access_log_start(br_access_log_t *log);
+void br_access_log_write(br_access_log_t *log, const char *ip,
+    br_request_t *req, br_response_t *res, long long latency);
+size_t br_access_log_flush(br_access_log_t *log);
+unsigned long br_access_log_dropped(br_access_log_t *log);
+
+#endif /* _ACCESS_LOG_H */
@@ -0,0 +1,522 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#endif /* HAVE_SYS_INOTIFY_H */
+#include "../common/utils.h"
+#include "cache.h"
+
+// entries are kept in a chained hash table, for lookups by url path, and in a
+// doubly linked list, most recently used first, for eviction.
+struct br_cache {
+    pthread_mutex_t mutex;
+    br_cache_entry_t **buckets;
+    size_t num_buckets;
+    br_cache_entry_t *head;
+    br_cache_entry_t *tail;
+    size_t len;
+    size_t size;
+    size_t max_entries;
+    size_t max_size;
+    unsigned long generation;
+    int inotify_fd;
+    char **watches;
+    size_t watches_len;
+    pthread_t thread;
+    bool watching;
+    br_cache_t *linked;
+};
+
+
+br_cache_entry_t*
+br_cache_entry_new(const char *key)
+{
+    br_cache_entry_t *rv = bc_malloc(sizeof(br_cache_entry_t));
+    rv->key = bc_strdup(key);
+    rv->path = NULL;
+    rv->content_type = NULL;
+    rv->compressible = false;
+    rv->gzip_path = NULL;
+    rv->redirect = false;
+    rv->size = 0;
+    rv->mtime = 0;
+    rv->inode = 0;
+    rv->data = NULL;
+    rv->refs = 1;
+    rv->hash = bc_hashmap_hash(key);
+    rv->prev = NULL;
+    rv->next = NULL;
+    rv->hnext = NULL;
+    return rv;
+}
+
+
+br_cache_entry_t*
+br_cache_entry_ref(br_cache_entry_t *entry)
+{
+    if (entry != NULL)
+        __atomic_add_fetch(&entry->refs, 1, __ATOMIC_RELAXED);
+    return entry;
+}
+
+
+void
+br_cache_entry_unref(br_cache_entry_t *entry)
+{
+    if (entry == NULL)
+        return;
+    if (0 != __atomic_sub_fetch(&entry->refs, 1, __ATOMIC_ACQ_REL))
+        return;
+    free(entry->key);
+    free(entry->path);
+    free(entry->gzip_path);
+    free(entry->data);
+    free(entry);
+}
+
+
+br_cache_t*
+br_cache_new(size_t max_entries, size_t max_size)
+{
+    br_cache_t *rv = bc_malloc(sizeof(br_cache_t));
+    pthread_mutex_init(&rv->mutex, NULL);
+    rv->num_buckets = 16;
+    while (rv->num_buckets < max_entries)
+        rv->num_buckets <<= 1;
+    rv->buckets = bc_malloc(rv->num_buckets * sizeof(br_cache_entry_t*));
+    for (size_t i = 0; i < rv->num_buckets; i++)
+        rv->buckets[i] = NULL;
+    rv->head = NULL;
+    rv->tail = NULL;
+    rv->len = 0;
+    rv->size = 0;
+    rv->max_entries = max_entries;
+    rv->max_size = max_size;
+    rv->generation = 0;
+    rv->inotify_fd = -1;
+    rv->watches = NULL;
+    rv->watches_len = 0;
+    rv->watching = false;
+    rv->linked = NULL;
+    return rv;
+}
+
+
+static size_t
+entry_size(br_cache_entry_t *entry)
+{
+    return entry->data != NULL ? entry->size : 0;
+}
+
+
+static br_cache_entry_t*
+find(br_cache_t *cache, const char *key, uint32_t hash)
+{
+    br_cache_entry_t *e = cache->buckets[hash & (cache->num_buckets - 1)];
+    for (; e != NULL; e = e->hnext)
+        if (e->hash == hash && 0 == strcmp(e->key, key))
+            return e;
+    return NULL;
+}
+
+
+static void
+list_remove(br_cache_t *cache, br_cache_entry_t *entry)
+{
+    if (entry->prev != NULL)
+        entry->prev->next = entry->next;
+    else
+        cache->head = entry->next;
+    if (entry->next != NULL)
+        entry->next->prev = entry->prev;
+    else
+        cache->tail = entry->prev;
+    entry->prev = NULL;
+    entry->next = NULL;
+}
+
+
+static void
+list_prepend(br_cache_t *cache, br_cache_entry_t *entry)
+{
+    entry->prev = NULL;
+    entry->next = cache->head;
+    if (cache->head != NULL)
+        cache->head->prev = entry;
+    else
+        cache->tail = entry;
+    cache->head = entry;
+}
+
+
+// must be called with the mutex locked. drops the reference owned by the
+// cache, users of the entry still hold their own.
+static void
+unlink_entry(br_cache_t *cache, br_cache_entry_t *entry)
+{
+    size_t bucket = entry->hash & (cache->num_buckets - 1);
+    br_cache_entry_t **e = &cache->buckets[bucket];
+    while (*e != entry)
+        e = &(*e)->hnext;
+    *e = entry->hnext;
+    entry->hnext = NULL;
+    list_remove(cache, entry);
+    cache->len--;
+    cache->size -= entry_size(entry);
+    br_cache_entry_unref(entry);
+}
+
+
+unsigned long
+br_cache_generation(br_cache_t *cache)
+{
+    if (cache == NULL)
+        return 0;
+    pthread_mutex_lock(&cache->mutex);
+    unsigned long rv = cache->generation;
+    pthread_mutex_unlock(&cache->mutex);
+    return rv;
+}
+
+
+br_cache_entry_t*
+br_cache_lookup(br_cache_t *cache, const char *key)
+{
+    if (cache == NULL || key == NULL)
+        return NULL;
+    pthread_mutex_lock(&cache->mutex);
+    br_cache_entry_t *rv = find(cache, key, bc_hashmap_hash(key));
+    if (rv != NULL && rv != cache->head) {
+        list_remove(cache, rv);
+        list_prepend(cache, rv);
+    }
+    br_cache_entry_ref(rv);
+    pthread_mutex_unlock(&cache->mutex);
+    return rv;
+}
+
+
+// the generation must be read before resolving the entry. if anything in the
+// docroot changed since then, the entry may be outdated already and is
+// dropped.
+void
+br_cache_insert(br_cache_t *cache, br_cache_entry_t *entry,
+    unsigned long generation)
+{
+    if (cache == NULL || entry == NULL)
+        return;
+    pthread_mutex_lock(&cache->mutex);
+    if (generation != cache->generation || cache->max_entries == 0 ||
+        entry_size(entry) > cache->max_size)
+        goto cleanup;
+
+    br_cache_entry_t *old = find(cache, entry->key, entry->hash);
+    if (old != NULL)
+        unlink_entry(cache, old);
+
+    size_t bucket = entry->hash & (cache->num_buckets - 1);
+    entry->hnext = cache->buckets[bucket];
+    cache->buckets[bucket] = br_cache_entry_ref(entry);
+    list_prepend(cache, entry);
+    cache->len++;
+    cache->size += entry_size(entry);
+
+    while (cache->len > cache->max_entries || cache->size > cache->max_size)
+        unlink_entry(cache, cache->tail);
+
+cleanup:
+    pthread_mutex_unlock(&cache->mutex);
+}
+
+
+void
+br_cache_remove(br_cache_t *cache, br_cache_entry_t *entry)
+{
+    if (cache == NULL || entry == NULL)
+        return;
+    pthread_mutex_lock(&cache->mutex);
+    if (entry == find(cache, entry->key, entry->hash))
+        unlink_entry(cache, entry);
+    pthread_mutex_unlock(&cache->mutex);
+}
+
+
+static bool
+path_matches(const char *path, const char *prefix, size_t prefix_len)
+{
+    return 0 == strncmp(path, prefix, prefix_len) &&
+        (path[prefix_len] == '\0' || path[prefix_len] == '/');
+}
+
+
+// drops the entries for the given file, for anything below it, and for
+// anything else in the same directory, because directory indexes may have
+// changed. a NULL path drops everything.
+void
+br_cache_invalidate(br_cache_t *cache, const char *path)
+{
+    if (cache == NULL)
+        return;
+
+    size_t path_len = path != NULL ? strlen(path) : 0;
+    const char *slash = path != NULL ? strrchr(path, '/') : NULL;
+    size_t dir_len = slash != NULL ? slash - path : 0;
+
+    pthread_mutex_lock(&cache->mutex);
+    cache->generation++;
+    br_cache_entry_t *e = cache->head;
+    while (e != NULL) {
+        br_cache_entry_t *next = e->next;
+        if (path == NULL || path_matches(e->path, path, path_len) ||
+            (0 == strncmp(e->path, path, dir_len) && e->path[dir_len] == '/' &&
+             NULL == strchr(e->path + dir_len + 1, '/')))
+            unlink_entry(cache, e);
+        e = next;
+    }
+    pthread_mutex_unlock(&cache->mutex);
+
+    br_cache_invalidate(cache->linked, path);
+}
+
+
+// the linked cache gets all the invalidations of the cache, including the
+// ones from the docroot watcher, so caches derived from the docroot can share
+// a single watcher.
+void
+br_cache_link(br_cache_t *cache, br_cache_t *linked)
+{
+    if (cache == NULL)
+        return;
+    pthread_mutex_lock(&cache->mutex);
+    cache->linked = linked;
+    pthread_mutex_unlock(&cache->mutex);
+}
+
+
+size_t
+br_cache_size(br_cache_t *cache)
+{
+    if (cache == NULL)
+        return 0;
+    pthread_mutex_lock(&cache->mutex);
+    size_t rv = cache->len;
+    pthread_mutex_unlock(&cache->mutex);
+    return rv;
+}
+
+
+#ifdef HAVE_SYS_INOTIFY_H
+
+#define WATCH_EVENTS (IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | \
+    IN_DELETE_SELF | IN_MODIFY | IN_MOVE_SELF | IN_MOVED_FROM | IN_MOVED_TO)
+#define WATCH_BUFFER_SIZE 8192
+
+// inotify watches aren't recursive, every directory below the docroot needs
+// its own watch. watch descriptors are small integers, and are mapped back to
+// the directory paths with a plain array.
+static bool
+watch_dir(br_cache_t *cache, const char *path)
+{
+    int wd = inotify_add_watch(cache->inotify_fd, path,
+        WATCH_EVENTS | IN_ONLYDIR | IN_DONT_FOLLOW);
+    if (wd < 0) {
+        fprintf(stderr, "warning: Failed to watch directory (%s): %s\n", path,
+            strerror(errno));
+        return false;
+    }
+
+    if ((size_t) wd >= cache->watches_len) {
+        size_t len = cache->watches_len > 0 ? cache->watches_len : 64;
+        while (len <= (size_t) wd)
+            len <<= 1;
+        cache->watches = bc_realloc(cache->watches, len * sizeof(char*));
+        for (size_t i = cache->watches_len; i < len; i++)
+            cache->watches[i] = NULL;
+        cache->watches_len = len;
+    }
+
+    // the same directory gets the same watch descriptor, e.g. when moved.
+    free(cache->watches[wd]);
+    cache->watches[wd] = bc_strdup(path);
+
+    DIR *dir = opendir(path);
+    if (dir == NULL)
+        return true;
+
+    bool rv = true;
+    struct dirent *d;
+    while ((d = readdir(dir)) != NULL) {
+        if (0 == strcmp(d->d_name, ".") || 0 == strcmp(d->d_name, ".."))
+            continue;
+        char *child = bc_strdup_printf("%s/%s", path, d->d_name);
+        struct stat st;
+        if (0 == lstat(child, &st) && S_ISDIR(st.st_mode))
+            rv = watch_dir(cache, child) && rv;
+        free(child);
+    }
+    closedir(dir);
+    return rv;
+}
+
+
+static void*
+watch_thread(void *arg)
+{
+    br_cache_t *cache = arg;
+    char buffer[WATCH_BUFFER_SIZE]
+        __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    while (1) {
+        ssize_t n = read(cache->inotify_fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0) {
+            fprintf(stderr, "warning: Failed to read docroot changes: %s\n",
+                n == 0 ? "EOF" : strerror(errno));
+            break;
+        }
+
+        for (char *p = buffer; p < buffer + n;) {
+            const struct inotify_event *ev = (const struct inotify_event*) p;
+            p += sizeof(struct inotify_event) + ev->len;
+
+            if (ev->mask & IN_Q_OVERFLOW) {
+                br_cache_invalidate(cache, NULL);
+                continue;
+            }
+
+            if (ev->wd < 0 || (size_t) ev->wd >= cache->watches_len ||
+                cache->watches[ev->wd] == NULL)
+                continue;
+
+            if (ev->mask & IN_IGNORED) {
+                free(cache->watches[ev->wd]);
+                cache->watches[ev->wd] = NULL;
+                continue;
+            }
+
+            char *path = ev->len > 0 ?
+                bc_strdup_printf("%s/%s", cache->watches[ev->wd], ev->name) :
+                bc_strdup(cache->watches[ev->wd]);
+
+            // new directories are watched before invalidating, so anything
+            // created inside them in the meantime is dropped too.
+            bool ok = true;
+            if ((ev->mask & IN_ISDIR) && (ev->mask & (IN_CREATE | IN_MOVED_TO)))
+                ok = watch_dir(cache, path);
+
+            br_cache_invalidate(cache, path);
+            free(path);
+            if (!ok)
+                goto disable;
+        }
+    }
+
+disable:
+
+    // without notifications the cache can't be trusted anymore.
+    fprintf(stderr, "warning: Stopped watching docroot, disabling cache\n");
+    for (br_cache_t *c = cache; c != NULL; c = c->linked) {
+        pthread_mutex_lock(&c->mutex);
+        c->max_entries = 0;
+        pthread_mutex_unlock(&c->mutex);
+    }
+    br_cache_invalidate(cache, NULL);
+    return NULL;
+}
+
+
+bool
+br_cache_watch(br_cache_t *cache, const char *docroot)
+{
+    if (cache == NULL || cache->watching)
+        return false;
+
+    char *real_root = realpath(docroot, NULL);
+    if (real_root == NULL) {
+        fprintf(stderr, "warning: Failed to resolve docroot (%s): %s\n",
+            docroot, strerror(errno));
+        return false;
+    }
+
+    cache->inotify_fd = inotify_init1(IN_CLOEXEC);
+    if (cache->inotify_fd == -1) {
+        fprintf(stderr, "warning: Failed to initialize inotify: %s\n",
+            strerror(errno));
+        free(real_root);
+        return false;
+    }
+
+    // a partially watched docroot would serve stale files.
+    if (!watch_dir(cache, real_root))
+        goto error;
+
+    if (0 != pthread_create(&cache->thread, NULL, watch_thread, cache)) {
+        fprintf(stderr, "warning: Failed to create watcher thread\n");
+        goto error;
+    }
+
+    free(real_root);
+    cache->watching = true;
+    return true;
+
+error:
+    free(real_root);
+    close(cache->inotify_fd);
+    cache->inotify_fd = -1;
+    return false;
+}
+
+#else
+
+bool
+br_cache_watch(br_cache_t *cache, const char *docroot)
+{
+    fprintf(stderr, "warning: Watching the docroot is not supported on this "
+        "platform\n");
+    return false;
+}
+
+#endif /* HAVE_SYS_INOTIFY_H */
+
+
+void
+br_cache_free(br_cache_t *cache)
+{
+    if (cache == NULL)
+        return;
+    if (cache->watching) {
+        pthread_cancel(cache->thread);
+        pthread_join(cache->thread, NULL);
+    }
+    if (cache->inotify_fd != -1)
+        close(cache->inotify_fd);
+    for (size_t i = 0; i < cache->watches_len; i++)
+        free(cache->watches[i]);
+    free(cache->watches);
+    while (cache->head != NULL)
+        unlink_entry(cache, cache->head);
+    free(cache->buckets);
+    pthread_mutex_destroy(&cache->mutex);
+    free(cache);
+}
@@ -0,0 +1,60 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+#ifndef _CACHE_H
+#define _CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/types.h>
+
+#define BR_CACHE_MAX_ENTRIES 1024
+#define BR_CACHE_MAX_SIZE (32 * 1024 * 1024)
+#define BR_CACHE_MAX_FILE_SIZE (64 * 1024)
+
+// an entry is the result of resolving an url path to a file in the docroot.
+// entries are reference counted, and are never changed after being inserted
+// in the cache, so they can be used without locking.
+typedef struct br_cache_entry {
+    char *key;
+    char *path;
+    const char *content_type;
+    bool compressible;
+    char *gzip_path;
+    bool redirect;
+    size_t size;
+    time_t mtime;
+    ino_t inode;
+    char *data;
+    size_t refs;
+    uint32_t hash;
+    struct br_cache_entry *prev;
+    struct br_cache_entry *next;
+    struct br_cache_entry *hnext;
+} br_cache_entry_t;
+
+typedef struct br_cache br_cache_t;
+
+br_cache_entry_t* br_cache_entry_new(const char *key);
+br_cache_entry_t* br_cache_entry_ref(br_cache_entry_t *entry);
+void br_cache_entry_unref(br_cache_entry_t *entry);
+br_cache_t* br_cache_new(size_t max_entries, size_t max_size);
+void br_cache_free(br_cache_t *cache);
+bool br_cache_watch(br_cache_t *cache, const char *docroot);
+unsigned long br_cache_generation(br_cache_t *cache);
+br_cache_entry_t* br_cache_lookup(br_cache_t *cache, const char *key);
+void br_cache_insert(br_cache_t *cache, br_cache_entry_t *entry,
+    unsigned long generation);
+void br_cache_remove(br_cache_t *cache, br_cache_entry_t *entry);
+void br_cache_invalidate(br_cache_t *cache, const char *path);
+void br_cache_link(br_cache_t *cache, br_cache_t *linked);
+size_t br_cache_size(br_cache_t *cache);
+
+#endif /* _CACHE_H */
@@ -0,0 +1,148 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <ctype.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif /* HAVE_ZLIB */
+#include "../common/utils.h"
+#include "compress.h"
+
+
+// qvalues have at most 3 decimal places, rfc7231 section 5.3.1, and are
+// returned multiplied by 1000. invalid values are handled as 0.
+static int
+parse_qvalue(const char *str)
+{
+    if ((str[0] != '0' && str[0] != '1') || (str[1] != '.' && str[1] != '\0'))
+        return 0;
+    if (str[0] == '1')
+        return 1000;
+    if (str[1] == '\0')
+        return 0;
+    int rv = 0;
+    int mult = 100;
+    for (const char *c = str + 2; *c != '\0' && mult > 0; c++, mult /= 10) {
+        if (!isdigit((unsigned char) *c))
+            return 0;
+        rv += (*c - '0') * mult;
+    }
+    return rv;
+}
+
+
+br_encoding_t
+br_compress_negotiate(const char *accept_encoding)
+{
+    if (accept_encoding == NULL)
+        return BR_ENCODING_IDENTITY;
+
+    int gzip = -1;
+    int deflate = -1;
+    int star = -1;
+
+    char **codings = bc_str_split(accept_encoding, ',', 0);
+    for (size_t i = 0; codings[i] != NULL; i++) {
+        char **params = bc_str_split(codings[i], ';', 0);
+        char *name = bc_str_strip(params[0]);
+        int q = 1000;
+        for (size_t j = 1; params[j] != NULL; j++) {
+            char *param = bc_str_strip(params[j]);
+            if (0 == strncasecmp(param, "q=", 2))
+                q = parse_qvalue(param + 2);
+        }
+        if (0 == strcasecmp(name, "gzip") || 0 == strcasecmp(name, "x-gzip"))
+            gzip = q;
+        else if (0 == strcasecmp(name, "deflate"))
+            deflate = q;
+        else if (0 == strcmp(name, "*"))
+            star = q;
+        bc_strv_free(params);
+    }
+    bc_strv_free(codings);
+
+    if (gzip == -1)
+        gzip = star > 0 ? star : 0;
+    if (deflate == -1)
+        deflate = star > 0 ? star : 0;
+
+    if (gzip > 0 && gzip >= deflate)
+        return BR_ENCODING_GZIP;
+    if (deflate > 0)
+        return BR_ENCODING_DEFLATE;
+    return BR_ENCODING_IDENTITY;
+}
+
+
+const char*
+br_compress_encoding_name(br_encoding_t encoding)
+{
+    switch (encoding) {
+        case BR_ENCODING_GZIP:
+            return "gzip";
+        case BR_ENCODING_DEFLATE:
+            return "deflate";
+        case BR_ENCODING_IDENTITY:
+            break;
+    }
+    return NULL;
+}
+
+
+// returns NULL if the data can't be compressed, e.g. when built without zlib,
+// and the identity encoding should be used.
+char*
+br_compress(br_encoding_t encoding, const char *data, size_t len,
+    size_t *out_len)
+{
+#ifdef HAVE_ZLIB
+    if (encoding == BR_ENCODING_IDENTITY || len > UINT_MAX)
+        return NULL;
+
+    z_stream strm;
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+
+    // 16 + window bits selects the gzip wrapper. http's deflate is the zlib
+    // format, not raw deflate.
+    int bits = encoding == BR_ENCODING_GZIP ? 16 + MAX_WBITS : MAX_WBITS;
+
+    // results are cached, so the best compression is worth it.
+    if (Z_OK != deflateInit2(&strm, Z_BEST_COMPRESSION, Z_DEFLATED, bits, 8,
+        Z_DEFAULT_STRATEGY))
+        return NULL;
+
+    uLong bound = deflateBound(&strm, len);
+    char *rv = bc_malloc(bound);
+    strm.next_in = (Bytef*) data;
+    strm.avail_in = len;
+    strm.next_out = (Bytef*) rv;
+    strm.avail_out = bound;
+
+    int ret = deflate(&strm, Z_FINISH);
+    *out_len = strm.total_out;
+    deflateEnd(&strm);
+
+    if (ret != Z_STREAM_END) {
+        free(rv);
+        return NULL;
+    }
+    return rv;
+#else
+    return NULL;
+#endif /* HAVE_ZLIB */
+}
@@ -0,0 +1,30 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+#ifndef _COMPRESS_H
+#define _COMPRESS_H
+
+#include <stddef.h>
+
+#define BR_COMPRESS_MIN_SIZE 256
+#define BR_COMPRESS_MAX_FILE_SIZE (4 * 1024 * 1024)
+#define BR_COMPRESS_CACHE_MAX_ENTRIES 1024
+#define BR_COMPRESS_CACHE_MAX_SIZE (32 * 1024 * 1024)
+
+typedef enum {
+    BR_ENCODING_IDENTITY = 0,
+    BR_ENCODING_GZIP,
+    BR_ENCODING_DEFLATE,
+} br_encoding_t;
+
+br_encoding_t br_compress_negotiate(const char *accept_encoding);
+const char* br_compress_encoding_name(br_encoding_t encoding);
+char* br_compress(br_encoding_t encoding, const char *data, size_t len,
+    size_t *out_len);
+
+#endif /* _COMPRESS_H */
@@ -6,42 +6,27 @@
  * See the file LICENSE.
  */
 
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+#include <pthread.h>
+#include <sched.h>
+#endif /* HAVE_PTHREAD_SETAFFINITY_NP */
+
 #include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
 #include "../common/utils.h"
 #include "httpd-utils.h"
 
 
-char*
-br_readline(int socket)
-{
-    bc_string_t *rv = bc_string_new();
-    char buffer[READLINE_BUFFER_SIZE];
-    ssize_t len;
-    bool end = false;
-
-    while ((len = read(socket, buffer, READLINE_BUFFER_SIZE)) > 0) {
-        if (!end) {
-            for (ssize_t i = 0; i < len; i++) {
-                if (buffer[i] == '\r' || buffer[i] == '\n' || buffer[i] == '\0') {
-                    // we finished "recording", but still need to exhaust
-                    // request data.
-                    end = true;
-                    break;
-                }
-                bc_string_append_c(rv, buffer[i]);
-            }
-        }
-        if (len < READLINE_BUFFER_SIZE) {
-            break;
-        }
-    }
-
-    return bc_string_free(rv, false);
-}
-
-
 int
 br_hextoi(const char c)
 {
@@ -103,3 +88,135 @@ br_get_extension(const char *filename)
         return NULL;
     return ext;
 }
+
+
+char*
+br_httpd_get_ip(int af, const struct sockaddr *addr)
+{
+    char host[INET6_ADDRSTRLEN];
+    if (af == AF_INET6) {
+        struct sockaddr_in6 *a = (struct sockaddr_in6*) addr;
+        inet_ntop(af, &(a->sin6_addr), host, INET6_ADDRSTRLEN);
+    }
+    else {
+        struct sockaddr_in *a = (struct sockaddr_in*) addr;
+        inet_ntop(af, &(a->sin_addr), host, INET6_ADDRSTRLEN);
+    }
+    return bc_strdup(host);
+}
+
+
+// http dates are always in english, so strftime can't be used.
+static const char *days[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+static const char *months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+    "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+
+char*
+br_format_http_date(time_t t)
+{
+    struct tm tm;
+    if (gmtime_r(&t, &tm) == NULL)
+        return NULL;
+    return bc_strdup_printf("%s, %02d %s %04d %02d:%02d:%02d GMT",
+        days[tm.tm_wday], tm.tm_mday, months[tm.tm_mon], tm.tm_year + 1900,
+        tm.tm_hour, tm.tm_min, tm.tm_sec);
+}
+
+
+// days since the epoch, for the proleptic gregorian calendar. timegm(3)
+// isn't standard.
+static long long
+days_from_civil(long long y, int m, int d)
+{
+    y -= m <= 2;
+    long long era = (y >= 0 ? y : y - 399) / 400;
+    long long yoe = y - era * 400;
+    long long doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    long long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+
+// accepts the 3 formats from rfc7231, section 7.1.1.1.
+bool
+br_parse_http_date(const char *str, time_t *t)
+{
+    if (str == NULL)
+        return false;
+
+    char month[4];
+    int day, year, hour, min, sec;
+    int n = -1;
+
+    // Sun, 06 Nov 1994 08:49:37 GMT
+    sscanf(str, "%*3[A-Za-z], %2d %3[A-Za-z] %4d %2d:%2d:%2d GMT%n", &day,
+        month, &year, &hour, &min, &sec, &n);
+
+    // Sunday, 06-Nov-94 08:49:37 GMT
+    if (n == -1 || str[n] != '\0') {
+        n = -1;
+        sscanf(str, "%*[A-Za-z], %2d-%3[A-Za-z]-%2d %2d:%2d:%2d GMT%n", &day,
+            month, &year, &hour, &min, &sec, &n);
+        if (n != -1)
+            year += year < 70 ? 2000 : 1900;
+    }
+
+    // Sun Nov  6 08:49:37 1994
+    if (n == -1 || str[n] != '\0') {
+        n = -1;
+        sscanf(str, "%*3[A-Za-z] %3[A-Za-z] %2d %2d:%2d:%2d %4d%n", month,
+            &day, &hour, &min, &sec, &year, &n);
+    }
+
+    if (n == -1 || str[n] != '\0')
+        return false;
+
+    int m;
+    for (m = 0; m < 12; m++)
+        if (0 == strcmp(month, months[m]))
+            break;
+
+    if (m == 12 || day < 1 || day > 31 || hour > 23 || min > 59 || sec > 60)
+        return false;
+
+    *t = (time_t) (days_from_civil(year, m + 1, day) * 86400 + hour * 3600 +
+        min * 60 + sec);
+    return true;
+}
+
+
+// monotonic clock, in microseconds, to measure how long things take.
+long long
+br_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+// pins the calling thread to the n-th cpu it is allowed to run on, wrapping
+// around if there are fewer cpus than threads.
+bool
+br_pin_thread(size_t n)
+{
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+    cpu_set_t allowed;
+    if (0 != sched_getaffinity(0, sizeof(allowed), &allowed))
+        return false;
+    int count = CPU_COUNT(&allowed);
+    if (count <= 0)
+        return false;
+    n %= count;
+    for (size_t cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed) || n-- > 0)
+            continue;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return 0 == pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#endif /* HAVE_PTHREAD_SETAFFINITY_NP */
+    return false;
+}
@@ -9,11 +9,18 @@
 #ifndef _HTTPD_UTILS_H
 #define _HTTPD_UTILS_H
 
-#define READLINE_BUFFER_SIZE 2048
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+#include <sys/socket.h>
 
-char* br_readline(int socket);
 int br_hextoi(const char c);
 char* br_urldecode(const char *str);
 const char* br_get_extension(const char *filename);
+char* br_httpd_get_ip(int af, const struct sockaddr *addr);
+char* br_format_http_date(time_t t);
+bool br_parse_http_date(const char *str, time_t *t);
+long long br_now(void);
+bool br_pin_thread(size_t n);
 
 #endif /* _HTTPD_UTILS_H */
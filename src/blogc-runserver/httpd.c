@@ -15,46 +15,90 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/time.h>
 #include <netdb.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <pthread.h>
-#include "../common/error.h"
-#include "../common/file.h"
 #include "../common/utils.h"
-#include "mime.h"
+#include "access-log.h"
+#include "cache.h"
+#include "compress.h"
+#include "httpd.h"
 #include "httpd-utils.h"
+#include "loop.h"
+#include "request-parser.h"
+#include "request.h"
+#include "stats.h"
 
 #define LISTEN_BACKLOG 100
+#define READ_BUFFER_SIZE 8192
+#define ACCEPT_RETRY_DELAY 100000  // usec
+
+// a connection being served by a thread. idle connections are waiting for
+// the first byte of a request, and may be closed to make room for new ones.
+typedef struct {
+    int socket;
+    bool busy;
+    bool idle;
+} slot_t;
 
 typedef struct {
     pthread_t thread;
-    bool initialized;
-} thread_data_t;
+    size_t id;
+    int socket;
+    int ai_family;
+    size_t max_threads;
+    bool pin_cpu;
+    br_server_t *server;
+
+    // connection threads are detached, and take a slot while running. the
+    // accept loop waits for a free slot, closing idle connections if needed.
+    slot_t *slots;
+    bool full;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+} worker_t;
 
 typedef struct {
-    size_t thread_id;
+    size_t slot;
     int socket;
     char *ip;
-    const char *docroot;
+    worker_t *worker;
 } request_data_t;
 
 
 static void
-error(int socket, int status_code, const char *error)
+set_timeout(int socket, int option, long timeout)
 {
-    char *str = bc_strdup_printf(
-        "HTTP/1.0 %d %s\r\n"
-        "Content-Type: text/html\r\n"
-        "Content-Length: %zu\r\n"
-        "Connection: close\r\n"
-        "\r\n"
-        "<h1>%s</h1>\n", status_code, error, strlen(error) + 10, error);
-    size_t str_len = strlen(str);
-    if (str_len != write(socket, str, str_len)) {
-        fprintf(stderr, "warning: Failed to write full response header!\n");
+    struct timeval tv = {
+        .tv_sec = timeout / 1000,
+        .tv_usec = (timeout % 1000) * 1000,
+    };
+    if (0 != setsockopt(socket, SOL_SOCKET, option, &tv, sizeof(tv))) {
+        fprintf(stderr, "warning: Failed to set socket timeout: %s\n",
+            strerror(errno));
     }
-    free(str);
+}
+
+
+static void
+set_idle(worker_t *worker, size_t slot, bool idle)
+{
+    pthread_mutex_lock(&worker->mutex);
+    worker->slots[slot].idle = idle;
+    pthread_mutex_unlock(&worker->mutex);
+}
+
+
+// while the worker waits for a free slot, connections aren't kept alive.
+static bool
+is_full(worker_t *worker)
+{
+    pthread_mutex_lock(&worker->mutex);
+    bool full = worker->full;
+    pthread_mutex_unlock(&worker->mutex);
+    return full;
 }
 
 
@@ -62,194 +106,324 @@ static void*
 handle_request(void *arg)
 {
     request_data_t *req = arg;
-    size_t thread_id = req->thread_id;
     int client_socket = req->socket;
     char *ip = req->ip;
-    const char *docroot = req->docroot;
+    worker_t *worker = req->worker;
+    size_t slot = req->slot;
+    br_server_t *server = worker->server;
+    br_stats_thread_t *stats = br_stats_thread(server->stats,
+        worker->id * worker->max_threads + slot);
     free(arg);
 
-    char *conn_line = br_readline(client_socket);
-    if (conn_line == NULL || conn_line[0] == '\0')
-        goto point0;
+    br_stats_connection(stats, 1);
 
-    unsigned short status_code = 200;
+    // blocking sockets can't have a deadline for the whole request, so the
+    // timeouts are per read/write call here.
+    set_timeout(client_socket, SO_RCVTIMEO, BR_READ_TIMEOUT);
+    set_timeout(client_socket, SO_SNDTIMEO, BR_WRITE_TIMEOUT);
 
-    char **pieces = bc_str_split(conn_line, ' ', 3);
-    if (bc_strv_length(pieces) != 3) {
-        status_code = 400;
-        error(client_socket, 400, "Bad Request");
-        goto point1;
-    }
+    br_request_parser_t *parser = br_request_parser_new();
+    char buffer[READ_BUFFER_SIZE];
+    size_t len = 0;
+    size_t pos = 0;
+    size_t requests = 0;
+    long long start = 0;
 
-    if (strcmp(pieces[0], "GET") != 0) {
-        status_code = 405;
-        error(client_socket, 405, "Method Not Allowed");
-        goto point1;
-    }
+    while (1) {
+        if (pos == len) {
+            // kept alive, and nothing of the next request was received yet
+            bool idle = requests > 0 && start == 0;
+            if (idle)
+                set_idle(worker, slot, true);
+            ssize_t n = read(client_socket, buffer, READ_BUFFER_SIZE);
+            if (idle)
+                set_idle(worker, slot, false);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                break;
+            len = n;
+            pos = 0;
+        }
 
-    char **pieces2 = bc_str_split(pieces[1], '?', 2);
-    char *path = br_urldecode(pieces2[0]);
-    bc_strv_free(pieces2);
+        if (start == 0)
+            start = br_now();
 
-    if (path == NULL) {
-        status_code = 400;
-        error(client_socket, 400, "Bad Request");
-        goto point2;
-    }
+        pos += br_request_parser_parse(parser, buffer + pos, len - pos);
 
-    char *abs_path = bc_strdup_printf("%s/%s", docroot, path);
-    char *real_path = realpath(abs_path, NULL);
-    free(abs_path);
+        br_response_t *res;
+        if (parser->state == BR_REQUEST_PARSER_ERROR)
+            res = br_response_error(parser->error, false);
+        else if (parser->state == BR_REQUEST_PARSER_DONE)
+            res = br_request_handle(server, &(parser->request),
+                parser->request.keep_alive && !is_full(worker) &&
+                ++requests < BR_KEEPALIVE_MAX_REQUESTS);
+        else
+            continue;
 
-    if (real_path == NULL) {
-        status_code = 404;
-        error(client_socket, 404, "Not Found");
-        goto point2;
-    }
+        bool keep_alive = res->keep_alive;
+        if (1 != br_response_send(res, client_socket)) {
+            fprintf(stderr, "warning: Failed to write full response: %s\n",
+                strerror(errno));
+            keep_alive = false;
+        }
 
-    char *real_root = realpath(docroot, NULL);
-    if (real_root == NULL) {
-        status_code = 500;
-        error(client_socket, 500, "Internal Server Error");
-        goto point3;
-    }
+        long long latency = br_now() - start;
+        br_access_log_write(server->access_log, ip, &(parser->request), res,
+            latency);
+        br_stats_request(stats, res, latency);
+        br_stats_busy(stats, latency);
+        br_response_free(res);
+        start = 0;
 
-    if (0 != strncmp(real_root, real_path, strlen(real_root))) {
-        status_code = 404;
-        error(client_socket, 404, "Not Found");
-        goto point4;
-    }
+        if (!keep_alive)
+            break;
 
-    struct stat st;
-    if (0 > stat(real_path, &st)) {
-        status_code = 404;
-        error(client_socket, 404, "Not Found");
-        goto point4;
+        if (requests == 1)
+            set_timeout(client_socket, SO_RCVTIMEO, BR_KEEPALIVE_TIMEOUT);
+        br_request_parser_reset(parser);
     }
 
-    bool add_slash = false;
-
-    if (S_ISDIR(st.st_mode)) {
-        char *found = br_mime_guess_index(real_path);
+    br_request_parser_free(parser);
+    br_stats_connection(stats, -1);
+    free(ip);
 
-        if (found == NULL) {
-            status_code = 403;
-            error(client_socket, 403, "Forbidden");
-            goto point4;
-        }
+    // the socket is closed with the lock held, so the accept loop never shuts
+    // down a descriptor that was reused by another connection.
+    pthread_mutex_lock(&worker->mutex);
+    close(client_socket);
+    worker->slots[slot].busy = false;
+    worker->slots[slot].idle = false;
+    pthread_cond_signal(&worker->cond);
+    pthread_mutex_unlock(&worker->mutex);
+    return NULL;
+}
 
-        size_t path_len = strlen(path);
-        if (path_len > 0 && path[path_len - 1] != '/')
-            add_slash = true;
 
-        free(real_path);
-        real_path = found;
+static u_int16_t
+br_httpd_get_port(int af, const struct sockaddr *addr)
+{
+    in_port_t port = 0;
+    if (af == AF_INET6) {
+        struct sockaddr_in6 *a = (struct sockaddr_in6*) addr;
+        port = a->sin6_port;
     }
-
-    if (0 != access(real_path, F_OK)) {
-        status_code = 500;
-        error(client_socket, 500, "Internal Server Error");
-        goto point4;
+    else {
+        struct sockaddr_in *a = (struct sockaddr_in*) addr;
+        port = a->sin_port;
     }
+    return ntohs(port);
+}
 
-    if (add_slash) {
-        // production webservers usually returns 301 in such cases, but 302 is
-        // better for development/testing.
-        char *tmp = bc_strdup_printf(
-            "HTTP/1.0 302 Found\r\n"
-            "Location: %s/\r\n"
-            "Content-Length: 0\r\n"
-            "Connection: close\r\n"
-            "\r\n", path);
-        status_code = 302;
-        size_t tmp_len = strlen(tmp);
-        if (tmp_len != write(client_socket, tmp, tmp_len)) {
-            fprintf(stderr, "warning: Failed to write full response header!\n");
+
+// opens a listening socket. with reuse_port, several sockets can listen on
+// the same address, and the kernel spreads new connections over them.
+static int
+listen_socket(const struct addrinfo *rp, bool reuse_port, const char **error)
+{
+    int server_socket = socket(rp->ai_family, rp->ai_socktype,
+        rp->ai_protocol);
+    if (server_socket == -1) {
+        *error = "Failed to open server socket";
+        return -1;
+    }
+    int value = 1;
+    if (0 > setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &value,
+        sizeof(int)))
+    {
+        *error = "Failed to set socket option";
+        goto error;
+    }
+    if (reuse_port) {
+#ifdef SO_REUSEPORT
+        if (0 > setsockopt(server_socket, SOL_SOCKET, SO_REUSEPORT, &value,
+            sizeof(int)))
+        {
+            *error = "Failed to set socket option";
+            goto error;
         }
-        free(tmp);
-        goto point4;
+#else
+        *error = "Failed to set socket option";
+        errno = ENOPROTOOPT;
+        goto error;
+#endif /* SO_REUSEPORT */
     }
-
-    size_t len;
-    bc_error_t *err = NULL;
-    char* contents = bc_file_get_contents(real_path, false, &len, &err);
-    if (err != NULL) {
-        status_code = 500;
-        error(client_socket, 500, "Internal Server Error");
-        bc_error_free(err);
-        goto point4;
+    if (0 != bind(server_socket, rp->ai_addr, rp->ai_addrlen)) {
+        *error = "Failed to bind to server socket";
+        goto error;
     }
-
-    char *out = bc_strdup_printf(
-        "HTTP/1.0 200 OK\r\n"
-        "Content-Type: %s\r\n"
-        "Content-Length: %zu\r\n"
-        "Connection: close\r\n"
-        "\r\n", br_mime_guess_content_type(real_path), len);
-    size_t out_len = strlen(out);
-    if (out_len != write(client_socket, out, out_len)) {
-        fprintf(stderr, "warning: Failed to write full response header!\n");
+    if (-1 == listen(server_socket, LISTEN_BACKLOG)) {
+        *error = "Failed to listen to server socket";
+        goto error;
     }
-    free(out);
+    return server_socket;
 
-    if (len != write(client_socket, contents, len)) {
-        fprintf(stderr, "warning: Failed to write full response body!\n");
-    }
-    free(contents);
-
-point4:
-    free(real_root);
-point3:
-    free(real_path);
-point2:
-    free(path);
-point1:
-    fprintf(stderr, "[Thread-%zu] %s - - \"%s\" %d\n", thread_id + 1,
-        ip, conn_line, status_code);
-    free(conn_line);
-    bc_strv_free(pieces);
-point0:
-    free(ip);
-    close(client_socket);
-    return NULL;
+error:
+    value = errno;
+    close(server_socket);
+    errno = value;
+    return -1;
 }
 
 
-static char*
-br_httpd_get_ip(int af, const struct sockaddr *addr)
+// waits for a free slot. if there is none, idle keep-alive connections are
+// shut down, their threads notice it and release their slots.
+static size_t
+acquire_slot(worker_t *worker)
 {
-    char host[INET6_ADDRSTRLEN];
-    if (af == AF_INET6) {
-        struct sockaddr_in6 *a = (struct sockaddr_in6*) addr;
-        inet_ntop(af, &(a->sin6_addr), host, INET6_ADDRSTRLEN);
+    pthread_mutex_lock(&worker->mutex);
+    while (1) {
+        for (size_t i = 0; i < worker->max_threads; i++) {
+            if (!worker->slots[i].busy) {
+                worker->slots[i].busy = true;
+                worker->slots[i].idle = false;
+                worker->full = false;
+                pthread_mutex_unlock(&worker->mutex);
+                return i;
+            }
+        }
+        worker->full = true;
+        for (size_t i = 0; i < worker->max_threads; i++) {
+            if (worker->slots[i].idle) {
+                shutdown(worker->slots[i].socket, SHUT_RDWR);
+                worker->slots[i].idle = false;
+            }
+        }
+        pthread_cond_wait(&worker->cond, &worker->mutex);
     }
-    else {
-        struct sockaddr_in *a = (struct sockaddr_in*) addr;
-        inet_ntop(af, &(a->sin_addr), host, INET6_ADDRSTRLEN);
+}
+
+
+// errors that only affect the connection being accepted, or that go away by
+// themselves, like running out of file descriptors.
+static bool
+accept_retry(int err, bool *exhausted)
+{
+    switch (err) {
+        case EINTR:
+        case EAGAIN:
+#if EWOULDBLOCK != EAGAIN
+        case EWOULDBLOCK:
+#endif
+        case ECONNABORTED:
+        case EPROTO:
+        case EPERM:
+        case ENETDOWN:
+        case ENETUNREACH:
+        case EHOSTDOWN:
+        case EHOSTUNREACH:
+        case ENOPROTOOPT:
+        case EOPNOTSUPP:
+#ifdef ENONET
+        case ENONET:
+#endif
+            return true;
+        case EMFILE:
+        case ENFILE:
+        case ENOBUFS:
+        case ENOMEM:
+            if (!*exhausted)
+                fprintf(stderr, "warning: Failed to accept connection: %s\n",
+                    strerror(err));
+            *exhausted = true;
+            usleep(ACCEPT_RETRY_DELAY);
+            return true;
     }
-    return bc_strdup(host);
+    return false;
 }
 
 
-static u_int16_t
-br_httpd_get_port(int af, const struct sockaddr *addr)
+// accepts connections from the worker socket, spawning a detached thread for
+// each of them, up to max_threads at once. the threads inherit the cpu
+// affinity of the worker. on errors the worker closes its socket before
+// returning, so connections go to the other workers instead of waiting for
+// this one.
+static int
+worker_run(worker_t *worker)
 {
-    in_port_t port = 0;
-    if (af == AF_INET6) {
-        struct sockaddr_in6 *a = (struct sockaddr_in6*) addr;
-        port = a->sin6_port;
+    if (worker->pin_cpu && !br_pin_thread(worker->id))
+        fprintf(stderr, "warning: Failed to pin worker %zu to a CPU\n",
+            worker->id + 1);
+
+    pthread_attr_t attr;
+    if (0 != pthread_attr_init(&attr) ||
+        0 != pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED))
+    {
+        fprintf(stderr, "Failed to initialize thread attributes\n");
+        close(worker->socket);
+        return 3;
     }
-    else {
-        struct sockaddr_in *a = (struct sockaddr_in*) addr;
-        port = a->sin_port;
+
+    bool exhausted = false;
+
+    while (1) {
+        struct sockaddr_in6 addr6;
+        struct sockaddr_in addr;
+
+        socklen_t addrlen;
+        struct sockaddr *client_addr = NULL;
+
+        if (worker->ai_family == AF_INET6) {
+            addrlen = sizeof(addr6);
+            client_addr = (struct sockaddr*) &addr6;
+        }
+        else {
+            addrlen = sizeof(addr);
+            client_addr = (struct sockaddr*) &addr;
+        }
+
+        int client_socket = accept(worker->socket, client_addr, &addrlen);
+        if (client_socket == -1) {
+            if (accept_retry(errno, &exhausted))
+                continue;
+            fprintf(stderr, "Failed to accept connection: %s\n",
+                strerror(errno));
+            break;
+        }
+        exhausted = false;
+
+        size_t slot = acquire_slot(worker);
+        worker->slots[slot].socket = client_socket;
+
+        request_data_t *arg = bc_malloc(sizeof(request_data_t));
+        arg->slot = slot;
+        arg->socket = client_socket;
+        arg->ip = br_httpd_get_ip(worker->ai_family, client_addr);
+        arg->worker = worker;
+
+        pthread_t thread;
+        if (pthread_create(&thread, &attr, handle_request, arg) != 0) {
+            fprintf(stderr, "Failed to create thread\n");
+            pthread_mutex_lock(&worker->mutex);
+            close(client_socket);
+            worker->slots[slot].busy = false;
+            pthread_mutex_unlock(&worker->mutex);
+            free(arg->ip);
+            free(arg);
+            break;
+        }
     }
-    return ntohs(port);
+
+    close(worker->socket);
+    pthread_attr_destroy(&attr);
+    return 3;
+}
+
+
+static void*
+worker_thread(void *arg)
+{
+    worker_t *worker = arg;
+    if (0 != worker_run(worker))
+        fprintf(stderr, "Worker %zu stopped\n", worker->id + 1);
+    return NULL;
 }
 
 
 int
 br_httpd_run(const char *host, const char *port, const char *docroot,
-    size_t max_threads)
+    size_t max_threads, bool event_loop, const char *log_file, bool stats,
+    size_t workers, bool pin_cpus)
 {
     int err;
     struct addrinfo *result;
@@ -268,14 +442,15 @@ br_httpd_run(const char *host, const char *port, const char *docroot,
         return 3;
     }
 
-    thread_data_t threads[max_threads];
-    for (size_t i = 0; i < max_threads; i++)
-        threads[i].initialized = false;
+    // without workers, a single socket is shared by all threads.
+    size_t num_sockets = workers > 0 ? workers : 1;
+    int server_sockets[num_sockets];
+    size_t opened = 0;
 
     int rv = 0;
 
     struct addrinfo *rp;
-    int server_socket = 0;
+    const char *error = NULL;
 
     int ai_family = 0;
     char *final_host = NULL;
@@ -284,48 +459,41 @@ br_httpd_run(const char *host, const char *port, const char *docroot,
     for (rp = result; rp != NULL; rp = rp->ai_next) {
         final_host = br_httpd_get_ip(rp->ai_family, rp->ai_addr);
         final_port = br_httpd_get_port(rp->ai_family, rp->ai_addr);
-        server_socket = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
-        if (server_socket == -1) {
-            if (rp->ai_next == NULL) {
-                fprintf(stderr, "Failed to open server socket (%s:%d): %s\n",
-                    final_host, final_port, strerror(errno));
-                rv = 3;
-                goto cleanup0;
-            }
-            continue;
-        }
-        int value = 1;
-        if (0 > setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &value,
-            sizeof(int)))
-        {
-            if (rp->ai_next == NULL) {
-                fprintf(stderr, "Failed to set socket option (%s:%d): %s\n",
-                    final_host, final_port, strerror(errno));
-                rv = 3;
-                goto cleanup;
-            }
-            close(server_socket);
-            continue;
-        }
-        if (0 == bind(server_socket, rp->ai_addr, rp->ai_addrlen)) {
+        server_sockets[0] = listen_socket(rp, workers > 0, &error);
+        if (server_sockets[0] != -1) {
             ai_family = rp->ai_family;
+            opened++;
             break;
         }
-        else {
-            if (rp->ai_next == NULL) {
-                fprintf(stderr, "Failed to bind to server socket (%s:%d): %s\n",
-                    final_host, final_port, strerror(errno));
-                rv = 3;
-                goto cleanup;
-            }
+        if (rp->ai_next == NULL) {
+            fprintf(stderr, "%s (%s:%d): %s\n", error, final_host, final_port,
+                strerror(errno));
+            rv = 3;
+            goto cleanup;
         }
         free(final_host);
-        close(server_socket);
     }
 
-    if (-1 == listen(server_socket, LISTEN_BACKLOG)) {
-        fprintf(stderr, "Failed to listen to server socket (%s:%d): %s\n",
-            final_host, final_port, strerror(errno));
+    for (; opened < num_sockets; opened++) {
+        server_sockets[opened] = listen_socket(rp, true, &error);
+        if (server_sockets[opened] == -1) {
+            fprintf(stderr, "%s (%s:%d): %s\n", error, final_host, final_port,
+                strerror(errno));
+            rv = 3;
+            goto cleanup;
+        }
+    }
+
+    // like the caches, the access log is never freed.
+    br_access_log_t *access_log = br_access_log_new(log_file);
+    if (access_log == NULL) {
+        fprintf(stderr, "Failed to open access log (%s): %s\n", log_file,
+            strerror(errno));
+        rv = 3;
+        goto cleanup;
+    }
+    if (!br_access_log_start(access_log)) {
+        fprintf(stderr, "Failed to create access log thread\n");
         rv = 3;
         goto cleanup;
     }
@@ -337,70 +505,93 @@ br_httpd_run(const char *host, const char *port, const char *docroot,
         fprintf(stderr, "%s", final_host);
     if (final_port != 80)
         fprintf(stderr, ":%d", final_port);
-    fprintf(stderr, "/ (max threads: %zu)\n"
-        "\n"
+    if (event_loop)
+        fprintf(stderr, "/ (event loop threads: %zu", max_threads);
+    else
+        fprintf(stderr, "/ (max threads: %zu", max_threads);
+    if (workers > 0)
+        fprintf(stderr, ", workers: %zu", workers);
+    fprintf(stderr, ")\n");
+    if (stats)
+        fprintf(stderr, " * Stats available at %s\n", BR_STATS_PATH);
+    fprintf(stderr, "\n"
         "WARNING!!! This is a development server, DO NOT RUN IT IN PRODUCTION!\n"
-        "\n", max_threads);
-
-    size_t current_thread = 0;
-
-    while (1) {
-        struct sockaddr_in6 addr6;
-        struct sockaddr_in addr;
-
-        socklen_t addrlen;
-        struct sockaddr *client_addr = NULL;
-
-        if (ai_family == AF_INET6) {
-            addrlen = sizeof(addr6);
-            client_addr = (struct sockaddr*) &addr6;
-        }
-        else {
-            addrlen = sizeof(addr);
-            client_addr = (struct sockaddr*) &addr;
-        }
+        "\n");
+
+    // the caches and the stats are shared by all threads, and the ones still
+    // running when we return may be using them, so the server is never freed.
+    // compressed files are cached by their validators, they don't need the
+    // docroot watcher.
+    br_server_t *server = bc_malloc(sizeof(br_server_t));
+    server->docroot = docroot;
+    server->cache = br_cache_new(BR_CACHE_MAX_ENTRIES, BR_CACHE_MAX_SIZE);
+    server->indexes = br_cache_new(BR_CACHE_MAX_ENTRIES, BR_CACHE_MAX_SIZE);
+    server->compressed = br_cache_new(BR_COMPRESS_CACHE_MAX_ENTRIES,
+        BR_COMPRESS_CACHE_MAX_SIZE);
+    server->access_log = access_log;
+    server->stats = stats ? br_stats_new(event_loop ? max_threads :
+        num_sockets * max_threads) : NULL;
+    br_cache_link(server->cache, server->indexes);
+    if (!br_cache_watch(server->cache, docroot)) {
+        fprintf(stderr, "warning: Running without file cache\n\n");
+        br_cache_free(server->cache);
+        br_cache_free(server->indexes);
+        server->cache = NULL;
+        server->indexes = NULL;
+    }
 
-        int client_socket = accept(server_socket, client_addr, &addrlen);
-        if (client_socket == -1) {
-            fprintf(stderr, "Failed to accept connection: %s\n", strerror(errno));
-            rv = 3;
-            goto cleanup;
-        }
+    if (event_loop) {
+        rv = br_loop_run(server_sockets, num_sockets, server, max_threads,
+            pin_cpus);
+        goto cleanup;
+    }
 
-        request_data_t *arg = malloc(sizeof(request_data_t));
-        arg->thread_id = current_thread;
-        arg->socket = client_socket;
-        arg->ip = br_httpd_get_ip(ai_family, client_addr);
-        arg->docroot = docroot;
-
-        if (threads[current_thread].initialized) {
-            if (pthread_join(threads[current_thread].thread, NULL) != 0) {
-                fprintf(stderr, "Failed to join thread\n");
-                free(arg->ip);
-                free(arg);
-                rv = 3;
-                goto cleanup;
-            }
+    // each worker accepts from its own socket, with its own threads. like the
+    // loops, the workers are never freed, other threads may still use them.
+    worker_t *w = bc_malloc(num_sockets * sizeof(worker_t));
+    for (size_t i = 0; i < num_sockets; i++) {
+        w[i].id = i;
+        w[i].socket = server_sockets[i];
+        w[i].ai_family = ai_family;
+        w[i].max_threads = max_threads;
+        w[i].pin_cpu = pin_cpus;
+        w[i].server = server;
+        w[i].slots = bc_malloc(max_threads * sizeof(slot_t));
+        for (size_t j = 0; j < max_threads; j++) {
+            w[i].slots[j].socket = -1;
+            w[i].slots[j].busy = false;
+            w[i].slots[j].idle = false;
         }
+        w[i].full = false;
+        pthread_mutex_init(&w[i].mutex, NULL);
+        pthread_cond_init(&w[i].cond, NULL);
+    }
 
-        if (pthread_create(&(threads[current_thread].thread), NULL,
-            handle_request, arg) != 0)
+    // the workers only return on errors, closing their sockets, and the
+    // others keep running. we return when all of them stopped. if some worker
+    // can't be started, the ones already running are stopped by shutting down
+    // their sockets, that makes accept fail.
+    size_t started = 0;
+    for (; started < num_sockets; started++) {
+        if (pthread_create(&(w[started].thread), NULL, worker_thread,
+            &w[started]) != 0)
         {
-            fprintf(stderr, "Failed to create thread\n");
-            rv = 3;
-            goto cleanup;
+            fprintf(stderr, "Failed to create worker thread\n");
+            for (size_t i = 0; i < started; i++)
+                shutdown(w[i].socket, SHUT_RDWR);
+            break;
         }
-
-        threads[current_thread++].initialized = true;
-
-        if (current_thread >= max_threads)
-            current_thread = 0;
     }
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(w[i].thread, NULL);
+        server_sockets[i] = -1;
+    }
+    rv = 3;
 
 cleanup:
-    close(server_socket);
-
-cleanup0:
+    for (size_t i = 0; i < opened; i++)
+        if (server_sockets[i] != -1)
+            close(server_sockets[i]);
     free(final_host);
     freeaddrinfo(result);
     return rv;
@@ -9,7 +9,22 @@
 #ifndef _HTTPD_H
 #define _HTTPD_H
 
+#include <stdbool.h>
+#include <stddef.h>
+
+// timeouts, in milliseconds. the read timeout covers the whole request
+// header, the write timeout is reset whenever the client reads something,
+// and the keep-alive timeout is how long an idle connection is kept open
+// waiting for the next request.
+#define BR_READ_TIMEOUT 10000
+#define BR_WRITE_TIMEOUT 30000
+#define BR_KEEPALIVE_TIMEOUT 5000
+
+// persistent connections are closed after this many requests
+#define BR_KEEPALIVE_MAX_REQUESTS 100
+
 int br_httpd_run(const char *host, const char *port, const char *docroot,
-    size_t max_threads);
+    size_t max_threads, bool event_loop, const char *log_file, bool stats,
+    size_t workers, bool pin_cpus);
 
 #endif /* _HTTPD_H */
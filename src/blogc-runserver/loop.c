@@ -0,0 +1,497 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <stdio.h>
+#include "loop.h"
+
+#ifdef HAVE_SYS_EPOLL_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include "../common/utils.h"
+#include "access-log.h"
+#include "httpd.h"
+#include "httpd-utils.h"
+#include "request-parser.h"
+#include "request.h"
+#include "stats.h"
+
+#define LOOP_MAX_EVENTS 64
+#define LOOP_MAX_ACCEPT 16
+#define LOOP_BUFFER_SIZE 8192
+
+typedef enum {
+    CONN_IDLE = 1,
+    CONN_READING,
+    CONN_WRITING,
+} conn_state_t;
+
+typedef struct conn {
+    struct conn *prev;
+    struct conn *next;
+    int socket;
+    char *ip;
+    conn_state_t state;
+    long long deadline;
+    bool want_write;
+    size_t requests;
+    long long start;
+    br_request_parser_t *parser;
+    br_response_t *response;
+    size_t buffer_len;
+    size_t buffer_pos;
+    char buffer[LOOP_BUFFER_SIZE];
+} conn_t;
+
+typedef struct {
+    conn_t *head;
+    conn_t *tail;
+    long long timeout;
+} conn_list_t;
+
+typedef struct {
+    size_t id;
+    pthread_t thread;
+    int epoll_fd;
+    int server_socket;
+    bool pin_cpu;
+    br_server_t *server;
+    br_stats_thread_t *stats;
+    conn_list_t idle;
+    conn_list_t reading;
+    conn_list_t writing;
+} loop_t;
+
+
+static long long
+now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+// all the connections in a list share the same timeout, so appending keeps
+// the list sorted by deadline, and finding expired connections is just a
+// matter of looking at the head.
+static void
+list_append(conn_list_t *list, conn_t *c)
+{
+    c->deadline = now_ms() + list->timeout;
+    c->prev = list->tail;
+    c->next = NULL;
+    if (list->tail != NULL)
+        list->tail->next = c;
+    else
+        list->head = c;
+    list->tail = c;
+}
+
+
+static void
+list_remove(conn_list_t *list, conn_t *c)
+{
+    if (c->prev != NULL)
+        c->prev->next = c->next;
+    else
+        list->head = c->next;
+    if (c->next != NULL)
+        c->next->prev = c->prev;
+    else
+        list->tail = c->prev;
+    c->prev = NULL;
+    c->next = NULL;
+}
+
+
+static conn_list_t*
+conn_list(loop_t *loop, conn_t *c)
+{
+    switch (c->state) {
+        case CONN_IDLE:
+            return &loop->idle;
+        case CONN_READING:
+            return &loop->reading;
+        default:
+            return &loop->writing;
+    }
+}
+
+
+static void
+conn_set_state(loop_t *loop, conn_t *c, conn_state_t state)
+{
+    list_remove(conn_list(loop, c), c);
+    c->state = state;
+    list_append(conn_list(loop, c), c);
+}
+
+
+static void
+conn_close(loop_t *loop, conn_t *c)
+{
+    list_remove(conn_list(loop, c), c);
+    br_stats_connection(loop->stats, -1);
+    close(c->socket);
+    free(c->ip);
+    br_request_parser_free(c->parser);
+    br_response_free(c->response);
+    free(c);
+}
+
+
+static void
+conn_log(loop_t *loop, conn_t *c)
+{
+    long long latency = br_now() - c->start;
+    br_access_log_write(loop->server->access_log, c->ip, &(c->parser->request),
+        c->response, latency);
+    br_stats_request(loop->stats, c->response, latency);
+    c->start = 0;
+}
+
+
+// returns true if the response was sent and the connection is ready for the
+// next request.
+static bool
+conn_write(loop_t *loop, conn_t *c)
+{
+    size_t start = c->response->sent;
+    bool keep_alive = c->response->keep_alive;
+
+    switch (br_response_send(c->response, c->socket)) {
+        case 1:
+            break;
+
+        case 0:
+            // socket buffer is full. the client is still reading, so it gets
+            // a new deadline, and we wait for the socket to become writable.
+            if (c->response->sent > start)
+                conn_set_state(loop, c, CONN_WRITING);
+            if (c->want_write)
+                return false;
+            struct epoll_event ev = {.events = EPOLLOUT, .data.ptr = c};
+            if (0 == epoll_ctl(loop->epoll_fd, EPOLL_CTL_MOD, c->socket, &ev)) {
+                c->want_write = true;
+                return false;
+            }
+            fprintf(stderr, "warning: Failed to watch connection: %s\n",
+                strerror(errno));
+            keep_alive = false;
+            break;
+
+        default:
+            fprintf(stderr, "warning: Failed to write full response: %s\n",
+                strerror(errno));
+            keep_alive = false;
+    }
+
+    conn_log(loop, c);
+    br_response_free(c->response);
+    c->response = NULL;
+    br_request_parser_reset(c->parser);
+
+    if (keep_alive && c->want_write) {
+        struct epoll_event ev = {.events = EPOLLIN, .data.ptr = c};
+        if (0 != epoll_ctl(loop->epoll_fd, EPOLL_CTL_MOD, c->socket, &ev)) {
+            fprintf(stderr, "warning: Failed to watch connection: %s\n",
+                strerror(errno));
+            keep_alive = false;
+        }
+        c->want_write = false;
+    }
+
+    if (!keep_alive) {
+        conn_close(loop, c);
+        return false;
+    }
+
+    conn_set_state(loop, c, CONN_IDLE);
+    return true;
+}
+
+
+static void
+conn_read(loop_t *loop, conn_t *c)
+{
+    // pipelined requests are already in the buffer when the previous response
+    // is done, so we keep parsing until the buffer is empty and the socket has
+    // nothing else to read.
+    while (1) {
+        if (c->buffer_pos == c->buffer_len) {
+            ssize_t n = read(c->socket, c->buffer, LOOP_BUFFER_SIZE);
+            if (n == 0) {
+                conn_close(loop, c);
+                return;
+            }
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    conn_close(loop, c);
+                return;
+            }
+            c->buffer_len = n;
+            c->buffer_pos = 0;
+        }
+
+        // the read timeout starts with the first byte of the request
+        if (c->state == CONN_IDLE)
+            conn_set_state(loop, c, CONN_READING);
+        if (c->start == 0)
+            c->start = br_now();
+
+        c->buffer_pos += br_request_parser_parse(c->parser,
+            c->buffer + c->buffer_pos, c->buffer_len - c->buffer_pos);
+
+        if (c->parser->state == BR_REQUEST_PARSER_ERROR)
+            c->response = br_response_error(c->parser->error, false);
+        else if (c->parser->state == BR_REQUEST_PARSER_DONE)
+            c->response = br_request_handle(loop->server,
+                &(c->parser->request), c->parser->request.keep_alive &&
+                ++c->requests < BR_KEEPALIVE_MAX_REQUESTS);
+        else
+            continue;
+
+        conn_set_state(loop, c, CONN_WRITING);
+        if (!conn_write(loop, c))
+            return;
+    }
+}
+
+
+static void
+loop_accept(loop_t *loop)
+{
+    // accept a few connections at a time, so that a burst of connections is
+    // spread over all the threads instead of piling up on the one that woke up
+    // first.
+    for (size_t i = 0; i < LOOP_MAX_ACCEPT; i++) {
+        struct sockaddr_storage addr;
+        socklen_t addrlen = sizeof(addr);
+
+        int client_socket = accept4(loop->server_socket,
+            (struct sockaddr*) &addr, &addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_socket == -1) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                fprintf(stderr, "warning: Failed to accept connection: %s\n",
+                    strerror(errno));
+            return;
+        }
+
+        conn_t *c = bc_malloc(sizeof(conn_t));
+        c->socket = client_socket;
+        c->ip = br_httpd_get_ip(addr.ss_family, (struct sockaddr*) &addr);
+        c->state = CONN_READING;
+        c->want_write = false;
+        c->requests = 0;
+        c->start = 0;
+        c->parser = br_request_parser_new();
+        c->response = NULL;
+        c->buffer_len = 0;
+        c->buffer_pos = 0;
+
+        struct epoll_event ev = {.events = EPOLLIN, .data.ptr = c};
+        if (0 != epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, client_socket, &ev)) {
+            fprintf(stderr, "warning: Failed to watch connection: %s\n",
+                strerror(errno));
+            close(client_socket);
+            br_request_parser_free(c->parser);
+            free(c->ip);
+            free(c);
+            continue;
+        }
+
+        list_append(&loop->reading, c);
+        br_stats_connection(loop->stats, 1);
+    }
+}
+
+
+static int
+loop_expire(loop_t *loop)
+{
+    long long now = now_ms();
+
+    while (loop->idle.head != NULL && loop->idle.head->deadline <= now)
+        conn_close(loop, loop->idle.head);
+
+    while (loop->reading.head != NULL && loop->reading.head->deadline <= now)
+        conn_close(loop, loop->reading.head);
+
+    while (loop->writing.head != NULL && loop->writing.head->deadline <= now) {
+        fprintf(stderr, "warning: Timed out writing response\n");
+        conn_log(loop, loop->writing.head);
+        conn_close(loop, loop->writing.head);
+    }
+
+    long long next = -1;
+    conn_list_t *lists[] = {&loop->idle, &loop->reading, &loop->writing};
+    for (size_t i = 0; i < 3; i++) {
+        if (lists[i]->head != NULL &&
+            (next == -1 || lists[i]->head->deadline < next))
+            next = lists[i]->head->deadline;
+    }
+
+    return next == -1 ? -1 : (int) (next - now);
+}
+
+
+static void*
+loop_thread(void *arg)
+{
+    loop_t *loop = arg;
+    struct epoll_event events[LOOP_MAX_EVENTS];
+
+    if (loop->pin_cpu && !br_pin_thread(loop->id))
+        fprintf(stderr, "warning: Failed to pin thread %zu to a CPU\n",
+            loop->id + 1);
+
+    while (1) {
+        int n = epoll_wait(loop->epoll_fd, events, LOOP_MAX_EVENTS,
+            loop_expire(loop));
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "Failed to wait for events: %s\n", strerror(errno));
+            break;
+        }
+
+        // the time spent out of epoll_wait is the time the thread is busy.
+        long long start = loop->stats != NULL ? br_now() : 0;
+
+        for (int i = 0; i < n; i++) {
+            conn_t *c = events[i].data.ptr;
+            if (c == NULL)
+                loop_accept(loop);
+            else if (c->state != CONN_WRITING)
+                conn_read(loop, c);
+            else if (conn_write(loop, c))
+                conn_read(loop, c);
+        }
+
+        if (loop->stats != NULL)
+            br_stats_busy(loop->stats, br_now() - start);
+    }
+
+    return NULL;
+}
+
+
+int
+br_loop_run(const int *server_sockets, size_t num_sockets, br_server_t *server,
+    size_t num_threads, bool pin_cpus)
+{
+    // threads share the listening sockets round-robin, and the ones that lose
+    // the race for a new connection must not block on accept.
+    for (size_t i = 0; i < num_sockets; i++) {
+        int flags = fcntl(server_sockets[i], F_GETFL);
+        if (flags == -1 ||
+            0 != fcntl(server_sockets[i], F_SETFL, flags | O_NONBLOCK))
+        {
+            fprintf(stderr, "Failed to set server socket non-blocking: %s\n",
+                strerror(errno));
+            return 3;
+        }
+    }
+
+    loop_t *loops = bc_malloc(num_threads * sizeof(loop_t));
+    size_t initialized = 0;
+    int rv = 0;
+
+    for (; initialized < num_threads; initialized++) {
+        loop_t *loop = &loops[initialized];
+        loop->id = initialized;
+        loop->server_socket = server_sockets[initialized % num_sockets];
+        loop->pin_cpu = pin_cpus;
+        loop->server = server;
+        loop->stats = br_stats_thread(server->stats, initialized);
+        loop->idle.head = NULL;
+        loop->idle.tail = NULL;
+        loop->idle.timeout = BR_KEEPALIVE_TIMEOUT;
+        loop->reading.head = NULL;
+        loop->reading.tail = NULL;
+        loop->reading.timeout = BR_READ_TIMEOUT;
+        loop->writing.head = NULL;
+        loop->writing.tail = NULL;
+        loop->writing.timeout = BR_WRITE_TIMEOUT;
+
+        loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (loop->epoll_fd == -1) {
+            fprintf(stderr, "Failed to create epoll instance: %s\n",
+                strerror(errno));
+            rv = 3;
+            goto cleanup;
+        }
+
+        // without EPOLLEXCLUSIVE every thread wakes up for every new
+        // connection, which works, just wastes some cpu.
+        struct epoll_event ev = {.events = EPOLLIN, .data.ptr = NULL};
+#ifdef EPOLLEXCLUSIVE
+        ev.events |= EPOLLEXCLUSIVE;
+#endif
+        if (0 != epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, loop->server_socket,
+            &ev))
+        {
+            fprintf(stderr, "Failed to watch server socket: %s\n",
+                strerror(errno));
+            close(loop->epoll_fd);
+            rv = 3;
+            goto cleanup;
+        }
+    }
+
+    for (size_t i = 1; i < num_threads; i++) {
+        if (pthread_create(&(loops[i].thread), NULL, loop_thread,
+            &loops[i]) != 0)
+        {
+            // threads that are already running still use the loops, so
+            // we can't free them. the caller is going to exit anyway.
+            fprintf(stderr, "Failed to create thread\n");
+            return 3;
+        }
+    }
+
+    // the loops only return on errors. same as above, the other threads are
+    // left running.
+    loop_thread(&loops[0]);
+    return 3;
+
+cleanup:
+    for (size_t i = 0; i < initialized; i++)
+        close(loops[i].epoll_fd);
+    free(loops);
+    return rv;
+}
+
+#else
+
+int
+br_loop_run(const int *server_sockets, size_t num_sockets, br_server_t *server,
+    size_t num_threads, bool pin_cpus)
+{
+    fprintf(stderr, "Event loop mode is not supported on this platform\n");
+    return 3;
+}
+
+#endif /* HAVE_SYS_EPOLL_H */
@@ -0,0 +1,19 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+#ifndef _LOOP_H
+#define _LOOP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "request.h"
+
+int br_loop_run(const int *server_sockets, size_t num_sockets,
+    br_server_t *server, size_t num_threads, bool pin_cpus);
+
+#endif /* _LOOP_H */
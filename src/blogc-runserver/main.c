@@ -12,7 +12,9 @@
 
 #include <signal.h>
 #include <stdio.h>
+#include <stdbool.h>
 #include <stdlib.h>
+#include <unistd.h>
 #include "../common/utils.h"
 #include "httpd.h"
 
@@ -22,7 +24,8 @@ print_help(const char *default_host, const char *default_port)
 {
     printf(
         "usage:\n"
-        "    blogc-runserver [-h] [-v] [-t HOST] [-p PORT] [-m THREADS] DOCROOT\n"
+        "    blogc-runserver [-h] [-v] [-e] [-s] [-c] [-t HOST] [-p PORT]\n"
+        "                    [-m THREADS] [-w WORKERS] [-l FILE] DOCROOT\n"
         "                    - A simple HTTP server to test blogc websites.\n"
         "\n"
         "positional arguments:\n"
@@ -31,9 +34,18 @@ print_help(const char *default_host, const char *default_port)
         "optional arguments:\n"
         "    -h            show this help message and exit\n"
         "    -v            show version and exit\n"
+        "    -e            serve connections from an event loop, instead of a\n"
+        "                  thread per connection\n"
+        "    -s            serve server stats at /__blogc/stats\n"
         "    -t HOST       set server listen address (default: %s)\n"
         "    -p PORT       set server listen port (default: %s)\n"
-        "    -m THREADS    set maximum number of threads to spawn (default: 20)\n",
+        "    -m THREADS    set maximum number of threads to spawn (default: 20,\n"
+        "                  or the number of CPUs with -e)\n"
+        "    -w WORKERS    accept connections from WORKERS listening sockets,\n"
+        "                  using SO_REUSEPORT (default: 1 shared socket)\n"
+        "    -c            pin workers, or event loop threads, to CPUs\n"
+        "    -l FILE       append access log to FILE, instead of printing it to\n"
+        "                  stderr\n",
         default_host, default_port);
 }
 
@@ -41,7 +53,8 @@ print_help(const char *default_host, const char *default_port)
 static void
 print_usage(void)
 {
-    printf("usage: blogc-runserver [-h] [-v] [-t HOST] [-p PORT] [-m THREADS] DOCROOT\n");
+    printf("usage: blogc-runserver [-h] [-v] [-e] [-s] [-c] [-t HOST] "
+        "[-p PORT] [-m THREADS] [-w WORKERS] [-l FILE] DOCROOT\n");
 }
 
 
@@ -58,7 +71,13 @@ main(int argc, char **argv)
     char *host = NULL;
     char *port = NULL;
     char *docroot = NULL;
-    size_t max_threads = 20;
+    char *log_file = NULL;
+    size_t max_threads = 0;
+    bool max_threads_set = false;
+    size_t workers = 0;
+    bool pin_cpus = false;
+    bool event_loop = false;
+    bool stats = false;
     char *ptr;
     char *endptr;
 
@@ -78,6 +97,15 @@ main(int argc, char **argv)
                 case 'v':
                     printf("%s\n", PACKAGE_STRING);
                     goto cleanup;
+                case 'e':
+                    event_loop = true;
+                    break;
+                case 's':
+                    stats = true;
+                    break;
+                case 'c':
+                    pin_cpus = true;
+                    break;
                 case 't':
                     if (argv[i][2] != '\0')
                         host = bc_strdup(argv[i] + 2);
@@ -90,16 +118,39 @@ main(int argc, char **argv)
                     else
                         port = bc_strdup(argv[++i]);
                     break;
+                case 'l':
+                    if (argv[i][2] != '\0')
+                        log_file = bc_strdup(argv[i] + 2);
+                    else
+                        log_file = bc_strdup(argv[++i]);
+                    break;
                 case 'm':
                     if (argv[i][2] != '\0')
                         ptr = argv[i] + 2;
                     else
                         ptr = argv[++i];
                     max_threads = strtoul(ptr, &endptr, 10);
+                    max_threads_set = true;
                     if (*ptr != '\0' && *endptr != '\0')
                         fprintf(stderr, "blogc-runserver: warning: invalid value "
                             "for -m argument: %s. using %zu instead\n", ptr, max_threads);
                     break;
+                case 'w':
+                    if (argv[i][2] != '\0')
+                        ptr = argv[i] + 2;
+                    else
+                        ptr = argv[++i];
+                    workers = strtoul(ptr, &endptr, 10);
+                    if (*ptr == '\0' || *endptr != '\0' || workers <= 0 ||
+                        workers > 1000)
+                    {
+                        print_usage();
+                        fprintf(stderr, "blogc-runserver: error: invalid value "
+                            "for -w. Must be integer > 0 and <= 1000\n");
+                        rv = 3;
+                        goto cleanup;
+                    }
+                    break;
                 default:
                     print_usage();
                     fprintf(stderr, "blogc-runserver: error: invalid "
@@ -129,6 +180,17 @@ main(int argc, char **argv)
         goto cleanup;
     }
 
+    if (!max_threads_set) {
+        long cpus = -1;
+        if (event_loop)
+            cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        max_threads = cpus > 0 ? (cpus < 1000 ? cpus : 1000) : 20;
+
+        // every worker socket needs an event loop thread
+        if (event_loop && workers > max_threads)
+            max_threads = workers;
+    }
+
     if (max_threads <= 0 || max_threads > 1000) {
         print_usage();
         fprintf(stderr, "blogc-runserver: error: invalid value for -m. "
@@ -137,10 +199,18 @@ main(int argc, char **argv)
         goto cleanup;
     }
 
+    if (event_loop && workers > max_threads) {
+        print_usage();
+        fprintf(stderr, "blogc-runserver: error: -w must not be greater than "
+            "-m with -e\n");
+        rv = 3;
+        goto cleanup;
+    }
+
     rv = br_httpd_run(
         host != NULL ? host : default_host,
         port != NULL ? port : default_port,
-        docroot, max_threads);
+        docroot, max_threads, event_loop, log_file, stats, workers, pin_cpus);
 
 cleanup:
     free(default_host);
@@ -148,6 +218,7 @@ cleanup:
     free(host);
     free(port);
     free(docroot);
+    free(log_file);
 
     return rv;
 }
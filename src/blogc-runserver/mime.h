@@ -9,7 +9,10 @@
 #ifndef _MIME_H
 #define _MIME_H
 
+#include <stdbool.h>
+
 const char* br_mime_guess_content_type(const char *filename);
+bool br_mime_compressible(const char *filename);
 char* br_mime_guess_index(const char *path);
 
 #endif /* _MIME_H */
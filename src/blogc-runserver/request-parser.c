@@ -0,0 +1,240 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "../common/utils.h"
+#include "request-parser.h"
+
+
+br_request_parser_t*
+br_request_parser_new(void)
+{
+    br_request_parser_t *rv = bc_malloc(sizeof(br_request_parser_t));
+    rv->current = bc_string_new();
+    rv->request.line = NULL;
+    rv->request.method = NULL;
+    rv->request.target = NULL;
+    rv->request.version = NULL;
+    rv->request.headers = NULL;
+    br_request_parser_reset(rv);
+    return rv;
+}
+
+
+void
+br_request_parser_free(br_request_parser_t *parser)
+{
+    if (parser == NULL)
+        return;
+    br_request_parser_reset(parser);
+    bc_string_free(parser->current, true);
+    free(parser);
+}
+
+
+void
+br_request_parser_reset(br_request_parser_t *parser)
+{
+    if (parser == NULL)
+        return;
+    parser->state = BR_REQUEST_PARSER_START;
+    parser->error = 0;
+    parser->size = 0;
+    parser->current->len = 0;
+    parser->current->str[0] = '\0';
+    free(parser->request.line);
+    parser->request.line = NULL;
+    free(parser->request.method);
+    parser->request.method = NULL;
+    free(parser->request.target);
+    parser->request.target = NULL;
+    free(parser->request.version);
+    parser->request.version = NULL;
+    bc_hashmap_free(parser->request.headers);
+    parser->request.headers = NULL;
+    parser->request.keep_alive = false;
+}
+
+
+static bool
+is_token_char(char c)
+{
+    return isalnum((unsigned char) c) || (c != '\0' &&
+        strchr("!#$%&'*+-.^_`|~", c) != NULL);
+}
+
+
+static br_request_parser_state_t
+parse_request_line(br_request_parser_t *parser, const char *line)
+{
+    br_request_t *req = &parser->request;
+    req->line = bc_strdup(line);
+
+    char **pieces = bc_str_split(line, ' ', 3);
+    if (bc_strv_length(pieces) != 3 || pieces[0][0] == '\0' ||
+        pieces[1][0] == '\0' || !bc_str_starts_with(pieces[2], "HTTP/"))
+    {
+        bc_strv_free(pieces);
+        parser->error = 400;
+        return BR_REQUEST_PARSER_ERROR;
+    }
+
+    if (!bc_str_starts_with(pieces[2], "HTTP/1.")) {
+        bc_strv_free(pieces);
+        parser->error = 505;
+        return BR_REQUEST_PARSER_ERROR;
+    }
+
+    req->method = pieces[0];
+    req->target = pieces[1];
+    req->version = pieces[2];
+    req->headers = bc_hashmap_new(free);
+
+    // persistent connections are the default since HTTP/1.1
+    req->keep_alive = 0 != strcmp(req->version, "HTTP/1.0");
+
+    free(pieces);
+    return BR_REQUEST_PARSER_HEADERS;
+}
+
+
+static br_request_parser_state_t
+parse_header(br_request_parser_t *parser, char *line)
+{
+    // obsolete line folding is not supported, rfc7230 allows us to reject it
+    if (line[0] == ' ' || line[0] == '\t')
+        goto error;
+
+    char *colon = strchr(line, ':');
+    if (colon == NULL || colon == line)
+        goto error;
+
+    for (char *c = line; c < colon; c++) {
+        if (!is_token_char(*c))
+            goto error;
+        *c = tolower((unsigned char) *c);
+    }
+    *colon = '\0';
+
+    char *value = bc_str_strip(colon + 1);
+    const char *prev = bc_hashmap_lookup(parser->request.headers, line);
+    if (prev != NULL)
+        bc_hashmap_insert(parser->request.headers, line,
+            bc_strdup_printf("%s, %s", prev, value));
+    else
+        bc_hashmap_insert(parser->request.headers, line, bc_strdup(value));
+
+    return BR_REQUEST_PARSER_HEADERS;
+
+error:
+    parser->error = 400;
+    return BR_REQUEST_PARSER_ERROR;
+}
+
+
+static br_request_parser_state_t
+finish_headers(br_request_parser_t *parser)
+{
+    br_request_t *req = &parser->request;
+
+    const char *connection = br_request_get_header(req, "connection");
+    if (connection != NULL) {
+        char **tokens = bc_str_split(connection, ',', 0);
+        for (size_t i = 0; tokens[i] != NULL; i++) {
+            char *token = bc_str_strip(tokens[i]);
+            if (0 == strcasecmp(token, "close"))
+                req->keep_alive = false;
+            else if (0 == strcasecmp(token, "keep-alive"))
+                req->keep_alive = true;
+        }
+        bc_strv_free(tokens);
+    }
+
+    // we don't read request bodies, so the connection can't be reused after
+    // a request with one, the body would be parsed as the next request.
+    const char *length = br_request_get_header(req, "content-length");
+    if (br_request_get_header(req, "transfer-encoding") != NULL ||
+        (length != NULL && 0 != strcmp(length, "0")))
+        req->keep_alive = false;
+
+    return BR_REQUEST_PARSER_DONE;
+}
+
+
+// feeds data to the parser, and returns how much of it was consumed. parsing
+// stops at the end of the request header, the rest of the data (e.g.
+// pipelined requests) must be fed again after the parser is reset.
+size_t
+br_request_parser_parse(br_request_parser_t *parser, const char *buf,
+    size_t len)
+{
+    size_t i = 0;
+
+    while (i < len && (parser->state == BR_REQUEST_PARSER_START ||
+        parser->state == BR_REQUEST_PARSER_HEADERS))
+    {
+        const char *nl = memchr(buf + i, '\n', len - i);
+        size_t chunk = nl != NULL ? nl - (buf + i) + 1 : len - i;
+
+        if (parser->size + chunk > BR_REQUEST_MAX_HEADER_SIZE) {
+            parser->error = 431;
+            parser->state = BR_REQUEST_PARSER_ERROR;
+            break;
+        }
+
+        parser->size += chunk;
+        i += chunk;
+
+        if (nl == NULL) {
+            bc_string_append_len(parser->current, buf + i - chunk, chunk);
+            break;
+        }
+        bc_string_append_len(parser->current, buf + i - chunk, chunk - 1);
+
+        char *line = parser->current->str;
+        size_t line_len = parser->current->len;
+        if (line_len > 0 && line[line_len - 1] == '\r')
+            line[--line_len] = '\0';
+
+        if (strlen(line) != line_len) {
+            parser->error = 400;
+            parser->state = BR_REQUEST_PARSER_ERROR;
+            break;
+        }
+
+        if (parser->state == BR_REQUEST_PARSER_START) {
+            // empty lines before the request line should be ignored
+            if (line_len > 0)
+                parser->state = parse_request_line(parser, line);
+        }
+        else if (line_len == 0) {
+            parser->state = finish_headers(parser);
+        }
+        else {
+            parser->state = parse_header(parser, line);
+        }
+
+        parser->current->len = 0;
+        parser->current->str[0] = '\0';
+    }
+
+    return i;
+}
+
+
+const char*
+br_request_get_header(br_request_t *req, const char *name)
+{
+    if (req == NULL)
+        return NULL;
+    return bc_hashmap_lookup(req->headers, name);
+}
@@ -0,0 +1,49 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+#ifndef _REQUEST_PARSER_H
+#define _REQUEST_PARSER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "../common/utils.h"
+
+#define BR_REQUEST_MAX_HEADER_SIZE 8192
+
+typedef enum {
+    BR_REQUEST_PARSER_START = 0,
+    BR_REQUEST_PARSER_HEADERS,
+    BR_REQUEST_PARSER_DONE,
+    BR_REQUEST_PARSER_ERROR,
+} br_request_parser_state_t;
+
+typedef struct {
+    char *line;
+    char *method;
+    char *target;
+    char *version;
+    bc_hashmap_t *headers;
+    bool keep_alive;
+} br_request_t;
+
+typedef struct {
+    br_request_parser_state_t state;
+    unsigned short error;
+    size_t size;
+    bc_string_t *current;
+    br_request_t request;
+} br_request_parser_t;
+
+br_request_parser_t* br_request_parser_new(void);
+void br_request_parser_free(br_request_parser_t *parser);
+void br_request_parser_reset(br_request_parser_t *parser);
+size_t br_request_parser_parse(br_request_parser_t *parser, const char *buf,
+    size_t len);
+const char* br_request_get_header(br_request_t *req, const char *name);
+
+#endif /* _REQUEST_PARSER_H */
@@ -0,0 +1,789 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif /* HAVE_SYS_SENDFILE_H */
+#include "../common/utils.h"
+#include "cache.h"
+#include "compress.h"
+#include "mime.h"
+#include "httpd-utils.h"
+#include "request-parser.h"
+#include "request.h"
+#include "stats.h"
+
+
+#ifndef MSG_MORE
+#define MSG_MORE 0
+#endif
+
+
+static const char*
+status_reason(unsigned short status_code)
+{
+    switch (status_code) {
+        case 200:
+            return "OK";
+        case 206:
+            return "Partial Content";
+        case 302:
+            return "Found";
+        case 304:
+            return "Not Modified";
+        case 400:
+            return "Bad Request";
+        case 403:
+            return "Forbidden";
+        case 404:
+            return "Not Found";
+        case 405:
+            return "Method Not Allowed";
+        case 416:
+            return "Range Not Satisfiable";
+        case 431:
+            return "Request Header Fields Too Large";
+        case 505:
+            return "HTTP Version Not Supported";
+    }
+    return "Internal Server Error";
+}
+
+
+static br_response_t*
+response_new(unsigned short status_code, bool keep_alive, const char *headers,
+    char *body, int fd, size_t body_len)
+{
+    // 304 responses have no body, and a Content-Length would describe the
+    // body of a 200 response instead.
+    char *length = status_code == 304 ? bc_strdup("") :
+        bc_strdup_printf("Content-Length: %zu\r\n", body_len);
+
+    br_response_t *rv = bc_malloc(sizeof(br_response_t));
+    rv->status_code = status_code;
+    rv->header = bc_strdup_printf(
+        "HTTP/1.1 %d %s\r\n"
+        "%s"
+        "%s"
+        "Connection: %s\r\n"
+        "\r\n", status_code, status_reason(status_code), headers, length,
+        keep_alive ? "keep-alive" : "close");
+    rv->header_len = strlen(rv->header);
+    rv->body = body;
+    rv->entry = NULL;
+    rv->fd = fd;
+    rv->offset = 0;
+    rv->body_len = body_len;
+    rv->sent = 0;
+    rv->buffered = false;
+    rv->keep_alive = keep_alive;
+    rv->lookup = BR_LOOKUP_NONE;
+    return rv;
+}
+
+
+static br_response_t*
+response_error(unsigned short status_code, bool keep_alive,
+    const char *headers)
+{
+    char *body = bc_strdup_printf("<h1>%s</h1>\n", status_reason(status_code));
+    char *h = bc_strdup_printf("Content-Type: text/html\r\n%s", headers);
+    br_response_t *rv = response_new(status_code, keep_alive, h, body, -1,
+        strlen(body));
+    free(h);
+    return rv;
+}
+
+
+br_response_t*
+br_response_error(unsigned short status_code, bool keep_alive)
+{
+    return response_error(status_code, keep_alive, "");
+}
+
+
+static char*
+read_all(int fd, size_t size)
+{
+    char *rv = bc_malloc(size + 1);
+    size_t len = 0;
+    while (len < size) {
+        ssize_t n = pread(fd, rv + len, size - len, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0) {
+            free(rv);
+            return NULL;
+        }
+        len += n;
+    }
+    rv[size] = '\0';
+    return rv;
+}
+
+
+// directory indexes are cached by the real path of the directory, so all the
+// urls pointing to a directory share a single lookup of the index files.
+static char*
+guess_index(br_cache_t *indexes, const char *dir)
+{
+    br_cache_entry_t *entry = br_cache_lookup(indexes, dir);
+    if (entry == NULL) {
+        unsigned long generation = br_cache_generation(indexes);
+        char *found = br_mime_guess_index(dir);
+        if (found == NULL)
+            return NULL;
+        entry = br_cache_entry_new(dir);
+        entry->path = found;
+        br_cache_insert(indexes, entry, generation);
+    }
+    char *rv = bc_strdup(entry->path);
+    br_cache_entry_unref(entry);
+    return rv;
+}
+
+
+// resolves an url path to a file in the docroot. small files are read into
+// the entry, otherwise the file is left open in fd.
+static br_cache_entry_t*
+resolve(br_server_t *server, const char *path, unsigned short *status,
+    int *fd)
+{
+    const char *docroot = server->docroot;
+    br_cache_entry_t *rv = NULL;
+
+    char *abs_path = bc_strdup_printf("%s/%s", docroot, path);
+    char *real_path = realpath(abs_path, NULL);
+    free(abs_path);
+
+    if (real_path == NULL) {
+        *status = 404;
+        return NULL;
+    }
+
+    char *real_root = realpath(docroot, NULL);
+    if (real_root == NULL) {
+        *status = 500;
+        goto point3;
+    }
+
+    if (0 != strncmp(real_root, real_path, strlen(real_root))) {
+        *status = 404;
+        goto point4;
+    }
+
+    struct stat st;
+    if (0 > stat(real_path, &st)) {
+        *status = 404;
+        goto point4;
+    }
+
+    bool add_slash = false;
+
+    if (S_ISDIR(st.st_mode)) {
+        char *found = guess_index(server->indexes, real_path);
+
+        if (found == NULL) {
+            *status = 403;
+            goto point4;
+        }
+
+        size_t path_len = strlen(path);
+        if (path_len > 0 && path[path_len - 1] != '/')
+            add_slash = true;
+
+        free(real_path);
+        real_path = found;
+    }
+
+    if (add_slash) {
+        rv = br_cache_entry_new(path);
+        rv->redirect = true;
+        rv->path = real_path;
+        real_path = NULL;
+        goto point4;
+    }
+
+    int f = open(real_path, O_RDONLY | O_CLOEXEC);
+    if (f == -1) {
+        *status = 500;
+        goto point4;
+    }
+
+    if (0 != fstat(f, &st) || !S_ISREG(st.st_mode)) {
+        close(f);
+        *status = 403;
+        goto point4;
+    }
+
+    rv = br_cache_entry_new(path);
+    rv->path = real_path;
+    rv->content_type = br_mime_guess_content_type(real_path);
+    rv->size = st.st_size;
+    rv->mtime = st.st_mtime;
+    rv->inode = st.st_ino;
+    rv->compressible = br_mime_compressible(real_path);
+    real_path = NULL;
+
+    // prebuilt compressed files are preferred over compressing on the fly.
+    if (rv->compressible) {
+        char *gzip_path = bc_strdup_printf("%s.gz", rv->path);
+        struct stat gst;
+        if (0 == stat(gzip_path, &gst) && S_ISREG(gst.st_mode))
+            rv->gzip_path = gzip_path;
+        else
+            free(gzip_path);
+    }
+
+    if (rv->size <= BR_CACHE_MAX_FILE_SIZE)
+        rv->data = read_all(f, rv->size);
+    if (rv->data != NULL)
+        close(f);
+    else
+        *fd = f;
+
+point4:
+    free(real_root);
+point3:
+    free(real_path);
+    return rv;
+}
+
+
+// weak comparison, as required for If-None-Match.
+static bool
+etag_matches(const char *list, const char *etag)
+{
+    bool rv = false;
+    char **tags = bc_str_split(list, ',', 0);
+    for (size_t i = 0; tags[i] != NULL; i++) {
+        char *tag = bc_str_strip(tags[i]);
+        if (bc_str_starts_with(tag, "W/"))
+            tag += 2;
+        if (0 == strcmp(tag, "*") || 0 == strcmp(tag, etag)) {
+            rv = true;
+            break;
+        }
+    }
+    bc_strv_free(tags);
+    return rv;
+}
+
+
+static bool
+not_modified(br_request_t *req, const char *etag, time_t mtime)
+{
+    // If-Modified-Since is ignored when If-None-Match is there, rfc7232
+    const char *if_none_match = br_request_get_header(req, "if-none-match");
+    if (if_none_match != NULL)
+        return etag_matches(if_none_match, etag);
+
+    time_t since;
+    return br_parse_http_date(br_request_get_header(req, "if-modified-since"),
+        &since) && mtime <= since;
+}
+
+
+// parses the digits in str up to end. values that don't fit are clamped.
+static bool
+parse_size(const char *str, const char *end, size_t *value)
+{
+    if (str == end)
+        return false;
+    *value = 0;
+    for (; str < end; str++) {
+        if (!isdigit((unsigned char) *str))
+            return false;
+        if (*value > (SIZE_MAX - 9) / 10)
+            *value = SIZE_MAX;
+        else
+            *value = *value * 10 + (*str - '0');
+    }
+    return true;
+}
+
+
+// returns 206 with the range to be sent, 416 if it can't be satisfied, or 200
+// if the whole file should be sent, as for invalid or multiple ranges, that
+// are allowed to be ignored.
+static unsigned short
+parse_range(br_request_t *req, const char *etag, const char *last_modified,
+    size_t size, size_t *start, size_t *len)
+{
+    *start = 0;
+    *len = size;
+
+    const char *range = br_request_get_header(req, "range");
+    if (range == NULL || 0 != strcmp(req->method, "GET") ||
+        !bc_str_starts_with(range, "bytes="))
+        return 200;
+
+    const char *if_range = br_request_get_header(req, "if-range");
+    if (if_range != NULL && 0 != strcmp(if_range, etag) &&
+        0 != strcmp(if_range, last_modified))
+        return 200;
+
+    const char *spec = range + 6;
+    const char *dash = strchr(spec, '-');
+    if (dash == NULL || strchr(spec, ',') != NULL)
+        return 200;
+
+    size_t first, last;
+    const char *end = spec + strlen(spec);
+
+    // bytes=-500 is the last 500 bytes
+    if (dash == spec) {
+        if (!parse_size(dash + 1, end, &last))
+            return 200;
+        if (last == 0 || size == 0)
+            return 416;
+        *len = last < size ? last : size;
+        *start = size - *len;
+        return 206;
+    }
+
+    if (!parse_size(spec, dash, &first))
+        return 200;
+    if (dash + 1 == end)
+        last = size > 0 ? size - 1 : 0;
+    else if (!parse_size(dash + 1, end, &last) || last < first)
+        return 200;
+
+    if (first >= size)
+        return 416;
+    if (last >= size)
+        last = size - 1;
+    *start = first;
+    *len = last - first + 1;
+    return 206;
+}
+
+
+// a representation of a file, with the body either in memory or in fd. the
+// entry owns the data.
+typedef struct {
+    br_cache_entry_t *entry;
+    const char *data;
+    int fd;
+    size_t size;
+    time_t mtime;
+    ino_t inode;
+    br_encoding_t encoding;
+} body_t;
+
+
+static br_response_t*
+file_response(br_request_t *req, const char *content_type, body_t *body,
+    bool vary, bool keep_alive)
+{
+    br_response_t *rv;
+    const char *encoding = br_compress_encoding_name(body->encoding);
+    char *etag = bc_strdup_printf("\"%llx-%llx-%llx%s%s\"",
+        (unsigned long long) body->inode, (unsigned long long) body->size,
+        (unsigned long long) body->mtime, encoding != NULL ? "-" : "",
+        encoding != NULL ? encoding : "");
+    char *last_modified = br_format_http_date(body->mtime);
+    char *variant = bc_strdup_printf("%s%s%s",
+        encoding != NULL ? "Content-Encoding: " : "",
+        encoding != NULL ? encoding : "", encoding != NULL ? "\r\n" : "");
+    char *headers;
+
+    if (not_modified(req, etag, body->mtime)) {
+        headers = bc_strdup_printf(
+            "ETag: %s\r\n"
+            "Last-Modified: %s\r\n"
+            "%s", etag, last_modified,
+            vary ? "Vary: Accept-Encoding\r\n" : "");
+        rv = response_new(304, keep_alive, headers, NULL, -1, 0);
+        if (body->fd != -1)
+            close(body->fd);
+        br_cache_entry_unref(body->entry);
+        goto cleanup;
+    }
+
+    size_t start, len;
+    unsigned short status_code = parse_range(req, etag, last_modified,
+        body->size, &start, &len);
+
+    if (status_code == 416) {
+        headers = bc_strdup_printf("Content-Range: bytes */%zu\r\n",
+            body->size);
+        rv = response_error(416, keep_alive, headers);
+        if (body->fd != -1)
+            close(body->fd);
+        br_cache_entry_unref(body->entry);
+        goto cleanup;
+    }
+
+    char *content_range = status_code == 206 ? bc_strdup_printf(
+        "Content-Range: bytes %zu-%zu/%zu\r\n", start, start + len - 1,
+        body->size) : bc_strdup("");
+    headers = bc_strdup_printf(
+        "Content-Type: %s\r\n"
+        "%s"
+        "%s"
+        "ETag: %s\r\n"
+        "Last-Modified: %s\r\n"
+        "Accept-Ranges: bytes\r\n"
+        "%s", content_type, variant, vary ? "Vary: Accept-Encoding\r\n" : "",
+        etag, last_modified, content_range);
+    free(content_range);
+
+    rv = response_new(status_code, keep_alive, headers,
+        body->data != NULL ? (char*) body->data + start : NULL, body->fd, len);
+    rv->entry = body->entry;
+    if (body->fd != -1)
+        rv->offset = start;
+
+cleanup:
+    free(headers);
+    free(variant);
+    free(last_modified);
+    free(etag);
+    return rv;
+}
+
+
+// compressed files are cached by path and validators, so each version of a
+// file is compressed only once. returns NULL if compression isn't worth it.
+static br_cache_entry_t*
+compressed_entry(br_server_t *server, body_t *body, const char *path,
+    br_encoding_t encoding)
+{
+    char *key = bc_strdup_printf("%s\n%llx-%llx-%llx\n%s", path,
+        (unsigned long long) body->inode, (unsigned long long) body->size,
+        (unsigned long long) body->mtime, br_compress_encoding_name(encoding));
+    br_cache_entry_t *rv = br_cache_lookup(server->compressed, key);
+
+    if (rv == NULL) {
+        unsigned long generation = br_cache_generation(server->compressed);
+        char *buffer = NULL;
+        const char *data = body->data;
+        if (data == NULL)
+            data = buffer = read_all(body->fd, body->size);
+        size_t len;
+        char *out = data != NULL ? br_compress(encoding, data, body->size,
+            &len) : NULL;
+        free(buffer);
+        if (out == NULL) {
+            free(key);
+            return NULL;
+        }
+        rv = br_cache_entry_new(key);
+        rv->path = bc_strdup(path);
+        rv->data = out;
+        rv->size = len;
+        rv->mtime = body->mtime;
+        rv->inode = body->inode;
+        br_cache_insert(server->compressed, rv, generation);
+    }
+    free(key);
+
+    if (rv->size >= body->size) {
+        br_cache_entry_unref(rv);
+        return NULL;
+    }
+    return rv;
+}
+
+
+static br_response_t*
+handle_get(br_server_t *server, br_request_t *req, bool keep_alive,
+    br_lookup_t *lookup)
+{
+    char **pieces2 = bc_str_split(req->target, '?', 2);
+    char *path = br_urldecode(pieces2[0]);
+    bc_strv_free(pieces2);
+
+    if (path == NULL)
+        return br_response_error(400, keep_alive);
+
+    int fd = -1;
+    br_cache_entry_t *entry = br_cache_lookup(server->cache, path);
+
+    // big files are sent straight from the file, see br_response_send.
+    if (entry != NULL && !entry->redirect && entry->data == NULL) {
+        fd = open(entry->path, O_RDONLY | O_CLOEXEC);
+
+        // the file is gone, and we weren't notified yet.
+        if (fd == -1) {
+            br_cache_remove(server->cache, entry);
+            br_cache_entry_unref(entry);
+            entry = NULL;
+        }
+    }
+
+    *lookup = entry != NULL ? BR_LOOKUP_HIT : BR_LOOKUP_MISS;
+
+    if (entry == NULL) {
+        unsigned long generation = br_cache_generation(server->cache);
+        unsigned short status_code;
+        entry = resolve(server, path, &status_code, &fd);
+        if (entry == NULL) {
+            free(path);
+            return br_response_error(status_code, keep_alive);
+        }
+        br_cache_insert(server->cache, entry, generation);
+    }
+    free(path);
+
+    if (entry->redirect) {
+        // production webservers usually returns 301 in such cases, but 302 is
+        // better for development/testing.
+        char *location = bc_strdup_printf("Location: %s/\r\n", entry->key);
+        br_response_t *rv = response_new(302, keep_alive, location, NULL, -1,
+            0);
+        free(location);
+        br_cache_entry_unref(entry);
+        return rv;
+    }
+
+    body_t body = {
+        .entry = entry,
+        .data = entry->data,
+        .fd = fd,
+        .size = entry->size,
+        .mtime = entry->mtime,
+        .inode = entry->inode,
+        .encoding = BR_ENCODING_IDENTITY,
+    };
+
+    struct stat st;
+    if (fd != -1) {
+        if (0 != fstat(fd, &st) || !S_ISREG(st.st_mode)) {
+            close(fd);
+            br_cache_entry_unref(entry);
+            return br_response_error(403, keep_alive);
+        }
+        body.size = st.st_size;
+        body.mtime = st.st_mtime;
+        body.inode = st.st_ino;
+    }
+
+    // ranges are always served from the uncompressed file, so resumed
+    // downloads don't depend on the compression.
+    bool vary = entry->compressible && body.size >= BR_COMPRESS_MIN_SIZE;
+    br_encoding_t encoding = BR_ENCODING_IDENTITY;
+    if (vary && br_request_get_header(req, "range") == NULL)
+        encoding = br_compress_negotiate(br_request_get_header(req,
+            "accept-encoding"));
+
+    if (encoding == BR_ENCODING_GZIP && entry->gzip_path != NULL) {
+        int gzip_fd = open(entry->gzip_path, O_RDONLY | O_CLOEXEC);
+        if (gzip_fd != -1) {
+            if (0 == fstat(gzip_fd, &st) && S_ISREG(st.st_mode)) {
+                if (fd != -1)
+                    close(fd);
+                body.data = NULL;
+                body.fd = gzip_fd;
+                body.size = st.st_size;
+                body.mtime = st.st_mtime;
+                body.inode = st.st_ino;
+                body.encoding = BR_ENCODING_GZIP;
+                return file_response(req, entry->content_type, &body, true,
+                    keep_alive);
+            }
+            close(gzip_fd);
+        }
+    }
+
+    if (encoding != BR_ENCODING_IDENTITY && (body.data != NULL ||
+        body.size <= BR_COMPRESS_MAX_FILE_SIZE))
+    {
+        br_cache_entry_t *c = compressed_entry(server, &body, entry->path,
+            encoding);
+        if (c != NULL) {
+            if (fd != -1)
+                close(fd);
+            const char *content_type = entry->content_type;
+            br_cache_entry_unref(entry);
+            body.entry = c;
+            body.data = c->data;
+            body.fd = -1;
+            body.size = c->size;
+            body.encoding = encoding;
+            return file_response(req, content_type, &body, true, keep_alive);
+        }
+    }
+
+    return file_response(req, entry->content_type, &body, vary, keep_alive);
+}
+
+
+// the stats are served only when enabled, and hide any file with the same
+// path in the docroot.
+static bool
+is_stats_request(br_server_t *server, br_request_t *req)
+{
+    if (server->stats == NULL)
+        return false;
+    size_t len = strlen(BR_STATS_PATH);
+    return 0 == strncmp(req->target, BR_STATS_PATH, len) &&
+        (req->target[len] == '\0' || req->target[len] == '?');
+}
+
+
+br_response_t*
+br_request_handle(br_server_t *server, br_request_t *req, bool keep_alive)
+{
+    bool head = 0 == strcmp(req->method, "HEAD");
+    if (!head && 0 != strcmp(req->method, "GET"))
+        return response_error(405, keep_alive, "Allow: GET, HEAD\r\n");
+
+    br_response_t *rv;
+    if (is_stats_request(server, req)) {
+        char *body = br_stats_format(server->stats);
+        rv = response_new(200, keep_alive,
+            "Content-Type: text/plain; charset=utf-8\r\n"
+            "Cache-Control: no-store\r\n", body, -1, strlen(body));
+    }
+    else {
+        br_lookup_t lookup = BR_LOOKUP_NONE;
+        rv = handle_get(server, req, keep_alive, &lookup);
+        rv->lookup = lookup;
+    }
+
+    // same headers as GET, Content-Length included, but no body.
+    if (head) {
+        if (rv->fd != -1)
+            close(rv->fd);
+        if (rv->entry == NULL)
+            free(rv->body);
+        rv->fd = -1;
+        rv->body = NULL;
+        rv->body_len = 0;
+    }
+    return rv;
+}
+
+
+void
+br_response_free(br_response_t *res)
+{
+    if (res == NULL)
+        return;
+    if (res->fd != -1)
+        close(res->fd);
+    free(res->header);
+    if (res->entry != NULL)
+        br_cache_entry_unref(res->entry);
+    else
+        free(res->body);
+    free(res);
+}
+
+
+static ssize_t
+send_file_buffered(br_response_t *res, int socket, size_t offset)
+{
+    char buffer[BR_RESPONSE_BUFFER_SIZE];
+    size_t len = res->body_len - offset;
+    if (len > BR_RESPONSE_BUFFER_SIZE)
+        len = BR_RESPONSE_BUFFER_SIZE;
+
+    ssize_t n = pread(res->fd, buffer, len, res->offset + offset);
+    if (n <= 0) {
+        // the file was truncated after we sent the header. nothing to do but
+        // dropping the connection.
+        if (n == 0)
+            errno = EIO;
+        return -1;
+    }
+
+    // if the socket takes just part of the buffer, the rest is read again
+    // from the file in the next call.
+    return write(socket, buffer, n);
+}
+
+
+static ssize_t
+send_file(br_response_t *res, int socket, size_t offset)
+{
+#ifdef HAVE_SYS_SENDFILE_H
+    if (!res->buffered) {
+        off_t off = res->offset + offset;
+        ssize_t n = sendfile(socket, res->fd, &off, res->body_len - offset);
+        if (n != -1 || (errno != EINVAL && errno != ENOSYS &&
+            errno != EOPNOTSUPP))
+            return n;
+
+        // the filesystem can't do it, stick to read/write for this response.
+        res->buffered = true;
+    }
+#endif /* HAVE_SYS_SENDFILE_H */
+    return send_file_buffered(res, socket, offset);
+}
+
+
+// returns 1 when the whole response was sent, 0 when the socket is
+// non-blocking and can't take more data right now, and -1 on errors, with
+// errno set.
+int
+br_response_send(br_response_t *res, int socket)
+{
+    size_t total = res->header_len + res->body_len;
+
+    while (res->sent < total) {
+        ssize_t n;
+
+        if (res->sent < res->header_len && res->fd != -1) {
+            // the header is corked with MSG_MORE, so it goes in the same
+            // packet as the start of the file.
+            n = send(socket, res->header + res->sent,
+                res->header_len - res->sent, MSG_MORE);
+        }
+        else if (res->sent < res->header_len) {
+            struct iovec iov[2];
+            int iovcnt = 1;
+            iov[0].iov_base = res->header + res->sent;
+            iov[0].iov_len = res->header_len - res->sent;
+            if (res->body != NULL && res->body_len > 0) {
+                iov[1].iov_base = res->body;
+                iov[1].iov_len = res->body_len;
+                iovcnt++;
+            }
+            n = writev(socket, iov, iovcnt);
+        }
+        else if (res->fd != -1) {
+            n = send_file(res, socket, res->sent - res->header_len);
+        }
+        else {
+            size_t offset = res->sent - res->header_len;
+            n = write(socket, res->body + offset, res->body_len - offset);
+        }
+
+        if (n >= 0) {
+            res->sent += n;
+            continue;
+        }
+        if (errno == EINTR)
+            continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return 0;
+        return -1;
+    }
+
+    return 1;
+}
@@ -0,0 +1,61 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+#ifndef _REQUEST_H
+#define _REQUEST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "cache.h"
+#include "request-parser.h"
+
+#define BR_RESPONSE_BUFFER_SIZE 65536
+
+// result of the file cache lookup, for the stats.
+typedef enum {
+    BR_LOOKUP_NONE = 0,
+    BR_LOOKUP_HIT,
+    BR_LOOKUP_MISS,
+} br_lookup_t;
+
+// the body is either in memory or in a file, starting at offset. header_len +
+// body_len bytes are sent in total, sent keeps track of the progress for
+// non-blocking sockets. bodies read from cache entries are owned by the entry.
+typedef struct {
+    unsigned short status_code;
+    char *header;
+    size_t header_len;
+    char *body;
+    br_cache_entry_t *entry;
+    int fd;
+    size_t offset;
+    size_t body_len;
+    size_t sent;
+    bool buffered;
+    bool keep_alive;
+    br_lookup_t lookup;
+} br_response_t;
+
+// everything needed to handle requests, shared by all the threads. the
+// caches, the access log and the stats may be NULL.
+typedef struct {
+    const char *docroot;
+    br_cache_t *cache;
+    br_cache_t *indexes;
+    br_cache_t *compressed;
+    struct br_access_log *access_log;
+    struct br_stats *stats;
+} br_server_t;
+
+br_response_t* br_response_error(unsigned short status_code, bool keep_alive);
+br_response_t* br_request_handle(br_server_t *server, br_request_t *req,
+    bool keep_alive);
+void br_response_free(br_response_t *res);
+int br_response_send(br_response_t *res, int socket);
+
+#endif /* _REQUEST_H */
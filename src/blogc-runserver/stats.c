@@ -0,0 +1,214 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../common/utils.h"
+#include "request.h"
+#include "stats.h"
+
+// counters have a single writer, a relaxed load and store is enough, and
+// cheaper than an atomic increment. readers may see slightly outdated values.
+#define STATS_ADD(c, n) __atomic_store_n(&(c), \
+    __atomic_load_n(&(c), __ATOMIC_RELAXED) + (n), __ATOMIC_RELAXED)
+#define STATS_GET(c) __atomic_load_n(&(c), __ATOMIC_RELAXED)
+
+struct br_stats {
+    long long started;
+    size_t num_threads;
+    br_stats_thread_t *threads;
+};
+
+
+static long long
+now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+br_stats_t*
+br_stats_new(size_t num_threads)
+{
+    br_stats_t *rv = bc_malloc(sizeof(br_stats_t));
+    rv->started = now_us();
+    rv->num_threads = num_threads;
+    rv->threads = bc_malloc(num_threads * sizeof(br_stats_thread_t));
+    memset(rv->threads, 0, num_threads * sizeof(br_stats_thread_t));
+    return rv;
+}
+
+
+void
+br_stats_free(br_stats_t *stats)
+{
+    if (stats == NULL)
+        return;
+    free(stats->threads);
+    free(stats);
+}
+
+
+br_stats_thread_t*
+br_stats_thread(br_stats_t *stats, size_t id)
+{
+    if (stats == NULL || id >= stats->num_threads)
+        return NULL;
+    return &stats->threads[id];
+}
+
+
+void
+br_stats_connection(br_stats_thread_t *t, long delta)
+{
+    if (t == NULL)
+        return;
+    STATS_ADD(t->connections, delta);
+}
+
+
+void
+br_stats_request(br_stats_thread_t *t, br_response_t *res, long long latency)
+{
+    if (t == NULL)
+        return;
+    STATS_ADD(t->requests, 1);
+    if (res->status_code >= BR_STATS_MIN_STATUS &&
+        res->status_code <= BR_STATS_MAX_STATUS)
+        STATS_ADD(t->status[res->status_code - BR_STATS_MIN_STATUS], 1);
+    STATS_ADD(t->bytes, res->sent);
+    if (res->lookup == BR_LOOKUP_HIT)
+        STATS_ADD(t->cache_hits, 1);
+    else if (res->lookup == BR_LOOKUP_MISS)
+        STATS_ADD(t->cache_misses, 1);
+    STATS_ADD(t->latency[br_stats_latency_bucket(latency)], 1);
+}
+
+
+void
+br_stats_busy(br_stats_thread_t *t, long long busy)
+{
+    if (t == NULL || busy <= 0)
+        return;
+    STATS_ADD(t->busy, busy);
+}
+
+
+// buckets 0 to 3 hold 0 to 3 microseconds. after that, each power of 2 is
+// split in 4 buckets, so the error is at most 25%.
+size_t
+br_stats_latency_bucket(long long latency)
+{
+    if (latency < 4)
+        return latency > 0 ? latency : 0;
+    size_t e = 63 - __builtin_clzll(latency);
+    size_t rv = 4 * (e - 1) + ((latency >> (e - 2)) & 3);
+    return rv < BR_STATS_LATENCY_BUCKETS ? rv : BR_STATS_LATENCY_BUCKETS - 1;
+}
+
+
+long long
+br_stats_latency_bucket_max(size_t bucket)
+{
+    if (bucket < 4)
+        return bucket;
+    size_t e = bucket / 4 + 1;
+    return ((5LL + bucket % 4) << (e - 2)) - 1;
+}
+
+
+static long long
+percentile(unsigned long *latency, unsigned long total, unsigned int p)
+{
+    if (total == 0)
+        return 0;
+    unsigned long target = (total * p + 99) / 100;
+    unsigned long count = 0;
+    for (size_t i = 0; i < BR_STATS_LATENCY_BUCKETS; i++) {
+        count += latency[i];
+        if (count >= target)
+            return br_stats_latency_bucket_max(i);
+    }
+    return br_stats_latency_bucket_max(BR_STATS_LATENCY_BUCKETS - 1);
+}
+
+
+static void
+append_seconds(bc_string_t *str, const char *name, long long us)
+{
+    bc_string_append_printf(str, "%s: %lld.%06lld\n", name, us / 1000000,
+        us % 1000000);
+}
+
+
+char*
+br_stats_format(br_stats_t *stats)
+{
+    if (stats == NULL)
+        return NULL;
+
+    long long uptime = now_us() - stats->started;
+    br_stats_thread_t total;
+    memset(&total, 0, sizeof(br_stats_thread_t));
+    unsigned long long busy[stats->num_threads];
+    unsigned long requests[stats->num_threads];
+    long connections[stats->num_threads];
+
+    for (size_t i = 0; i < stats->num_threads; i++) {
+        br_stats_thread_t *t = &stats->threads[i];
+        requests[i] = STATS_GET(t->requests);
+        connections[i] = STATS_GET(t->connections);
+        busy[i] = STATS_GET(t->busy);
+        total.requests += requests[i];
+        total.connections += connections[i];
+        total.bytes += STATS_GET(t->bytes);
+        total.cache_hits += STATS_GET(t->cache_hits);
+        total.cache_misses += STATS_GET(t->cache_misses);
+        for (size_t j = 0; j <= BR_STATS_MAX_STATUS - BR_STATS_MIN_STATUS; j++)
+            total.status[j] += STATS_GET(t->status[j]);
+        for (size_t j = 0; j < BR_STATS_LATENCY_BUCKETS; j++)
+            total.latency[j] += STATS_GET(t->latency[j]);
+    }
+
+    // the latency counters may be a bit ahead of the requests counters.
+    unsigned long num_latencies = 0;
+    for (size_t j = 0; j < BR_STATS_LATENCY_BUCKETS; j++)
+        num_latencies += total.latency[j];
+
+    bc_string_t *rv = bc_string_new();
+    append_seconds(rv, "uptime", uptime);
+    bc_string_append_printf(rv, "connections: %ld\n", total.connections);
+    bc_string_append_printf(rv, "requests: %lu\n", total.requests);
+    bc_string_append_printf(rv, "bytes: %llu\n", total.bytes);
+    for (size_t j = 0; j <= BR_STATS_MAX_STATUS - BR_STATS_MIN_STATUS; j++) {
+        if (total.status[j] > 0)
+            bc_string_append_printf(rv, "status %zu: %lu\n",
+                j + BR_STATS_MIN_STATUS, total.status[j]);
+    }
+    bc_string_append_printf(rv, "cache hits: %lu\n", total.cache_hits);
+    bc_string_append_printf(rv, "cache misses: %lu\n", total.cache_misses);
+    unsigned long lookups = total.cache_hits + total.cache_misses;
+    bc_string_append_printf(rv, "cache hit ratio: %.1f%%\n",
+        lookups > 0 ? 100.0 * total.cache_hits / lookups : 0.0);
+    append_seconds(rv, "latency p50",
+        percentile(total.latency, num_latencies, 50));
+    append_seconds(rv, "latency p90",
+        percentile(total.latency, num_latencies, 90));
+    append_seconds(rv, "latency p99",
+        percentile(total.latency, num_latencies, 99));
+    for (size_t i = 0; i < stats->num_threads; i++) {
+        bc_string_append_printf(rv, "thread %zu: %.1f%% busy, %lu requests, "
+            "%ld connections\n", i + 1,
+            uptime > 0 ? 100.0 * busy[i] / uptime : 0.0, requests[i],
+            connections[i]);
+    }
+    return bc_string_free(rv, false);
+}
@@ -0,0 +1,53 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+#ifndef _STATS_H
+#define _STATS_H
+
+#include <stddef.h>
+#include "request.h"
+
+#define BR_STATS_PATH "/__blogc/stats"
+
+// status codes from 100 to 599 are counted individually.
+#define BR_STATS_MIN_STATUS 100
+#define BR_STATS_MAX_STATUS 599
+
+// latencies are counted in buckets, 4 for each power of 2 microseconds, up to
+// about an hour.
+#define BR_STATS_LATENCY_BUCKETS 128
+
+// counters of a thread. they are only changed by the thread that owns them,
+// so no locking is needed, and are aggregated when the stats are read. the
+// padding keeps the counters of different threads in different cache lines.
+typedef struct {
+    unsigned long requests;
+    unsigned long status[BR_STATS_MAX_STATUS - BR_STATS_MIN_STATUS + 1];
+    unsigned long long bytes;
+    unsigned long cache_hits;
+    unsigned long cache_misses;
+    long connections;
+    unsigned long long busy;
+    unsigned long latency[BR_STATS_LATENCY_BUCKETS];
+    char padding[64];
+} br_stats_thread_t;
+
+typedef struct br_stats br_stats_t;
+
+br_stats_t* br_stats_new(size_t num_threads);
+void br_stats_free(br_stats_t *stats);
+br_stats_thread_t* br_stats_thread(br_stats_t *stats, size_t id);
+void br_stats_connection(br_stats_thread_t *t, long delta);
+void br_stats_request(br_stats_thread_t *t, br_response_t *res,
+    long long latency);
+void br_stats_busy(br_stats_thread_t *t, long long busy);
+size_t br_stats_latency_bucket(long long latency);
+long long br_stats_latency_bucket_max(size_t bucket);
+char* br_stats_format(br_stats_t *stats);
+
+#endif /* _STATS_H */
@@ -176,8 +176,12 @@ typedef enum {
 } blogc_content_parser_inline_state_t;
 
 
+// scratch strings are allocated from the arena, that is shared by all the
+// recursive calls and released by the public functions when done. the parsed
+// strings returned by the internal functions are still allocated in the heap.
 static char*
-blogc_content_parse_inline_internal(const char *src, size_t src_len)
+blogc_content_parse_inline_internal(const char *src, size_t src_len,
+    bc_arena_t *arena)
 {
     size_t current = 0;
     size_t start = 0;
@@ -186,11 +190,13 @@ blogc_content_parse_inline_internal(const char *src, size_t src_len)
     const char *tmp = NULL;
     char *tmp2 = NULL;
     char *tmp3 = NULL;
+    char *chunk = NULL;
 
     size_t start_link = 0;
     char *link1 = NULL;
 
-    bc_string_t *rv = bc_string_new();
+    // output is usually a bit bigger than input, due to markup.
+    bc_string_t *rv = bc_string_new_sized(src_len);
 
     blogc_content_parser_inline_state_t state = CONTENT_INLINE_START;
 
@@ -251,7 +257,7 @@ blogc_content_parse_inline_internal(const char *src, size_t src_len)
                     continue;
                 }
                 tmp2 = blogc_content_parse_inline_internal(
-                    src + current, (tmp - src) - current);
+                    src + current, (tmp - src) - current, arena);
                 bc_string_append_printf(rv, "<em>%s</em>", tmp2);
                 current = tmp - src;
                 tmp = NULL;
@@ -276,7 +282,7 @@ blogc_content_parse_inline_internal(const char *src, size_t src_len)
                     continue;
                 }
                 tmp2 = blogc_content_parse_inline_internal(
-                    src + current, (tmp - src) - current);
+                    src + current, (tmp - src) - current, arena);
                 bc_string_append_printf(rv, "<strong>%s</strong>", tmp2);
                 current = tmp - src + 1;
                 tmp = NULL;
@@ -297,7 +303,7 @@ blogc_content_parse_inline_internal(const char *src, size_t src_len)
                     continue;
                 }
                 tmp2 = blogc_content_parse_inline_internal(
-                    src + current, (tmp - src) - current);
+                    src + current, (tmp - src) - current, arena);
                 bc_string_append_printf(rv, "<em>%s</em>", tmp2);
                 current = tmp - src;
                 tmp = NULL;
@@ -322,7 +328,7 @@ blogc_content_parse_inline_internal(const char *src, size_t src_len)
                     continue;
                 }
                 tmp2 = blogc_content_parse_inline_internal(
-                    src + current, (tmp - src) - current);
+                    src + current, (tmp - src) - current, arena);
                 bc_string_append_printf(rv, "<strong>%s</strong>", tmp2);
                 current = tmp - src + 1;
                 tmp = NULL;
@@ -342,10 +348,9 @@ blogc_content_parse_inline_internal(const char *src, size_t src_len)
                     state = CONTENT_INLINE_START;
                     continue;
                 }
-                tmp3 = bc_strndup(src + current, (tmp - src) - current);
-                tmp2 = blogc_htmlentities(tmp3);
-                free(tmp3);
-                tmp3 = NULL;
+                chunk = bc_arena_strndup(arena, src + current,
+                    (tmp - src) - current);
+                tmp2 = blogc_htmlentities(chunk);
                 bc_string_append(rv, "<code>");
                 bc_string_append_escaped(rv, tmp2);
                 bc_string_append(rv, "</code>");
@@ -371,10 +376,9 @@ blogc_content_parse_inline_internal(const char *src, size_t src_len)
                     state = CONTENT_INLINE_START;
                     continue;
                 }
-                tmp3 = bc_strndup(src + current, (tmp - src) - current);
-                tmp2 = blogc_htmlentities(tmp3);
-                free(tmp3);
-                tmp3 = NULL;
+                chunk = bc_arena_strndup(arena, src + current,
+                    (tmp - src) - current);
+                tmp2 = blogc_htmlentities(chunk);
                 bc_string_append(rv, "<code>");
                 bc_string_append_escaped(rv, tmp2);
                 bc_string_append(rv, "</code>");
@@ -410,16 +414,15 @@ blogc_content_parse_inline_internal(const char *src, size_t src_len)
                     state = CONTENT_INLINE_START;
                     continue;
                 }
-                tmp2 = bc_strndup(src + current, (tmp - src) - current);
+                chunk = bc_arena_strndup(arena, src + current,
+                    (tmp - src) - current);
                 bc_string_append(rv, "<a href=\"");
-                bc_string_append_escaped(rv, tmp2);
+                bc_string_append_escaped(rv, chunk);
                 bc_string_append(rv, "\">");
-                bc_string_append_escaped(rv, tmp2);
+                bc_string_append_escaped(rv, chunk);
                 bc_string_append(rv, "</a>");
                 current = tmp - src + 1;
                 tmp = NULL;
-                free(tmp2);
-                tmp2 = NULL;
                 state = CONTENT_INLINE_START;
                 break;
 
@@ -434,7 +437,8 @@ blogc_content_parse_inline_internal(const char *src, size_t src_len)
                 }
                 if (c == ']') {
                     if (--count == 0) {
-                        link1 = bc_strndup(src + start_link, current - start_link);
+                        link1 = bc_arena_strndup(arena, src + start_link,
+                            current - start_link);
                         state = CONTENT_INLINE_LINK_URL_START;
                     }
                 }
@@ -460,15 +464,14 @@ blogc_content_parse_inline_internal(const char *src, size_t src_len)
                     break;
                 }
                 if (c == ')') {
-                    tmp2 = bc_strndup(src + start, current - start);
-                    tmp3 = blogc_content_parse_inline(link1);
-                    free(link1);
+                    chunk = bc_arena_strndup(arena, src + start,
+                        current - start);
+                    tmp3 = blogc_content_parse_inline_internal(link1,
+                        strlen(link1), arena);
                     link1 = NULL;
                     bc_string_append(rv, "<a href=\"");
-                    bc_string_append_escaped(rv, tmp2);
+                    bc_string_append_escaped(rv, chunk);
                     bc_string_append_printf(rv, "\">%s</a>", tmp3);
-                    free(tmp2);
-                    tmp2 = NULL;
                     free(tmp3);
                     tmp3 = NULL;
                     state = CONTENT_INLINE_START;
@@ -493,7 +496,8 @@ blogc_content_parse_inline_internal(const char *src, size_t src_len)
                     break;
                 }
                 if (c == ']') {
-                    link1 = bc_strndup(src + start_link, current - start_link);
+                    link1 = bc_arena_strndup(arena, src + start_link,
+                        current - start_link);
                     state = CONTENT_INLINE_IMAGE_URL_START;
                 }
                 break;
@@ -519,15 +523,13 @@ blogc_content_parse_inline_internal(const char *src, size_t src_len)
                     break;
                 }
                 if (c == ')') {
-                    tmp2 = bc_strndup(src + start, current - start);
+                    chunk = bc_arena_strndup(arena, src + start,
+                        current - start);
                     bc_string_append(rv, "<img src=\"");
-                    bc_string_append_escaped(rv, tmp2);
+                    bc_string_append_escaped(rv, chunk);
                     bc_string_append(rv, "\" alt=\"");
                     bc_string_append_escaped(rv, link1);
                     bc_string_append(rv, "\">");
-                    free(tmp2);
-                    tmp2 = NULL;
-                    free(link1);
                     link1 = NULL;
                     state = CONTENT_INLINE_START;
                     break;
@@ -609,7 +611,8 @@ blogc_content_parse_inline_internal(const char *src, size_t src_len)
         case CONTENT_INLINE_LINK_CONTENT:
         case CONTENT_INLINE_LINK_URL_START:
         case CONTENT_INLINE_LINK_URL:
-            tmp2 = blogc_content_parse_inline(src + start_link);
+            tmp2 = blogc_content_parse_inline_internal(src + start_link,
+                strlen(src + start_link), arena);
             bc_string_append_c(rv, '[');
             bc_string_append_escaped(rv, tmp2);  // no need to free, as it wil be done below.
             break;
@@ -634,7 +637,6 @@ blogc_content_parse_inline_internal(const char *src, size_t src_len)
 
     free(tmp2);
     free(tmp3);
-    free(link1);
 
     return bc_string_free(rv, false);
 }
@@ -643,7 +645,10 @@ blogc_content_parse_inline_internal(const char *src, size_t src_len)
 char*
 blogc_content_parse_inline(const char *src)
 {
-    return blogc_content_parse_inline_internal(src, strlen(src));
+    bc_arena_t *arena = bc_arena_new(0);
+    char *rv = blogc_content_parse_inline_internal(src, strlen(src), arena);
+    bc_arena_free(arena);
+    return rv;
 }
 
 
@@ -674,9 +679,20 @@ blogc_is_ordered_list_item(const char *str, size_t prefix_len)
 }
 
 
-char*
-blogc_content_parse(const char *src, size_t *end_excerpt, char **first_header,
-    char **description)
+// returns true if str starts with len spaces.
+static bool
+starts_with_spaces(const char *str, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+        if (str[i] != ' ')
+            return false;
+    return true;
+}
+
+
+static char*
+blogc_content_parse_internal(const char *src, size_t *end_excerpt,
+    char **first_header, char **description, bc_arena_t *arena)
 {
     // src is always nul-terminated.
     size_t src_len = strlen(src);
@@ -692,7 +708,6 @@ blogc_content_parse(const char *src, size_t *end_excerpt, char **first_header,
     char *prefix = NULL;
     size_t prefix_len = 0;
     char *tmp = NULL;
-    char *tmp2 = NULL;
     char *parsed = NULL;
     char *slug = NULL;
 
@@ -707,7 +722,7 @@ blogc_content_parse(const char *src, size_t *end_excerpt, char **first_header,
     bc_slist_t *lines = NULL;
     bc_slist_t *lines2 = NULL;
 
-    bc_string_t *rv = bc_string_new();
+    bc_string_t *rv = bc_string_new_sized(src_len);
     bc_string_t *tmp_str = NULL;
 
     blogc_content_parser_state_t state = CONTENT_START_LINE;
@@ -835,10 +850,11 @@ blogc_content_parse(const char *src, size_t *end_excerpt, char **first_header,
                 if (c == '\n' || c == '\r' || is_last) {
                     end = is_last && c != '\n' && c != '\r' ? src_len :
                         (real_end != 0 ? real_end : current);
-                    tmp = bc_strndup(src + start, end - start);
+                    tmp = bc_arena_strndup(arena, src + start, end - start);
                     if (first_header != NULL && *first_header == NULL)
                         *first_header = blogc_htmlentities(tmp);
-                    parsed = blogc_content_parse_inline(tmp);
+                    parsed = blogc_content_parse_inline_internal(tmp,
+                        strlen(tmp), arena);
                     slug = blogc_slugify(tmp);
                     if (slug == NULL)
                         bc_string_append_printf(rv, "<h%d>%s</h%d>%s",
@@ -850,7 +866,6 @@ blogc_content_parse(const char *src, size_t *end_excerpt, char **first_header,
                     free(slug);
                     free(parsed);
                     parsed = NULL;
-                    free(tmp);
                     tmp = NULL;
                     state = CONTENT_START_LINE;
                     start = current;
@@ -868,10 +883,8 @@ blogc_content_parse(const char *src, size_t *end_excerpt, char **first_header,
 
             case CONTENT_HTML_END:
                 if (c == '\n' || c == '\r' || is_last) {
-                    tmp = bc_strndup(src + start, end - start);
-                    bc_string_append_printf(rv, "%s%s", tmp, line_ending);
-                    free(tmp);
-                    tmp = NULL;
+                    bc_string_append_len(rv, src + start, end - start);
+                    bc_string_append(rv, line_ending);
                     state = CONTENT_START_LINE;
                     start = current;
                 }
@@ -882,7 +895,7 @@ blogc_content_parse(const char *src, size_t *end_excerpt, char **first_header,
             case CONTENT_BLOCKQUOTE:
                 if (c == ' ' || c == '\t')
                     break;
-                prefix = bc_strndup(src + start, current - start);
+                prefix = bc_arena_strndup(arena, src + start, current - start);
                 state = CONTENT_BLOCKQUOTE_START;
                 break;
 
@@ -890,24 +903,21 @@ blogc_content_parse(const char *src, size_t *end_excerpt, char **first_header,
                 if (c == '\n' || c == '\r' || is_last) {
                     end = is_last && c != '\n' && c != '\r' ? src_len :
                         (real_end != 0 ? real_end : current);
-                    tmp = bc_strndup(src + start2, end - start2);
+                    tmp = bc_arena_strndup(arena, src + start2, end - start2);
                     if (bc_str_starts_with(tmp, prefix)) {
-                        lines = bc_slist_append(lines, bc_strdup(tmp + strlen(prefix)));
+                        lines = bc_arena_slist_append(arena, lines,
+                            tmp + strlen(prefix));
                         state = CONTENT_BLOCKQUOTE_END;
                     }
                     else {
                         state = CONTENT_PARAGRAPH;
-                        free(prefix);
                         prefix = NULL;
-                        bc_slist_free_full(lines, free);
                         lines = NULL;
                         if (is_last) {
-                            free(tmp);
                             tmp = NULL;
                             continue;
                         }
                     }
-                    free(tmp);
                     tmp = NULL;
                 }
                 if (!is_last)
@@ -922,16 +932,15 @@ blogc_content_parse(const char *src, size_t *end_excerpt, char **first_header,
                     // do not propagate title and description to blockquote parsing,
                     // because we just want paragraphs from first level of
                     // content.
-                    tmp = blogc_content_parse(tmp_str->str, NULL, NULL, NULL);
+                    parsed = blogc_content_parse_internal(tmp_str->str, NULL,
+                        NULL, NULL, arena);
                     bc_string_append_printf(rv, "<blockquote>%s</blockquote>%s",
-                        tmp, line_ending);
-                    free(tmp);
-                    tmp = NULL;
+                        parsed, line_ending);
+                    free(parsed);
+                    parsed = NULL;
                     bc_string_free(tmp_str, true);
                     tmp_str = NULL;
-                    bc_slist_free_full(lines, free);
                     lines = NULL;
-                    free(prefix);
                     prefix = NULL;
                     state = CONTENT_START_LINE;
                     start2 = current;
@@ -945,7 +954,7 @@ blogc_content_parse(const char *src, size_t *end_excerpt, char **first_header,
             case CONTENT_CODE:
                 if (c == ' ' || c == '\t')
                     break;
-                prefix = bc_strndup(src + start, current - start);
+                prefix = bc_arena_strndup(arena, src + start, current - start);
                 state = CONTENT_CODE_START;
                 break;
 
@@ -953,24 +962,21 @@ blogc_content_parse(const char *src, size_t *end_excerpt, char **first_header,
                 if (c == '\n' || c == '\r' || is_last) {
                     end = is_last && c != '\n' && c != '\r' ? src_len :
                         (real_end != 0 ? real_end : current);
-                    tmp = bc_strndup(src + start2, end - start2);
+                    tmp = bc_arena_strndup(arena, src + start2, end - start2);
                     if (bc_str_starts_with(tmp, prefix)) {
-                        lines = bc_slist_append(lines, bc_strdup(tmp + strlen(prefix)));
+                        lines = bc_arena_slist_append(arena, lines,
+                            tmp + strlen(prefix));
                         state = CONTENT_CODE_END;
                     }
                     else {
                         state = CONTENT_PARAGRAPH;
-                        free(prefix);
                         prefix = NULL;
-                        bc_slist_free_full(lines, free);
                         lines = NULL;
-                        free(tmp);
                         tmp = NULL;
                         if (is_last)
                             continue;
                         break;
                     }
-                    free(tmp);
                     tmp = NULL;
                 }
                 if (!is_last)
@@ -989,9 +995,7 @@ blogc_content_parse(const char *src, size_t *end_excerpt, char **first_header,
                         free(tmp_line);
                     }
                     bc_string_append_printf(rv, "</code></pre>%s", line_ending);
-                    bc_slist_free_full(lines, free);
                     lines = NULL;
-                    free(prefix);
                     prefix = NULL;
                     state = CONTENT_START_LINE;
                     start2 = current;
@@ -1015,7 +1019,7 @@ blogc_content_parse(const char *src, size_t *end_excerpt, char **first_header,
                 }
                 if (c == ' ' || c == '\t')
                     break;
-                prefix = bc_strndup(src + start, current - start);
+                prefix = bc_arena_strndup(arena, src + start, current - start);
                 state = CONTENT_UNORDERED_LIST_START;
                 break;
 
@@ -1049,8 +1053,7 @@ blogc_content_parse(const char *src, size_t *end_excerpt, char **first_header,
                 if (c == '\n' || c == '\r' || is_last) {
                     end = is_last && c != '\n' && c != '\r' ? src_len :
                         (real_end != 0 ? real_end : current);
-                    tmp = bc_strndup(src + start2, end - start2);
-                    tmp2 = bc_strdup_printf("%-*s", strlen(prefix), "");
+                    tmp = bc_arena_strndup(arena, src + start2, end - start2);
                     if (bc_str_starts_with(tmp, prefix)) {
                         if (lines2 != NULL) {
                             tmp_str = bc_string_new();
@@ -1061,38 +1064,33 @@ blogc_content_parse(const char *src, size_t *end_excerpt, char **first_header,
                                     bc_string_append_printf(tmp_str, "%s%s", l->data,
                                         line_ending);
                             }
-                            bc_slist_free_full(lines2, free);
                             lines2 = NULL;
-                            parsed = blogc_content_parse_inline(tmp_str->str);
+                            parsed = blogc_content_parse_inline_internal(
+                                tmp_str->str, tmp_str->len, arena);
                             bc_string_free(tmp_str, true);
-                            lines = bc_slist_append(lines, bc_strdup(parsed));
+                            lines = bc_arena_slist_append(arena, lines,
+                                bc_arena_strdup(arena, parsed));
                             free(parsed);
                             parsed = NULL;
                         }
-                        lines2 = bc_slist_append(lines2, bc_strdup(tmp + strlen(prefix)));
+                        lines2 = bc_arena_slist_append(arena, lines2,
+                            tmp + strlen(prefix));
                     }
-                    else if (bc_str_starts_with(tmp, tmp2)) {
-                        lines2 = bc_slist_append(lines2, bc_strdup(tmp + strlen(prefix)));
+                    else if (starts_with_spaces(tmp, strlen(prefix))) {
+                        lines2 = bc_arena_slist_append(arena, lines2,
+                            tmp + strlen(prefix));
                     }
                     else {
                         state = CONTENT_PARAGRAPH_END;
-                        free(tmp);
                         tmp = NULL;
-                        free(tmp2);
-                        tmp2 = NULL;
-                        free(prefix);
                         prefix = NULL;
-                        bc_slist_free_full(lines, free);
-                        bc_slist_free_full(lines2, free);
                         lines = NULL;
+                        lines2 = NULL;
                         if (is_last)
                             continue;
                         break;
                     }
-                    free(tmp);
                     tmp = NULL;
-                    free(tmp2);
-                    tmp2 = NULL;
                     state = CONTENT_UNORDERED_LIST_END;
                 }
                 if (!is_last)
@@ -1110,11 +1108,12 @@ blogc_content_parse(const char *src, size_t *end_excerpt, char **first_header,
                                 bc_string_append_printf(tmp_str, "%s%s", l->data,
                                     line_ending);
                         }
-                        bc_slist_free_full(lines2, free);
                         lines2 = NULL;
-                        parsed = blogc_content_parse_inline(tmp_str->str);
+                        parsed = blogc_content_parse_inline_internal(
+                            tmp_str->str, tmp_str->len, arena);
                         bc_string_free(tmp_str, true);
-                        lines = bc_slist_append(lines, bc_strdup(parsed));
+                        lines = bc_arena_slist_append(arena, lines,
+                            bc_arena_strdup(arena, parsed));
                         free(parsed);
                         parsed = NULL;
                     }
@@ -1123,9 +1122,7 @@ blogc_content_parse(const char *src, size_t *end_excerpt, char **first_header,
                         bc_string_append_printf(rv, "<li>%s</li>%s", l->data,
                             line_ending);
                     bc_string_append_printf(rv, "</ul>%s", line_ending);
-                    bc_slist_free_full(lines, free);
                     lines = NULL;
-                    free(prefix);
                     prefix = NULL;
                     state = CONTENT_START_LINE;
                     start2 = current;
@@ -1160,8 +1157,7 @@ blogc_content_parse(const char *src, size_t *end_excerpt, char **first_header,
                 if (c == '\n' || c == '\r' || is_last) {
                     end = is_last && c != '\n' && c != '\r' ? src_len :
                         (real_end != 0 ? real_end : current);
-                    tmp = bc_strndup(src + start2, end - start2);
-                    tmp2 = bc_strdup_printf("%-*s", prefix_len, "");
+                    tmp = bc_arena_strndup(arena, src + start2, end - start2);
                     if (blogc_is_ordered_list_item(tmp, prefix_len)) {
                         if (lines2 != NULL) {
                             tmp_str = bc_string_new();
@@ -1172,38 +1168,32 @@ blogc_content_parse(const char *src, size_t *end_excerpt, char **first_header,
                                     bc_string_append_printf(tmp_str, "%s%s", l->data,
                                         line_ending);
                             }
-                            bc_slist_free_full(lines2, free);
                             lines2 = NULL;
-                            parsed = blogc_content_parse_inline(tmp_str->str);
+                            parsed = blogc_content_parse_inline_internal(
+                                tmp_str->str, tmp_str->len, arena);
                             bc_string_free(tmp_str, true);
-                            lines = bc_slist_append(lines, bc_strdup(parsed));
+                            lines = bc_arena_slist_append(arena, lines,
+                                bc_arena_strdup(arena, parsed));
                             free(parsed);
                             parsed = NULL;
                         }
-                        lines2 = bc_slist_append(lines2, bc_strdup(tmp + prefix_len));
+                        lines2 = bc_arena_slist_append(arena, lines2,
+                            tmp + prefix_len);
                     }
-                    else if (bc_str_starts_with(tmp, tmp2)) {
-                        lines2 = bc_slist_append(lines2, bc_strdup(tmp + prefix_len));
+                    else if (starts_with_spaces(tmp, prefix_len)) {
+                        lines2 = bc_arena_slist_append(arena, lines2,
+                            tmp + prefix_len);
                     }
                     else {
                         state = CONTENT_PARAGRAPH_END;
-                        free(tmp);
                         tmp = NULL;
-                        free(tmp2);
-                        tmp2 = NULL;
-                        free(parsed);
-                        parsed = NULL;
-                        bc_slist_free_full(lines, free);
-                        bc_slist_free_full(lines2, free);
                         lines = NULL;
+                        lines2 = NULL;
                         if (is_last)
                             continue;
                         break;
                     }
-                    free(tmp);
                     tmp = NULL;
-                    free(tmp2);
-                    tmp2 = NULL;
                     state = CONTENT_ORDERED_LIST_END;
                 }
                 if (!is_last)
@@ -1221,11 +1211,12 @@ blogc_content_parse(const char *src, size_t *end_excerpt, char **first_header,
                                 bc_string_append_printf(tmp_str, "%s%s", l->data,
                                     line_ending);
                         }
-                        bc_slist_free_full(lines2, free);
                         lines2 = NULL;
-                        parsed = blogc_content_parse_inline(tmp_str->str);
+                        parsed = blogc_content_parse_inline_internal(
+                            tmp_str->str, tmp_str->len, arena);
                         bc_string_free(tmp_str, true);
-                        lines = bc_slist_append(lines, bc_strdup(parsed));
+                        lines = bc_arena_slist_append(arena, lines,
+                            bc_arena_strdup(arena, parsed));
                         free(parsed);
                         parsed = NULL;
                     }
@@ -1234,9 +1225,7 @@ blogc_content_parse(const char *src, size_t *end_excerpt, char **first_header,
                         bc_string_append_printf(rv, "<li>%s</li>%s", l->data,
                             line_ending);
                     bc_string_append_printf(rv, "</ol>%s", line_ending);
-                    bc_slist_free_full(lines, free);
                     lines = NULL;
-                    free(prefix);
                     prefix = NULL;
                     state = CONTENT_START_LINE;
                     start2 = current;
@@ -1258,15 +1247,15 @@ blogc_content_parse(const char *src, size_t *end_excerpt, char **first_header,
 
             case CONTENT_PARAGRAPH_END:
                 if (c == '\n' || c == '\r' || is_last) {
-                    tmp = bc_strndup(src + start, end - start);
+                    tmp = bc_arena_strndup(arena, src + start, end - start);
                     if (description != NULL && *description == NULL)
                         *description = blogc_fix_description(tmp);
-                    parsed = blogc_content_parse_inline(tmp);
+                    parsed = blogc_content_parse_inline_internal(tmp,
+                        strlen(tmp), arena);
                     bc_string_append_printf(rv, "<p>%s</p>%s", parsed,
                         line_ending);
                     free(parsed);
                     parsed = NULL;
-                    free(tmp);
                     tmp = NULL;
                     state = CONTENT_START_LINE;
                     start = current;
@@ -1282,3 +1271,15 @@ blogc_content_parse(const char *src, size_t *end_excerpt, char **first_header,
 
     return bc_string_free(rv, false);
 }
+
+
+char*
+blogc_content_parse(const char *src, size_t *end_excerpt, char **first_header,
+    char **description)
+{
+    bc_arena_t *arena = bc_arena_new(0);
+    char *rv = blogc_content_parse_internal(src, end_excerpt, first_header,
+        description, arena);
+    bc_arena_free(arena);
+    return rv;
+}
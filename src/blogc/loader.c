@@ -58,69 +58,59 @@ blogc_get_filename(const char *f)
 
 
 bc_slist_t*
-blogc_template_parse_from_file(const char *f, bc_error_t **err)
+blogc_template_parse_from_file(const char *f, bc_arena_t *arena,
+    bool use_mmap, bc_error_t **err)
 {
     if (err == NULL || *err != NULL)
         return NULL;
 
-    size_t len;
-    char *s = bc_file_get_contents(f, true, &len, err);
-    if (s == NULL)
+    // parsers work on the mapped bytes directly, and copy whatever they need.
+    // long running callers (blogc-make) read the file instead, as it may be
+    // truncated while mapped.
+    bc_file_map_t *map = use_mmap ? bc_file_map(f, true, err) :
+        bc_file_read(f, true, err);
+    if (map == NULL)
         return NULL;
-    bc_slist_t *rv = blogc_template_parse(s, len, err);
-    free(s);
+    bc_slist_t *rv = blogc_template_parse(map->str, map->len, arena, err);
+    bc_file_map_free(map);
     return rv;
 }
 
 
-bc_trie_t*
-blogc_source_parse_from_file(const char *f, bc_error_t **err)
+bc_hashmap_t*
+blogc_source_parse_from_file(const char *f, bool use_mmap, bc_error_t **err)
 {
     if (err == NULL || *err != NULL)
         return NULL;
 
-    size_t len;
-    char *s = bc_file_get_contents(f, true, &len, err);
-    if (s == NULL)
+    bc_file_map_t *map = use_mmap ? bc_file_map(f, true, err) :
+        bc_file_read(f, true, err);
+    if (map == NULL)
         return NULL;
-    bc_trie_t *rv = blogc_source_parse(s, len, err);
+    bc_hashmap_t *rv = blogc_source_parse(map->str, map->len, err);
 
     // set FILENAME variable
     if (rv != NULL) {
         char *filename = blogc_get_filename(f);
         if (filename != NULL)
-            bc_trie_insert(rv, "FILENAME", filename);
+            bc_hashmap_insert(rv, "FILENAME", filename);
     }
 
-    free(s);
+    bc_file_map_free(map);
     return rv;
 }
 
 
-bc_slist_t*
-blogc_source_parse_from_files(bc_trie_t *conf, bc_slist_t *l, bc_error_t **err)
+static bc_slist_t*
+filter_sources(bc_hashmap_t *conf, bc_slist_t *sources, bc_free_func_t free_func,
+    bc_error_t **err)
 {
-    if (err == NULL || *err != NULL)
-        return NULL;
-
-    bool reverse = bc_trie_lookup(conf, "FILTER_REVERSE");
-    bc_slist_t* sources = NULL;
-    for (bc_slist_t *tmp = l; tmp != NULL; tmp = tmp->next) {
-        if (reverse) {
-            sources = bc_slist_prepend(sources, tmp->data);
-        }
-        else {
-            sources = bc_slist_append(sources, tmp->data);
-        }
-    }
-
-    bc_error_t *tmp_err = NULL;
     bc_slist_t *rv = NULL;
     size_t with_date = 0;
 
-    const char *filter_tag = bc_trie_lookup(conf, "FILTER_TAG");
-    const char *filter_page = bc_trie_lookup(conf, "FILTER_PAGE");
-    const char *filter_per_page = bc_trie_lookup(conf, "FILTER_PER_PAGE");
+    const char *filter_tag = bc_hashmap_lookup(conf, "FILTER_TAG");
+    const char *filter_page = bc_hashmap_lookup(conf, "FILTER_PAGE");
+    const char *filter_per_page = bc_hashmap_lookup(conf, "FILTER_PER_PAGE");
 
     const char *ptr;
     char *endptr;
@@ -147,23 +137,13 @@ blogc_source_parse_from_files(bc_trie_t *conf, bc_slist_t *l, bc_error_t **err)
     size_t counter = 0;
 
     for (bc_slist_t *tmp = sources; tmp != NULL; tmp = tmp->next) {
-        char *f = tmp->data;
-        bc_trie_t *s = blogc_source_parse_from_file(f, &tmp_err);
-        if (s == NULL) {
-            *err = bc_error_new_printf(BLOGC_ERROR_LOADER,
-                "An error occurred while parsing source file: %s\n\n%s",
-                f, tmp_err->msg);
-            bc_error_free(tmp_err);
-            tmp_err = NULL;
-            bc_slist_free_full(rv, (bc_free_func_t) bc_trie_free);
-            rv = NULL;
-            break;
-        }
+        bc_hashmap_t *s = tmp->data;
         if (filter_tag != NULL) {
-            const char *tags_str = bc_trie_lookup(s, "TAGS");
+            const char *tags_str = bc_hashmap_lookup(s, "TAGS");
             // if user wants to filter by tag and no tag is provided, skip it
             if (tags_str == NULL) {
-                bc_trie_free(s);
+                if (free_func != NULL)
+                    free_func(s);
                 continue;
             }
             char **tags = bc_str_split(tags_str, ' ', 0);
@@ -176,67 +156,136 @@ blogc_source_parse_from_files(bc_trie_t *conf, bc_slist_t *l, bc_error_t **err)
             }
             bc_strv_free(tags);
             if (!found) {
-                bc_trie_free(s);
+                if (free_func != NULL)
+                    free_func(s);
                 continue;
             }
         }
         if (filter_page != NULL) {
             if (counter < start || counter >= end) {
                 counter++;
-                bc_trie_free(s);
+                if (free_func != NULL)
+                    free_func(s);
                 continue;
             }
             counter++;
         }
-        if (bc_trie_lookup(s, "DATE") != NULL)
+        if (bc_hashmap_lookup(s, "DATE") != NULL)
             with_date++;
         rv = bc_slist_append(rv, s);
     }
 
-    bc_slist_free(sources);
-
     if (with_date > 0 && with_date < bc_slist_length(rv)) {
         *err = bc_error_new_printf(BLOGC_ERROR_LOADER,
             "'DATE' variable provided for at least one source file, but not "
             "for all source files. It must be provided for all files.\n");
-        bc_slist_free_full(rv, (bc_free_func_t) bc_trie_free);
-        rv = NULL;
+        bc_slist_free_full(rv, free_func);
+        return NULL;
     }
 
     bool first = true;
     for (bc_slist_t *tmp = rv; tmp != NULL; tmp = tmp->next) {
-        bc_trie_t *s = tmp->data;
+        bc_hashmap_t *s = tmp->data;
         if (first) {
-            const char *val = bc_trie_lookup(s, "DATE");
+            const char *val = bc_hashmap_lookup(s, "DATE");
             if (val != NULL)
-                bc_trie_insert(conf, "DATE_FIRST", bc_strdup(val));
-            val = bc_trie_lookup(s, "FILENAME");
+                bc_hashmap_insert(conf, "DATE_FIRST", bc_strdup(val));
+            val = bc_hashmap_lookup(s, "FILENAME");
             if (val != NULL)
-                bc_trie_insert(conf, "FILENAME_FIRST", bc_strdup(val));
+                bc_hashmap_insert(conf, "FILENAME_FIRST", bc_strdup(val));
             first = false;
         }
         if (tmp->next == NULL) {  // last
-            const char *val = bc_trie_lookup(s, "DATE");
+            const char *val = bc_hashmap_lookup(s, "DATE");
             if (val != NULL)
-                bc_trie_insert(conf, "DATE_LAST", bc_strdup(val));
-            val = bc_trie_lookup(s, "FILENAME");
+                bc_hashmap_insert(conf, "DATE_LAST", bc_strdup(val));
+            val = bc_hashmap_lookup(s, "FILENAME");
             if (val != NULL)
-                bc_trie_insert(conf, "FILENAME_LAST", bc_strdup(val));
+                bc_hashmap_insert(conf, "FILENAME_LAST", bc_strdup(val));
         }
     }
 
     if (filter_page != NULL) {
         size_t last_page = ceilf(((float) counter) / per_page);
-        bc_trie_insert(conf, "CURRENT_PAGE", bc_strdup_printf("%ld", page));
+        bc_hashmap_insert(conf, "CURRENT_PAGE", bc_strdup_printf("%ld", page));
         if (page > 1)
-            bc_trie_insert(conf, "PREVIOUS_PAGE", bc_strdup_printf("%ld", page - 1));
+            bc_hashmap_insert(conf, "PREVIOUS_PAGE", bc_strdup_printf("%ld", page - 1));
         if (page < last_page)
-            bc_trie_insert(conf, "NEXT_PAGE", bc_strdup_printf("%ld", page + 1));
+            bc_hashmap_insert(conf, "NEXT_PAGE", bc_strdup_printf("%ld", page + 1));
         if (bc_slist_length(rv) > 0)
-            bc_trie_insert(conf, "FIRST_PAGE", bc_strdup("1"));
+            bc_hashmap_insert(conf, "FIRST_PAGE", bc_strdup("1"));
         if (last_page > 0)
-            bc_trie_insert(conf, "LAST_PAGE", bc_strdup_printf("%d", last_page));
+            bc_hashmap_insert(conf, "LAST_PAGE", bc_strdup_printf("%d", last_page));
+    }
+
+    return rv;
+}
+
+
+static bc_slist_t*
+order_list(bc_hashmap_t *conf, bc_slist_t *l)
+{
+    bool reverse = bc_hashmap_lookup(conf, "FILTER_REVERSE");
+    bc_slist_t* rv = NULL;
+    for (bc_slist_t *tmp = l; tmp != NULL; tmp = tmp->next) {
+        if (reverse) {
+            rv = bc_slist_prepend(rv, tmp->data);
+        }
+        else {
+            rv = bc_slist_append(rv, tmp->data);
+        }
+    }
+    return rv;
+}
+
+
+bc_slist_t*
+blogc_source_parse_from_files(bc_hashmap_t *conf, bc_slist_t *l, bc_error_t **err)
+{
+    if (err == NULL || *err != NULL)
+        return NULL;
+
+    bc_slist_t *files = order_list(conf, l);
+
+    bc_error_t *tmp_err = NULL;
+    bc_slist_t *sources = NULL;
+
+    for (bc_slist_t *tmp = files; tmp != NULL; tmp = tmp->next) {
+        char *f = tmp->data;
+        bc_hashmap_t *s = blogc_source_parse_from_file(f, true, &tmp_err);
+        if (s == NULL) {
+            *err = bc_error_new_printf(BLOGC_ERROR_LOADER,
+                "An error occurred while parsing source file: %s\n\n%s",
+                f, tmp_err->msg);
+            bc_error_free(tmp_err);
+            bc_slist_free_full(sources, (bc_free_func_t) bc_hashmap_free);
+            bc_slist_free(files);
+            return NULL;
+        }
+        sources = bc_slist_append(sources, s);
     }
 
+    bc_slist_free(files);
+
+    // the returned list owns the selected sources, everything else is freed
+    bc_slist_t *rv = filter_sources(conf, sources,
+        (bc_free_func_t) bc_hashmap_free, err);
+    bc_slist_free(sources);
+    return rv;
+}
+
+
+bc_slist_t*
+blogc_source_filter(bc_hashmap_t *conf, bc_slist_t *l, bc_error_t **err)
+{
+    if (err == NULL || *err != NULL)
+        return NULL;
+
+    bc_slist_t *sources = order_list(conf, l);
+
+    // sources are borrowed from the caller, the returned list must be freed
+    // with bc_slist_free
+    bc_slist_t *rv = filter_sources(conf, sources, NULL, err);
+    bc_slist_free(sources);
     return rv;
 }
@@ -13,9 +13,13 @@
 #include "../common/utils.h"
 
 char* blogc_get_filename(const char *f);
-bc_slist_t* blogc_template_parse_from_file(const char *f, bc_error_t **err);
-bc_trie_t* blogc_source_parse_from_file(const char *f, bc_error_t **err);
-bc_slist_t* blogc_source_parse_from_files(bc_trie_t *conf, bc_slist_t *l,
+bc_slist_t* blogc_template_parse_from_file(const char *f, bc_arena_t *arena,
+    bool use_mmap, bc_error_t **err);
+bc_hashmap_t* blogc_source_parse_from_file(const char *f, bool use_mmap,
+    bc_error_t **err);
+bc_slist_t* blogc_source_parse_from_files(bc_hashmap_t *conf, bc_slist_t *l,
+    bc_error_t **err);
+bc_slist_t* blogc_source_filter(bc_hashmap_t *conf, bc_slist_t *l,
     bc_error_t **err);
 
 #endif /* _LOADER_H */
@@ -15,18 +15,21 @@
 #endif /* HAVE_SYS_STAT_H */
 
 #include <errno.h>
+#include <fcntl.h>
 #include <locale.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "debug.h"
 #include "template-parser.h"
 #include "loader.h"
 #include "renderer.h"
 #include "../common/error.h"
+#include "../common/file.h"
 #include "../common/utf8.h"
 #include "../common/utils.h"
 
@@ -120,6 +123,13 @@ blogc_mkdir_recursive(const char *filename)
 }
 
 
+static void
+blogc_write_output(const char *str, size_t len, void *user_data)
+{
+    bc_file_writer_write(user_data, str, len);
+}
+
+
 static bc_slist_t*
 blogc_read_stdin_to_list(bc_slist_t *l)
 {
@@ -162,8 +172,8 @@ main(int argc, char **argv)
     char **pieces = NULL;
 
     bc_slist_t *sources = NULL;
-    bc_trie_t *config = bc_trie_new(free);
-    bc_trie_insert(config, "BLOGC_VERSION", bc_strdup(PACKAGE_VERSION));
+    bc_hashmap_t *config = bc_hashmap_new(free);
+    bc_hashmap_insert(config, "BLOGC_VERSION", bc_strdup(PACKAGE_VERSION));
 
     for (size_t i = 1; i < argc; i++) {
         tmp = NULL;
@@ -233,7 +243,7 @@ main(int argc, char **argv)
                                 goto cleanup;
                             }
                         }
-                        bc_trie_insert(config, pieces[0], bc_strdup(pieces[1]));
+                        bc_hashmap_insert(config, pieces[0], bc_strdup(pieces[1]));
                         bc_strv_free(pieces);
                         pieces = NULL;
                     }
@@ -292,7 +302,7 @@ main(int argc, char **argv)
     }
 
     if (print != NULL) {
-        const char *val = bc_trie_lookup(config, print);
+        const char *val = bc_hashmap_lookup(config, print);
         if (val == NULL) {
             fprintf(stderr, "blogc: error: configuration variable not found: %s\n",
                 print);
@@ -311,7 +321,8 @@ main(int argc, char **argv)
         goto cleanup2;
     }
 
-    bc_slist_t* l = blogc_template_parse_from_file(template, &err);
+    bc_slist_t* l = blogc_template_parse_from_file(template, NULL, true,
+        &err);
     if (err != NULL) {
         bc_error_print(err, "blogc");
         rv = 3;
@@ -321,37 +332,47 @@ main(int argc, char **argv)
     if (debug)
         blogc_debug_template(l);
 
-    char *out = blogc_render(l, s, config, listing);
-
     bool write_to_stdout = (output == NULL || (0 == strcmp(output, "-")));
 
-    FILE *fp = stdout;
-    if (!write_to_stdout) {
+    int fd = STDOUT_FILENO;
+    if (write_to_stdout) {
+        fflush(stdout);
+    }
+    else {
         blogc_mkdir_recursive(output);
-        fp = fopen(output, "w");
-        if (fp == NULL) {
+        fd = open(output, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        if (fd == -1) {
             fprintf(stderr, "blogc: error: failed to open output file (%s): %s\n",
                 output, strerror(errno));
             rv = 3;
-            goto cleanup4;
+            goto cleanup3;
         }
     }
 
-    if (out != NULL)
-        fprintf(fp, "%s", out);
+    // output is streamed through a fixed-size buffer, instead of being built
+    // in memory.
+    bc_file_writer_t *writer = bc_file_writer_new(fd);
+    blogc_render_to_sink(l, s, config, listing, blogc_write_output, writer);
+    if (!bc_file_writer_flush(writer)) {
+        fprintf(stderr, "blogc: error: failed to write output file (%s): %s\n",
+            write_to_stdout ? "-" : output, strerror(writer->error));
+        rv = 3;
+    }
+    bc_file_writer_free(writer);
 
-    if (!write_to_stdout)
-        fclose(fp);
+    if (!write_to_stdout && close(fd) != 0 && rv == 0) {
+        fprintf(stderr, "blogc: error: failed to write output file (%s): %s\n",
+            output, strerror(errno));
+        rv = 3;
+    }
 
-cleanup4:
-    free(out);
 cleanup3:
     blogc_template_free_ast(l);
 cleanup2:
-    bc_slist_free_full(s, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(s, (bc_free_func_t) bc_hashmap_free);
     bc_error_free(err);
 cleanup:
-    bc_trie_free(config);
+    bc_hashmap_free(config);
     free(template);
     free(output);
     free(print);
@@ -19,22 +19,22 @@
 
 
 const char*
-blogc_get_variable(const char *name, bc_trie_t *global, bc_trie_t *local)
+blogc_get_variable(const char *name, bc_hashmap_t *global, bc_hashmap_t *local)
 {
     const char *rv = NULL;
     if (local != NULL) {
-        rv = bc_trie_lookup(local, name);
+        rv = bc_hashmap_lookup(local, name);
         if (rv != NULL)
             return rv;
     }
     if (global != NULL)
-        rv = bc_trie_lookup(global, name);
+        rv = bc_hashmap_lookup(global, name);
     return rv;
 }
 
 
 char*
-blogc_format_date(const char *date, bc_trie_t *global, bc_trie_t *local)
+blogc_format_date(const char *date, bc_hashmap_t *global, bc_hashmap_t *local)
 {
     const char *date_format = blogc_get_variable("DATE_FORMAT", global, local);
     if (date == NULL)
@@ -53,94 +53,81 @@ blogc_format_date(const char *date, bc_trie_t *global, bc_trie_t *local)
 }
 
 
-char*
-blogc_format_variable(const char *name, bc_trie_t *global, bc_trie_t *local,
-    bc_slist_t *foreach_var)
+static const char*
+resolve_variable(const char *name, const blogc_template_variable_t *var,
+    bc_hashmap_t *global, bc_hashmap_t *local, bc_slist_t *foreach_var,
+    size_t *len, char **formatted)
 {
+    *formatted = NULL;
+
     // if used asked for a variable that exists, just return it right away
     const char *value = blogc_get_variable(name, global, local);
-    if (value != NULL)
-        return bc_strdup(value);
-
-    // do the same for special variable 'FOREACH_ITEM'
-    if (0 == strcmp(name, "FOREACH_ITEM")) {
-        if (foreach_var != NULL && foreach_var->data != NULL) {
-            return bc_strdup(foreach_var->data);
-        }
-        return NULL;
+    if (value != NULL) {
+        *len = strlen(value);
+        return value;
     }
 
-    char *var = bc_strdup(name);
-
-    size_t i;
-    size_t last = strlen(var);
-
-    long int len = -1;
-
-    // just walk till the last '_'
-    for (i = last - 1; i > 0 && var[i] >= '0' && var[i] <= '9'; i--);
-
-    if (var[i] == '_' && (i + 1) < last) {  // var ends with '_[0-9]+'
-        char *endptr;
-        len = strtol(var + i + 1, &endptr, 10);
-        if (*endptr != '\0') {
-            fprintf(stderr, "warning: invalid variable size for '%s', "
-                "ignoring.\n", var);
-            len = -1;
-        }
-        else {
-            var[i] = '\0';
+    if (var->key == NULL) {
+        // do the same for special variable 'FOREACH_ITEM'
+        if (var->foreach_item && foreach_var != NULL &&
+            foreach_var->data != NULL)
+        {
+            *len = strlen(foreach_var->data);
+            return foreach_var->data;
         }
+        return NULL;
     }
 
-    bool must_format = false;
-
-    if (bc_str_ends_with(var, "_FORMATTED")) {
-        var[strlen(var) - 10] = '\0';
-        must_format = true;
-    }
-
-    if ((0 == strcmp(var, "FOREACH_ITEM")) &&
-        (foreach_var != NULL && foreach_var->data != NULL))
+    if (var->foreach_item && foreach_var != NULL && foreach_var->data != NULL)
         value = foreach_var->data;
     else
-        value = blogc_get_variable(var, global, local);
+        value = blogc_get_variable(var->key, global, local);
 
-    if (value == NULL) {
-        free(var);
+    if (value == NULL)
         return NULL;
-    }
 
-    char *rv = NULL;
-
-    if (must_format) {
-        if (bc_str_starts_with(name, "DATE_")) {
-            rv = blogc_format_date(value, global, local);
-        }
-        else {
+    switch (var->formatter) {
+        case BLOGC_TEMPLATE_FORMATTER_NONE:
+            break;
+        case BLOGC_TEMPLATE_FORMATTER_DATE:
+            *formatted = blogc_format_date(value, global, local);
+            value = *formatted;
+            break;
+        case BLOGC_TEMPLATE_FORMATTER_UNKNOWN:
             fprintf(stderr, "warning: no formatter found for '%s', "
-                "ignoring.\n", var);
-            rv = bc_strdup(value);
-        }
-    }
-    else {
-        rv = bc_strdup(value);
+                "ignoring.\n", var->key);
+            break;
     }
 
-    free(var);
+    *len = strlen(value);
+    if (var->len > 0 && (size_t) var->len < *len)
+        *len = var->len;
 
-    if (len > 0) {
-        char *tmp = bc_strndup(rv, len);
-        free(rv);
-        rv = tmp;
-    }
+    return value;
+}
+
+
+char*
+blogc_format_variable(const char *name, bc_hashmap_t *global, bc_hashmap_t *local,
+    bc_slist_t *foreach_var)
+{
+    blogc_template_variable_t var;
+    blogc_template_parse_variable(name, &var, NULL);
+
+    size_t len;
+    char *formatted;
+    const char *value = resolve_variable(name, &var, global, local,
+        foreach_var, &len, &formatted);
 
+    char *rv = value != NULL ? bc_strndup(value, len) : NULL;
+    free(formatted);
+    free(var.key);
     return rv;
 }
 
 
 bc_slist_t*
-blogc_split_list_variable(const char *name, bc_trie_t *global, bc_trie_t *local)
+blogc_split_list_variable(const char *name, bc_hashmap_t *global, bc_hashmap_t *local)
 {
     const char *value = blogc_get_variable(name, global, local);
     if (value == NULL)
@@ -161,23 +148,63 @@ blogc_split_list_variable(const char *name, bc_trie_t *global, bc_trie_t *local)
 }
 
 
+static size_t
+estimate_size(bc_slist_t *tmpl, bc_slist_t *sources)
+{
+    // static template content plus the content of every source is a good
+    // enough guess of the output size, and saves most of the reallocs while
+    // rendering big listings.
+    size_t rv = 0;
+    for (bc_slist_t *tmp = tmpl; tmp != NULL; tmp = tmp->next) {
+        blogc_template_node_t *node = tmp->data;
+        if (node->type == BLOGC_TEMPLATE_NODE_CONTENT && node->data[0] != NULL)
+            rv += strlen(node->data[0]);
+    }
+    for (bc_slist_t *tmp = sources; tmp != NULL; tmp = tmp->next) {
+        const char *content = bc_hashmap_lookup(tmp->data, "CONTENT");
+        if (content != NULL)
+            rv += strlen(content);
+    }
+    return rv;
+}
+
+
+static void
+string_sink(const char *str, size_t len, void *user_data)
+{
+    bc_string_append_len(user_data, str, len);
+}
+
+
 char*
-blogc_render(bc_slist_t *tmpl, bc_slist_t *sources, bc_trie_t *config, bool listing)
+blogc_render(bc_slist_t *tmpl, bc_slist_t *sources, bc_hashmap_t *config, bool listing)
 {
     if (tmpl == NULL)
         return NULL;
 
+    bc_string_t *str = bc_string_new_sized(estimate_size(tmpl, sources));
+    blogc_render_to_sink(tmpl, sources, config, listing, string_sink, str);
+    return bc_string_free(str, false);
+}
+
+
+void
+blogc_render_to_sink(bc_slist_t *tmpl, bc_slist_t *sources,
+    bc_hashmap_t *config, bool listing, blogc_render_sink_func_t sink,
+    void *user_data)
+{
+    if (tmpl == NULL || sink == NULL)
+        return;
+
     bc_slist_t *current_source = NULL;
     bc_slist_t *listing_start = NULL;
 
-    bc_string_t *str = bc_string_new();
-
-    bc_trie_t *tmp_source = NULL;
+    bc_hashmap_t *tmp_source = NULL;
+    const char *value = NULL;
+    size_t value_len = 0;
     char *config_value = NULL;
     char *defined = NULL;
 
-    size_t if_count = 0;
-
     bc_slist_t *foreach_var = NULL;
     bc_slist_t *foreach_var_start = NULL;
     bc_slist_t *foreach_start = NULL;
@@ -197,21 +224,17 @@ blogc_render(bc_slist_t *tmpl, bc_slist_t *sources, bc_trie_t *config, bool list
 
             case BLOGC_TEMPLATE_NODE_CONTENT:
                 if (node->data[0] != NULL)
-                    bc_string_append(str, node->data[0]);
+                    sink(node->data[0], strlen(node->data[0]), user_data);
                 break;
 
             case BLOGC_TEMPLATE_NODE_BLOCK:
                 inside_block = true;
-                if_count = 0;
                 if (0 == strcmp("entry", node->data[0])) {
                     if (listing) {
 
-                        // we can just skip anything and walk until the next
+                        // we can just skip anything and jump to the matching
                         // 'endblock'
-                        while (node->type != BLOGC_TEMPLATE_NODE_ENDBLOCK) {
-                            tmp = tmp->next;
-                            node = tmp->data;
-                        }
+                        tmp = node->jump;
                         break;
                     }
                     current_source = sources;
@@ -221,24 +244,18 @@ blogc_render(bc_slist_t *tmpl, bc_slist_t *sources, bc_trie_t *config, bool list
                          (0 == strcmp("listing_once", node->data[0]))) {
                     if (!listing) {
 
-                        // we can just skip anything and walk until the next
+                        // we can just skip anything and jump to the matching
                         // 'endblock'
-                        while (node->type != BLOGC_TEMPLATE_NODE_ENDBLOCK) {
-                            tmp = tmp->next;
-                            node = tmp->data;
-                        }
+                        tmp = node->jump;
                         break;
                     }
                 }
                 if (0 == strcmp("listing", node->data[0])) {
                     if (sources == NULL) {
 
-                        // we can just skip anything and walk until the next
+                        // we can just skip anything and jump to the matching
                         // 'endblock'
-                        while (node->type != BLOGC_TEMPLATE_NODE_ENDBLOCK) {
-                            tmp = tmp->next;
-                            node = tmp->data;
-                        }
+                        tmp = node->jump;
                         break;
                     }
                     if (current_source == NULL) {
@@ -251,14 +268,15 @@ blogc_render(bc_slist_t *tmpl, bc_slist_t *sources, bc_trie_t *config, bool list
 
             case BLOGC_TEMPLATE_NODE_VARIABLE:
                 if (node->data[0] != NULL) {
-                    config_value = blogc_format_variable(node->data[0],
-                        config, inside_block ? tmp_source : NULL, foreach_var);
-                    if (config_value != NULL) {
-                        bc_string_append(str, config_value);
-                        free(config_value);
-                        config_value = NULL;
-                        break;
-                    }
+                    // modifiers were resolved by the parser, and values are
+                    // appended right from the sources, no need to copy.
+                    value = resolve_variable(node->data[0], &node->var,
+                        config, inside_block ? tmp_source : NULL, foreach_var,
+                        &value_len, &config_value);
+                    if (value != NULL)
+                        sink(value, value_len, user_data);
+                    free(config_value);
+                    config_value = NULL;
                 }
                 break;
 
@@ -280,7 +298,6 @@ blogc_render(bc_slist_t *tmpl, bc_slist_t *sources, bc_trie_t *config, bool list
 
             case BLOGC_TEMPLATE_NODE_IF:
             case BLOGC_TEMPLATE_NODE_IFDEF:
-                if_count = 0;
                 defined = NULL;
                 if (node->data[0] != NULL)
                     defined = blogc_format_variable(node->data[0], config,
@@ -328,37 +345,17 @@ blogc_render(bc_slist_t *tmpl, bc_slist_t *sources, bc_trie_t *config, bool list
                 }
                 if (!evaluate) {
 
-                    // at this point we can just skip anything, counting the
-                    // number of 'if's, to know how many 'endif's we need to
-                    // skip as well.
-                    while (1) {
-                        tmp = tmp->next;
-                        node = tmp->data;
-                        if ((node->type == BLOGC_TEMPLATE_NODE_IF) ||
-                            (node->type == BLOGC_TEMPLATE_NODE_IFDEF) ||
-                            (node->type == BLOGC_TEMPLATE_NODE_IFNDEF))
-                        {
-                            if_count++;
-                            continue;
-                        }
-                        if ((node->type == BLOGC_TEMPLATE_NODE_ELSE) &&
-                            (if_count == 0))
-                        {
-                            // this is somewhat complex. only an else statement
-                            // right after a non evaluated block should be considered
-                            // valid, because all the inner conditionals were just
-                            // skipped, and all the outter conditionals evaluated
-                            // to true.
-                            valid_else = true;
-                            break;
-                        }
-                        if (node->type == BLOGC_TEMPLATE_NODE_ENDIF) {
-                            if (if_count > 0) {
-                                if_count--;
-                                continue;
-                            }
-                            break;
-                        }
+                    // at this point we can just skip anything, jumping to the
+                    // matching 'else' or 'endif'.
+                    tmp = node->jump;
+                    node = tmp->data;
+                    if (node->type == BLOGC_TEMPLATE_NODE_ELSE) {
+                        // this is somewhat complex. only an else statement
+                        // right after a non evaluated block should be considered
+                        // valid, because all the inner conditionals were just
+                        // skipped, and all the outter conditionals evaluated
+                        // to true.
+                        valid_else = true;
                     }
                 }
                 else {
@@ -370,32 +367,11 @@ blogc_render(bc_slist_t *tmpl, bc_slist_t *sources, bc_trie_t *config, bool list
                 break;
 
             case BLOGC_TEMPLATE_NODE_ELSE:
-                if_count = 0;
                 if (!valid_else) {
 
-                    // at this point we can just skip anything, counting the
-                    // number of 'if's, to know how many 'endif's we need to
-                    // skip as well.
-                    while (1) {
-                        tmp = tmp->next;
-                        node = tmp->data;
-                        if ((node->type == BLOGC_TEMPLATE_NODE_IF) ||
-                            (node->type == BLOGC_TEMPLATE_NODE_IFDEF) ||
-                            (node->type == BLOGC_TEMPLATE_NODE_IFNDEF))
-                        {
-                            if_count++;
-                            continue;
-                        }
-                        // no need to handle else statements here, because every
-                        // if should have an endif.
-                        if (node->type == BLOGC_TEMPLATE_NODE_ENDIF) {
-                            if (if_count > 0) {
-                                if_count--;
-                                continue;
-                            }
-                            break;
-                        }
-                    }
+                    // at this point we can just skip anything, jumping to the
+                    // matching 'endif'.
+                    tmp = node->jump;
                 }
                 valid_else = false;
                 break;
@@ -404,8 +380,6 @@ blogc_render(bc_slist_t *tmpl, bc_slist_t *sources, bc_trie_t *config, bool list
                 // any endif statement should invalidate valid_else, to avoid
                 // propagation to outter conditionals.
                 valid_else = false;
-                if (if_count > 0)
-                    if_count--;
                 break;
 
             case BLOGC_TEMPLATE_NODE_FOREACH:
@@ -420,12 +394,9 @@ blogc_render(bc_slist_t *tmpl, bc_slist_t *sources, bc_trie_t *config, bool list
                     }
                     else {
 
-                        // we can just skip anything and walk until the next
+                        // we can just skip anything and jump to the matching
                         // 'endforeach'
-                        while (node->type != BLOGC_TEMPLATE_NODE_ENDFOREACH) {
-                            tmp = tmp->next;
-                            node = tmp->data;
-                        }
+                        tmp = node->jump;
                         break;
                     }
                 }
@@ -454,6 +425,4 @@ blogc_render(bc_slist_t *tmpl, bc_slist_t *sources, bc_trie_t *config, bool list
 
     // no need to free temporary variables here. the template parser makes sure
     // that templates are sane and statements are closed.
-
-    return bc_string_free(str, false);
 }
@@ -10,15 +10,23 @@
 #define _RENDERER_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include "../common/utils.h"
 
-const char* blogc_get_variable(const char *name, bc_trie_t *global, bc_trie_t *local);
-char* blogc_format_date(const char *date, bc_trie_t *global, bc_trie_t *local);
-char* blogc_format_variable(const char *name, bc_trie_t *global, bc_trie_t *local,
+// receives the rendered output, piece by piece. pieces are not nul-terminated.
+typedef void (*blogc_render_sink_func_t)(const char *str, size_t len,
+    void *user_data);
+
+const char* blogc_get_variable(const char *name, bc_hashmap_t *global, bc_hashmap_t *local);
+char* blogc_format_date(const char *date, bc_hashmap_t *global, bc_hashmap_t *local);
+char* blogc_format_variable(const char *name, bc_hashmap_t *global, bc_hashmap_t *local,
     bc_slist_t *foreach_var);
-bc_slist_t* blogc_split_list_variable(const char *name, bc_trie_t *global,
-    bc_trie_t *local);
-char* blogc_render(bc_slist_t *tmpl, bc_slist_t *sources, bc_trie_t *config,
+bc_slist_t* blogc_split_list_variable(const char *name, bc_hashmap_t *global,
+    bc_hashmap_t *local);
+char* blogc_render(bc_slist_t *tmpl, bc_slist_t *sources, bc_hashmap_t *config,
     bool listing);
+void blogc_render_to_sink(bc_slist_t *tmpl, bc_slist_t *sources,
+    bc_hashmap_t *config, bool listing, blogc_render_sink_func_t sink,
+    void *user_data);
 
 #endif /* _RENDERER_H */
@@ -26,7 +26,7 @@ typedef enum {
 } blogc_source_parser_state_t;
 
 
-bc_trie_t*
+bc_hashmap_t*
 blogc_source_parse(const char *src, size_t src_len, bc_error_t **err)
 {
     if (err == NULL || *err != NULL)
@@ -39,7 +39,7 @@ blogc_source_parse(const char *src, size_t src_len, bc_error_t **err)
     char *key = NULL;
     char *tmp = NULL;
     char *content = NULL;
-    bc_trie_t *rv = bc_trie_new(free);
+    bc_hashmap_t *rv = bc_hashmap_new(free);
 
     blogc_source_parser_state_t state = SOURCE_START;
 
@@ -111,7 +111,7 @@ blogc_source_parse(const char *src, size_t src_len, bc_error_t **err)
                     start = current;
                     break;
                 }
-                bc_trie_insert(rv, key, bc_strdup(""));
+                bc_hashmap_insert(rv, key, bc_strdup(""));
                 free(key);
                 key = NULL;
                 state = SOURCE_START;
@@ -120,7 +120,7 @@ blogc_source_parse(const char *src, size_t src_len, bc_error_t **err)
             case SOURCE_CONFIG_VALUE:
                 if (c == '\n' || c == '\r') {
                     tmp = bc_strndup(src + start, current - start);
-                    bc_trie_insert(rv, key, bc_strdup(bc_str_strip(tmp)));
+                    bc_hashmap_insert(rv, key, bc_strdup(bc_str_strip(tmp)));
                     free(tmp);
                     free(key);
                     key = NULL;
@@ -150,17 +150,17 @@ blogc_source_parse(const char *src, size_t src_len, bc_error_t **err)
             case SOURCE_CONTENT:
                 if (current == (src_len - 1)) {
                     tmp = bc_strndup(src + start, src_len - start);
-                    bc_trie_insert(rv, "RAW_CONTENT", tmp);
+                    bc_hashmap_insert(rv, "RAW_CONTENT", tmp);
                     char *first_header = NULL;
                     char *description = NULL;
                     content = blogc_content_parse(tmp, &end_excerpt,
                         &first_header, &description);
                     if (first_header != NULL) {
                         // do not override source-provided first_header.
-                        if (NULL == bc_trie_lookup(rv, "FIRST_HEADER")) {
+                        if (NULL == bc_hashmap_lookup(rv, "FIRST_HEADER")) {
                             // no need to free, because we are transfering memory
-                            // ownership to the trie.
-                            bc_trie_insert(rv, "FIRST_HEADER", first_header);
+                            // ownership to the map.
+                            bc_hashmap_insert(rv, "FIRST_HEADER", first_header);
                         }
                         else {
                             free(first_header);
@@ -168,17 +168,17 @@ blogc_source_parse(const char *src, size_t src_len, bc_error_t **err)
                     }
                     if (description != NULL) {
                         // do not override source-provided description.
-                        if (NULL == bc_trie_lookup(rv, "DESCRIPTION")) {
+                        if (NULL == bc_hashmap_lookup(rv, "DESCRIPTION")) {
                             // no need to free, because we are transfering memory
-                            // ownership to the trie.
-                            bc_trie_insert(rv, "DESCRIPTION", description);
+                            // ownership to the map.
+                            bc_hashmap_insert(rv, "DESCRIPTION", description);
                         }
                         else {
                             free(description);
                         }
                     }
-                    bc_trie_insert(rv, "CONTENT", content);
-                    bc_trie_insert(rv, "EXCERPT", end_excerpt == 0 ?
+                    bc_hashmap_insert(rv, "CONTENT", content);
+                    bc_hashmap_insert(rv, "EXCERPT", end_excerpt == 0 ?
                         bc_strdup(content) : bc_strndup(content, end_excerpt));
                 }
                 break;
@@ -190,9 +190,9 @@ blogc_source_parse(const char *src, size_t src_len, bc_error_t **err)
         current++;
     }
 
-    if (*err == NULL && bc_trie_size(rv) == 0) {
+    if (*err == NULL && bc_hashmap_size(rv) == 0) {
 
-        // ok, nothing found in the config trie, but no error set either.
+        // ok, nothing found in the config map, but no error set either.
         // let's try to be nice with the users and provide some reasonable
         // output. :)
         switch (state) {
@@ -224,7 +224,7 @@ blogc_source_parse(const char *src, size_t src_len, bc_error_t **err)
 
     if (*err != NULL) {
         free(key);
-        bc_trie_free(rv);
+        bc_hashmap_free(rv);
         return NULL;
     }
 
@@ -13,7 +13,7 @@
 #include "../common/error.h"
 #include "../common/utils.h"
 
-bc_trie_t* blogc_source_parse(const char *src, size_t src_len,
+bc_hashmap_t* blogc_source_parse(const char *src, size_t src_len,
     bc_error_t **err);
 
 #endif /* _SOURCE_PARSER_H */
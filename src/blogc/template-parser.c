@@ -7,6 +7,7 @@
  */
 
 #include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -41,8 +42,81 @@ typedef enum {
 } blogc_template_parser_state_t;
 
 
+static void
+link_ast(bc_slist_t *ast)
+{
+    // the template was already validated, so every statement is closed, and
+    // blocks and foreach statements are never nested. conditionals can be
+    // nested, so we keep a stack with the elements of the open ones.
+    bc_slist_t *ifs = NULL;
+    bc_slist_t *block = NULL;
+    bc_slist_t *foreach = NULL;
+    bc_slist_t *top;
+
+    for (bc_slist_t *tmp = ast; tmp != NULL; tmp = tmp->next) {
+        blogc_template_node_t *node = tmp->data;
+        switch (node->type) {
+            case BLOGC_TEMPLATE_NODE_IF:
+            case BLOGC_TEMPLATE_NODE_IFDEF:
+            case BLOGC_TEMPLATE_NODE_IFNDEF:
+                ifs = bc_slist_prepend(ifs, tmp);
+                break;
+            case BLOGC_TEMPLATE_NODE_ELSE:
+                if (ifs != NULL) {
+                    ((blogc_template_node_t*) ((bc_slist_t*) ifs->data)->data)->jump = tmp;
+                    ifs->data = tmp;
+                }
+                break;
+            case BLOGC_TEMPLATE_NODE_ENDIF:
+                if (ifs != NULL) {
+                    ((blogc_template_node_t*) ((bc_slist_t*) ifs->data)->data)->jump = tmp;
+                    top = ifs;
+                    ifs = ifs->next;
+                    free(top);
+                }
+                break;
+            case BLOGC_TEMPLATE_NODE_BLOCK:
+                block = tmp;
+                break;
+            case BLOGC_TEMPLATE_NODE_ENDBLOCK:
+                if (block != NULL)
+                    ((blogc_template_node_t*) block->data)->jump = tmp;
+                block = NULL;
+                break;
+            case BLOGC_TEMPLATE_NODE_FOREACH:
+                foreach = tmp;
+                break;
+            case BLOGC_TEMPLATE_NODE_ENDFOREACH:
+                if (foreach != NULL)
+                    ((blogc_template_node_t*) foreach->data)->jump = tmp;
+                foreach = NULL;
+                break;
+            default:
+                break;
+        }
+    }
+
+    bc_slist_free(ifs);
+}
+
+
+static bc_slist_t*
+append_node(bc_arena_t *arena, bc_slist_t *ast, bc_slist_t **tail,
+    blogc_template_node_t *node)
+{
+    bc_slist_t *l = bc_arena_slist_append(arena, NULL, node);
+    if (*tail == NULL)
+        ast = l;
+    else
+        (*tail)->next = l;
+    *tail = l;
+    return ast;
+}
+
+
 bc_slist_t*
-blogc_template_parse(const char *src, size_t src_len, bc_error_t **err)
+blogc_template_parse(const char *src, size_t src_len, bc_arena_t *arena,
+    bc_error_t **err)
 {
     if (err == NULL || *err != NULL)
         return NULL;
@@ -64,6 +138,7 @@ blogc_template_parse(const char *src, size_t src_len, bc_error_t **err)
     bool block_foreach_open = false;
 
     bc_slist_t *ast = NULL;
+    bc_slist_t *tail = NULL;  // to append without walking the whole ast
     blogc_template_node_t *node = NULL;
 
     /*
@@ -94,21 +169,23 @@ blogc_template_parse(const char *src, size_t src_len, bc_error_t **err)
 
             case TEMPLATE_START:
                 if (last) {
-                    node = bc_malloc(sizeof(blogc_template_node_t));
+                    node = bc_arena_alloc(arena, sizeof(blogc_template_node_t));
                     node->type = type;
                     if (lstrip_next) {
                         tmp = bc_strndup(src + start, src_len - start);
-                        node->data[0] = bc_strdup(bc_str_lstrip(tmp));
+                        node->data[0] = bc_arena_strdup(arena, bc_str_lstrip(tmp));
                         free(tmp);
                         tmp = NULL;
                         lstrip_next = false;
                     }
                     else {
-                        node->data[0] = bc_strndup(src + start, src_len - start);
+                        node->data[0] = bc_arena_strndup(arena, src + start, src_len - start);
                     }
                     node->op = 0;
                     node->data[1] = NULL;
-                    ast = bc_slist_append(ast, node);
+                    node->jump = NULL;
+                    blogc_template_parse_variable(NULL, &node->var, arena);
+                    ast = append_node(arena, ast, &tail, node);
                     previous = node;
                     node = NULL;
                 }
@@ -125,21 +202,23 @@ blogc_template_parse(const char *src, size_t src_len, bc_error_t **err)
                     else
                         state = TEMPLATE_VARIABLE_START;
                     if (end > start) {
-                        node = bc_malloc(sizeof(blogc_template_node_t));
+                        node = bc_arena_alloc(arena, sizeof(blogc_template_node_t));
                         node->type = type;
                         if (lstrip_next) {
                             tmp = bc_strndup(src + start, end - start);
-                            node->data[0] = bc_strdup(bc_str_lstrip(tmp));
+                            node->data[0] = bc_arena_strdup(arena, bc_str_lstrip(tmp));
                             free(tmp);
                             tmp = NULL;
                             lstrip_next = false;
                         }
                         else {
-                            node->data[0] = bc_strndup(src + start, end - start);
+                            node->data[0] = bc_arena_strndup(arena, src + start, end - start);
                         }
                         node->op = 0;
                         node->data[1] = NULL;
-                        ast = bc_slist_append(ast, node);
+                        node->jump = NULL;
+                        blogc_template_parse_variable(NULL, &node->var, arena);
+                        ast = append_node(arena, ast, &tail, node);
                         previous = node;
                         node = NULL;
                     }
@@ -600,21 +679,25 @@ blogc_template_parse(const char *src, size_t src_len, bc_error_t **err)
                         op_start = 0;
                         op_end = 0;
                     }
-                    node = bc_malloc(sizeof(blogc_template_node_t));
+                    node = bc_arena_alloc(arena, sizeof(blogc_template_node_t));
                     node->type = type;
                     node->op = tmp_op;
                     node->data[0] = NULL;
                     node->data[1] = NULL;
+                    node->jump = NULL;
                     if (end > start)
-                        node->data[0] = bc_strndup(src + start, end - start);
+                        node->data[0] = bc_arena_strndup(arena, src + start, end - start);
                     if (end2 > start2) {
-                        node->data[1] = bc_strndup(src + start2, end2 - start2);
+                        node->data[1] = bc_arena_strndup(arena, src + start2, end2 - start2);
                         start2 = 0;
                         end2 = 0;
                     }
+                    blogc_template_parse_variable(
+                        type == BLOGC_TEMPLATE_NODE_VARIABLE ? node->data[0] : NULL,
+                        &node->var, arena);
                     if (type == BLOGC_TEMPLATE_NODE_BLOCK)
                         block_type = node->data[0];
-                    ast = bc_slist_append(ast, node);
+                    ast = append_node(arena, ast, &tail, node);
                     previous = node;
                     node = NULL;
                     state = TEMPLATE_START;
@@ -652,18 +735,81 @@ blogc_template_parse(const char *src, size_t src_len, bc_error_t **err)
     }
 
     if (*err != NULL) {
-        if (node != NULL) {
-            free(node->data[0]);
-            free(node);
+        // if using an arena, the caller will free everything with it.
+        if (arena == NULL) {
+            if (node != NULL) {
+                free(node->data[0]);
+                free(node);
+            }
+            blogc_template_free_ast(ast);
         }
-        blogc_template_free_ast(ast);
         return NULL;
     }
 
+    link_ast(ast);
+
     return ast;
 }
 
 
+void
+blogc_template_parse_variable(const char *name, blogc_template_variable_t *var,
+    bc_arena_t *arena)
+{
+    var->key = NULL;
+    var->len = -1;
+    var->formatter = BLOGC_TEMPLATE_FORMATTER_NONE;
+    var->foreach_item = false;
+
+    if (name == NULL || name[0] == '\0')
+        return;
+
+    if (0 == strcmp(name, "FOREACH_ITEM")) {
+        var->foreach_item = true;
+        return;
+    }
+
+    char *key = bc_arena_strdup(arena, name);
+
+    size_t i;
+    size_t last = strlen(key);
+
+    // just walk till the last '_'
+    for (i = last - 1; i > 0 && key[i] >= '0' && key[i] <= '9'; i--);
+
+    if (key[i] == '_' && (i + 1) < last) {  // key ends with '_[0-9]+'
+        char *endptr;
+        var->len = strtol(key + i + 1, &endptr, 10);
+        if (*endptr != '\0') {
+            fprintf(stderr, "warning: invalid variable size for '%s', "
+                "ignoring.\n", key);
+            var->len = -1;
+        }
+        else {
+            key[i] = '\0';
+        }
+    }
+
+    if (bc_str_ends_with(key, "_FORMATTED")) {
+        key[strlen(key) - 10] = '\0';
+        if (bc_str_starts_with(name, "DATE_"))
+            var->formatter = BLOGC_TEMPLATE_FORMATTER_DATE;
+        else
+            var->formatter = BLOGC_TEMPLATE_FORMATTER_UNKNOWN;
+    }
+
+    // no modifiers
+    if (0 == strcmp(key, name)) {
+        if (arena == NULL)
+            free(key);
+        return;
+    }
+
+    var->key = key;
+    var->foreach_item = 0 == strcmp(key, "FOREACH_ITEM");
+}
+
+
 void
 blogc_template_free_ast(bc_slist_t *ast)
 {
@@ -673,6 +819,7 @@ blogc_template_free_ast(bc_slist_t *ast)
             continue;
         free(data->data[0]);
         free(data->data[1]);
+        free(data->var.key);
         free(data);
     }
     bc_slist_free(ast);
@@ -9,6 +9,7 @@
 #ifndef _TEMPLATE_PARSER_H
 #define _TEMPLATE_PARSER_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include "../common/error.h"
 #include "../common/utils.h"
@@ -41,6 +42,30 @@ typedef enum {
     BLOGC_TEMPLATE_OP_GT  = 1 << 3,
 } blogc_template_operator_t;
 
+typedef enum {
+    BLOGC_TEMPLATE_FORMATTER_NONE = 0,
+    BLOGC_TEMPLATE_FORMATTER_DATE,
+    BLOGC_TEMPLATE_FORMATTER_UNKNOWN,
+} blogc_template_formatter_t;
+
+/*
+ * variable modifiers, resolved from the variable name. these are only used
+ * if the variable name itself is not defined.
+ */
+typedef struct {
+    // variable name without modifiers. NULL if there are no modifiers.
+    char *key;
+
+    // truncate value to this length, if > 0. from '_NNN' suffix.
+    long len;
+
+    // from '_FORMATTED' suffix.
+    blogc_template_formatter_t formatter;
+
+    // variable is 'FOREACH_ITEM', with or without modifiers.
+    bool foreach_item;
+} blogc_template_variable_t;
+
 typedef struct {
     blogc_template_node_type_t type;
     blogc_template_operator_t op;
@@ -48,11 +73,22 @@ typedef struct {
     // 2 slots to store node data.
     char *data[2];
 
-    bc_slist_t *childs;
+    // for control nodes, the list element of the matching node: 'else' or
+    // 'endif' for conditionals, 'endif' for 'else', 'endforeach' for
+    // 'foreach' and 'endblock' for 'block'. the renderer uses it to skip
+    // statements that are not evaluated without walking them.
+    bc_slist_t *jump;
+
+    // for variable nodes.
+    blogc_template_variable_t var;
 } blogc_template_node_t;
 
+// if arena is not NULL, the AST is allocated into it, and must be released
+// with bc_arena_free() instead of blogc_template_free_ast().
 bc_slist_t* blogc_template_parse(const char *src, size_t src_len,
-    bc_error_t **err);
+    bc_arena_t *arena, bc_error_t **err);
+void blogc_template_parse_variable(const char *name,
+    blogc_template_variable_t *var, bc_arena_t *arena);
 void blogc_template_free_ast(bc_slist_t *ast);
 
 #endif /* _TEMPLATE_PARSER_H */
@@ -10,7 +10,12 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "file.h"
 #include "error.h"
 #include "utf8.h"
@@ -64,3 +69,168 @@ bc_file_get_contents(const char *path, bool utf8, size_t *len, bc_error_t **err)
 
     return bc_string_free(str, false);
 }
+
+
+bc_file_map_t*
+bc_file_map(const char *path, bool utf8, bc_error_t **err)
+{
+    if (path == NULL || err == NULL || *err != NULL)
+        return NULL;
+
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        int tmp_errno = errno;
+        *err = bc_error_new_printf(BC_ERROR_FILE,
+            "Failed to open file (%s): %s", path, strerror(tmp_errno));
+        return NULL;
+    }
+
+    bc_file_map_t *rv = bc_malloc(sizeof(bc_file_map_t));
+    rv->str = "";
+    rv->len = 0;
+    rv->map = NULL;
+    rv->map_len = 0;
+    rv->buffer = NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+
+        // not a regular file, use the buffered reader.
+        close(fd);
+        free(rv);
+        return bc_file_read(path, utf8, err);
+    }
+
+    // empty files can't be mapped, but there's nothing to read anyway.
+    if (st.st_size > 0) {
+        void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            int tmp_errno = errno;
+            *err = bc_error_new_printf(BC_ERROR_FILE,
+                "Failed to map file (%s): %s", path, strerror(tmp_errno));
+            close(fd);
+            free(rv);
+            return NULL;
+        }
+        rv->map = map;
+        rv->map_len = st.st_size;
+        rv->str = map;
+        rv->len = st.st_size;
+    }
+    close(fd);
+
+    if (utf8) {
+        size_t skip = bc_utf8_skip_bom((uint8_t*) rv->str, rv->len);
+        rv->str += skip;
+        rv->len -= skip;
+        if (!bc_utf8_validate((uint8_t*) rv->str, rv->len)) {
+            *err = bc_error_new_printf(BC_ERROR_FILE,
+                "File content is not valid UTF-8: %s", path);
+            bc_file_map_free(rv);
+            return NULL;
+        }
+    }
+
+    return rv;
+}
+
+
+// same as bc_file_map, but always reads the file into a buffer. long running
+// programs should use it for files that may be truncated while being read,
+// because accessing a mapping past the end of the file raises SIGBUS.
+bc_file_map_t*
+bc_file_read(const char *path, bool utf8, bc_error_t **err)
+{
+    if (path == NULL || err == NULL || *err != NULL)
+        return NULL;
+
+    bc_file_map_t *rv = bc_malloc(sizeof(bc_file_map_t));
+    rv->map = NULL;
+    rv->map_len = 0;
+    rv->buffer = bc_file_get_contents(path, utf8, &rv->len, err);
+    if (rv->buffer == NULL) {
+        free(rv);
+        return NULL;
+    }
+    rv->str = rv->buffer;
+    return rv;
+}
+
+
+void
+bc_file_map_free(bc_file_map_t *map)
+{
+    if (map == NULL)
+        return;
+    if (map->map != NULL)
+        munmap(map->map, map->map_len);
+    free(map->buffer);
+    free(map);
+}
+
+
+bc_file_writer_t*
+bc_file_writer_new(int fd)
+{
+    bc_file_writer_t *rv = bc_malloc(sizeof(bc_file_writer_t));
+    rv->fd = fd;
+    rv->len = 0;
+    rv->error = 0;
+    return rv;
+}
+
+
+static void
+write_all(bc_file_writer_t *writer, const char *str, size_t len)
+{
+    while (writer->error == 0 && len > 0) {
+        ssize_t n = write(writer->fd, str, len);
+        if (n < 0) {
+            if (errno != EINTR)
+                writer->error = errno;
+            continue;
+        }
+        str += n;
+        len -= n;
+    }
+}
+
+
+void
+bc_file_writer_write(bc_file_writer_t *writer, const char *str, size_t len)
+{
+    if (writer == NULL || str == NULL || writer->error != 0)
+        return;
+
+    if (writer->len + len > BC_FILE_WRITER_BUFFER_SIZE) {
+        write_all(writer, writer->buffer, writer->len);
+        writer->len = 0;
+
+        // too big to buffer, just write it
+        if (len > BC_FILE_WRITER_BUFFER_SIZE) {
+            write_all(writer, str, len);
+            return;
+        }
+    }
+
+    memcpy(writer->buffer + writer->len, str, len);
+    writer->len += len;
+}
+
+
+bool
+bc_file_writer_flush(bc_file_writer_t *writer)
+{
+    if (writer == NULL)
+        return false;
+    write_all(writer, writer->buffer, writer->len);
+    writer->len = 0;
+    return writer->error == 0;
+}
+
+
+void
+bc_file_writer_free(bc_file_writer_t *writer)
+{
+    free(writer);
+}
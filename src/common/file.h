@@ -14,7 +14,35 @@
 #include "error.h"
 
 #define BC_FILE_CHUNK_SIZE 1024
+#define BC_FILE_WRITER_BUFFER_SIZE 65536
+
+// read-only view of a file. regular files are mapped into memory, and str
+// points right into the mapping, so it is NOT nul-terminated. other files
+// (pipes, stdin, ...), or any file with bc_file_read, are read into buffer.
+typedef struct {
+    const char *str;
+    size_t len;
+    void *map;
+    size_t map_len;
+    char *buffer;
+} bc_file_map_t;
+
+// buffered writer for file descriptors. write errors are saved, and reported
+// by bc_file_writer_flush.
+typedef struct {
+    int fd;
+    size_t len;
+    int error;
+    char buffer[BC_FILE_WRITER_BUFFER_SIZE];
+} bc_file_writer_t;
 
 char* bc_file_get_contents(const char *path, bool utf8, size_t *len, bc_error_t **err);
+bc_file_map_t* bc_file_map(const char *path, bool utf8, bc_error_t **err);
+bc_file_map_t* bc_file_read(const char *path, bool utf8, bc_error_t **err);
+void bc_file_map_free(bc_file_map_t *map);
+bc_file_writer_t* bc_file_writer_new(int fd);
+void bc_file_writer_write(bc_file_writer_t *writer, const char *str, size_t len);
+bool bc_file_writer_flush(bc_file_writer_t *writer);
+void bc_file_writer_free(bc_file_writer_t *writer);
 
 #endif /* _FILE_H */
@@ -28,8 +28,15 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 #include "utils.h"
 
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define UTF8_X86
+#include <immintrin.h>
+#endif
+
 #define UTF8_ACCEPT 0
 #define UTF8_REJECT 12
 
@@ -69,14 +76,94 @@ decode(uint32_t* state, uint32_t* codep, uint32_t byte) {
 }
 
 
+// the functions below return the length of the longest prefix of str that is
+// made of ASCII-only blocks, so the DFA can skip it.
+
+static size_t
+ascii_prefix_scalar(const uint8_t *str, size_t len)
+{
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t block;
+        memcpy(&block, str + i, 8);
+        if (block & 0x8080808080808080ull)
+            break;
+    }
+    return i;
+}
+
+
+#ifdef UTF8_X86
+
+__attribute__((target("sse2")))
+static size_t
+ascii_prefix_sse2(const uint8_t *str, size_t len)
+{
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*) (str + i));
+        if (_mm_movemask_epi8(block) != 0)
+            break;
+    }
+    return i;
+}
+
+
+__attribute__((target("avx2")))
+static size_t
+ascii_prefix_avx2(const uint8_t *str, size_t len)
+{
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i*) (str + i));
+        if (_mm256_movemask_epi8(block) != 0)
+            break;
+    }
+    return i;
+}
+
+#endif /* UTF8_X86 */
+
+
 bool
 bc_utf8_validate(const uint8_t *str, size_t len)
 {
-    uint32_t codepoint;
-    uint32_t state = 0;
+    size_t (*ascii_prefix)(const uint8_t*, size_t) = ascii_prefix_scalar;
+#ifdef UTF8_X86
+    if (__builtin_cpu_supports("avx2"))
+        ascii_prefix = ascii_prefix_avx2;
+    else if (__builtin_cpu_supports("sse2"))
+        ascii_prefix = ascii_prefix_sse2;
+#endif
 
-    for (size_t i = 0; i < len; i++)
-        decode(&state, &codepoint, str[i]);
+    uint32_t codepoint;
+    uint32_t state = UTF8_ACCEPT;
+
+    size_t i = 0;
+    while (i < len) {
+
+        // ASCII is only valid between sequences, so we can only skip it when
+        // the DFA is in the accept state.
+        if (state == UTF8_ACCEPT && str[i] < 0x80) {
+            size_t skip = ascii_prefix(str + i, len - i);
+            i += skip;
+            if (skip == 0) {
+
+                // no ASCII block to skip, text is mixed. just run the DFA for
+                // a while. the reject state is final, so it is fine to check
+                // it only at the end.
+                size_t end = len - i > 64 ? i + 64 : len;
+                for (; i < end; i++)
+                    decode(&state, &codepoint, str[i]);
+                if (state == UTF8_REJECT)
+                    return false;
+            }
+            continue;
+        }
+
+        if (decode(&state, &codepoint, str[i++]) == UTF8_REJECT)
+            return false;
+    }
 
     return state == UTF8_ACCEPT;
 }
@@ -16,6 +16,11 @@
 
 #include "utils.h"
 
+#define BC_ARENA_BLOCK_SIZE 4096
+#define BC_ARENA_ALIGN 16
+#define BC_ARENA_ALIGN_UP(x) (((x) + BC_ARENA_ALIGN - 1) & ~((size_t) BC_ARENA_ALIGN - 1))
+#define BC_ARENA_HEADER_SIZE BC_ARENA_ALIGN_UP(sizeof(bc_arena_block_t))
+
 
 void*
 bc_malloc(size_t size)
@@ -341,19 +346,42 @@ bc_strv_length(char **strv)
 
 bc_string_t*
 bc_string_new(void)
+{
+    return bc_string_new_sized(0);
+}
+
+
+bc_string_t*
+bc_string_new_sized(size_t len)
 {
     bc_string_t* rv = bc_malloc(sizeof(bc_string_t));
-    rv->str = NULL;
     rv->len = 0;
-    rv->allocated_len = 0;
+    rv->allocated_len = ((len / BC_STRING_CHUNK_SIZE) + 1) * BC_STRING_CHUNK_SIZE;
+    rv->str = bc_malloc(rv->allocated_len);
 
     // initialize with empty string
-    rv = bc_string_append(rv, "");
+    rv->str[0] = '\0';
 
     return rv;
 }
 
 
+static void
+bc_string_grow(bc_string_t *str, size_t len)
+{
+    if (len + 1 <= str->allocated_len)
+        return;
+
+    // grow geometrically, to avoid a realloc per chunk when building big
+    // strings, but never less than what was requested.
+    size_t allocated_len = 2 * str->allocated_len;
+    if (allocated_len < len + 1)
+        allocated_len = (((len + 1) / BC_STRING_CHUNK_SIZE) + 1) * BC_STRING_CHUNK_SIZE;
+    str->allocated_len = allocated_len;
+    str->str = bc_realloc(str->str, str->allocated_len);
+}
+
+
 char*
 bc_string_free(bc_string_t *str, bool free_str)
 {
@@ -374,7 +402,7 @@ bc_string_dup(bc_string_t *str)
 {
     if (str == NULL)
         return NULL;
-    bc_string_t* new = bc_string_new();
+    bc_string_t* new = bc_string_new_sized(str->len);
     return bc_string_append_len(new, str->str, str->len);
 }
 
@@ -388,10 +416,7 @@ bc_string_append_len(bc_string_t *str, const char *suffix, size_t len)
         return str;
     size_t old_len = str->len;
     str->len += len;
-    if (str->len + 1 > str->allocated_len) {
-        str->allocated_len = (((str->len + 1) / BC_STRING_CHUNK_SIZE) + 1) * BC_STRING_CHUNK_SIZE;
-        str->str = bc_realloc(str->str, str->allocated_len);
-    }
+    bc_string_grow(str, str->len);
     memcpy(str->str + old_len, suffix, len);
     str->str[str->len] = '\0';
     return str;
@@ -415,10 +440,7 @@ bc_string_append_c(bc_string_t *str, char c)
         return NULL;
     size_t old_len = str->len;
     str->len += 1;
-    if (str->len + 1 > str->allocated_len) {
-        str->allocated_len = (((str->len + 1) / BC_STRING_CHUNK_SIZE) + 1) * BC_STRING_CHUNK_SIZE;
-        str->str = bc_realloc(str->str, str->allocated_len);
-    }
+    bc_string_grow(str, str->len);
     str->str[old_len] = c;
     str->str[str->len] = '\0';
     return str;
@@ -643,6 +665,260 @@ bc_trie_foreach(bc_trie_t *trie, bc_trie_foreach_func_t func,
 }
 
 
+uint32_t
+bc_hashmap_hash(const char *key)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (const char *tmp = key; *tmp != '\0'; tmp++) {
+        hash ^= (unsigned char) *tmp;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+
+bc_hashmap_t*
+bc_hashmap_new(bc_free_func_t free_func)
+{
+    bc_hashmap_t *map = bc_malloc(sizeof(bc_hashmap_t));
+    map->entries = NULL;
+    map->len = 0;
+    map->allocated_len = 0;
+    map->buckets = NULL;
+    map->num_buckets = 0;
+    map->free_func = free_func;
+    return map;
+}
+
+
+void
+bc_hashmap_free(bc_hashmap_t *map)
+{
+    if (map == NULL)
+        return;
+    for (size_t i = 0; i < map->len; i++) {
+        if (map->free_func != NULL)
+            map->free_func(map->entries[i].data);
+        free(map->entries[i].key);
+    }
+    free(map->entries);
+    free(map->buckets);
+    free(map);
+}
+
+
+static size_t*
+bc_hashmap_find_bucket(bc_hashmap_t *map, const char *key, uint32_t hash)
+{
+    size_t mask = map->num_buckets - 1;
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+        if (map->buckets[i] == 0)
+            return &map->buckets[i];
+        bc_hashmap_entry_t *e = &map->entries[map->buckets[i] - 1];
+        if (e->hash == hash && 0 == strcmp(e->key, key))
+            return &map->buckets[i];
+    }
+}
+
+
+static void
+bc_hashmap_resize(bc_hashmap_t *map, size_t num_buckets)
+{
+    free(map->buckets);
+    map->buckets = bc_malloc(num_buckets * sizeof(size_t));
+    memset(map->buckets, 0, num_buckets * sizeof(size_t));
+    map->num_buckets = num_buckets;
+
+    // hashes are stored with the entries, no need to compute them again
+    size_t mask = num_buckets - 1;
+    for (size_t i = 0; i < map->len; i++) {
+        size_t j = map->entries[i].hash & mask;
+        while (map->buckets[j] != 0)
+            j = (j + 1) & mask;
+        map->buckets[j] = i + 1;
+    }
+}
+
+
+void
+bc_hashmap_insert(bc_hashmap_t *map, const char *key, void *data)
+{
+    if (map == NULL || key == NULL || data == NULL)
+        return;
+
+    // keep load factor <= 3/4
+    if (4 * (map->len + 1) > 3 * map->num_buckets)
+        bc_hashmap_resize(map, map->num_buckets == 0 ? 16 : 2 * map->num_buckets);
+
+    uint32_t hash = bc_hashmap_hash(key);
+    size_t *bucket = bc_hashmap_find_bucket(map, key, hash);
+
+    if (*bucket != 0) {
+        bc_hashmap_entry_t *e = &map->entries[*bucket - 1];
+        if (map->free_func != NULL)
+            map->free_func(e->data);
+        e->data = data;
+        return;
+    }
+
+    if (map->len == map->allocated_len) {
+        map->allocated_len = map->allocated_len == 0 ? 8 : 2 * map->allocated_len;
+        map->entries = bc_realloc(map->entries,
+            map->allocated_len * sizeof(bc_hashmap_entry_t));
+    }
+
+    bc_hashmap_entry_t *e = &map->entries[map->len++];
+    e->key = bc_strdup(key);
+    e->data = data;
+    e->hash = hash;
+    *bucket = map->len;
+}
+
+
+void*
+bc_hashmap_lookup(bc_hashmap_t *map, const char *key)
+{
+    if (map == NULL || map->len == 0 || key == NULL)
+        return NULL;
+
+    size_t *bucket = bc_hashmap_find_bucket(map, key, bc_hashmap_hash(key));
+    if (*bucket == 0)
+        return NULL;
+    return map->entries[*bucket - 1].data;
+}
+
+
+size_t
+bc_hashmap_size(bc_hashmap_t *map)
+{
+    if (map == NULL)
+        return 0;
+    return map->len;
+}
+
+
+void
+bc_hashmap_foreach(bc_hashmap_t *map, bc_hashmap_foreach_func_t func,
+    void *user_data)
+{
+    if (map == NULL || func == NULL)
+        return;
+
+    for (size_t i = 0; i < map->len; i++)
+        func(map->entries[i].key, map->entries[i].data, user_data);
+}
+
+
+bc_arena_t*
+bc_arena_new(size_t block_size)
+{
+    bc_arena_t *arena = bc_malloc(sizeof(bc_arena_t));
+    arena->blocks = NULL;
+    arena->block_size = block_size == 0 ? BC_ARENA_BLOCK_SIZE : block_size;
+    return arena;
+}
+
+
+void
+bc_arena_free(bc_arena_t *arena)
+{
+    if (arena == NULL)
+        return;
+    bc_arena_block_t *tmp = arena->blocks;
+    while (tmp != NULL) {
+        bc_arena_block_t *next = tmp->next;
+        free(tmp);
+        tmp = next;
+    }
+    free(arena);
+}
+
+
+static bc_arena_block_t*
+bc_arena_block_new(size_t size)
+{
+    bc_arena_block_t *block = bc_malloc(BC_ARENA_HEADER_SIZE + size);
+    block->next = NULL;
+    block->len = 0;
+    block->allocated_len = size;
+    return block;
+}
+
+
+void*
+bc_arena_alloc(bc_arena_t *arena, size_t size)
+{
+    if (arena == NULL)
+        return bc_malloc(size);
+
+    size = BC_ARENA_ALIGN_UP(size == 0 ? 1 : size);
+
+    // big allocations get their own block, placed after the current one, so
+    // the free space in the current block is not wasted.
+    if (size > arena->block_size / 4) {
+        bc_arena_block_t *block = bc_arena_block_new(size);
+        block->len = size;
+        if (arena->blocks == NULL) {
+            arena->blocks = block;
+        }
+        else {
+            block->next = arena->blocks->next;
+            arena->blocks->next = block;
+        }
+        return (char*) block + BC_ARENA_HEADER_SIZE;
+    }
+
+    bc_arena_block_t *block = arena->blocks;
+    if (block == NULL || block->len + size > block->allocated_len) {
+        block = bc_arena_block_new(arena->block_size);
+        block->next = arena->blocks;
+        arena->blocks = block;
+    }
+
+    void *rv = (char*) block + BC_ARENA_HEADER_SIZE + block->len;
+    block->len += size;
+    return rv;
+}
+
+
+char*
+bc_arena_strdup(bc_arena_t *arena, const char *s)
+{
+    if (s == NULL)
+        return NULL;
+    return bc_arena_strndup(arena, s, strlen(s));
+}
+
+
+char*
+bc_arena_strndup(bc_arena_t *arena, const char *s, size_t n)
+{
+    if (s == NULL)
+        return NULL;
+    size_t l = strnlen(s, n);
+    char *rv = bc_arena_alloc(arena, l + 1);
+    memcpy(rv, s, l);
+    rv[l] = '\0';
+    return rv;
+}
+
+
+bc_slist_t*
+bc_arena_slist_append(bc_arena_t *arena, bc_slist_t *l, void *data)
+{
+    bc_slist_t *node = bc_arena_alloc(arena, sizeof(bc_slist_t));
+    node->data = data;
+    node->next = NULL;
+    if (l == NULL)
+        return node;
+    bc_slist_t *tmp;
+    for (tmp = l; tmp->next != NULL; tmp = tmp->next);
+    tmp->next = node;
+    return l;
+}
+
+
 char*
 bc_shell_quote(const char *command)
 {
@@ -12,6 +12,7 @@
 #include <stddef.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 
 // memory
@@ -64,6 +65,7 @@ typedef struct {
 } bc_string_t;
 
 bc_string_t* bc_string_new(void);
+bc_string_t* bc_string_new_sized(size_t len);
 char* bc_string_free(bc_string_t *str, bool free_str);
 bc_string_t* bc_string_dup(bc_string_t *str);
 bc_string_t* bc_string_append_len(bc_string_t *str, const char *suffix, size_t len);
@@ -100,6 +102,65 @@ void bc_trie_foreach(bc_trie_t *trie, bc_trie_foreach_func_t func,
     void *user_data);
 
 
+// hashmap
+//
+// same API as trie, but with open addressing and linear probing. entries are
+// stored in a dense array, in insertion order, with their hashes, and the
+// buckets only store indexes into this array.
+
+typedef struct {
+    char *key;
+    void *data;
+    uint32_t hash;
+} bc_hashmap_entry_t;
+
+typedef struct {
+    bc_hashmap_entry_t *entries;
+    size_t len;
+    size_t allocated_len;
+    size_t *buckets;  // index + 1 in entries, 0 if empty
+    size_t num_buckets;  // power of 2
+    bc_free_func_t free_func;
+} bc_hashmap_t;
+
+typedef void (*bc_hashmap_foreach_func_t)(const char *key, void *data,
+    void *user_data);
+
+uint32_t bc_hashmap_hash(const char *key);
+bc_hashmap_t* bc_hashmap_new(bc_free_func_t free_func);
+void bc_hashmap_free(bc_hashmap_t *map);
+void bc_hashmap_insert(bc_hashmap_t *map, const char *key, void *data);
+void* bc_hashmap_lookup(bc_hashmap_t *map, const char *key);
+size_t bc_hashmap_size(bc_hashmap_t *map);
+void bc_hashmap_foreach(bc_hashmap_t *map, bc_hashmap_foreach_func_t func,
+    void *user_data);
+
+
+// arena
+//
+// bump allocator, for lots of small allocations that share the same lifetime.
+// everything is released at once by bc_arena_free. functions that receive an
+// arena fall back to the heap if it is NULL, so parsers can use it optionally.
+
+typedef struct _bc_arena_block_t {
+    struct _bc_arena_block_t *next;
+    size_t len;
+    size_t allocated_len;
+} bc_arena_block_t;
+
+typedef struct {
+    bc_arena_block_t *blocks;  // current block first
+    size_t block_size;
+} bc_arena_t;
+
+bc_arena_t* bc_arena_new(size_t block_size);
+void bc_arena_free(bc_arena_t *arena);
+void* bc_arena_alloc(bc_arena_t *arena, size_t size);
+char* bc_arena_strdup(bc_arena_t *arena, const char *s);
+char* bc_arena_strndup(bc_arena_t *arena, const char *s, size_t n);
+bc_slist_t* bc_arena_slist_append(bc_arena_t *arena, bc_slist_t *l, void *data);
+
+
 // shell
 
 char* bc_shell_quote(const char *command);
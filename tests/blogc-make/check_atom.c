@@ -25,10 +25,10 @@ static void
 test_atom_file(void **state)
 {
     bm_settings_t *settings = bc_malloc(sizeof(bm_settings_t));
-    settings->settings = bc_trie_new(free);
-    bc_trie_insert(settings->settings, "atom_prefix", bc_strdup("atom"));
-    bc_trie_insert(settings->settings, "atom_ext", bc_strdup(".xml"));
-    bc_trie_insert(settings->settings, "post_prefix", bc_strdup("post"));
+    settings->settings = bc_hashmap_new(free);
+    bc_hashmap_insert(settings->settings, "atom_prefix", bc_strdup("atom"));
+    bc_hashmap_insert(settings->settings, "atom_ext", bc_strdup(".xml"));
+    bc_hashmap_insert(settings->settings, "post_prefix", bc_strdup("post"));
 
     bc_error_t *err = NULL;
     char *rv = bm_atom_deploy(settings, &err);
@@ -77,7 +77,7 @@ test_atom_file(void **state)
     free(cmp);
     bm_atom_destroy(rv);
     free(rv);
-    bc_trie_free(settings->settings);
+    bc_hashmap_free(settings->settings);
     free(settings);
 }
 
@@ -86,10 +86,10 @@ static void
 test_atom_dir(void **state)
 {
     bm_settings_t *settings = bc_malloc(sizeof(bm_settings_t));
-    settings->settings = bc_trie_new(free);
-    bc_trie_insert(settings->settings, "atom_prefix", bc_strdup("atom"));
-    bc_trie_insert(settings->settings, "atom_ext", bc_strdup("/index.xml"));
-    bc_trie_insert(settings->settings, "post_prefix", bc_strdup("post"));
+    settings->settings = bc_hashmap_new(free);
+    bc_hashmap_insert(settings->settings, "atom_prefix", bc_strdup("atom"));
+    bc_hashmap_insert(settings->settings, "atom_ext", bc_strdup("/index.xml"));
+    bc_hashmap_insert(settings->settings, "post_prefix", bc_strdup("post"));
 
     bc_error_t *err = NULL;
     char *rv = bm_atom_deploy(settings, &err);
@@ -138,7 +138,7 @@ test_atom_dir(void **state)
     free(cmp);
     bm_atom_destroy(rv);
     free(rv);
-    bc_trie_free(settings->settings);
+    bc_hashmap_free(settings->settings);
     free(settings);
 }
 
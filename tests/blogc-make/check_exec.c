@@ -76,15 +76,15 @@ static void
 test_build_blogc_cmd_with_settings(void **state)
 {
     bm_settings_t *settings = bc_malloc(sizeof(bm_settings_t));
-    settings->settings = bc_trie_new(free);
-    bc_trie_insert(settings->settings, "locale", bc_strdup("en_US.utf8"));
-    settings->global = bc_trie_new(free);
-    bc_trie_insert(settings->global, "FOO", bc_strdup("BAR"));
-    bc_trie_insert(settings->global, "BAR", bc_strdup("BAZ"));
-    bc_trie_t *variables = bc_trie_new(free);
-    bc_trie_insert(variables, "LOL", bc_strdup("HEHE"));
-    bc_trie_t *local = bc_trie_new(free);
-    bc_trie_insert(local, "ASD", bc_strdup("QWE"));
+    settings->settings = bc_hashmap_new(free);
+    bc_hashmap_insert(settings->settings, "locale", bc_strdup("en_US.utf8"));
+    settings->global = bc_hashmap_new(free);
+    bc_hashmap_insert(settings->global, "FOO", bc_strdup("BAR"));
+    bc_hashmap_insert(settings->global, "BAR", bc_strdup("BAZ"));
+    bc_hashmap_t *variables = bc_hashmap_new(free);
+    bc_hashmap_insert(variables, "LOL", bc_strdup("HEHE"));
+    bc_hashmap_t *local = bc_hashmap_new(free);
+    bc_hashmap_insert(local, "ASD", bc_strdup("QWE"));
     settings->tags = NULL;
 
     char *rv = bm_exec_build_blogc_cmd("blogc", settings, variables, local, true,
@@ -106,10 +106,10 @@ test_build_blogc_cmd_with_settings(void **state)
         "LC_ALL='en_US.utf8' blogc -D FOO='BAR' -D BAR='BAZ'");
     free(rv);
 
-    bc_trie_free(local);
-    bc_trie_free(variables);
-    bc_trie_free(settings->settings);
-    bc_trie_free(settings->global);
+    bc_hashmap_free(local);
+    bc_hashmap_free(variables);
+    bc_hashmap_free(settings->settings);
+    bc_hashmap_free(settings->global);
     free(settings);
 }
 
@@ -118,15 +118,15 @@ static void
 test_build_blogc_cmd_with_settings_and_dev(void **state)
 {
     bm_settings_t *settings = bc_malloc(sizeof(bm_settings_t));
-    settings->settings = bc_trie_new(free);
-    bc_trie_insert(settings->settings, "locale", bc_strdup("en_US.utf8"));
-    settings->global = bc_trie_new(free);
-    bc_trie_insert(settings->global, "FOO", bc_strdup("BAR"));
-    bc_trie_insert(settings->global, "BAR", bc_strdup("BAZ"));
-    bc_trie_t *variables = bc_trie_new(free);
-    bc_trie_insert(variables, "LOL", bc_strdup("HEHE"));
-    bc_trie_t *local = bc_trie_new(free);
-    bc_trie_insert(local, "ASD", bc_strdup("QWE"));
+    settings->settings = bc_hashmap_new(free);
+    bc_hashmap_insert(settings->settings, "locale", bc_strdup("en_US.utf8"));
+    settings->global = bc_hashmap_new(free);
+    bc_hashmap_insert(settings->global, "FOO", bc_strdup("BAR"));
+    bc_hashmap_insert(settings->global, "BAR", bc_strdup("BAZ"));
+    bc_hashmap_t *variables = bc_hashmap_new(free);
+    bc_hashmap_insert(variables, "LOL", bc_strdup("HEHE"));
+    bc_hashmap_t *local = bc_hashmap_new(free);
+    bc_hashmap_insert(local, "ASD", bc_strdup("QWE"));
     settings->tags = NULL;
 
     char *rv = bm_exec_build_blogc_cmd("blogc", settings, variables, local, true,
@@ -151,10 +151,10 @@ test_build_blogc_cmd_with_settings_and_dev(void **state)
         "-D MAKE_ENV_DEV=1 -D MAKE_ENV='dev'");
     free(rv);
 
-    bc_trie_free(local);
-    bc_trie_free(variables);
-    bc_trie_free(settings->settings);
-    bc_trie_free(settings->global);
+    bc_hashmap_free(local);
+    bc_hashmap_free(variables);
+    bc_hashmap_free(settings->settings);
+    bc_hashmap_free(settings->global);
     free(settings);
 }
 
@@ -163,15 +163,15 @@ static void
 test_build_blogc_cmd_with_settings_and_tags(void **state)
 {
     bm_settings_t *settings = bc_malloc(sizeof(bm_settings_t));
-    settings->settings = bc_trie_new(free);
-    bc_trie_insert(settings->settings, "locale", bc_strdup("en_US.utf8"));
-    settings->global = bc_trie_new(free);
-    bc_trie_insert(settings->global, "FOO", bc_strdup("BAR"));
-    bc_trie_insert(settings->global, "BAR", bc_strdup("BAZ"));
-    bc_trie_t *variables = bc_trie_new(free);
-    bc_trie_insert(variables, "LOL", bc_strdup("HEHE"));
-    bc_trie_t *local = bc_trie_new(free);
-    bc_trie_insert(local, "ASD", bc_strdup("QWE"));
+    settings->settings = bc_hashmap_new(free);
+    bc_hashmap_insert(settings->settings, "locale", bc_strdup("en_US.utf8"));
+    settings->global = bc_hashmap_new(free);
+    bc_hashmap_insert(settings->global, "FOO", bc_strdup("BAR"));
+    bc_hashmap_insert(settings->global, "BAR", bc_strdup("BAZ"));
+    bc_hashmap_t *variables = bc_hashmap_new(free);
+    bc_hashmap_insert(variables, "LOL", bc_strdup("HEHE"));
+    bc_hashmap_t *local = bc_hashmap_new(free);
+    bc_hashmap_insert(local, "ASD", bc_strdup("QWE"));
     settings->tags = bc_str_split("asd foo bar", ' ', 0);
 
     char *rv = bm_exec_build_blogc_cmd("blogc", settings, variables, local, true,
@@ -196,10 +196,10 @@ test_build_blogc_cmd_with_settings_and_tags(void **state)
         "-D BAR='BAZ' -D MAKE_ENV_DEV=1 -D MAKE_ENV='dev'");
     free(rv);
 
-    bc_trie_free(local);
-    bc_trie_free(variables);
-    bc_trie_free(settings->settings);
-    bc_trie_free(settings->global);
+    bc_hashmap_free(local);
+    bc_hashmap_free(variables);
+    bc_hashmap_free(settings->settings);
+    bc_hashmap_free(settings->global);
     bc_strv_free(settings->tags);
     free(settings);
 }
@@ -208,10 +208,10 @@ test_build_blogc_cmd_with_settings_and_tags(void **state)
 static void
 test_build_blogc_cmd_without_settings(void **state)
 {
-    bc_trie_t *variables = bc_trie_new(free);
-    bc_trie_insert(variables, "LOL", bc_strdup("HEHE"));
-    bc_trie_t *local = bc_trie_new(free);
-    bc_trie_insert(local, "ASD", bc_strdup("QWE"));
+    bc_hashmap_t *variables = bc_hashmap_new(free);
+    bc_hashmap_insert(variables, "LOL", bc_strdup("HEHE"));
+    bc_hashmap_t *local = bc_hashmap_new(free);
+    bc_hashmap_insert(local, "ASD", bc_strdup("QWE"));
 
     char *rv = bm_exec_build_blogc_cmd("blogc", NULL, variables, local, true,
         "main.tmpl", "foo.html", false, true);
@@ -231,8 +231,8 @@ test_build_blogc_cmd_without_settings(void **state)
         "blogc");
     free(rv);
 
-    bc_trie_free(local);
-    bc_trie_free(variables);
+    bc_hashmap_free(local);
+    bc_hashmap_free(variables);
 }
 
 
@@ -0,0 +1,313 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../../src/blogc-make/ctx.h"
+#include "../../src/blogc-make/manifest.h"
+#include "../../src/common/utils.h"
+
+
+static void
+write_file(const char *dir, const char *name, const char *content)
+{
+    char *path = bc_strdup_printf("%s/%s", dir, name);
+    FILE *fp = fopen(path, "w");
+    assert_non_null(fp);
+    fputs(content, fp);
+    fclose(fp);
+    free(path);
+}
+
+
+static void
+remove_file(const char *dir, const char *name)
+{
+    char *path = bc_strdup_printf("%s/%s", dir, name);
+    unlink(path);
+    free(path);
+}
+
+
+static void
+free_source(bm_source_t *src)
+{
+    bc_hashmap_free(src->source);
+    free(src);
+}
+
+
+static void
+test_manifest_digest(void **state)
+{
+    char root[] = "/tmp/check_manifest_XXXXXX";
+    assert_non_null(mkdtemp(root));
+    write_file(root, "blogcfile", "[global]\nAUTHOR_NAME = Lol\n");
+    write_file(root, "main.tmpl", "{{ CONTENT }}\n");
+    write_file(root, "foo.txt", "TITLE: Foo\n-----\nfoo\n");
+
+    bm_ctx_t ctx;
+    memset(&ctx, 0, sizeof(bm_ctx_t));
+    ctx.root_dir = root;
+    ctx.settings_fctx = bm_filectx_new(&ctx, "blogcfile", NULL, NULL);
+    ctx.sources = bc_hashmap_new((bc_free_func_t) free_source);
+    pthread_mutex_init(&ctx.sources_mutex, NULL);
+    bm_filectx_t *tmpl = bm_filectx_new(&ctx, "main.tmpl", NULL, NULL);
+    bc_slist_t *sources = bc_slist_append(NULL,
+        bm_filectx_new(&ctx, "foo.txt", "foo", NULL));
+
+    bm_manifest_t *m = bm_manifest_new("/tmp/check_manifest_nonexistent/m");
+    assert_non_null(m);
+
+    bc_hashmap_t *v1 = bc_hashmap_new(free);
+    bc_hashmap_insert(v1, "FOO", bc_strdup("bar"));
+    bc_hashmap_insert(v1, "BAR", bc_strdup("baz"));
+    bc_hashmap_t *v2 = bc_hashmap_new(free);
+    bc_hashmap_insert(v2, "BAR", bc_strdup("baz"));
+    bc_hashmap_insert(v2, "FOO", bc_strdup("bar"));
+
+    char *d1 = bm_manifest_digest(m, &ctx, v1, NULL, false, tmpl, sources,
+        true);
+    assert_non_null(d1);
+    assert_int_equal(strlen(d1), 16);
+
+    // the order of the variables doesn't matter
+    char *d2 = bm_manifest_digest(m, &ctx, v2, NULL, false, tmpl, sources,
+        true);
+    assert_string_equal(d1, d2);
+    free(d2);
+
+    // but their values, where they come from and the listing flag do
+    bc_hashmap_insert(v2, "FOO", bc_strdup("baz"));
+    d2 = bm_manifest_digest(m, &ctx, v2, NULL, false, tmpl, sources, true);
+    assert_string_not_equal(d1, d2);
+    free(d2);
+    d2 = bm_manifest_digest(m, &ctx, NULL, v1, false, tmpl, sources, true);
+    assert_string_not_equal(d1, d2);
+    free(d2);
+    d2 = bm_manifest_digest(m, &ctx, v1, NULL, true, tmpl, sources, true);
+    assert_string_not_equal(d1, d2);
+    free(d2);
+
+    // a touched file with the same content gives the same digest
+    bm_filectx_t *fctx = sources->data;
+    fctx->tv_sec++;
+    d2 = bm_manifest_digest(m, &ctx, v1, NULL, false, tmpl, sources, true);
+    assert_string_equal(d1, d2);
+    free(d2);
+
+    // while the mtime is the same, the hash of the file is reused
+    write_file(root, "foo.txt", "TITLE: Foo\n-----\nbar\n");
+    d2 = bm_manifest_digest(m, &ctx, v1, NULL, false, tmpl, sources, true);
+    assert_string_equal(d1, d2);
+    free(d2);
+    fctx->tv_sec++;
+    d2 = bm_manifest_digest(m, &ctx, v1, NULL, false, tmpl, sources, true);
+    assert_string_not_equal(d1, d2);
+    free(d2);
+
+    // unreadable inputs have no digest
+    fctx->readable = false;
+    assert_null(bm_manifest_digest(m, &ctx, v1, NULL, false, tmpl, sources,
+        true));
+    assert_null(bm_manifest_digest(NULL, &ctx, v1, NULL, false, tmpl, sources,
+        true));
+
+    free(d1);
+    bc_hashmap_free(v1);
+    bc_hashmap_free(v2);
+    bm_manifest_free(m);
+    bc_slist_free_full(sources, (bc_free_func_t) bm_filectx_free);
+    bm_filectx_free(tmpl);
+    bm_filectx_free(ctx.settings_fctx);
+    bc_hashmap_free(ctx.sources);
+    pthread_mutex_destroy(&ctx.sources_mutex);
+    remove_file(root, "blogcfile");
+    remove_file(root, "main.tmpl");
+    remove_file(root, "foo.txt");
+    rmdir(root);
+}
+
+
+static void
+test_manifest_digest_listing(void **state)
+{
+    char root[] = "/tmp/check_manifest_XXXXXX";
+    assert_non_null(mkdtemp(root));
+    write_file(root, "blogcfile", "[global]\nAUTHOR_NAME = Lol\n");
+    write_file(root, "foo.txt", "TAGS: a\n-----\nfoo\n");
+    write_file(root, "bar.txt", "TAGS: b\n-----\nbar\n");
+    write_file(root, "baz.txt", "TAGS: a b\n-----\nbaz\n");
+
+    bm_ctx_t ctx;
+    memset(&ctx, 0, sizeof(bm_ctx_t));
+    ctx.root_dir = root;
+    ctx.settings_fctx = bm_filectx_new(&ctx, "blogcfile", NULL, NULL);
+    ctx.sources = bc_hashmap_new((bc_free_func_t) free_source);
+    pthread_mutex_init(&ctx.sources_mutex, NULL);
+    bc_slist_t *sources = NULL;
+    sources = bc_slist_append(sources,
+        bm_filectx_new(&ctx, "foo.txt", "foo", NULL));
+    sources = bc_slist_append(sources,
+        bm_filectx_new(&ctx, "bar.txt", "bar", NULL));
+    sources = bc_slist_append(sources,
+        bm_filectx_new(&ctx, "baz.txt", "baz", NULL));
+    bm_filectx_t *foo = sources->data;
+    bm_filectx_t *bar = sources->next->data;
+
+    char *path = bc_strdup_printf("%s/manifest", root);
+    bm_manifest_t *m = bm_manifest_new(path);
+
+    bc_hashmap_t *tag = bc_hashmap_new(free);
+    bc_hashmap_insert(tag, "FILTER_TAG", bc_strdup("a"));
+    bc_hashmap_t *page = bc_hashmap_new(free);
+    bc_hashmap_insert(page, "FILTER_PAGE", bc_strdup("1"));
+    bc_hashmap_insert(page, "FILTER_PER_PAGE", bc_strdup("1"));
+    bc_hashmap_insert(page, "FILTER_REVERSE", bc_strdup("1"));
+
+    char *t1 = bm_manifest_digest(m, &ctx, tag, NULL, true, NULL, sources,
+        false);
+    char *p1 = bm_manifest_digest(m, &ctx, page, NULL, true, NULL, sources,
+        false);
+    assert_non_null(t1);
+    assert_non_null(p1);
+
+    // bar is not tagged `a`, and isn't in the first page when reversed
+    assert_true(bm_manifest_save(m));
+    write_file(root, "bar.txt", "TAGS: b\n-----\nbarrrr\n");
+    bar->tv_sec++;
+    char *t2 = bm_manifest_digest(m, &ctx, tag, NULL, true, NULL, sources,
+        false);
+    char *p2 = bm_manifest_digest(m, &ctx, page, NULL, true, NULL, sources,
+        false);
+    assert_string_equal(t1, t2);
+    assert_string_equal(p1, p2);
+    free(t2);
+    free(p2);
+
+    // until it is, in the next build
+    write_file(root, "bar.txt", "TAGS: a b\n-----\nbarrrr\n");
+    bar->tv_sec++;
+    t2 = bm_manifest_digest(m, &ctx, tag, NULL, true, NULL, sources, false);
+    assert_string_equal(t1, t2);
+    free(t2);
+    assert_true(bm_manifest_save(m));
+    t2 = bm_manifest_digest(m, &ctx, tag, NULL, true, NULL, sources, false);
+    assert_string_not_equal(t1, t2);
+    free(t2);
+
+    // the first page doesn't list foo, but it knows how many pages there are
+    p2 = bm_manifest_digest(m, &ctx, page, NULL, true, NULL, sources->next,
+        false);
+    assert_string_not_equal(p1, p2);
+    free(p2);
+
+    // not listing, everything counts
+    p2 = bm_manifest_digest(m, &ctx, page, NULL, false, NULL, sources, false);
+    assert_string_not_equal(p1, p2);
+    free(p2);
+
+    // tags that no post has list nothing
+    bc_hashmap_t *none = bc_hashmap_new(free);
+    bc_hashmap_insert(none, "FILTER_TAG", bc_strdup("c"));
+    t2 = bm_manifest_digest(m, &ctx, none, NULL, true, NULL, sources, false);
+    assert_non_null(t2);
+    assert_string_not_equal(t1, t2);
+    free(t2);
+    bc_hashmap_free(none);
+
+    // sources that can't be parsed have no digest
+    assert_true(bm_manifest_save(m));
+    write_file(root, "foo.txt", "TAGS a\n");
+    foo->tv_sec++;
+    assert_null(bm_manifest_digest(m, &ctx, tag, NULL, true, NULL, sources,
+        false));
+
+    free(t1);
+    free(p1);
+    bc_hashmap_free(tag);
+    bc_hashmap_free(page);
+    bm_manifest_free(m);
+    unlink(path);
+    free(path);
+    bc_slist_free_full(sources, (bc_free_func_t) bm_filectx_free);
+    bm_filectx_free(ctx.settings_fctx);
+    bc_hashmap_free(ctx.sources);
+    pthread_mutex_destroy(&ctx.sources_mutex);
+    remove_file(root, "blogcfile");
+    remove_file(root, "foo.txt");
+    remove_file(root, "bar.txt");
+    remove_file(root, "baz.txt");
+    rmdir(root);
+}
+
+
+static void
+test_manifest_save(void **state)
+{
+    char dir[] = "/tmp/check_manifest_XXXXXX";
+    assert_non_null(mkdtemp(dir));
+    char *path = bc_strdup_printf("%s/%s", dir, BM_MANIFEST_FILENAME);
+
+    bm_manifest_t *m = bm_manifest_new(path);
+    assert_false(bm_manifest_check(m, "_build/index.html", "0123"));
+
+    // nothing to save
+    assert_true(bm_manifest_save(m));
+    assert_int_not_equal(access(path, F_OK), 0);
+
+    bm_manifest_record(m, "_build/index.html", "0123");
+    bm_manifest_record(m, "_build/foo bar.html", "4567");
+    bm_manifest_record(m, "_build/foo\nbar.html", "89ab");
+    assert_true(bm_manifest_check(m, "_build/index.html", "0123"));
+    assert_false(bm_manifest_check(m, "_build/index.html", "4567"));
+    assert_false(bm_manifest_check(m, "_build/foo\nbar.html", "89ab"));
+    assert_false(bm_manifest_check(m, NULL, "0123"));
+    assert_false(bm_manifest_check(m, "_build/index.html", NULL));
+    assert_true(bm_manifest_save(m));
+    bm_manifest_free(m);
+
+    m = bm_manifest_new(path);
+    assert_true(bm_manifest_check(m, "_build/index.html", "0123"));
+    assert_true(bm_manifest_check(m, "_build/foo bar.html", "4567"));
+    bm_manifest_clear(m);
+    assert_false(bm_manifest_check(m, "_build/index.html", "0123"));
+    assert_int_not_equal(access(path, F_OK), 0);
+    bm_manifest_free(m);
+
+    // manifests from other versions are ignored
+    write_file(dir, BM_MANIFEST_FILENAME,
+        "blogc-make manifest 0\nO 0123 _build/index.html\n");
+    m = bm_manifest_new(path);
+    assert_false(bm_manifest_check(m, "_build/index.html", "0123"));
+    bm_manifest_free(m);
+
+    remove_file(dir, BM_MANIFEST_FILENAME);
+    rmdir(dir);
+    free(path);
+}
+
+
+int
+main(void)
+{
+    const UnitTest tests[] = {
+        unit_test(test_manifest_digest),
+        unit_test(test_manifest_digest_listing),
+        unit_test(test_manifest_save),
+    };
+    return run_tests(tests);
+}
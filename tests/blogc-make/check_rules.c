@@ -11,72 +11,228 @@
 #include <setjmp.h>
 #include <cmocka.h>
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
 
+#include "../../src/blogc-make/ctx.h"
 #include "../../src/blogc-make/rules.h"
 #include "../../src/common/utils.h"
 
 
+#define SETTINGS \
+    "[global]\n" \
+    "AUTHOR_NAME = Lol\n" \
+    "AUTHOR_EMAIL = author@example.com\n" \
+    "SITE_TITLE = Lol's Website\n" \
+    "SITE_TAGLINE = WAT?!\n" \
+    "BASE_DOMAIN = http://example.org\n" \
+    "\n" \
+    "[pages]\n" \
+    "bar\n" \
+    "\n" \
+    "[copy]\n" \
+    "baz.txt\n" \
+    "\n" \
+    "[posts]\n" \
+    "foo\n"
+
+static char root[sizeof("/tmp/check_rules_XXXXXX")];
+
+static const char *outputs[] = {
+    "_build/index.html",
+    "_build/atom.xml",
+    "_build/post/foo/index.html",
+    "_build/bar/index.html",
+    "_build/baz.txt",
+    NULL,
+};
+
+
+static void
+write_file(const char *name, const char *content)
+{
+    char *path = bc_strdup_printf("%s/%s", root, name);
+    FILE *fp = fopen(path, "w");
+    assert_non_null(fp);
+    fputs(content, fp);
+    fclose(fp);
+    free(path);
+}
+
+
+static void
+remove_file(const char *name)
+{
+    char *path = bc_strdup_printf("%s/%s", root, name);
+    unlink(path);
+    free(path);
+}
+
+
+static void
+remove_dir(const char *name)
+{
+    char *path = bc_strdup_printf("%s/%s", root, name);
+    rmdir(path);
+    free(path);
+}
+
+
+// outputs are set way older than their sources, so any rule that runs
+// rebuilds or touches them.
+static void
+set_outputs_old(void)
+{
+    struct timeval tv[2] = {{.tv_sec = 1000}, {.tv_sec = 1000}};
+    for (size_t i = 0; outputs[i] != NULL; i++) {
+        char *path = bc_strdup_printf("%s/%s", root, outputs[i]);
+        assert_int_equal(utimes(path, tv), 0);
+        free(path);
+    }
+}
+
+
+static bool
+is_old(const char *name)
+{
+    char *path = bc_strdup_printf("%s/%s", root, name);
+    struct stat st;
+    assert_int_equal(stat(path, &st), 0);
+    free(path);
+    return st.st_mtime == 1000;
+}
+
+
+static void
+setup(void)
+{
+    strcpy(root, "/tmp/check_rules_XXXXXX");
+    assert_non_null(mkdtemp(root));
+    char *dir = bc_strdup_printf("%s/templates", root);
+    assert_int_equal(mkdir(dir, 0700), 0);
+    free(dir);
+    dir = bc_strdup_printf("%s/content", root);
+    assert_int_equal(mkdir(dir, 0700), 0);
+    free(dir);
+    dir = bc_strdup_printf("%s/content/post", root);
+    assert_int_equal(mkdir(dir, 0700), 0);
+    free(dir);
+
+    write_file("blogcfile", SETTINGS);
+    write_file("templates/main.tmpl",
+        "{% block entry %}{{ CONTENT }}{% endblock %}"
+        "{% block listing %}{{ TITLE }}{% endblock %}\n");
+    write_file("content/post/foo.txt",
+        "TITLE: Foo\nDATE: 2016-10-01\n-----\nfoo\n");
+    write_file("content/bar.txt", "TITLE: Bar\n-----\nbar\n");
+    write_file("baz.txt", "baz\n");
+
+    unsetenv("OUTPUT_DIR");
+    unsetenv("BLOGC");
+}
+
+
+static void
+teardown(void)
+{
+    remove_file("blogcfile");
+    remove_file("templates/main.tmpl");
+    remove_file("content/post/foo.txt");
+    remove_file("content/bar.txt");
+    remove_file("baz.txt");
+    remove_dir("content/post");
+    remove_dir("content");
+    remove_dir("templates");
+    remove_dir("");
+}
+
+
+static bm_ctx_t*
+ctx_new(void)
+{
+    char *path = bc_strdup_printf("%s/blogcfile", root);
+    bc_error_t *err = NULL;
+    bm_ctx_t *ctx = bm_ctx_new(NULL, path, "blogc-make", &err);
+    assert_null(err);
+    assert_non_null(ctx);
+    free(path);
+    return ctx;
+}
+
+
+static void
+ctx_clean(bm_ctx_t *ctx)
+{
+    bc_slist_t *l = bc_slist_append(NULL, bc_strdup("clean"));
+    assert_int_equal(bm_rule_executor(ctx, l), 0);
+    bc_slist_free_full(l, free);
+    bm_ctx_free(ctx);
+}
+
+
 static void
 test_rule_parse_args(void **state)
 {
-    bc_trie_t *t = bm_rule_parse_args("bola:foo=" + 4);
+    bc_hashmap_t *t = bm_rule_parse_args("bola:foo=" + 4);
     assert_non_null(t);
-    assert_int_equal(bc_trie_size(t), 1);
-    assert_string_equal(bc_trie_lookup(t, "foo"), "");
-    bc_trie_free(t);
+    assert_int_equal(bc_hashmap_size(t), 1);
+    assert_string_equal(bc_hashmap_lookup(t, "foo"), "");
+    bc_hashmap_free(t);
     t = bm_rule_parse_args("bola:foo=bar" + 4);
     assert_non_null(t);
-    assert_int_equal(bc_trie_size(t), 1);
-    assert_string_equal(bc_trie_lookup(t, "foo"), "bar");
-    bc_trie_free(t);
+    assert_int_equal(bc_hashmap_size(t), 1);
+    assert_string_equal(bc_hashmap_lookup(t, "foo"), "bar");
+    bc_hashmap_free(t);
     t = bm_rule_parse_args("bola:foo=,baz=lol" + 4);
     assert_non_null(t);
-    assert_int_equal(bc_trie_size(t), 2);
-    assert_string_equal(bc_trie_lookup(t, "foo"), "");
-    assert_string_equal(bc_trie_lookup(t, "baz"), "lol");
-    bc_trie_free(t);
+    assert_int_equal(bc_hashmap_size(t), 2);
+    assert_string_equal(bc_hashmap_lookup(t, "foo"), "");
+    assert_string_equal(bc_hashmap_lookup(t, "baz"), "lol");
+    bc_hashmap_free(t);
     t = bm_rule_parse_args("bola:foo=bar,baz=" + 4);
     assert_non_null(t);
-    assert_int_equal(bc_trie_size(t), 2);
-    assert_string_equal(bc_trie_lookup(t, "foo"), "bar");
-    assert_string_equal(bc_trie_lookup(t, "baz"), "");
-    bc_trie_free(t);
+    assert_int_equal(bc_hashmap_size(t), 2);
+    assert_string_equal(bc_hashmap_lookup(t, "foo"), "bar");
+    assert_string_equal(bc_hashmap_lookup(t, "baz"), "");
+    bc_hashmap_free(t);
     t = bm_rule_parse_args("bola:foo=bar,baz=lol" + 4);
     assert_non_null(t);
-    assert_int_equal(bc_trie_size(t), 2);
-    assert_string_equal(bc_trie_lookup(t, "foo"), "bar");
-    assert_string_equal(bc_trie_lookup(t, "baz"), "lol");
-    bc_trie_free(t);
+    assert_int_equal(bc_hashmap_size(t), 2);
+    assert_string_equal(bc_hashmap_lookup(t, "foo"), "bar");
+    assert_string_equal(bc_hashmap_lookup(t, "baz"), "lol");
+    bc_hashmap_free(t);
     t = bm_rule_parse_args("bola:foo=,baz=lol,asd=qwe" + 4);
     assert_non_null(t);
-    assert_int_equal(bc_trie_size(t), 3);
-    assert_string_equal(bc_trie_lookup(t, "foo"), "");
-    assert_string_equal(bc_trie_lookup(t, "baz"), "lol");
-    assert_string_equal(bc_trie_lookup(t, "asd"), "qwe");
-    bc_trie_free(t);
+    assert_int_equal(bc_hashmap_size(t), 3);
+    assert_string_equal(bc_hashmap_lookup(t, "foo"), "");
+    assert_string_equal(bc_hashmap_lookup(t, "baz"), "lol");
+    assert_string_equal(bc_hashmap_lookup(t, "asd"), "qwe");
+    bc_hashmap_free(t);
     t = bm_rule_parse_args("bola:foo=bar,baz=,asd=qwe" + 4);
     assert_non_null(t);
-    assert_int_equal(bc_trie_size(t), 3);
-    assert_string_equal(bc_trie_lookup(t, "foo"), "bar");
-    assert_string_equal(bc_trie_lookup(t, "baz"), "");
-    assert_string_equal(bc_trie_lookup(t, "asd"), "qwe");
-    bc_trie_free(t);
+    assert_int_equal(bc_hashmap_size(t), 3);
+    assert_string_equal(bc_hashmap_lookup(t, "foo"), "bar");
+    assert_string_equal(bc_hashmap_lookup(t, "baz"), "");
+    assert_string_equal(bc_hashmap_lookup(t, "asd"), "qwe");
+    bc_hashmap_free(t);
     t = bm_rule_parse_args("bola:foo=bar,baz=lol,asd=" + 4);
     assert_non_null(t);
-    assert_int_equal(bc_trie_size(t), 3);
-    assert_string_equal(bc_trie_lookup(t, "foo"), "bar");
-    assert_string_equal(bc_trie_lookup(t, "baz"), "lol");
-    assert_string_equal(bc_trie_lookup(t, "asd"), "");
-    bc_trie_free(t);
+    assert_int_equal(bc_hashmap_size(t), 3);
+    assert_string_equal(bc_hashmap_lookup(t, "foo"), "bar");
+    assert_string_equal(bc_hashmap_lookup(t, "baz"), "lol");
+    assert_string_equal(bc_hashmap_lookup(t, "asd"), "");
+    bc_hashmap_free(t);
     t = bm_rule_parse_args("bola:foo=bar,baz=lol,asd=qwe" + 4);
     assert_non_null(t);
-    assert_int_equal(bc_trie_size(t), 3);
-    assert_string_equal(bc_trie_lookup(t, "foo"), "bar");
-    assert_string_equal(bc_trie_lookup(t, "baz"), "lol");
-    assert_string_equal(bc_trie_lookup(t, "asd"), "qwe");
-    bc_trie_free(t);
+    assert_int_equal(bc_hashmap_size(t), 3);
+    assert_string_equal(bc_hashmap_lookup(t, "foo"), "bar");
+    assert_string_equal(bc_hashmap_lookup(t, "baz"), "lol");
+    assert_string_equal(bc_hashmap_lookup(t, "asd"), "qwe");
+    bc_hashmap_free(t);
 }
 
 
@@ -93,12 +249,193 @@ test_rule_parse_args_error(void **state)
 }
 
 
+static void
+test_rule_execute_changed(void **state)
+{
+    setup();
+    bm_ctx_t *ctx = ctx_new();
+    assert_int_equal(bm_rule_execute_changed(ctx, ~0), 0);
+    for (size_t i = 0; outputs[i] != NULL; i++)
+        assert_false(is_old(outputs[i]));
+
+    // copied files only depend on themselves
+    set_outputs_old();
+    assert_int_equal(bm_rule_execute_changed(ctx, BM_RULE_DEPENDS_COPY), 0);
+    assert_true(is_old("_build/index.html"));
+    assert_true(is_old("_build/atom.xml"));
+    assert_true(is_old("_build/post/foo/index.html"));
+    assert_true(is_old("_build/bar/index.html"));
+    assert_false(is_old("_build/baz.txt"));
+
+    // atom feeds don't use the main template
+    set_outputs_old();
+    assert_int_equal(bm_rule_execute_changed(ctx, BM_RULE_DEPENDS_TEMPLATE),
+        0);
+    assert_false(is_old("_build/index.html"));
+    assert_true(is_old("_build/atom.xml"));
+    assert_false(is_old("_build/post/foo/index.html"));
+    assert_false(is_old("_build/bar/index.html"));
+    assert_true(is_old("_build/baz.txt"));
+
+    set_outputs_old();
+    assert_int_equal(bm_rule_execute_changed(ctx, BM_RULE_DEPENDS_POSTS), 0);
+    assert_false(is_old("_build/index.html"));
+    assert_false(is_old("_build/atom.xml"));
+    assert_false(is_old("_build/post/foo/index.html"));
+    assert_true(is_old("_build/bar/index.html"));
+    assert_true(is_old("_build/baz.txt"));
+
+    set_outputs_old();
+    assert_int_equal(bm_rule_execute_changed(ctx, BM_RULE_DEPENDS_PAGES), 0);
+    assert_true(is_old("_build/index.html"));
+    assert_true(is_old("_build/atom.xml"));
+    assert_true(is_old("_build/post/foo/index.html"));
+    assert_false(is_old("_build/bar/index.html"));
+    assert_true(is_old("_build/baz.txt"));
+
+    // nothing changed, nothing runs
+    set_outputs_old();
+    assert_int_equal(bm_rule_execute_changed(ctx, 0), 0);
+    for (size_t i = 0; outputs[i] != NULL; i++)
+        assert_true(is_old(outputs[i]));
+
+    ctx_clean(ctx);
+    teardown();
+}
+
+
+static void
+test_ctx_rescan(void **state)
+{
+    setup();
+    bm_ctx_t *ctx = ctx_new();
+    bm_ctx_t *orig = ctx;
+
+    // settings that can't be parsed keep the old context around
+    write_file("blogcfile", "[global]\nAUTHOR_NAME = Lol\n[posts\n");
+    assert_false(bm_ctx_rescan(&ctx));
+    assert_true(ctx == orig);
+    assert_non_null(ctx->settings);
+    assert_non_null(ctx->posts_fctx);
+    assert_string_equal(((bm_filectx_t*) ctx->posts_fctx->data)->slug, "foo");
+    assert_int_equal(bm_rule_execute_changed(ctx, ~0), 0);
+    assert_false(is_old("_build/post/foo/index.html"));
+
+    // and fixing them picks up the changes
+    write_file("blogcfile", SETTINGS "foo2\n");
+    write_file("content/post/foo2.txt",
+        "TITLE: Foo 2\nDATE: 2016-10-02\n-----\nfoo2\n");
+    assert_true(bm_ctx_rescan(&ctx));
+    assert_non_null(ctx->posts_fctx);
+    assert_non_null(ctx->posts_fctx->next);
+    assert_string_equal(
+        ((bm_filectx_t*) ctx->posts_fctx->next->data)->slug, "foo2");
+    assert_int_equal(bm_rule_execute_changed(ctx, BM_RULE_DEPENDS_POSTS), 0);
+    assert_false(is_old("_build/post/foo2/index.html"));
+
+    ctx_clean(ctx);
+    remove_file("content/post/foo2.txt");
+    teardown();
+}
+
+
+static void
+test_ctx_get_source(void **state)
+{
+    setup();
+    bm_ctx_t *ctx = ctx_new();
+    bm_filectx_t *foo = ctx->posts_fctx->data;
+    bc_error_t *err = NULL;
+
+    // sources are parsed once, and then served from the store
+    bc_hashmap_t *s1 = bm_ctx_get_source(ctx, foo, &err);
+    assert_null(err);
+    assert_non_null(s1);
+    assert_string_equal(bc_hashmap_lookup(s1, "TITLE"), "Foo");
+    write_file("content/post/foo.txt",
+        "TITLE: Foo 2\nDATE: 2016-10-01\n-----\nfoo\n");
+    bc_hashmap_t *s2 = bm_ctx_get_source(ctx, foo, &err);
+    assert_null(err);
+    assert_true(s1 == s2);
+    assert_string_equal(bc_hashmap_lookup(s2, "TITLE"), "Foo");
+
+    // until their mtime changes
+    foo->tv_nsec++;
+    s2 = bm_ctx_get_source(ctx, foo, &err);
+    assert_null(err);
+    assert_non_null(s2);
+    assert_string_equal(bc_hashmap_lookup(s2, "TITLE"), "Foo 2");
+    assert_true(s2 == bm_ctx_get_source(ctx, foo, &err));
+    write_file("content/post/foo.txt",
+        "TITLE: Foo 3\nDATE: 2016-10-01\n-----\nfoo\n");
+    foo->tv_sec++;
+    s2 = bm_ctx_get_source(ctx, foo, &err);
+    assert_null(err);
+    assert_non_null(s2);
+    assert_string_equal(bc_hashmap_lookup(s2, "TITLE"), "Foo 3");
+    assert_int_equal(bc_hashmap_size(ctx->sources), 1);
+
+    // sources that can't be parsed aren't stored
+    write_file("content/post/foo.txt", "TITLE Foo\n");
+    foo->tv_sec++;
+    assert_null(bm_ctx_get_source(ctx, foo, &err));
+    assert_non_null(err);
+    bc_error_free(err);
+    err = NULL;
+    write_file("content/post/foo.txt",
+        "TITLE: Foo\nDATE: 2016-10-01\n-----\nfoo\n");
+
+    bm_ctx_free(ctx);
+    teardown();
+}
+
+
+static void
+test_ctx_rescan_sources(void **state)
+{
+    setup();
+    write_file("blogcfile", SETTINGS "foo2\n");
+    write_file("content/post/foo2.txt",
+        "TITLE: Foo 2\nDATE: 2016-10-02\n-----\nfoo2\n");
+    bm_ctx_t *ctx = ctx_new();
+    bc_error_t *err = NULL;
+
+    for (bc_slist_t *l = ctx->posts_fctx; l != NULL; l = l->next)
+        assert_non_null(bm_ctx_get_source(ctx, l->data, &err));
+    bm_filectx_t *bar = ctx->pages_fctx->data;
+    bc_hashmap_t *s = bm_ctx_get_source(ctx, bar, &err);
+    assert_non_null(s);
+    assert_null(err);
+    assert_int_equal(bc_hashmap_size(ctx->sources), 3);
+    char *foo2 = bc_strdup(((bm_filectx_t*) ctx->posts_fctx->next->data)->path);
+    assert_non_null(bc_hashmap_lookup(ctx->sources, foo2));
+
+    // removed posts are dropped from the store, the others are kept
+    write_file("blogcfile", SETTINGS);
+    assert_true(bm_ctx_rescan(&ctx));
+    assert_int_equal(bc_hashmap_size(ctx->sources), 2);
+    assert_null(bc_hashmap_lookup(ctx->sources, foo2));
+    bar = ctx->pages_fctx->data;
+    assert_true(s == bm_ctx_get_source(ctx, bar, &err));
+    assert_null(err);
+
+    free(foo2);
+    bm_ctx_free(ctx);
+    remove_file("content/post/foo2.txt");
+    teardown();
+}
+
+
 int
 main(void)
 {
     const UnitTest tests[] = {
         unit_test(test_rule_parse_args),
         unit_test(test_rule_parse_args_error),
+        unit_test(test_rule_execute_changed),
+        unit_test(test_ctx_rescan),
+        unit_test(test_ctx_get_source),
+        unit_test(test_ctx_rescan_sources),
     };
     return run_tests(tests);
 }
@@ -118,31 +118,31 @@ test_settings2(void **state)
     assert_null(err);
     assert_non_null(s);
     assert_null(s->root_dir);
-    assert_int_equal(bc_trie_size(s->global), 7);
-    assert_string_equal(bc_trie_lookup(s->global, "BOLA"), "asd");
-    assert_string_equal(bc_trie_lookup(s->global, "GUDA"), "qwe");
-    assert_string_equal(bc_trie_lookup(s->global, "AUTHOR_NAME"), "chunda");
-    assert_string_equal(bc_trie_lookup(s->global, "AUTHOR_EMAIL"), "chunda@example.com");
-    assert_string_equal(bc_trie_lookup(s->global, "SITE_TITLE"), "Fuuuuuuuuu");
-    assert_string_equal(bc_trie_lookup(s->global, "SITE_TAGLINE"), "My cool tagline");
-    assert_string_equal(bc_trie_lookup(s->global, "BASE_DOMAIN"), "http://example.com");
-    assert_int_equal(bc_trie_size(s->settings), 15);
-    assert_string_equal(bc_trie_lookup(s->settings, "source_ext"), ".txt");
-    assert_string_equal(bc_trie_lookup(s->settings, "html_ext"), "/index.html");
-    assert_string_equal(bc_trie_lookup(s->settings, "content_dir"), "guda");
-    assert_string_equal(bc_trie_lookup(s->settings, "template_dir"), "templates");
-    assert_string_equal(bc_trie_lookup(s->settings, "main_template"), "foo.tmpl");
-    assert_string_equal(bc_trie_lookup(s->settings, "date_format"),
+    assert_int_equal(bc_hashmap_size(s->global), 7);
+    assert_string_equal(bc_hashmap_lookup(s->global, "BOLA"), "asd");
+    assert_string_equal(bc_hashmap_lookup(s->global, "GUDA"), "qwe");
+    assert_string_equal(bc_hashmap_lookup(s->global, "AUTHOR_NAME"), "chunda");
+    assert_string_equal(bc_hashmap_lookup(s->global, "AUTHOR_EMAIL"), "chunda@example.com");
+    assert_string_equal(bc_hashmap_lookup(s->global, "SITE_TITLE"), "Fuuuuuuuuu");
+    assert_string_equal(bc_hashmap_lookup(s->global, "SITE_TAGLINE"), "My cool tagline");
+    assert_string_equal(bc_hashmap_lookup(s->global, "BASE_DOMAIN"), "http://example.com");
+    assert_int_equal(bc_hashmap_size(s->settings), 15);
+    assert_string_equal(bc_hashmap_lookup(s->settings, "source_ext"), ".txt");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "html_ext"), "/index.html");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "content_dir"), "guda");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "template_dir"), "templates");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "main_template"), "foo.tmpl");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "date_format"),
         "%b %d, %Y, %I:%M %p GMT");
-    assert_string_equal(bc_trie_lookup(s->settings, "posts_per_page"), "10");
-    assert_string_equal(bc_trie_lookup(s->settings, "atom_prefix"), "atom");
-    assert_string_equal(bc_trie_lookup(s->settings, "atom_ext"), ".xml");
-    assert_string_equal(bc_trie_lookup(s->settings, "atom_posts_per_page"), "10");
-    assert_string_equal(bc_trie_lookup(s->settings, "pagination_prefix"), "page");
-    assert_string_equal(bc_trie_lookup(s->settings, "post_prefix"), "post");
-    assert_string_equal(bc_trie_lookup(s->settings, "tag_prefix"), "tag");
-    assert_string_equal(bc_trie_lookup(s->settings, "html_order"), "DESC");
-    assert_string_equal(bc_trie_lookup(s->settings, "atom_order"), "DESC");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "posts_per_page"), "10");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "atom_prefix"), "atom");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "atom_ext"), ".xml");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "atom_posts_per_page"), "10");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "pagination_prefix"), "page");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "post_prefix"), "post");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "tag_prefix"), "tag");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "html_order"), "DESC");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "atom_order"), "DESC");
     assert_non_null(s->posts);
     assert_string_equal(s->posts[0], "aaaa");
     assert_string_equal(s->posts[1], "bbbb");
@@ -207,31 +207,31 @@ test_settings_env2(void **state)
     assert_null(err);
     assert_non_null(s);
     assert_null(s->root_dir);
-    assert_int_equal(bc_trie_size(s->global), 7);
-    assert_string_equal(bc_trie_lookup(s->global, "BOLA"), "asd");
-    assert_string_equal(bc_trie_lookup(s->global, "GUDA"), "qwe");
-    assert_string_equal(bc_trie_lookup(s->global, "AUTHOR_NAME"), "chunda");
-    assert_string_equal(bc_trie_lookup(s->global, "AUTHOR_EMAIL"), "chunda@example.com");
-    assert_string_equal(bc_trie_lookup(s->global, "SITE_TITLE"), "Fuuuuuuuuu");
-    assert_string_equal(bc_trie_lookup(s->global, "SITE_TAGLINE"), "My cool tagline");
-    assert_string_equal(bc_trie_lookup(s->global, "BASE_DOMAIN"), "http://example.com");
-    assert_int_equal(bc_trie_size(s->settings), 15);
-    assert_string_equal(bc_trie_lookup(s->settings, "source_ext"), ".txt");
-    assert_string_equal(bc_trie_lookup(s->settings, "html_ext"), "/index.html");
-    assert_string_equal(bc_trie_lookup(s->settings, "content_dir"), "guda");
-    assert_string_equal(bc_trie_lookup(s->settings, "template_dir"), "templates");
-    assert_string_equal(bc_trie_lookup(s->settings, "main_template"), "foo.tmpl");
-    assert_string_equal(bc_trie_lookup(s->settings, "date_format"),
+    assert_int_equal(bc_hashmap_size(s->global), 7);
+    assert_string_equal(bc_hashmap_lookup(s->global, "BOLA"), "asd");
+    assert_string_equal(bc_hashmap_lookup(s->global, "GUDA"), "qwe");
+    assert_string_equal(bc_hashmap_lookup(s->global, "AUTHOR_NAME"), "chunda");
+    assert_string_equal(bc_hashmap_lookup(s->global, "AUTHOR_EMAIL"), "chunda@example.com");
+    assert_string_equal(bc_hashmap_lookup(s->global, "SITE_TITLE"), "Fuuuuuuuuu");
+    assert_string_equal(bc_hashmap_lookup(s->global, "SITE_TAGLINE"), "My cool tagline");
+    assert_string_equal(bc_hashmap_lookup(s->global, "BASE_DOMAIN"), "http://example.com");
+    assert_int_equal(bc_hashmap_size(s->settings), 15);
+    assert_string_equal(bc_hashmap_lookup(s->settings, "source_ext"), ".txt");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "html_ext"), "/index.html");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "content_dir"), "guda");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "template_dir"), "templates");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "main_template"), "foo.tmpl");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "date_format"),
         "%b %d, %Y, %I:%M %p GMT");
-    assert_string_equal(bc_trie_lookup(s->settings, "posts_per_page"), "10");
-    assert_string_equal(bc_trie_lookup(s->settings, "atom_prefix"), "atom");
-    assert_string_equal(bc_trie_lookup(s->settings, "atom_ext"), ".xml");
-    assert_string_equal(bc_trie_lookup(s->settings, "atom_posts_per_page"), "10");
-    assert_string_equal(bc_trie_lookup(s->settings, "pagination_prefix"), "page");
-    assert_string_equal(bc_trie_lookup(s->settings, "post_prefix"), "post");
-    assert_string_equal(bc_trie_lookup(s->settings, "tag_prefix"), "tag");
-    assert_string_equal(bc_trie_lookup(s->settings, "html_order"), "DESC");
-    assert_string_equal(bc_trie_lookup(s->settings, "atom_order"), "DESC");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "posts_per_page"), "10");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "atom_prefix"), "atom");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "atom_ext"), ".xml");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "atom_posts_per_page"), "10");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "pagination_prefix"), "page");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "post_prefix"), "post");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "tag_prefix"), "tag");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "html_order"), "DESC");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "atom_order"), "DESC");
     assert_non_null(s->posts);
     assert_string_equal(s->posts[0], "aaaa");
     assert_string_equal(s->posts[1], "bbbb");
@@ -296,31 +296,31 @@ test_settings_copy_files(void **state)
     assert_null(err);
     assert_non_null(s);
     assert_null(s->root_dir);
-    assert_int_equal(bc_trie_size(s->global), 7);
-    assert_string_equal(bc_trie_lookup(s->global, "BOLA"), "asd");
-    assert_string_equal(bc_trie_lookup(s->global, "GUDA"), "qwe");
-    assert_string_equal(bc_trie_lookup(s->global, "AUTHOR_NAME"), "chunda");
-    assert_string_equal(bc_trie_lookup(s->global, "AUTHOR_EMAIL"), "chunda@example.com");
-    assert_string_equal(bc_trie_lookup(s->global, "SITE_TITLE"), "Fuuuuuuuuu");
-    assert_string_equal(bc_trie_lookup(s->global, "SITE_TAGLINE"), "My cool tagline");
-    assert_string_equal(bc_trie_lookup(s->global, "BASE_DOMAIN"), "http://example.com");
-    assert_int_equal(bc_trie_size(s->settings), 15);
-    assert_string_equal(bc_trie_lookup(s->settings, "source_ext"), ".txt");
-    assert_string_equal(bc_trie_lookup(s->settings, "html_ext"), "/index.html");
-    assert_string_equal(bc_trie_lookup(s->settings, "content_dir"), "guda");
-    assert_string_equal(bc_trie_lookup(s->settings, "template_dir"), "templates");
-    assert_string_equal(bc_trie_lookup(s->settings, "main_template"), "foo.tmpl");
-    assert_string_equal(bc_trie_lookup(s->settings, "date_format"),
+    assert_int_equal(bc_hashmap_size(s->global), 7);
+    assert_string_equal(bc_hashmap_lookup(s->global, "BOLA"), "asd");
+    assert_string_equal(bc_hashmap_lookup(s->global, "GUDA"), "qwe");
+    assert_string_equal(bc_hashmap_lookup(s->global, "AUTHOR_NAME"), "chunda");
+    assert_string_equal(bc_hashmap_lookup(s->global, "AUTHOR_EMAIL"), "chunda@example.com");
+    assert_string_equal(bc_hashmap_lookup(s->global, "SITE_TITLE"), "Fuuuuuuuuu");
+    assert_string_equal(bc_hashmap_lookup(s->global, "SITE_TAGLINE"), "My cool tagline");
+    assert_string_equal(bc_hashmap_lookup(s->global, "BASE_DOMAIN"), "http://example.com");
+    assert_int_equal(bc_hashmap_size(s->settings), 15);
+    assert_string_equal(bc_hashmap_lookup(s->settings, "source_ext"), ".txt");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "html_ext"), "/index.html");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "content_dir"), "guda");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "template_dir"), "templates");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "main_template"), "foo.tmpl");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "date_format"),
         "%b %d, %Y, %I:%M %p GMT");
-    assert_string_equal(bc_trie_lookup(s->settings, "posts_per_page"), "10");
-    assert_string_equal(bc_trie_lookup(s->settings, "atom_prefix"), "atom");
-    assert_string_equal(bc_trie_lookup(s->settings, "atom_ext"), ".xml");
-    assert_string_equal(bc_trie_lookup(s->settings, "atom_posts_per_page"), "10");
-    assert_string_equal(bc_trie_lookup(s->settings, "pagination_prefix"), "page");
-    assert_string_equal(bc_trie_lookup(s->settings, "post_prefix"), "post");
-    assert_string_equal(bc_trie_lookup(s->settings, "tag_prefix"), "tag");
-    assert_string_equal(bc_trie_lookup(s->settings, "html_order"), "DESC");
-    assert_string_equal(bc_trie_lookup(s->settings, "atom_order"), "DESC");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "posts_per_page"), "10");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "atom_prefix"), "atom");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "atom_ext"), ".xml");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "atom_posts_per_page"), "10");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "pagination_prefix"), "page");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "post_prefix"), "post");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "tag_prefix"), "tag");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "html_order"), "DESC");
+    assert_string_equal(bc_hashmap_lookup(s->settings, "atom_order"), "DESC");
     assert_non_null(s->posts);
     assert_string_equal(s->posts[0], "aaaa");
     assert_string_equal(s->posts[1], "bbbb");
@@ -0,0 +1,440 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+// load generator for blogc-runserver. starts the server in a child process,
+// serving a generated docroot, and sends requests from several client threads,
+// each with its own persistent connection. every scenario runs for a fixed
+// time, in every threading mode. not run by `make check`, use
+// `make bench-runserver`. the number of seconds per run may be given as an
+// argument.
+
+#include <errno.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <pthread.h>
+#include "../../src/common/utils.h"
+#include "../../src/blogc-runserver/httpd.h"
+#include "../../src/blogc-runserver/httpd-utils.h"
+#include "../../src/blogc-runserver/stats.h"
+
+#define DEFAULT_SECONDS 2
+#define NUM_PAGES 100
+#define SMALL_SIZE 2048
+#define BIG_SIZE (1024 * 1024)
+#define BUFFER_SIZE 65536
+
+typedef struct {
+    const char *name;
+    const char *format;
+    size_t num_paths;
+} scenario_t;
+
+// every path is requested in turn, so the file cache sees the same pattern
+// as when browsing a small site.
+static const scenario_t scenarios[] = {
+    {"small", "/page-%zu.html", NUM_PAGES},
+    {"large", "/big.bin", 1},
+    {"index", "/post/%zu/", NUM_PAGES},
+};
+#define NUM_SCENARIOS (sizeof(scenarios) / sizeof(scenarios[0]))
+
+static const size_t concurrency[] = {1, 8, 32};
+#define NUM_CONCURRENCY (sizeof(concurrency) / sizeof(concurrency[0]))
+
+// the workers mode runs one thread-per-connection worker per cpu, each with
+// its own listening socket.
+typedef struct {
+    const char *name;
+    bool event_loop;
+    bool workers;
+} server_mode_t;
+
+static const server_mode_t modes[] = {
+    {"threads", false, false},
+    {"loop", true, false},
+    {"workers", false, true},
+};
+#define NUM_MODES (sizeof(modes) / sizeof(modes[0]))
+
+typedef struct {
+    pthread_t thread;
+    const scenario_t *scenario;
+    size_t offset;
+    int port;
+    long long deadline;
+    int socket;
+    char buffer[BUFFER_SIZE];
+    unsigned long requests;
+    unsigned long errors;
+    unsigned long latency[BR_STATS_LATENCY_BUCKETS];
+} client_t;
+
+
+static void
+write_file(const char *path, size_t size, char c)
+{
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL) {
+        fprintf(stderr, "error: failed to create file (%s): %s\n", path,
+            strerror(errno));
+        exit(1);
+    }
+    fputs("<html><body>", fp);
+    for (size_t i = 12; i < size; i++)
+        fputc(i % 80 == 79 ? '\n' : c, fp);
+    fclose(fp);
+}
+
+
+static void
+docroot_create(const char *docroot)
+{
+    char *path = bc_strdup_printf("%s/big.bin", docroot);
+    write_file(path, BIG_SIZE, 'b');
+    free(path);
+    path = bc_strdup_printf("%s/post", docroot);
+    mkdir(path, 0755);
+    free(path);
+    for (size_t i = 0; i < NUM_PAGES; i++) {
+        path = bc_strdup_printf("%s/page-%zu.html", docroot, i);
+        write_file(path, SMALL_SIZE, 'a' + i % 26);
+        free(path);
+        path = bc_strdup_printf("%s/post/%zu", docroot, i);
+        mkdir(path, 0755);
+        free(path);
+        path = bc_strdup_printf("%s/post/%zu/index.html", docroot, i);
+        write_file(path, SMALL_SIZE, 'a' + i % 26);
+        free(path);
+    }
+}
+
+
+static void
+docroot_remove(const char *docroot)
+{
+    char *path;
+    for (size_t i = 0; i < NUM_PAGES; i++) {
+        path = bc_strdup_printf("%s/page-%zu.html", docroot, i);
+        unlink(path);
+        free(path);
+        path = bc_strdup_printf("%s/post/%zu/index.html", docroot, i);
+        unlink(path);
+        free(path);
+        path = bc_strdup_printf("%s/post/%zu", docroot, i);
+        rmdir(path);
+        free(path);
+    }
+    path = bc_strdup_printf("%s/post", docroot);
+    rmdir(path);
+    free(path);
+    path = bc_strdup_printf("%s/big.bin", docroot);
+    unlink(path);
+    free(path);
+    rmdir(docroot);
+}
+
+
+static int
+free_port(void)
+{
+    int s = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = 0,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    socklen_t len = sizeof(addr);
+    if (s == -1 || 0 != bind(s, (struct sockaddr*) &addr, len) ||
+        0 != getsockname(s, (struct sockaddr*) &addr, &len))
+    {
+        fprintf(stderr, "error: failed to find a free port: %s\n",
+            strerror(errno));
+        exit(1);
+    }
+    close(s);
+    return ntohs(addr.sin_port);
+}
+
+
+static int
+client_connect(int port)
+{
+    int s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s == -1)
+        return -1;
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    if (0 != connect(s, (struct sockaddr*) &addr, sizeof(addr))) {
+        close(s);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return s;
+}
+
+
+static const char*
+find_header(const char *header, const char *name)
+{
+    size_t len = strlen(name);
+    for (const char *p = strstr(header, "\r\n"); p != NULL;
+        p = strstr(p + 2, "\r\n"))
+    {
+        if (0 == strncasecmp(p + 2, name, len) && p[len + 2] == ':')
+            return p + len + 3;
+    }
+    return NULL;
+}
+
+
+// sends a request and reads the whole response. returns false on errors,
+// and closes the connection if the server asked for it.
+static bool
+client_request(client_t *c, const char *path)
+{
+    if (c->socket == -1) {
+        c->socket = client_connect(c->port);
+        if (c->socket == -1)
+            return false;
+    }
+
+    char *req = bc_strdup_printf("GET %s HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n",
+        path);
+    size_t len = strlen(req);
+    ssize_t n = write(c->socket, req, len);
+    free(req);
+    if (n != len)
+        goto error;
+
+    size_t buffer_len = 0;
+    char *end = NULL;
+    while (end == NULL) {
+        if (buffer_len == BUFFER_SIZE - 1)
+            goto error;
+        n = read(c->socket, c->buffer + buffer_len,
+            BUFFER_SIZE - 1 - buffer_len);
+        if (n <= 0)
+            goto error;
+        buffer_len += n;
+        c->buffer[buffer_len] = '\0';
+        end = strstr(c->buffer, "\r\n\r\n");
+    }
+    end[2] = '\0';
+
+    const char *length = find_header(c->buffer, "Content-Length");
+    if (0 != strncmp(c->buffer, "HTTP/1.1 200 ", 13) || length == NULL)
+        goto error;
+
+    // the buffer is reused to read the body, check the headers before.
+    const char *connection = find_header(c->buffer, "Connection");
+    bool close_connection = connection != NULL &&
+        0 == strncasecmp(connection, " close", 6);
+
+    size_t remaining = strtoul(length, NULL, 10);
+    size_t body = buffer_len - (end + 4 - c->buffer);
+    if (body > remaining)
+        goto error;
+    remaining -= body;
+    while (remaining > 0) {
+        n = read(c->socket, c->buffer, remaining < BUFFER_SIZE ? remaining :
+            BUFFER_SIZE);
+        if (n <= 0)
+            goto error;
+        remaining -= n;
+    }
+
+    if (close_connection) {
+        close(c->socket);
+        c->socket = -1;
+    }
+    return true;
+
+error:
+    close(c->socket);
+    c->socket = -1;
+    return false;
+}
+
+
+static void*
+client_thread(void *arg)
+{
+    client_t *c = arg;
+    size_t i = c->offset;
+    while (br_now() < c->deadline) {
+        char *path = bc_strdup_printf(c->scenario->format,
+            i++ % c->scenario->num_paths);
+        long long start = br_now();
+        if (client_request(c, path)) {
+            c->requests++;
+            c->latency[br_stats_latency_bucket(br_now() - start)]++;
+        }
+        else {
+            c->errors++;
+        }
+        free(path);
+    }
+    if (c->socket != -1)
+        close(c->socket);
+    return NULL;
+}
+
+
+static double
+percentile(unsigned long *latency, unsigned long total, unsigned int p)
+{
+    if (total == 0)
+        return 0;
+    unsigned long target = (total * p + 99) / 100;
+    unsigned long count = 0;
+    size_t i;
+    for (i = 0; i < BR_STATS_LATENCY_BUCKETS - 1; i++) {
+        count += latency[i];
+        if (count >= target)
+            break;
+    }
+    return br_stats_latency_bucket_max(i) / 1000.0;
+}
+
+
+static void
+run(const char *mode, const scenario_t *scenario, size_t num_clients,
+    int port, int seconds)
+{
+    client_t *clients = bc_malloc(num_clients * sizeof(client_t));
+    long long start = br_now();
+    for (size_t i = 0; i < num_clients; i++) {
+        clients[i].scenario = scenario;
+        clients[i].offset = i * scenario->num_paths / num_clients;
+        clients[i].port = port;
+        clients[i].deadline = start + seconds * 1000000LL;
+        clients[i].socket = -1;
+        clients[i].requests = 0;
+        clients[i].errors = 0;
+        memset(clients[i].latency, 0, sizeof(clients[i].latency));
+        if (0 != pthread_create(&clients[i].thread, NULL, client_thread,
+            &clients[i]))
+        {
+            fprintf(stderr, "error: failed to create client thread\n");
+            exit(1);
+        }
+    }
+
+    unsigned long requests = 0;
+    unsigned long errors = 0;
+    unsigned long latency[BR_STATS_LATENCY_BUCKETS] = {0};
+    for (size_t i = 0; i < num_clients; i++) {
+        pthread_join(clients[i].thread, NULL);
+        requests += clients[i].requests;
+        errors += clients[i].errors;
+        for (size_t j = 0; j < BR_STATS_LATENCY_BUCKETS; j++)
+            latency[j] += clients[i].latency[j];
+    }
+    double elapsed = (br_now() - start) / 1e6;
+    free(clients);
+
+    printf("%-8s %-8s %5zu %10.1f %9.3f %9.3f %9.3f %8lu\n", mode,
+        scenario->name, num_clients, requests / elapsed,
+        percentile(latency, requests, 50), percentile(latency, requests, 90),
+        percentile(latency, requests, 99), errors);
+    fflush(stdout);
+}
+
+
+static pid_t
+server_start(const char *docroot, int port, const server_mode_t *mode)
+{
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == -1) {
+        fprintf(stderr, "error: failed to fork: %s\n", strerror(errno));
+        exit(1);
+    }
+    if (pid == 0) {
+        FILE *fp = freopen("/dev/null", "w", stderr);
+        if (fp == NULL)
+            _exit(1);
+        char *p = bc_strdup_printf("%d", port);
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        if (cpus <= 0)
+            cpus = 1;
+        _exit(br_httpd_run("127.0.0.1", p, docroot,
+            mode->event_loop ? cpus : 20, mode->event_loop, "/dev/null",
+            false, mode->workers ? cpus : 0, false));
+    }
+
+    for (size_t i = 0; i < 500; i++) {
+        int s = client_connect(port);
+        if (s != -1) {
+            close(s);
+            return pid;
+        }
+        usleep(10000);
+    }
+    fprintf(stderr, "error: server didn't start\n");
+    kill(pid, SIGTERM);
+    exit(1);
+}
+
+
+static void
+server_stop(pid_t pid)
+{
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+}
+
+
+int
+main(int argc, char **argv)
+{
+    int seconds = argc > 1 ? atoi(argv[1]) : DEFAULT_SECONDS;
+    if (seconds <= 0)
+        seconds = DEFAULT_SECONDS;
+
+    signal(SIGPIPE, SIG_IGN);
+
+    char docroot[] = "/tmp/bench_runserver_XXXXXX";
+    if (NULL == mkdtemp(docroot)) {
+        fprintf(stderr, "error: failed to create docroot: %s\n",
+            strerror(errno));
+        return 1;
+    }
+    docroot_create(docroot);
+
+    printf("%-8s %-8s %5s %10s %9s %9s %9s %8s\n", "mode", "scenario",
+        "conns", "req/s", "p50 ms", "p90 ms", "p99 ms", "errors");
+
+    for (size_t m = 0; m < NUM_MODES; m++) {
+        int port = free_port();
+        pid_t pid = server_start(docroot, port, &modes[m]);
+        for (size_t s = 0; s < NUM_SCENARIOS; s++)
+            for (size_t c = 0; c < NUM_CONCURRENCY; c++)
+                run(modes[m].name, &scenarios[s], concurrency[c], port,
+                    seconds);
+        server_stop(pid);
+    }
+
+    docroot_remove(docroot);
+    return 0;
+}
@@ -0,0 +1,176 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../../src/common/error.h"
+#include "../../src/common/file.h"
+#include "../../src/common/utils.h"
+#include "../../src/blogc-runserver/access-log.h"
+#include "../../src/blogc-runserver/request-parser.h"
+#include "../../src/blogc-runserver/request.h"
+
+
+static char*
+read_log(const char *path)
+{
+    size_t len;
+    bc_error_t *err = NULL;
+    char *rv = bc_file_get_contents(path, false, &len, &err);
+    assert_null(err);
+    return rv != NULL ? rv : bc_strdup("");
+}
+
+
+static void
+write_entry(br_access_log_t *log, const char *request, unsigned short status,
+    size_t sent)
+{
+    br_request_parser_t *parser = br_request_parser_new();
+    br_request_parser_parse(parser, request, strlen(request));
+    br_response_t res = {
+        .status_code = status,
+        .header_len = 10,
+        .sent = sent,
+    };
+    br_access_log_write(log, "127.0.0.1", &(parser->request), &res, 1234);
+    br_request_parser_free(parser);
+}
+
+
+static void
+test_access_log(void **state)
+{
+    char path[] = "/tmp/check_access_log_XXXXXX";
+    int fd = mkstemp(path);
+    assert_int_not_equal(fd, -1);
+    close(fd);
+
+    br_access_log_t *log = br_access_log_new(path);
+    assert_non_null(log);
+    write_entry(log,
+        "GET /foo HTTP/1.1\r\n"
+        "Referer: http://example.org/\r\n"
+        "User-Agent: bola \"guda\"\r\n"
+        "\r\n", 200, 30);
+    write_entry(log, "GET /bar HTTP/1.0\r\n\r\n", 404, 5);
+    write_entry(log, "GET /a\tb HTTP/1.1\r\n\r\n", 400, 10);
+
+    char *content = read_log(path);
+    assert_string_equal(content, "");
+    free(content);
+
+    assert_int_equal(br_access_log_flush(log), 3);
+    assert_int_equal(br_access_log_flush(log), 0);
+
+    content = read_log(path);
+    char **lines = bc_str_split(content, '\n', 0);
+    assert_int_equal(bc_strv_length(lines), 4);
+    assert_true(bc_str_starts_with(lines[0], "127.0.0.1 - - ["));
+    assert_non_null(strstr(lines[0], "] \"GET /foo HTTP/1.1\" 200 20 "
+        "\"http://example.org/\" \"bola \\x22guda\\x22\" 0.001234"));
+    assert_non_null(strstr(lines[1], "] \"GET /bar HTTP/1.0\" 404 0 "
+        "\"-\" \"-\" 0.001234"));
+    assert_non_null(strstr(lines[2], "] \"GET /a\\x09b HTTP/1.1\" 400 0 "));
+    assert_string_equal(lines[3], "");
+    bc_strv_free(lines);
+    free(content);
+
+    assert_int_equal(br_access_log_dropped(log), 0);
+    br_access_log_free(log);
+    unlink(path);
+
+    assert_null(br_access_log_new("/tmp/check_access_log_nonexistent/log"));
+    br_access_log_write(NULL, "127.0.0.1", NULL, NULL, 0);
+    assert_int_equal(br_access_log_flush(NULL), 0);
+    assert_int_equal(br_access_log_dropped(NULL), 0);
+}
+
+
+static void
+test_access_log_full(void **state)
+{
+    char path[] = "/tmp/check_access_log_XXXXXX";
+    int fd = mkstemp(path);
+    assert_int_not_equal(fd, -1);
+    close(fd);
+
+    br_access_log_t *log = br_access_log_new(path);
+    for (size_t i = 0; i < BR_ACCESS_LOG_QUEUE_SIZE + 10; i++)
+        write_entry(log, "GET / HTTP/1.1\r\n\r\n", 200, 10);
+    assert_int_equal(br_access_log_dropped(log), 10);
+    assert_int_equal(br_access_log_flush(log), BR_ACCESS_LOG_QUEUE_SIZE);
+
+    // the queue is reused after being flushed
+    write_entry(log, "GET / HTTP/1.1\r\n\r\n", 200, 10);
+    assert_int_equal(br_access_log_flush(log), 1);
+    assert_int_equal(br_access_log_dropped(log), 10);
+    br_access_log_free(log);
+    unlink(path);
+}
+
+
+static void
+test_access_log_thread(void **state)
+{
+    char path[] = "/tmp/check_access_log_XXXXXX";
+    int fd = mkstemp(path);
+    assert_int_not_equal(fd, -1);
+    close(fd);
+
+    br_access_log_t *log = br_access_log_new(path);
+    assert_true(br_access_log_start(log));
+    assert_false(br_access_log_start(log));
+
+    // the idle thread is woken up by new entries
+    usleep(50000);
+    write_entry(log, "GET / HTTP/1.1\r\n\r\n", 200, 10);
+    char *content = NULL;
+    for (size_t i = 0; i < 200; i++) {
+        content = read_log(path);
+        if (content[0] != '\0')
+            break;
+        free(content);
+        content = NULL;
+        usleep(10000);
+    }
+    assert_non_null(content);
+    free(content);
+
+    for (size_t i = 0; i < 100; i++)
+        write_entry(log, "GET / HTTP/1.1\r\n\r\n", 200, 10);
+
+    // pending entries are written when the log is freed
+    br_access_log_free(log);
+
+    content = read_log(path);
+    char **lines = bc_str_split(content, '\n', 0);
+    assert_int_equal(bc_strv_length(lines), 102);
+    bc_strv_free(lines);
+    free(content);
+    unlink(path);
+}
+
+
+int
+main(void)
+{
+    const UnitTest tests[] = {
+        unit_test(test_access_log),
+        unit_test(test_access_log_full),
+        unit_test(test_access_log_thread),
+    };
+    return run_tests(tests);
+}
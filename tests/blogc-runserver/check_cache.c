@@ -0,0 +1,272 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "../../src/common/utils.h"
+#include "../../src/blogc-runserver/cache.h"
+
+
+static br_cache_entry_t*
+entry_new(const char *key, const char *path, const char *data)
+{
+    br_cache_entry_t *rv = br_cache_entry_new(key);
+    rv->path = bc_strdup(path);
+    if (data != NULL) {
+        rv->data = bc_strdup(data);
+        rv->size = strlen(data);
+    }
+    return rv;
+}
+
+
+static void
+insert(br_cache_t *cache, const char *key, const char *path, const char *data)
+{
+    br_cache_entry_t *e = entry_new(key, path, data);
+    br_cache_insert(cache, e, br_cache_generation(cache));
+    br_cache_entry_unref(e);
+}
+
+
+static bool
+cached(br_cache_t *cache, const char *key)
+{
+    br_cache_entry_t *e = br_cache_lookup(cache, key);
+    br_cache_entry_unref(e);
+    return e != NULL;
+}
+
+
+static void
+test_cache_lru(void **state)
+{
+    br_cache_t *cache = br_cache_new(3, 1024);
+    assert_null(br_cache_lookup(cache, "/a"));
+    insert(cache, "/a", "/r/a", NULL);
+    insert(cache, "/b", "/r/b", NULL);
+    insert(cache, "/c", "/r/c", NULL);
+    assert_int_equal(br_cache_size(cache), 3);
+
+    br_cache_entry_t *e = br_cache_lookup(cache, "/a");
+    assert_non_null(e);
+    assert_string_equal(e->key, "/a");
+    assert_string_equal(e->path, "/r/a");
+    br_cache_entry_unref(e);
+
+    // /b is the least recently used now
+    insert(cache, "/d", "/r/d", NULL);
+    assert_int_equal(br_cache_size(cache), 3);
+    assert_false(cached(cache, "/b"));
+    assert_true(cached(cache, "/a"));
+    assert_true(cached(cache, "/c"));
+    assert_true(cached(cache, "/d"));
+
+    // same key replaces the entry
+    insert(cache, "/c", "/r/cc", NULL);
+    assert_int_equal(br_cache_size(cache), 3);
+    e = br_cache_lookup(cache, "/c");
+    assert_string_equal(e->path, "/r/cc");
+
+    // entries outlive the cache while referenced
+    br_cache_free(cache);
+    assert_string_equal(e->path, "/r/cc");
+    br_cache_entry_unref(e);
+
+    assert_null(br_cache_lookup(NULL, "/a"));
+    assert_int_equal(br_cache_generation(NULL), 0);
+    assert_int_equal(br_cache_size(NULL), 0);
+}
+
+
+static void
+test_cache_max_size(void **state)
+{
+    br_cache_t *cache = br_cache_new(10, 10);
+    insert(cache, "/a", "/r/a", "bola");
+    insert(cache, "/b", "/r/b", "guda");
+    insert(cache, "/c", "/r/c", NULL);
+    assert_int_equal(br_cache_size(cache), 3);
+
+    // 12 bytes, /a goes away
+    insert(cache, "/d", "/r/d", "asd");
+    assert_int_equal(br_cache_size(cache), 3);
+    assert_false(cached(cache, "/a"));
+
+    // too big for the cache
+    insert(cache, "/e", "/r/e", "12345678901");
+    assert_false(cached(cache, "/e"));
+    assert_int_equal(br_cache_size(cache), 3);
+    br_cache_free(cache);
+}
+
+
+static void
+test_cache_generation(void **state)
+{
+    br_cache_t *cache = br_cache_new(10, 1024);
+    unsigned long generation = br_cache_generation(cache);
+    br_cache_entry_t *e = entry_new("/a", "/r/a", NULL);
+
+    // something changed while the entry was being resolved
+    br_cache_invalidate(cache, "/r/b");
+    assert_int_equal(br_cache_generation(cache), generation + 1);
+    br_cache_insert(cache, e, generation);
+    assert_false(cached(cache, "/a"));
+
+    br_cache_insert(cache, e, generation + 1);
+    assert_true(cached(cache, "/a"));
+
+    br_cache_remove(cache, e);
+    assert_false(cached(cache, "/a"));
+    br_cache_remove(cache, e);
+    assert_string_equal(e->key, "/a");
+    br_cache_entry_unref(e);
+    br_cache_free(cache);
+}
+
+
+static void
+test_cache_invalidate(void **state)
+{
+    br_cache_t *cache = br_cache_new(10, 1024);
+    insert(cache, "/", "/r/index.html", NULL);
+    insert(cache, "/foo/", "/r/foo/index.html", NULL);
+    insert(cache, "/foo/bar.css", "/r/foo/bar.css", NULL);
+    insert(cache, "/foo/baz/", "/r/foo/baz/index.html", NULL);
+    insert(cache, "/foobar.txt", "/r/foobar.txt", NULL);
+    insert(cache, "/asd/", "/r/asd/index.html", NULL);
+
+    // siblings go away too, but not subdirectories
+    br_cache_invalidate(cache, "/r/foo/bar.css");
+    assert_false(cached(cache, "/foo/"));
+    assert_false(cached(cache, "/foo/bar.css"));
+    assert_true(cached(cache, "/foo/baz/"));
+    assert_true(cached(cache, "/"));
+    assert_true(cached(cache, "/foobar.txt"));
+    assert_true(cached(cache, "/asd/"));
+
+    // everything below a directory
+    br_cache_invalidate(cache, "/r/foo");
+    assert_false(cached(cache, "/foo/baz/"));
+    assert_false(cached(cache, "/"));
+    assert_false(cached(cache, "/foobar.txt"));
+    assert_true(cached(cache, "/asd/"));
+
+    br_cache_invalidate(cache, NULL);
+    assert_int_equal(br_cache_size(cache), 0);
+
+    // invalidations are applied to the linked cache too
+    br_cache_t *linked = br_cache_new(10, 1024);
+    br_cache_link(cache, linked);
+    insert(cache, "/foo/", "/r/foo/index.html", NULL);
+    insert(linked, "/r/foo", "/r/foo/index.html", NULL);
+    insert(linked, "/r/asd", "/r/asd/index.html", NULL);
+    br_cache_invalidate(linked, "/r/asd/index.txt");
+    assert_true(cached(cache, "/foo/"));
+    assert_false(cached(linked, "/r/asd"));
+    br_cache_invalidate(cache, "/r/foo/index.txt");
+    assert_false(cached(cache, "/foo/"));
+    assert_false(cached(linked, "/r/foo"));
+    br_cache_free(cache);
+    br_cache_free(linked);
+}
+
+
+#ifdef HAVE_SYS_INOTIFY_H
+
+static bool
+wait_invalidated(br_cache_t *cache, const char *key)
+{
+    for (size_t i = 0; i < 200; i++) {
+        if (!cached(cache, key))
+            return true;
+        usleep(10000);
+    }
+    return false;
+}
+
+
+static void
+write_file(const char *path, const char *content)
+{
+    FILE *fp = fopen(path, "w");
+    assert_non_null(fp);
+    fputs(content, fp);
+    fclose(fp);
+}
+
+
+static void
+test_cache_watch(void **state)
+{
+    char docroot[] = "/tmp/check_cache_XXXXXX";
+    assert_non_null(mkdtemp(docroot));
+    char *root = realpath(docroot, NULL);
+    char *index = bc_strdup_printf("%s/index.html", root);
+    char *dir = bc_strdup_printf("%s/foo", root);
+    char *file = bc_strdup_printf("%s/foo/bar.html", root);
+    write_file(index, "bola");
+
+    br_cache_t *cache = br_cache_new(10, 1024);
+    assert_true(br_cache_watch(cache, docroot));
+
+    insert(cache, "/", index, "bola");
+    assert_true(cached(cache, "/"));
+    write_file(index, "guda");
+    assert_true(wait_invalidated(cache, "/"));
+
+    // new directories are watched too
+    insert(cache, "/", index, "guda");
+    assert_int_equal(mkdir(dir, 0755), 0);
+    assert_true(wait_invalidated(cache, "/"));
+    write_file(file, "chunda");
+    insert(cache, "/foo/bar.html", file, "chunda");
+    assert_true(cached(cache, "/foo/bar.html"));
+    unlink(file);
+    assert_true(wait_invalidated(cache, "/foo/bar.html"));
+
+    br_cache_free(cache);
+    rmdir(dir);
+    unlink(index);
+    rmdir(docroot);
+    free(file);
+    free(dir);
+    free(index);
+    free(root);
+}
+
+#endif /* HAVE_SYS_INOTIFY_H */
+
+
+int
+main(void)
+{
+    const UnitTest tests[] = {
+        unit_test(test_cache_lru),
+        unit_test(test_cache_max_size),
+        unit_test(test_cache_generation),
+        unit_test(test_cache_invalidate),
+#ifdef HAVE_SYS_INOTIFY_H
+        unit_test(test_cache_watch),
+#endif /* HAVE_SYS_INOTIFY_H */
+    };
+    return run_tests(tests);
+}
@@ -0,0 +1,144 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif /* HAVE_ZLIB */
+#include "../../src/common/utils.h"
+#include "../../src/blogc-runserver/compress.h"
+
+
+static void
+test_compress_negotiate(void **state)
+{
+    assert_int_equal(br_compress_negotiate(NULL), BR_ENCODING_IDENTITY);
+    assert_int_equal(br_compress_negotiate(""), BR_ENCODING_IDENTITY);
+    assert_int_equal(br_compress_negotiate("identity"), BR_ENCODING_IDENTITY);
+    assert_int_equal(br_compress_negotiate("br"), BR_ENCODING_IDENTITY);
+    assert_int_equal(br_compress_negotiate("gzip"), BR_ENCODING_GZIP);
+    assert_int_equal(br_compress_negotiate("GZIP"), BR_ENCODING_GZIP);
+    assert_int_equal(br_compress_negotiate("x-gzip"), BR_ENCODING_GZIP);
+    assert_int_equal(br_compress_negotiate("deflate"), BR_ENCODING_DEFLATE);
+    assert_int_equal(br_compress_negotiate("gzip, deflate, br"),
+        BR_ENCODING_GZIP);
+    assert_int_equal(br_compress_negotiate("deflate, gzip"), BR_ENCODING_GZIP);
+    assert_int_equal(br_compress_negotiate("gzip;q=0.5, deflate"),
+        BR_ENCODING_DEFLATE);
+    assert_int_equal(br_compress_negotiate("gzip ; q=1.0, deflate;q=0.999"),
+        BR_ENCODING_GZIP);
+    assert_int_equal(br_compress_negotiate("gzip;q=0, deflate;q=0"),
+        BR_ENCODING_IDENTITY);
+    assert_int_equal(br_compress_negotiate("gzip;q=0.000"),
+        BR_ENCODING_IDENTITY);
+    assert_int_equal(br_compress_negotiate("gzip;q=bola"),
+        BR_ENCODING_IDENTITY);
+    assert_int_equal(br_compress_negotiate("*"), BR_ENCODING_GZIP);
+    assert_int_equal(br_compress_negotiate("gzip;q=0, *"),
+        BR_ENCODING_DEFLATE);
+    assert_int_equal(br_compress_negotiate("*;q=0"), BR_ENCODING_IDENTITY);
+}
+
+
+static void
+test_compress_encoding_name(void **state)
+{
+    assert_null(br_compress_encoding_name(BR_ENCODING_IDENTITY));
+    assert_string_equal(br_compress_encoding_name(BR_ENCODING_GZIP), "gzip");
+    assert_string_equal(br_compress_encoding_name(BR_ENCODING_DEFLATE),
+        "deflate");
+}
+
+
+#ifdef HAVE_ZLIB
+
+static char*
+decompress(br_encoding_t encoding, const char *data, size_t len,
+    size_t out_len)
+{
+    z_stream strm;
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+    strm.next_in = (Bytef*) data;
+    strm.avail_in = len;
+    assert_int_equal(inflateInit2(&strm, encoding == BR_ENCODING_GZIP ?
+        16 + MAX_WBITS : MAX_WBITS), Z_OK);
+    char *rv = bc_malloc(out_len + 1);
+    strm.next_out = (Bytef*) rv;
+    strm.avail_out = out_len + 1;
+    assert_int_equal(inflate(&strm, Z_FINISH), Z_STREAM_END);
+    assert_int_equal(strm.total_out, out_len);
+    inflateEnd(&strm);
+    rv[out_len] = '\0';
+    return rv;
+}
+
+
+static void
+test_compress(void **state)
+{
+    bc_string_t *str = bc_string_new();
+    for (size_t i = 0; i < 1000; i++)
+        bc_string_append_printf(str, "<p>bola %zu</p>\n", i);
+
+    size_t len;
+    assert_null(br_compress(BR_ENCODING_IDENTITY, str->str, str->len, &len));
+
+    char *out = br_compress(BR_ENCODING_GZIP, str->str, str->len, &len);
+    assert_non_null(out);
+    assert_true(len < str->len);
+    assert_int_equal((unsigned char) out[0], 0x1f);
+    assert_int_equal((unsigned char) out[1], 0x8b);
+    char *back = decompress(BR_ENCODING_GZIP, out, len, str->len);
+    assert_string_equal(back, str->str);
+    free(back);
+    free(out);
+
+    out = br_compress(BR_ENCODING_DEFLATE, str->str, str->len, &len);
+    assert_non_null(out);
+    assert_true(len < str->len);
+    back = decompress(BR_ENCODING_DEFLATE, out, len, str->len);
+    assert_string_equal(back, str->str);
+    free(back);
+    free(out);
+
+    out = br_compress(BR_ENCODING_GZIP, "", 0, &len);
+    assert_non_null(out);
+    back = decompress(BR_ENCODING_GZIP, out, len, 0);
+    assert_string_equal(back, "");
+    free(back);
+    free(out);
+
+    bc_string_free(str, true);
+}
+
+#endif /* HAVE_ZLIB */
+
+
+int
+main(void)
+{
+    const UnitTest tests[] = {
+        unit_test(test_compress_negotiate),
+        unit_test(test_compress_encoding_name),
+#ifdef HAVE_ZLIB
+        unit_test(test_compress),
+#endif /* HAVE_ZLIB */
+    };
+    return run_tests(tests);
+}
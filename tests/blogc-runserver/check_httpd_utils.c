@@ -16,44 +16,6 @@
 #include "../../src/blogc-runserver/httpd-utils.h"
 
 
-ssize_t
-__wrap_read(int fd, void *buf, size_t count)
-{
-    assert_int_equal(fd, mock_type(int));
-    const char *mock_buf = mock_type(const char*);
-    strcpy(buf, mock_buf);
-    assert_int_equal(count, READLINE_BUFFER_SIZE);
-    return strlen(mock_buf) > 0 ? strlen(mock_buf) : -1;
-}
-
-
-static void
-test_readline(void **state)
-{
-    char *t;
-    will_return(__wrap_read, 1234);
-    will_return(__wrap_read, "bola");
-    t = br_readline(1234);
-    assert_string_equal(t, "bola");
-    free(t);
-    will_return(__wrap_read, 1234);
-    will_return(__wrap_read, "bola1\nguda\nxd");
-    t = br_readline(1234);
-    assert_string_equal(t, "bola1");
-    free(t);
-    will_return(__wrap_read, 1234);
-    will_return(__wrap_read, "bola2\rguda\rxd");
-    t = br_readline(1234);
-    assert_string_equal(t, "bola2");
-    free(t);
-    will_return(__wrap_read, 1234);
-    will_return(__wrap_read, "bola3\r\nguda\r\nxd");
-    t = br_readline(1234);
-    assert_string_equal(t, "bola3");
-    free(t);
-}
-
-
 static void
 test_hextoi(void **state)
 {
@@ -119,14 +81,56 @@ test_get_extension(void **state)
 }
 
 
+static void
+test_format_http_date(void **state)
+{
+    char *d = br_format_http_date(0);
+    assert_string_equal(d, "Thu, 01 Jan 1970 00:00:00 GMT");
+    free(d);
+    d = br_format_http_date(784111777);
+    assert_string_equal(d, "Sun, 06 Nov 1994 08:49:37 GMT");
+    free(d);
+    d = br_format_http_date(1709210096);
+    assert_string_equal(d, "Thu, 29 Feb 2024 12:34:56 GMT");
+    free(d);
+}
+
+
+static void
+test_parse_http_date(void **state)
+{
+    time_t t = 0;
+    assert_true(br_parse_http_date("Sun, 06 Nov 1994 08:49:37 GMT", &t));
+    assert_int_equal(t, 784111777);
+    t = 0;
+    assert_true(br_parse_http_date("Sunday, 06-Nov-94 08:49:37 GMT", &t));
+    assert_int_equal(t, 784111777);
+    t = 0;
+    assert_true(br_parse_http_date("Sun Nov  6 08:49:37 1994", &t));
+    assert_int_equal(t, 784111777);
+    assert_true(br_parse_http_date("Thu, 29 Feb 2024 12:34:56 GMT", &t));
+    assert_int_equal(t, 1709210096);
+    assert_true(br_parse_http_date("Thu, 01 Jan 1970 00:00:00 GMT", &t));
+    assert_int_equal(t, 0);
+    assert_false(br_parse_http_date(NULL, &t));
+    assert_false(br_parse_http_date("", &t));
+    assert_false(br_parse_http_date("bola", &t));
+    assert_false(br_parse_http_date("Sun, 06 Bol 1994 08:49:37 GMT", &t));
+    assert_false(br_parse_http_date("Sun, 06 Nov 1994 08:49:37", &t));
+    assert_false(br_parse_http_date("Sun, 06 Nov 1994 08:49:37 GMT bola", &t));
+    assert_false(br_parse_http_date("Sun, 06 Nov 1994 25:49:37 GMT", &t));
+}
+
+
 int
 main(void)
 {
     const UnitTest tests[] = {
-        unit_test(test_readline),
         unit_test(test_hextoi),
         unit_test(test_urldecode),
         unit_test(test_get_extension),
+        unit_test(test_format_http_date),
+        unit_test(test_parse_http_date),
     };
     return run_tests(tests);
 }
@@ -31,6 +31,35 @@ test_guess_content_type(void **state)
     assert_string_equal(br_mime_guess_content_type("foo.jpg"), "image/jpeg");
     assert_string_equal(br_mime_guess_content_type("foo.mp4"), "video/mp4");
     assert_string_equal(br_mime_guess_content_type("foo.bola"), "application/octet-stream");
+    assert_string_equal(br_mime_guess_content_type("foo.HTML"), "text/html");
+    assert_string_equal(br_mime_guess_content_type("foo.Jpg"), "image/jpeg");
+    assert_string_equal(br_mime_guess_content_type("foo.JARDIFF"),
+        "application/x-java-archive-diff");
+    assert_string_equal(br_mime_guess_content_type("foo.7z"),
+        "application/x-7z-compressed");
+    assert_string_equal(br_mime_guess_content_type("foo.htmlx"),
+        "application/octet-stream");
+    assert_string_equal(br_mime_guess_content_type("foo.jardiffs"),
+        "application/octet-stream");
+    assert_string_equal(br_mime_guess_content_type("foo/bar"),
+        "application/octet-stream");
+    assert_string_equal(br_mime_guess_content_type("foo."),
+        "application/octet-stream");
+}
+
+
+static void
+test_compressible(void **state)
+{
+    assert_true(br_mime_compressible("foo.html"));
+    assert_true(br_mime_compressible("foo/bar.css"));
+    assert_true(br_mime_compressible("foo.js"));
+    assert_true(br_mime_compressible("foo.svg"));
+    assert_false(br_mime_compressible("foo.svgz"));
+    assert_false(br_mime_compressible("foo.jpg"));
+    assert_false(br_mime_compressible("foo.bola"));
+    assert_false(br_mime_compressible("foo"));
+    assert_true(br_mime_compressible("FOO.CSS"));
 }
 
 
@@ -86,6 +115,7 @@ main(void)
 {
     const UnitTest tests[] = {
         unit_test(test_guess_content_type),
+        unit_test(test_compressible),
         unit_test(test_guess_index),
     };
     return run_tests(tests);
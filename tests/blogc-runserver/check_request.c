@@ -0,0 +1,777 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif /* HAVE_ZLIB */
+#include "../../src/common/utils.h"
+#include "../../src/blogc-runserver/compress.h"
+#include "../../src/blogc-runserver/request-parser.h"
+#include "../../src/blogc-runserver/request.h"
+#include "../../src/blogc-runserver/stats.h"
+
+static char docroot[] = "/tmp/check_request_XXXXXX";
+static br_cache_t *indexes = NULL;
+static br_cache_t *compressed = NULL;
+static br_stats_t *stats = NULL;
+
+
+static void
+create_file(const char *name, const char *content)
+{
+    char *path = bc_strdup_printf("%s/%s", docroot, name);
+    FILE *fp = fopen(path, "w");
+    assert_non_null(fp);
+    assert_int_equal(fwrite(content, sizeof(char), strlen(content), fp),
+        strlen(content));
+    fclose(fp);
+    free(path);
+}
+
+
+static void
+create_dir(const char *name)
+{
+    char *path = bc_strdup_printf("%s/%s", docroot, name);
+    assert_int_equal(mkdir(path, 0755), 0);
+    free(path);
+}
+
+
+// sets a known mtime, and returns the etag
+static char*
+set_mtime(const char *name, time_t mtime)
+{
+    char *path = bc_strdup_printf("%s/%s", docroot, name);
+    struct timeval tv[2] = {{mtime, 0}, {mtime, 0}};
+    assert_int_equal(utimes(path, tv), 0);
+    struct stat st;
+    assert_int_equal(stat(path, &st), 0);
+    free(path);
+    return bc_strdup_printf("\"%llx-%llx-%llx\"",
+        (unsigned long long) st.st_ino, (unsigned long long) st.st_size,
+        (unsigned long long) mtime);
+}
+
+
+static void
+remove_path(const char *name, bool dir)
+{
+    char *path = bc_strdup_printf("%s/%s", docroot, name);
+    if (dir)
+        rmdir(path);
+    else
+        unlink(path);
+    free(path);
+}
+
+
+static char*
+send_response(br_response_t *res)
+{
+    int fds[2];
+    assert_int_equal(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    assert_int_equal(br_response_send(res, fds[0]), 1);
+    assert_int_equal(res->sent, res->header_len + res->body_len);
+    close(fds[0]);
+
+    bc_string_t *rv = bc_string_new();
+    char buffer[1024];
+    ssize_t n;
+    while ((n = read(fds[1], buffer, sizeof(buffer))) > 0)
+        bc_string_append_len(rv, buffer, n);
+    close(fds[1]);
+    return bc_string_free(rv, false);
+}
+
+
+static br_response_t*
+handle(br_cache_t *cache, const char *request, bool keep_alive)
+{
+    br_request_parser_t *parser = br_request_parser_new();
+    assert_int_equal(br_request_parser_parse(parser, request, strlen(request)),
+        strlen(request));
+    assert_int_equal(parser->state, BR_REQUEST_PARSER_DONE);
+    br_server_t server = {
+        .docroot = docroot,
+        .cache = cache,
+        .indexes = indexes,
+        .compressed = compressed,
+        .stats = stats,
+    };
+    br_response_t *rv = br_request_handle(&server, &(parser->request),
+        keep_alive);
+    br_request_parser_free(parser);
+    return rv;
+}
+
+
+static void
+test_request_handle(void **state)
+{
+    assert_non_null(mkdtemp(docroot));
+    create_file("index.html", "<h1>bola</h1>\n");
+    create_file("style.css", "body{}");
+    create_dir("foo");
+    create_file("foo/index.html", "guda");
+    create_dir("bar");
+    char *etag = set_mtime("index.html", 784111777);
+    char *header = bc_strdup_printf(
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/html\r\n"
+        "ETag: %s\r\n"
+        "Last-Modified: Sun, 06 Nov 1994 08:49:37 GMT\r\n"
+        "Accept-Ranges: bytes\r\n"
+        "Content-Length: 14\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n", etag);
+
+    br_response_t *res = handle(NULL, "GET / HTTP/1.1\r\n\r\n", true);
+    assert_int_equal(res->status_code, 200);
+    assert_true(res->keep_alive);
+    assert_string_equal(res->header, header);
+    assert_int_equal(res->header_len, strlen(res->header));
+    assert_string_equal(res->body, "<h1>bola</h1>\n");
+    assert_int_equal(res->fd, -1);
+    assert_int_equal(res->body_len, 14);
+    char *out = send_response(res);
+    assert_true(bc_str_starts_with(out, header));
+    assert_string_equal(out + strlen(header), "<h1>bola</h1>\n");
+    free(out);
+    br_response_free(res);
+
+    // same headers, no body
+    res = handle(NULL, "HEAD / HTTP/1.1\r\n\r\n", true);
+    assert_int_equal(res->status_code, 200);
+    assert_string_equal(res->header, header);
+    assert_null(res->body);
+    assert_int_equal(res->fd, -1);
+    assert_int_equal(res->body_len, 0);
+    out = send_response(res);
+    assert_string_equal(out, header);
+    free(out);
+    br_response_free(res);
+    free(header);
+    free(etag);
+
+    res = handle(NULL, "GET /style.css?v=1 HTTP/1.1\r\n\r\n", false);
+    assert_int_equal(res->status_code, 200);
+    assert_false(res->keep_alive);
+    assert_non_null(strstr(res->header, "Content-Type: text/css\r\n"));
+    assert_non_null(strstr(res->header, "Connection: close\r\n"));
+    assert_int_equal(res->body_len, 6);
+    out = send_response(res);
+    assert_string_equal(out + res->header_len, "body{}");
+    free(out);
+    br_response_free(res);
+
+    res = handle(NULL, "GET /foo/ HTTP/1.1\r\n\r\n", true);
+    assert_int_equal(res->status_code, 200);
+    assert_int_equal(res->body_len, 4);
+    out = send_response(res);
+    assert_string_equal(out + res->header_len, "guda");
+    free(out);
+    br_response_free(res);
+
+    res = handle(NULL, "GET /foo HTTP/1.1\r\n\r\n", true);
+    assert_int_equal(res->status_code, 302);
+    assert_string_equal(res->header,
+        "HTTP/1.1 302 Found\r\n"
+        "Location: /foo/\r\n"
+        "Content-Length: 0\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n");
+    assert_null(res->body);
+    assert_int_equal(res->fd, -1);
+    assert_int_equal(res->body_len, 0);
+    br_response_free(res);
+
+    res = handle(NULL, "GET /bar/ HTTP/1.1\r\n\r\n", true);
+    assert_int_equal(res->status_code, 403);
+    br_response_free(res);
+
+    res = handle(NULL, "GET /baz HTTP/1.1\r\n\r\n", true);
+    assert_int_equal(res->status_code, 404);
+    assert_true(res->keep_alive);
+    assert_string_equal(res->header,
+        "HTTP/1.1 404 Not Found\r\n"
+        "Content-Type: text/html\r\n"
+        "Content-Length: 19\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n");
+    assert_string_equal(res->body, "<h1>Not Found</h1>\n");
+    assert_int_equal(res->body_len, 19);
+    out = send_response(res);
+    assert_string_equal(out + res->header_len, "<h1>Not Found</h1>\n");
+    free(out);
+    br_response_free(res);
+
+    res = handle(NULL, "GET /../../../../../etc/passwd HTTP/1.1\r\n\r\n", true);
+    assert_int_equal(res->status_code, 404);
+    br_response_free(res);
+
+    res = handle(NULL, "POST / HTTP/1.1\r\n\r\n", true);
+    assert_int_equal(res->status_code, 405);
+    assert_non_null(strstr(res->header, "Allow: GET, HEAD\r\n"));
+    br_response_free(res);
+
+    res = handle(NULL, "HEAD /baz HTTP/1.1\r\n\r\n", true);
+    assert_int_equal(res->status_code, 404);
+    assert_non_null(strstr(res->header, "Content-Length: 19\r\n"));
+    assert_null(res->body);
+    assert_int_equal(res->body_len, 0);
+    br_response_free(res);
+
+    // big files are sent straight from the file
+    char *big = bc_malloc(BR_CACHE_MAX_FILE_SIZE + 2);
+    memset(big, 'a', BR_CACHE_MAX_FILE_SIZE + 1);
+    big[BR_CACHE_MAX_FILE_SIZE + 1] = '\0';
+    create_file("big.txt", big);
+    res = handle(NULL, "GET /big.txt HTTP/1.1\r\n\r\n", true);
+    assert_int_equal(res->status_code, 200);
+    assert_non_null(strstr(res->header, "Content-Type: text/plain\r\n"));
+    assert_null(res->body);
+    assert_int_not_equal(res->fd, -1);
+    assert_int_equal(res->body_len, BR_CACHE_MAX_FILE_SIZE + 1);
+    out = send_response(res);
+    assert_string_equal(out + res->header_len, big);
+    free(out);
+    br_response_free(res);
+    free(big);
+
+    remove_path("big.txt", false);
+    remove_path("foo/index.html", false);
+    remove_path("foo", true);
+    remove_path("bar", true);
+    remove_path("style.css", false);
+    remove_path("index.html", false);
+    rmdir(docroot);
+}
+
+
+static void
+test_request_handle_cache(void **state)
+{
+    strcpy(docroot, "/tmp/check_request_XXXXXX");
+    assert_non_null(mkdtemp(docroot));
+    create_file("index.html", "<h1>bola</h1>\n");
+    create_dir("foo");
+    create_file("foo/index.html", "guda");
+    char *big = bc_malloc(BR_CACHE_MAX_FILE_SIZE + 2);
+    memset(big, 'a', BR_CACHE_MAX_FILE_SIZE + 1);
+    big[BR_CACHE_MAX_FILE_SIZE + 1] = '\0';
+    create_file("big.txt", big);
+    free(big);
+
+    br_cache_t *cache = br_cache_new(10, BR_CACHE_MAX_SIZE);
+    indexes = br_cache_new(10, BR_CACHE_MAX_SIZE);
+    br_cache_link(cache, indexes);
+
+    br_response_t *res = handle(cache, "GET / HTTP/1.1\r\n\r\n", true);
+    assert_int_equal(res->status_code, 200);
+    assert_non_null(res->entry);
+    assert_true(res->body == res->entry->data);
+    br_cache_entry_t *entry = res->entry;
+    br_response_free(res);
+    assert_int_equal(br_cache_size(cache), 1);
+    assert_int_equal(br_cache_size(indexes), 1);
+
+    res = handle(cache, "GET /?bola HTTP/1.1\r\n\r\n", true);
+    assert_int_equal(res->status_code, 200);
+    assert_true(res->entry == entry);
+    assert_string_equal(res->body, "<h1>bola</h1>\n");
+    br_response_free(res);
+
+    res = handle(cache, "GET /foo HTTP/1.1\r\n\r\n", true);
+    assert_int_equal(res->status_code, 302);
+    assert_non_null(strstr(res->header, "Location: /foo/\r\n"));
+    br_response_free(res);
+    res = handle(cache, "GET /foo HTTP/1.1\r\n\r\n", false);
+    assert_int_equal(res->status_code, 302);
+    assert_non_null(strstr(res->header, "Location: /foo/\r\n"));
+    br_response_free(res);
+    assert_int_equal(br_cache_size(cache), 2);
+    assert_int_equal(br_cache_size(indexes), 2);
+
+    // same directory, the index is found in the index cache
+    res = handle(cache, "GET /foo/ HTTP/1.1\r\n\r\n", true);
+    assert_int_equal(res->status_code, 200);
+    assert_string_equal(res->body, "guda");
+    br_response_free(res);
+    assert_int_equal(br_cache_size(cache), 3);
+    assert_int_equal(br_cache_size(indexes), 2);
+
+    // a new index in the directory, as notified by the watcher
+    remove_path("foo/index.html", false);
+    create_file("foo/index.txt", "chunda");
+    char *real_root = realpath(docroot, NULL);
+    char *changed = bc_strdup_printf("%s/foo/index.txt", real_root);
+    br_cache_invalidate(cache, changed);
+    free(changed);
+    free(real_root);
+    assert_int_equal(br_cache_size(cache), 1);
+    assert_int_equal(br_cache_size(indexes), 1);
+    res = handle(cache, "GET /foo/ HTTP/1.1\r\n\r\n", true);
+    assert_int_equal(res->status_code, 200);
+    assert_string_equal(res->body, "chunda");
+    br_response_free(res);
+    assert_int_equal(br_cache_size(cache), 2);
+    assert_int_equal(br_cache_size(indexes), 2);
+
+    // errors aren't cached
+    res = handle(cache, "GET /baz HTTP/1.1\r\n\r\n", true);
+    assert_int_equal(res->status_code, 404);
+    br_response_free(res);
+    assert_int_equal(br_cache_size(cache), 2);
+
+    res = handle(cache, "GET /big.txt HTTP/1.1\r\n\r\n", true);
+    assert_int_equal(res->status_code, 200);
+    assert_null(res->body);
+    assert_int_not_equal(res->fd, -1);
+    br_response_free(res);
+    assert_int_equal(br_cache_size(cache), 3);
+
+    res = handle(cache, "GET /big.txt HTTP/1.1\r\n\r\n", true);
+    assert_int_equal(res->status_code, 200);
+    assert_int_not_equal(res->fd, -1);
+    assert_int_equal(res->body_len, BR_CACHE_MAX_FILE_SIZE + 1);
+    br_response_free(res);
+
+    // removed before the cache was told about it
+    remove_path("big.txt", false);
+    res = handle(cache, "GET /big.txt HTTP/1.1\r\n\r\n", true);
+    assert_int_equal(res->status_code, 404);
+    br_response_free(res);
+    assert_int_equal(br_cache_size(cache), 2);
+
+    create_file("index.html", "<h1>guda</h1>\n");
+    br_cache_invalidate(cache, NULL);
+    assert_int_equal(br_cache_size(indexes), 0);
+    res = handle(cache, "GET / HTTP/1.1\r\n\r\n", true);
+    assert_int_equal(res->status_code, 200);
+    assert_string_equal(res->body, "<h1>guda</h1>\n");
+    br_response_free(res);
+
+    br_cache_free(cache);
+    br_cache_free(indexes);
+    indexes = NULL;
+    remove_path("foo/index.txt", false);
+    remove_path("foo", true);
+    remove_path("index.html", false);
+    rmdir(docroot);
+}
+
+
+static br_response_t*
+handle_with(const char *target, const char *header, const char *value)
+{
+    char *req = bc_strdup_printf("GET %s HTTP/1.1\r\n%s: %s\r\n\r\n", target,
+        header, value);
+    br_response_t *rv = handle(NULL, req, true);
+    free(req);
+    return rv;
+}
+
+
+static void
+test_request_handle_conditional(void **state)
+{
+    strcpy(docroot, "/tmp/check_request_XXXXXX");
+    assert_non_null(mkdtemp(docroot));
+    create_file("index.html", "<h1>bola</h1>\n");
+    char *etag = set_mtime("index.html", 784111777);
+
+    br_response_t *res = handle_with("/", "If-None-Match", etag);
+    assert_int_equal(res->status_code, 304);
+    char *header = bc_strdup_printf(
+        "HTTP/1.1 304 Not Modified\r\n"
+        "ETag: %s\r\n"
+        "Last-Modified: Sun, 06 Nov 1994 08:49:37 GMT\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n", etag);
+    assert_string_equal(res->header, header);
+    assert_null(res->body);
+    assert_int_equal(res->fd, -1);
+    assert_int_equal(res->body_len, 0);
+    br_response_free(res);
+    free(header);
+
+    char *list = bc_strdup_printf("\"bola\", W/%s", etag);
+    res = handle_with("/", "If-None-Match", list);
+    assert_int_equal(res->status_code, 304);
+    br_response_free(res);
+    free(list);
+
+    res = handle_with("/", "If-None-Match", "*");
+    assert_int_equal(res->status_code, 304);
+    br_response_free(res);
+
+    res = handle_with("/", "If-None-Match", "\"bola\"");
+    assert_int_equal(res->status_code, 200);
+    br_response_free(res);
+
+    res = handle_with("/", "If-Modified-Since",
+        "Sun, 06 Nov 1994 08:49:37 GMT");
+    assert_int_equal(res->status_code, 304);
+    br_response_free(res);
+
+    res = handle_with("/", "If-Modified-Since",
+        "Sun, 06 Nov 1994 08:49:36 GMT");
+    assert_int_equal(res->status_code, 200);
+    br_response_free(res);
+
+    res = handle_with("/", "If-Modified-Since", "bola");
+    assert_int_equal(res->status_code, 200);
+    br_response_free(res);
+
+    // If-None-Match wins
+    res = handle(NULL, "GET / HTTP/1.1\r\n"
+        "If-None-Match: \"bola\"\r\n"
+        "If-Modified-Since: Sun, 06 Nov 1994 08:49:37 GMT\r\n"
+        "\r\n", true);
+    assert_int_equal(res->status_code, 200);
+    br_response_free(res);
+
+    // the etag changes with the file
+    create_file("index.html", "<h1>guda</h1>\n");
+    char *etag2 = set_mtime("index.html", 784111778);
+    assert_string_not_equal(etag, etag2);
+    res = handle_with("/", "If-None-Match", etag);
+    assert_int_equal(res->status_code, 200);
+    br_response_free(res);
+    free(etag2);
+
+    free(etag);
+    remove_path("index.html", false);
+    rmdir(docroot);
+}
+
+
+static void
+test_request_handle_range(void **state)
+{
+    strcpy(docroot, "/tmp/check_request_XXXXXX");
+    assert_non_null(mkdtemp(docroot));
+    create_file("index.html", "0123456789");
+    char *etag = set_mtime("index.html", 784111777);
+    char *big = bc_malloc(BR_CACHE_MAX_FILE_SIZE + 2);
+    for (size_t i = 0; i < BR_CACHE_MAX_FILE_SIZE + 1; i++)
+        big[i] = 'a' + i % 26;
+    big[BR_CACHE_MAX_FILE_SIZE + 1] = '\0';
+    create_file("big.txt", big);
+
+    const char *ranges[] = {
+        "bytes=0-3",
+        "bytes=2-",
+        "bytes=-3",
+        "bytes=5-100",
+        "bytes=-100",
+        "bytes=9-9",
+    };
+    const char *expected[] = {"0123", "23456789", "789", "56789", "0123456789",
+        "9"};
+    const char *content_range[] = {"0-3/10", "2-9/10", "7-9/10", "5-9/10",
+        "0-9/10", "9-9/10"};
+
+    for (size_t i = 0; i < sizeof(ranges) / sizeof(ranges[0]); i++) {
+        br_response_t *res = handle_with("/", "Range", ranges[i]);
+        assert_int_equal(res->status_code, 206);
+        char *h = bc_strdup_printf("Content-Range: bytes %s\r\n",
+            content_range[i]);
+        assert_non_null(strstr(res->header, h));
+        free(h);
+        assert_int_equal(res->body_len, strlen(expected[i]));
+        char *out = send_response(res);
+        assert_string_equal(out + res->header_len, expected[i]);
+        free(out);
+        br_response_free(res);
+    }
+
+    // ignored
+    const char *ignored[] = {"bytes=0-1,3-4", "bytes=3-1", "bytes=a-", "bola",
+        "bytes=-", "bytes=1"};
+    for (size_t i = 0; i < sizeof(ignored) / sizeof(ignored[0]); i++) {
+        br_response_t *res = handle_with("/", "Range", ignored[i]);
+        assert_int_equal(res->status_code, 200);
+        assert_int_equal(res->body_len, 10);
+        br_response_free(res);
+    }
+
+    br_response_t *res = handle_with("/", "Range", "bytes=10-");
+    assert_int_equal(res->status_code, 416);
+    assert_non_null(strstr(res->header, "Content-Range: bytes */10\r\n"));
+    br_response_free(res);
+
+    res = handle_with("/", "Range", "bytes=-0");
+    assert_int_equal(res->status_code, 416);
+    br_response_free(res);
+
+    char *req = bc_strdup_printf("GET / HTTP/1.1\r\nRange: bytes=1-2\r\n"
+        "If-Range: %s\r\n\r\n", etag);
+    res = handle(NULL, req, true);
+    assert_int_equal(res->status_code, 206);
+    br_response_free(res);
+    free(req);
+
+    res = handle(NULL, "GET / HTTP/1.1\r\nRange: bytes=1-2\r\n"
+        "If-Range: Sun, 06 Nov 1994 08:49:37 GMT\r\n\r\n", true);
+    assert_int_equal(res->status_code, 206);
+    br_response_free(res);
+
+    res = handle(NULL, "GET / HTTP/1.1\r\nRange: bytes=1-2\r\n"
+        "If-Range: \"bola\"\r\n\r\n", true);
+    assert_int_equal(res->status_code, 200);
+    br_response_free(res);
+
+    res = handle(NULL, "HEAD / HTTP/1.1\r\nRange: bytes=1-2\r\n\r\n", true);
+    assert_int_equal(res->status_code, 200);
+    assert_non_null(strstr(res->header, "Content-Length: 10\r\n"));
+    br_response_free(res);
+
+    // ranges of big files are sent from the file
+    res = handle_with("/big.txt", "Range", "bytes=65530-65535");
+    assert_int_equal(res->status_code, 206);
+    assert_int_not_equal(res->fd, -1);
+    assert_int_equal(res->offset, 65530);
+    assert_int_equal(res->body_len, 6);
+    char *out = send_response(res);
+    assert_memory_equal(out + res->header_len, big + 65530, 6);
+    assert_int_equal(strlen(out), res->header_len + 6);
+    free(out);
+    br_response_free(res);
+
+    free(big);
+    free(etag);
+    remove_path("big.txt", false);
+    remove_path("index.html", false);
+    rmdir(docroot);
+}
+
+
+static void
+test_request_handle_compress(void **state)
+{
+    strcpy(docroot, "/tmp/check_request_XXXXXX");
+    assert_non_null(mkdtemp(docroot));
+    bc_string_t *html = bc_string_new();
+    for (size_t i = 0; i < 100; i++)
+        bc_string_append_printf(html, "<p>bola %zu</p>\n", i);
+    create_file("index.html", html->str);
+    create_file("small.css", "body{}");
+    create_file("style.css", html->str);
+    create_file("style.css.gz", "not really gzip");
+    create_file("image.png", html->str);
+
+    // small files and other types are never compressed
+    br_response_t *res = handle_with("/small.css", "Accept-Encoding", "gzip");
+    assert_int_equal(res->status_code, 200);
+    assert_null(strstr(res->header, "Content-Encoding"));
+    assert_null(strstr(res->header, "Vary"));
+    br_response_free(res);
+    res = handle_with("/image.png", "Accept-Encoding", "gzip");
+    assert_null(strstr(res->header, "Content-Encoding"));
+    assert_null(strstr(res->header, "Vary"));
+    br_response_free(res);
+
+    // prebuilt files win, even without zlib
+    res = handle_with("/style.css", "Accept-Encoding", "gzip, deflate");
+    assert_int_equal(res->status_code, 200);
+    assert_non_null(strstr(res->header, "Content-Type: text/css\r\n"));
+    assert_non_null(strstr(res->header, "Content-Encoding: gzip\r\n"));
+    assert_non_null(strstr(res->header, "Vary: Accept-Encoding\r\n"));
+    assert_non_null(strstr(res->header, "-gzip\"\r\n"));
+    char *out = send_response(res);
+    assert_string_equal(out + res->header_len, "not really gzip");
+    free(out);
+    br_response_free(res);
+
+    res = handle_with("/style.css", "Accept-Encoding", "identity");
+    assert_null(strstr(res->header, "Content-Encoding"));
+    assert_non_null(strstr(res->header, "Vary: Accept-Encoding\r\n"));
+    assert_int_equal(res->body_len, html->len);
+    br_response_free(res);
+
+    // ranges are served from the uncompressed file
+    res = handle(NULL, "GET /index.html HTTP/1.1\r\n"
+        "Accept-Encoding: gzip\r\n"
+        "Range: bytes=0-2\r\n"
+        "\r\n", true);
+    assert_int_equal(res->status_code, 206);
+    assert_null(strstr(res->header, "Content-Encoding"));
+    br_response_free(res);
+
+#ifdef HAVE_ZLIB
+    compressed = br_cache_new(10, 1024 * 1024);
+    const char *encodings[] = {"gzip", "deflate"};
+    for (size_t i = 0; i < 2; i++) {
+        res = handle_with("/", "Accept-Encoding", encodings[i]);
+        assert_int_equal(res->status_code, 200);
+        char *h = bc_strdup_printf("Content-Encoding: %s\r\n", encodings[i]);
+        assert_non_null(strstr(res->header, h));
+        free(h);
+        assert_true(res->body_len < html->len);
+        br_cache_entry_t *entry = res->entry;
+
+        char *back = bc_malloc(html->len + 1);
+        uLongf back_len = html->len;
+        z_stream strm;
+        strm.zalloc = Z_NULL;
+        strm.zfree = Z_NULL;
+        strm.opaque = Z_NULL;
+        strm.next_in = (Bytef*) res->body;
+        strm.avail_in = res->body_len;
+        strm.next_out = (Bytef*) back;
+        strm.avail_out = back_len;
+        assert_int_equal(inflateInit2(&strm, i == 0 ? 16 + MAX_WBITS :
+            MAX_WBITS), Z_OK);
+        assert_int_equal(inflate(&strm, Z_FINISH), Z_STREAM_END);
+        assert_int_equal(strm.total_out, html->len);
+        inflateEnd(&strm);
+        assert_memory_equal(back, html->str, html->len);
+        free(back);
+        br_response_free(res);
+
+        // compressed only once
+        res = handle_with("/", "Accept-Encoding", encodings[i]);
+        assert_true(res->entry == entry);
+        br_response_free(res);
+    }
+    assert_int_equal(br_cache_size(compressed), 2);
+
+    // the compressed version has its own etag
+    res = handle_with("/", "Accept-Encoding", "gzip");
+    const char *e = strstr(res->header, "ETag: ") + 6;
+    char *etag = bc_strndup(e, strstr(e, "\r\n") - e);
+    assert_true(bc_str_ends_with(etag, "-gzip\""));
+    br_response_free(res);
+    res = handle(NULL, "GET / HTTP/1.1\r\n"
+        "Accept-Encoding: gzip\r\n"
+        "If-None-Match: \"bola\"\r\n"
+        "\r\n", true);
+    assert_int_equal(res->status_code, 200);
+    br_response_free(res);
+    char *req = bc_strdup_printf("GET / HTTP/1.1\r\nAccept-Encoding: gzip\r\n"
+        "If-None-Match: %s\r\n\r\n", etag);
+    res = handle(NULL, req, true);
+    assert_int_equal(res->status_code, 304);
+    assert_non_null(strstr(res->header, "Vary: Accept-Encoding\r\n"));
+    br_response_free(res);
+    free(req);
+    free(etag);
+
+    br_cache_free(compressed);
+    compressed = NULL;
+#endif /* HAVE_ZLIB */
+
+    bc_string_free(html, true);
+    remove_path("image.png", false);
+    remove_path("style.css.gz", false);
+    remove_path("style.css", false);
+    remove_path("small.css", false);
+    remove_path("index.html", false);
+    rmdir(docroot);
+}
+
+
+static void
+test_request_handle_stats(void **state)
+{
+    strcpy(docroot, "/tmp/check_request_XXXXXX");
+    assert_non_null(mkdtemp(docroot));
+    create_file("index.html", "<h1>bola</h1>\n");
+
+    // disabled by default
+    br_response_t *res = handle(NULL, "GET /__blogc/stats HTTP/1.1\r\n\r\n",
+        true);
+    assert_int_equal(res->status_code, 404);
+    assert_int_equal(res->lookup, BR_LOOKUP_MISS);
+    br_response_free(res);
+
+    stats = br_stats_new(1);
+    res = handle(NULL, "GET /__blogc/stats HTTP/1.1\r\n\r\n", true);
+    assert_int_equal(res->status_code, 200);
+    assert_int_equal(res->lookup, BR_LOOKUP_NONE);
+    assert_non_null(strstr(res->header,
+        "Content-Type: text/plain; charset=utf-8\r\n"
+        "Cache-Control: no-store\r\n"));
+    assert_true(0 == strncmp(res->body, "uptime: ", 8));
+    assert_int_equal(res->body_len, strlen(res->body));
+    br_response_free(res);
+
+    res = handle(NULL, "HEAD /__blogc/stats?bola HTTP/1.1\r\n\r\n", true);
+    assert_int_equal(res->status_code, 200);
+    assert_null(res->body);
+    assert_int_equal(res->body_len, 0);
+    br_response_free(res);
+
+    res = handle(NULL, "GET /__blogc/statsx HTTP/1.1\r\n\r\n", true);
+    assert_int_equal(res->status_code, 404);
+    br_response_free(res);
+
+    res = handle(NULL, "GET / HTTP/1.1\r\n\r\n", true);
+    assert_int_equal(res->status_code, 200);
+    assert_int_equal(res->lookup, BR_LOOKUP_MISS);
+    br_response_free(res);
+
+    br_stats_free(stats);
+    stats = NULL;
+    remove_path("index.html", false);
+    rmdir(docroot);
+}
+
+
+static void
+test_response_error(void **state)
+{
+    br_response_t *res = br_response_error(431, false);
+    assert_int_equal(res->status_code, 431);
+    assert_false(res->keep_alive);
+    assert_string_equal(res->header,
+        "HTTP/1.1 431 Request Header Fields Too Large\r\n"
+        "Content-Type: text/html\r\n"
+        "Content-Length: 41\r\n"
+        "Connection: close\r\n"
+        "\r\n");
+    assert_int_equal(res->header_len, strlen(res->header));
+    assert_string_equal(res->body, "<h1>Request Header Fields Too Large</h1>\n");
+    assert_int_equal(res->body_len, 41);
+    assert_int_equal(res->fd, -1);
+    br_response_free(res);
+}
+
+
+int
+main(void)
+{
+    const UnitTest tests[] = {
+        unit_test(test_request_handle),
+        unit_test(test_request_handle_cache),
+        unit_test(test_request_handle_conditional),
+        unit_test(test_request_handle_range),
+        unit_test(test_request_handle_compress),
+        unit_test(test_request_handle_stats),
+        unit_test(test_response_error),
+    };
+    return run_tests(tests);
+}
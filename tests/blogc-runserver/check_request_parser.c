@@ -0,0 +1,196 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../src/common/utils.h"
+#include "../../src/blogc-runserver/request-parser.h"
+
+
+static void
+test_request_parser(void **state)
+{
+    const char *req =
+        "GET /bola?guda=1 HTTP/1.1\r\n"
+        "Host: localhost:8080\r\n"
+        "User-Agent:   chunda/1.0  \r\n"
+        "Accept: text/html\r\n"
+        "ACCEPT: */*\r\n"
+        "\r\n";
+    br_request_parser_t *parser = br_request_parser_new();
+    assert_int_equal(br_request_parser_parse(parser, req, strlen(req)),
+        strlen(req));
+    assert_int_equal(parser->state, BR_REQUEST_PARSER_DONE);
+    assert_string_equal(parser->request.line, "GET /bola?guda=1 HTTP/1.1");
+    assert_string_equal(parser->request.method, "GET");
+    assert_string_equal(parser->request.target, "/bola?guda=1");
+    assert_string_equal(parser->request.version, "HTTP/1.1");
+    assert_true(parser->request.keep_alive);
+    assert_int_equal(bc_hashmap_size(parser->request.headers), 3);
+    assert_string_equal(br_request_get_header(&(parser->request), "host"),
+        "localhost:8080");
+    assert_string_equal(br_request_get_header(&(parser->request),
+        "user-agent"), "chunda/1.0");
+    assert_string_equal(br_request_get_header(&(parser->request), "accept"),
+        "text/html, */*");
+    assert_null(br_request_get_header(&(parser->request), "Host"));
+    assert_null(br_request_get_header(&(parser->request), "cookie"));
+
+    // parser is done, nothing else is consumed until reset
+    assert_int_equal(br_request_parser_parse(parser, req, strlen(req)), 0);
+
+    br_request_parser_reset(parser);
+    assert_int_equal(parser->state, BR_REQUEST_PARSER_START);
+    assert_null(parser->request.line);
+    assert_null(parser->request.headers);
+    assert_null(br_request_get_header(&(parser->request), "host"));
+
+    // byte by byte, and bare newlines
+    req =
+        "\r\n"
+        "\n"
+        "GET / HTTP/1.0\n"
+        "Connection: Keep-Alive\n"
+        "\n";
+    for (size_t i = 0; i < strlen(req); i++) {
+        assert_int_equal(parser->state, i < 18 ? BR_REQUEST_PARSER_START :
+            BR_REQUEST_PARSER_HEADERS);
+        assert_int_equal(br_request_parser_parse(parser, req + i, 1), 1);
+    }
+    assert_int_equal(parser->state, BR_REQUEST_PARSER_DONE);
+    assert_string_equal(parser->request.line, "GET / HTTP/1.0");
+    assert_true(parser->request.keep_alive);
+    br_request_parser_free(parser);
+}
+
+
+static void
+test_request_parser_keep_alive(void **state)
+{
+    const char *reqs[] = {
+        "GET / HTTP/1.1\r\n\r\n",
+        "GET / HTTP/1.0\r\n\r\n",
+        "GET / HTTP/1.1\r\nConnection: close\r\n\r\n",
+        "GET / HTTP/1.1\r\nConnection: upgrade, CLOSE\r\n\r\n",
+        "GET / HTTP/1.0\r\nConnection: keep-alive\r\n\r\n",
+        "GET / HTTP/1.1\r\nContent-Length: 0\r\n\r\n",
+        "POST / HTTP/1.1\r\nContent-Length: 4\r\n\r\n",
+        "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n",
+    };
+    bool expected[] = {true, false, false, false, true, true, false, false};
+
+    br_request_parser_t *parser = br_request_parser_new();
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+        br_request_parser_parse(parser, reqs[i], strlen(reqs[i]));
+        assert_int_equal(parser->state, BR_REQUEST_PARSER_DONE);
+        assert_int_equal(parser->request.keep_alive, expected[i]);
+        br_request_parser_reset(parser);
+    }
+    br_request_parser_free(parser);
+}
+
+
+static void
+test_request_parser_pipelining(void **state)
+{
+    const char *req =
+        "GET /foo HTTP/1.1\r\n"
+        "Host: localhost\r\n"
+        "\r\n"
+        "GET /bar HTTP/1.1\r\n"
+        "Host: localhost\r\n"
+        "\r\n"
+        "GET /baz HTTP/1.1\r\n";
+    size_t len = strlen(req);
+    br_request_parser_t *parser = br_request_parser_new();
+
+    size_t n = br_request_parser_parse(parser, req, len);
+    assert_int_equal(n, 38);
+    assert_int_equal(parser->state, BR_REQUEST_PARSER_DONE);
+    assert_string_equal(parser->request.target, "/foo");
+    br_request_parser_reset(parser);
+
+    n += br_request_parser_parse(parser, req + n, len - n);
+    assert_int_equal(n, 76);
+    assert_int_equal(parser->state, BR_REQUEST_PARSER_DONE);
+    assert_string_equal(parser->request.target, "/bar");
+    br_request_parser_reset(parser);
+
+    n += br_request_parser_parse(parser, req + n, len - n);
+    assert_int_equal(n, len);
+    assert_int_equal(parser->state, BR_REQUEST_PARSER_HEADERS);
+    assert_string_equal(parser->request.target, "/baz");
+    assert_int_equal(br_request_parser_parse(parser, "\r\n", 2), 2);
+    assert_int_equal(parser->state, BR_REQUEST_PARSER_DONE);
+    br_request_parser_free(parser);
+}
+
+
+static void
+test_request_parser_error(void **state)
+{
+    const char *reqs[] = {
+        "GET /\r\n\r\n",
+        "GET / bola\r\n\r\n",
+        "GET  HTTP/1.1\r\n\r\n",
+        "GET / HTTP/2.0\r\n\r\n",
+        "GET / HTTP/1.1\r\nHost\r\n\r\n",
+        "GET / HTTP/1.1\r\n: bola\r\n\r\n",
+        "GET / HTTP/1.1\r\nHo st: bola\r\n\r\n",
+        "GET / HTTP/1.1\r\nHost: bola\r\n guda\r\n\r\n",
+    };
+    unsigned short expected[] = {400, 400, 400, 505, 400, 400, 400, 400};
+
+    br_request_parser_t *parser = br_request_parser_new();
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+        br_request_parser_parse(parser, reqs[i], strlen(reqs[i]));
+        assert_int_equal(parser->state, BR_REQUEST_PARSER_ERROR);
+        assert_int_equal(parser->error, expected[i]);
+        br_request_parser_reset(parser);
+    }
+
+    // the request line is still available for logging
+    br_request_parser_parse(parser, "GET /\r\n", 7);
+    assert_string_equal(parser->request.line, "GET /");
+    br_request_parser_reset(parser);
+
+    const char nul[] = "GET / HTTP/1.1\r\nHost: bo\0la\r\n\r\n";
+    br_request_parser_parse(parser, nul, sizeof(nul) - 1);
+    assert_int_equal(parser->state, BR_REQUEST_PARSER_ERROR);
+    assert_int_equal(parser->error, 400);
+    br_request_parser_reset(parser);
+
+    bc_string_t *big = bc_string_new();
+    bc_string_append(big, "GET / HTTP/1.1\r\n");
+    while (big->len <= BR_REQUEST_MAX_HEADER_SIZE)
+        bc_string_append(big, "X-Bola: guda\r\n");
+    bc_string_append(big, "\r\n");
+    br_request_parser_parse(parser, big->str, big->len);
+    assert_int_equal(parser->state, BR_REQUEST_PARSER_ERROR);
+    assert_int_equal(parser->error, 431);
+    bc_string_free(big, true);
+    br_request_parser_free(parser);
+}
+
+
+int
+main(void)
+{
+    const UnitTest tests[] = {
+        unit_test(test_request_parser),
+        unit_test(test_request_parser_keep_alive),
+        unit_test(test_request_parser_pipelining),
+        unit_test(test_request_parser_error),
+    };
+    return run_tests(tests);
+}
@@ -0,0 +1,119 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../src/blogc-runserver/request.h"
+#include "../../src/blogc-runserver/stats.h"
+
+
+static void
+test_stats_latency_bucket(void **state)
+{
+    assert_int_equal(br_stats_latency_bucket(-1), 0);
+    assert_int_equal(br_stats_latency_bucket(0), 0);
+    assert_int_equal(br_stats_latency_bucket(3), 3);
+    assert_int_equal(br_stats_latency_bucket(4), 4);
+    assert_int_equal(br_stats_latency_bucket(7), 7);
+    assert_int_equal(br_stats_latency_bucket(8), 8);
+    assert_int_equal(br_stats_latency_bucket(9), 8);
+    assert_int_equal(br_stats_latency_bucket(10), 9);
+    assert_int_equal(br_stats_latency_bucket(1000), 35);
+    assert_int_equal(br_stats_latency_bucket(1LL << 40),
+        BR_STATS_LATENCY_BUCKETS - 1);
+
+    // every latency is in the bucket that it is mapped to
+    for (long long i = 0; i < 100000; i++) {
+        size_t b = br_stats_latency_bucket(i);
+        assert_true(i <= br_stats_latency_bucket_max(b));
+        if (b > 0)
+            assert_true(i > br_stats_latency_bucket_max(b - 1));
+    }
+}
+
+
+static void
+request(br_stats_thread_t *t, unsigned short status, size_t sent,
+    br_lookup_t lookup, long long latency)
+{
+    br_response_t res = {
+        .status_code = status,
+        .sent = sent,
+        .lookup = lookup,
+    };
+    br_stats_request(t, &res, latency);
+}
+
+
+static void
+test_stats_format(void **state)
+{
+    br_stats_t *stats = br_stats_new(2);
+    assert_null(br_stats_thread(stats, 2));
+    assert_null(br_stats_thread(NULL, 0));
+    br_stats_thread_t *t1 = br_stats_thread(stats, 0);
+    br_stats_thread_t *t2 = br_stats_thread(stats, 1);
+    assert_non_null(t1);
+    assert_non_null(t2);
+
+    br_stats_connection(t1, 1);
+    br_stats_connection(t1, 1);
+    br_stats_connection(t2, 1);
+    br_stats_connection(t1, -1);
+    for (size_t i = 0; i < 90; i++)
+        request(t1, 200, 100, BR_LOOKUP_HIT, 10);
+    for (size_t i = 0; i < 8; i++)
+        request(t2, 404, 50, BR_LOOKUP_MISS, 100);
+    request(t2, 405, 50, BR_LOOKUP_NONE, 1000);
+    request(t2, 200, 100, BR_LOOKUP_MISS, 1000);
+    br_stats_busy(t1, 1000);
+
+    // NULL threads are ignored
+    br_stats_connection(NULL, 1);
+    request(NULL, 200, 100, BR_LOOKUP_HIT, 10);
+    br_stats_busy(NULL, 1000);
+
+    char *out = br_stats_format(stats);
+    assert_true(0 == strncmp(out, "uptime: ", 8));
+    assert_non_null(strstr(out,
+        "connections: 2\n"
+        "requests: 100\n"
+        "bytes: 9550\n"
+        "status 200: 91\n"
+        "status 404: 8\n"
+        "status 405: 1\n"
+        "cache hits: 90\n"
+        "cache misses: 9\n"
+        "cache hit ratio: 90.9%\n"
+        "latency p50: 0.000011\n"
+        "latency p90: 0.000011\n"
+        "latency p99: 0.001023\n"
+        "thread 1: "));
+    assert_non_null(strstr(out, "% busy, 90 requests, 1 connections\n"
+        "thread 2: "));
+    assert_non_null(strstr(out, "% busy, 10 requests, 1 connections\n"));
+    free(out);
+
+    br_stats_free(stats);
+    assert_null(br_stats_format(NULL));
+}
+
+
+int
+main(void)
+{
+    const UnitTest tests[] = {
+        unit_test(test_stats_latency_bucket),
+        unit_test(test_stats_format),
+    };
+    return run_tests(tests);
+}
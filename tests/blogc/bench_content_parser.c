@@ -0,0 +1,129 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+// micro-benchmark for the content parser, parsing a corpus of posts. the
+// posts are read from the files given as arguments, or generated to look
+// like a typical blog post. not run by `make check`, use
+// `make bench-content-parser`.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../../src/blogc/content-parser.h"
+#include "../../src/common/error.h"
+#include "../../src/common/file.h"
+#include "../../src/common/utils.h"
+
+#define ROUNDS 20
+#define GENERATED_POSTS 500
+
+static const char *blocks[] = {
+    "# Some *title* for the post\n",
+    "Lorem ipsum dolor sit amet, *consectetur* adipiscing elit, sed do\n"
+    "eiusmod tempor incididunt ut labore et dolore magna aliqua. Ut enim ad\n"
+    "minim veniam, quis nostrud [exercitation](http://example.org/) ullamco\n"
+    "laboris nisi ut aliquip ex ea commodo consequat -- duis aute irure.\n",
+    "## A section with `some code`\n",
+    "Duis aute irure dolor in **reprehenderit** in voluptate velit esse\n"
+    "cillum dolore eu fugiat nulla pariatur. Excepteur sint occaecat\n"
+    "cupidatat non proident, sunt in culpa qui officia deserunt mollit\n"
+    "anim id est laborum. ![an image](/images/foo.png)\n",
+    "- first item, with a [link][1]\n"
+    "- second item, with _emphasis_\n"
+    "- third item, with `code`\n"
+    "- fourth item\n",
+    "1. first step\n"
+    "2. second step, quite a bit longer than the first one, to wrap\n"
+    "   around in the source file\n"
+    "3. third step\n",
+    "> quoted text, that goes on\n"
+    "> for a couple of lines.\n",
+    "    int\n"
+    "    main(void)\n"
+    "    {\n"
+    "        return 0;\n"
+    "    }\n",
+    "..\n",
+    "[1]: http://example.org/some/link\n",
+};
+#define NUM_BLOCKS (sizeof(blocks) / sizeof(blocks[0]))
+
+
+static double
+now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static char*
+generate_post(size_t seed)
+{
+    bc_string_t *str = bc_string_new();
+    bc_string_append(str, blocks[0]);
+    for (size_t i = 0; i < 12 + seed % 8; i++) {
+        bc_string_append_c(str, '\n');
+        bc_string_append(str, blocks[1 + (i * 7 + seed) % (NUM_BLOCKS - 1)]);
+    }
+    return bc_string_free(str, false);
+}
+
+
+int
+main(int argc, char **argv)
+{
+    size_t num_posts = argc > 1 ? argc - 1 : GENERATED_POSTS;
+    char **posts = bc_malloc(num_posts * sizeof(char*));
+    size_t bytes = 0;
+
+    for (size_t i = 0; i < num_posts; i++) {
+        if (argc > 1) {
+            size_t len;
+            bc_error_t *err = NULL;
+            posts[i] = bc_file_get_contents(argv[i + 1], true, &len, &err);
+            if (err != NULL) {
+                bc_error_print(err, "bench_content_parser");
+                bc_error_free(err);
+                return 1;
+            }
+        }
+        else {
+            posts[i] = generate_post(i);
+        }
+        bytes += strlen(posts[i]);
+    }
+
+    size_t out = 0;
+    double t = now();
+    for (size_t r = 0; r < ROUNDS; r++) {
+        for (size_t i = 0; i < num_posts; i++) {
+            size_t end_excerpt;
+            char *first_header = NULL;
+            char *description = NULL;
+            char *html = blogc_content_parse(posts[i], &end_excerpt,
+                &first_header, &description);
+            out += strlen(html);
+            free(html);
+            free(first_header);
+            free(description);
+        }
+    }
+    t = now() - t;
+
+    printf("%zu posts, %zu bytes, %d rounds\n", num_posts, bytes, ROUNDS);
+    printf("%10.1f us/post %10.1f MB/s\n", t * 1e6 / (ROUNDS * num_posts),
+        ROUNDS * bytes / t / 1e6);
+
+    for (size_t i = 0; i < num_posts; i++)
+        free(posts[i]);
+    free(posts);
+    return out > 0 ? 0 : 1;
+}
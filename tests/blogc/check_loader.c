@@ -14,6 +14,7 @@
 #include <string.h>
 #include <stdio.h>
 #include "../../src/common/error.h"
+#include "../../src/common/file.h"
 #include "../../src/common/utils.h"
 #include "../../src/blogc/template-parser.h"
 #include "../../src/blogc/loader.h"
@@ -49,18 +50,23 @@ test_get_filename(void **state)
 }
 
 
-char*
-__wrap_bc_file_get_contents(const char *path, bool utf8, size_t *len, bc_error_t **err)
+bc_file_map_t*
+__wrap_bc_file_map(const char *path, bool utf8, bc_error_t **err)
 {
     assert_true(utf8);
     assert_null(*err);
     const char *_path = mock_type(const char*);
     if (_path != NULL)
         assert_string_equal(path, _path);
-    char *rv = mock_type(char*);
-    *len = 0;
-    if (rv != NULL)
-        *len = strlen(rv);
+    char *buffer = mock_type(char*);
+    if (buffer == NULL)
+        return NULL;
+    bc_file_map_t *rv = bc_malloc(sizeof(bc_file_map_t));
+    rv->str = buffer;
+    rv->len = strlen(buffer);
+    rv->map = NULL;
+    rv->map_len = 0;
+    rv->buffer = buffer;
     return rv;
 }
 
@@ -69,9 +75,9 @@ static void
 test_template_parse_from_file(void **state)
 {
     bc_error_t *err = NULL;
-    will_return(__wrap_bc_file_get_contents, "bola");
-    will_return(__wrap_bc_file_get_contents, bc_strdup("{{ BOLA }}\n"));
-    bc_slist_t *l = blogc_template_parse_from_file("bola", &err);
+    will_return(__wrap_bc_file_map, "bola");
+    will_return(__wrap_bc_file_map, bc_strdup("{{ BOLA }}\n"));
+    bc_slist_t *l = blogc_template_parse_from_file("bola", NULL, true, &err);
     assert_null(err);
     assert_non_null(l);
     assert_int_equal(bc_slist_length(l), 2);
@@ -83,9 +89,9 @@ static void
 test_template_parse_from_file_null(void **state)
 {
     bc_error_t *err = NULL;
-    will_return(__wrap_bc_file_get_contents, "bola");
-    will_return(__wrap_bc_file_get_contents, NULL);
-    bc_slist_t *l = blogc_template_parse_from_file("bola", &err);
+    will_return(__wrap_bc_file_map, "bola");
+    will_return(__wrap_bc_file_map, NULL);
+    bc_slist_t *l = blogc_template_parse_from_file("bola", NULL, true, &err);
     assert_null(err);
     assert_null(l);
 }
@@ -95,22 +101,22 @@ static void
 test_source_parse_from_file(void **state)
 {
     bc_error_t *err = NULL;
-    will_return(__wrap_bc_file_get_contents, "bola.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 123\n"
         "--------\n"
         "bola"));
-    bc_trie_t *t = blogc_source_parse_from_file("bola.txt", &err);
+    bc_hashmap_t *t = blogc_source_parse_from_file("bola.txt", true, &err);
     assert_null(err);
     assert_non_null(t);
-    assert_int_equal(bc_trie_size(t), 6);
-    assert_string_equal(bc_trie_lookup(t, "ASD"), "123");
-    assert_string_equal(bc_trie_lookup(t, "FILENAME"), "bola");
-    assert_string_equal(bc_trie_lookup(t, "EXCERPT"), "<p>bola</p>\n");
-    assert_string_equal(bc_trie_lookup(t, "CONTENT"), "<p>bola</p>\n");
-    assert_string_equal(bc_trie_lookup(t, "RAW_CONTENT"), "bola");
-    assert_string_equal(bc_trie_lookup(t, "DESCRIPTION"), "bola");
-    bc_trie_free(t);
+    assert_int_equal(bc_hashmap_size(t), 6);
+    assert_string_equal(bc_hashmap_lookup(t, "ASD"), "123");
+    assert_string_equal(bc_hashmap_lookup(t, "FILENAME"), "bola");
+    assert_string_equal(bc_hashmap_lookup(t, "EXCERPT"), "<p>bola</p>\n");
+    assert_string_equal(bc_hashmap_lookup(t, "CONTENT"), "<p>bola</p>\n");
+    assert_string_equal(bc_hashmap_lookup(t, "RAW_CONTENT"), "bola");
+    assert_string_equal(bc_hashmap_lookup(t, "DESCRIPTION"), "bola");
+    bc_hashmap_free(t);
 }
 
 
@@ -118,9 +124,9 @@ static void
 test_source_parse_from_file_null(void **state)
 {
     bc_error_t *err = NULL;
-    will_return(__wrap_bc_file_get_contents, "bola.txt");
-    will_return(__wrap_bc_file_get_contents, NULL);
-    bc_trie_t *t = blogc_source_parse_from_file("bola.txt", &err);
+    will_return(__wrap_bc_file_map, "bola.txt");
+    will_return(__wrap_bc_file_map, NULL);
+    bc_hashmap_t *t = blogc_source_parse_from_file("bola.txt", true, &err);
     assert_null(err);
     assert_null(t);
 }
@@ -129,20 +135,20 @@ test_source_parse_from_file_null(void **state)
 static void
 test_source_parse_from_files(void **state)
 {
-    will_return(__wrap_bc_file_get_contents, "bola1.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola1.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 123\n"
         "DATE: 2001-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola2.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola2.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 456\n"
         "DATE: 2002-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola3.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola3.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 789\n"
         "DATE: 2003-02-03 04:05:06\n"
         "--------\n"
@@ -152,40 +158,40 @@ test_source_parse_from_files(void **state)
     s = bc_slist_append(s, bc_strdup("bola1.txt"));
     s = bc_slist_append(s, bc_strdup("bola2.txt"));
     s = bc_slist_append(s, bc_strdup("bola3.txt"));
-    bc_trie_t *c = bc_trie_new(free);
+    bc_hashmap_t *c = bc_hashmap_new(free);
     bc_slist_t *t = blogc_source_parse_from_files(c, s, &err);
     assert_null(err);
     assert_non_null(t);
     assert_int_equal(bc_slist_length(t), 3);  // it is enough, no need to look at the items
-    assert_int_equal(bc_trie_size(c), 4);
-    assert_string_equal(bc_trie_lookup(c, "FILENAME_FIRST"), "bola1");
-    assert_string_equal(bc_trie_lookup(c, "FILENAME_LAST"), "bola3");
-    assert_string_equal(bc_trie_lookup(c, "DATE_FIRST"), "2001-02-03 04:05:06");
-    assert_string_equal(bc_trie_lookup(c, "DATE_LAST"), "2003-02-03 04:05:06");
-    bc_trie_free(c);
+    assert_int_equal(bc_hashmap_size(c), 4);
+    assert_string_equal(bc_hashmap_lookup(c, "FILENAME_FIRST"), "bola1");
+    assert_string_equal(bc_hashmap_lookup(c, "FILENAME_LAST"), "bola3");
+    assert_string_equal(bc_hashmap_lookup(c, "DATE_FIRST"), "2001-02-03 04:05:06");
+    assert_string_equal(bc_hashmap_lookup(c, "DATE_LAST"), "2003-02-03 04:05:06");
+    bc_hashmap_free(c);
     bc_slist_free_full(s, free);
-    bc_slist_free_full(t, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(t, (bc_free_func_t) bc_hashmap_free);
 }
 
 
 static void
 test_source_parse_from_files_filter_reverse(void **state)
 {
-    will_return(__wrap_bc_file_get_contents, "bola3.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola3.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 789\n"
         "DATE: 2003-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola2.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola2.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 456\n"
         "DATE: 2002-02-03 04:05:06\n"
         "TAGS: bola, chunda\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola1.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola1.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 123\n"
         "DATE: 2001-02-03 04:05:06\n"
         "TAGS: chunda\n"
@@ -196,43 +202,43 @@ test_source_parse_from_files_filter_reverse(void **state)
     s = bc_slist_append(s, bc_strdup("bola1.txt"));
     s = bc_slist_append(s, bc_strdup("bola2.txt"));
     s = bc_slist_append(s, bc_strdup("bola3.txt"));
-    bc_trie_t *c = bc_trie_new(free);
-    bc_trie_insert(c, "FILTER_REVERSE", bc_strdup(""));
+    bc_hashmap_t *c = bc_hashmap_new(free);
+    bc_hashmap_insert(c, "FILTER_REVERSE", bc_strdup(""));
     bc_slist_t *t = blogc_source_parse_from_files(c, s, &err);
     assert_null(err);
     assert_non_null(t);
     assert_int_equal(bc_slist_length(t), 3);  // it is enough, no need to look at the items
-    assert_int_equal(bc_trie_size(c), 5);
-    assert_string_equal(bc_trie_lookup(c, "FILENAME_FIRST"), "bola3");
-    assert_string_equal(bc_trie_lookup(c, "FILENAME_LAST"), "bola1");
-    assert_string_equal(bc_trie_lookup(c, "DATE_FIRST"), "2003-02-03 04:05:06");
-    assert_string_equal(bc_trie_lookup(c, "DATE_LAST"), "2001-02-03 04:05:06");
-    assert_string_equal(bc_trie_lookup(c, "FILTER_REVERSE"), "");
-    bc_trie_free(c);
+    assert_int_equal(bc_hashmap_size(c), 5);
+    assert_string_equal(bc_hashmap_lookup(c, "FILENAME_FIRST"), "bola3");
+    assert_string_equal(bc_hashmap_lookup(c, "FILENAME_LAST"), "bola1");
+    assert_string_equal(bc_hashmap_lookup(c, "DATE_FIRST"), "2003-02-03 04:05:06");
+    assert_string_equal(bc_hashmap_lookup(c, "DATE_LAST"), "2001-02-03 04:05:06");
+    assert_string_equal(bc_hashmap_lookup(c, "FILTER_REVERSE"), "");
+    bc_hashmap_free(c);
     bc_slist_free_full(s, free);
-    bc_slist_free_full(t, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(t, (bc_free_func_t) bc_hashmap_free);
 }
 
 
 static void
 test_source_parse_from_files_filter_by_tag(void **state)
 {
-    will_return(__wrap_bc_file_get_contents, "bola1.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola1.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 123\n"
         "DATE: 2001-02-03 04:05:06\n"
         "TAGS: chunda\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola2.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola2.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 456\n"
         "DATE: 2002-02-03 04:05:06\n"
         "TAGS: bola, chunda\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola3.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola3.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 789\n"
         "DATE: 2003-02-03 04:05:06\n"
         "--------\n"
@@ -242,65 +248,65 @@ test_source_parse_from_files_filter_by_tag(void **state)
     s = bc_slist_append(s, bc_strdup("bola1.txt"));
     s = bc_slist_append(s, bc_strdup("bola2.txt"));
     s = bc_slist_append(s, bc_strdup("bola3.txt"));
-    bc_trie_t *c = bc_trie_new(free);
-    bc_trie_insert(c, "FILTER_TAG", bc_strdup("chunda"));
+    bc_hashmap_t *c = bc_hashmap_new(free);
+    bc_hashmap_insert(c, "FILTER_TAG", bc_strdup("chunda"));
     bc_slist_t *t = blogc_source_parse_from_files(c, s, &err);
     assert_null(err);
     assert_non_null(t);
     assert_int_equal(bc_slist_length(t), 2);  // it is enough, no need to look at the items
-    assert_int_equal(bc_trie_size(c), 5);
-    assert_string_equal(bc_trie_lookup(c, "FILENAME_FIRST"), "bola1");
-    assert_string_equal(bc_trie_lookup(c, "FILENAME_LAST"), "bola2");
-    assert_string_equal(bc_trie_lookup(c, "DATE_FIRST"), "2001-02-03 04:05:06");
-    assert_string_equal(bc_trie_lookup(c, "DATE_LAST"), "2002-02-03 04:05:06");
-    assert_string_equal(bc_trie_lookup(c, "FILTER_TAG"), "chunda");
-    bc_trie_free(c);
+    assert_int_equal(bc_hashmap_size(c), 5);
+    assert_string_equal(bc_hashmap_lookup(c, "FILENAME_FIRST"), "bola1");
+    assert_string_equal(bc_hashmap_lookup(c, "FILENAME_LAST"), "bola2");
+    assert_string_equal(bc_hashmap_lookup(c, "DATE_FIRST"), "2001-02-03 04:05:06");
+    assert_string_equal(bc_hashmap_lookup(c, "DATE_LAST"), "2002-02-03 04:05:06");
+    assert_string_equal(bc_hashmap_lookup(c, "FILTER_TAG"), "chunda");
+    bc_hashmap_free(c);
     bc_slist_free_full(s, free);
-    bc_slist_free_full(t, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(t, (bc_free_func_t) bc_hashmap_free);
 }
 
 
 static void
 test_source_parse_from_files_filter_by_page(void **state)
 {
-    will_return(__wrap_bc_file_get_contents, "bola1.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola1.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 123\n"
         "DATE: 2001-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola2.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola2.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 456\n"
         "DATE: 2002-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola3.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola3.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 789\n"
         "DATE: 2003-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola4.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola4.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 7891\n"
         "DATE: 2004-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola5.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola5.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 7892\n"
         "DATE: 2005-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola6.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola6.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 7893\n"
         "DATE: 2006-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola7.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola7.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 7894\n"
         "DATE: 2007-02-03 04:05:06\n"
         "--------\n"
@@ -314,71 +320,71 @@ test_source_parse_from_files_filter_by_page(void **state)
     s = bc_slist_append(s, bc_strdup("bola5.txt"));
     s = bc_slist_append(s, bc_strdup("bola6.txt"));
     s = bc_slist_append(s, bc_strdup("bola7.txt"));
-    bc_trie_t *c = bc_trie_new(free);
-    bc_trie_insert(c, "FILTER_PAGE", bc_strdup("1"));
-    bc_trie_insert(c, "FILTER_PER_PAGE", bc_strdup("2"));
+    bc_hashmap_t *c = bc_hashmap_new(free);
+    bc_hashmap_insert(c, "FILTER_PAGE", bc_strdup("1"));
+    bc_hashmap_insert(c, "FILTER_PER_PAGE", bc_strdup("2"));
     bc_slist_t *t = blogc_source_parse_from_files(c, s, &err);
     assert_null(err);
     assert_non_null(t);
     assert_int_equal(bc_slist_length(t), 2);  // it is enough, no need to look at the items
-    assert_int_equal(bc_trie_size(c), 10);
-    assert_string_equal(bc_trie_lookup(c, "FILENAME_FIRST"), "bola1");
-    assert_string_equal(bc_trie_lookup(c, "FILENAME_LAST"), "bola2");
-    assert_string_equal(bc_trie_lookup(c, "DATE_FIRST"), "2001-02-03 04:05:06");
-    assert_string_equal(bc_trie_lookup(c, "DATE_LAST"), "2002-02-03 04:05:06");
-    assert_string_equal(bc_trie_lookup(c, "FILTER_PAGE"), "1");
-    assert_string_equal(bc_trie_lookup(c, "FILTER_PER_PAGE"), "2");
-    assert_string_equal(bc_trie_lookup(c, "CURRENT_PAGE"), "1");
-    assert_string_equal(bc_trie_lookup(c, "NEXT_PAGE"), "2");
-    assert_string_equal(bc_trie_lookup(c, "FIRST_PAGE"), "1");
-    assert_string_equal(bc_trie_lookup(c, "LAST_PAGE"), "4");
-    bc_trie_free(c);
+    assert_int_equal(bc_hashmap_size(c), 10);
+    assert_string_equal(bc_hashmap_lookup(c, "FILENAME_FIRST"), "bola1");
+    assert_string_equal(bc_hashmap_lookup(c, "FILENAME_LAST"), "bola2");
+    assert_string_equal(bc_hashmap_lookup(c, "DATE_FIRST"), "2001-02-03 04:05:06");
+    assert_string_equal(bc_hashmap_lookup(c, "DATE_LAST"), "2002-02-03 04:05:06");
+    assert_string_equal(bc_hashmap_lookup(c, "FILTER_PAGE"), "1");
+    assert_string_equal(bc_hashmap_lookup(c, "FILTER_PER_PAGE"), "2");
+    assert_string_equal(bc_hashmap_lookup(c, "CURRENT_PAGE"), "1");
+    assert_string_equal(bc_hashmap_lookup(c, "NEXT_PAGE"), "2");
+    assert_string_equal(bc_hashmap_lookup(c, "FIRST_PAGE"), "1");
+    assert_string_equal(bc_hashmap_lookup(c, "LAST_PAGE"), "4");
+    bc_hashmap_free(c);
     bc_slist_free_full(s, free);
-    bc_slist_free_full(t, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(t, (bc_free_func_t) bc_hashmap_free);
 }
 
 
 static void
 test_source_parse_from_files_filter_by_page2(void **state)
 {
-    will_return(__wrap_bc_file_get_contents, "bola1.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola1.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 123\n"
         "DATE: 2001-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola2.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola2.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 456\n"
         "DATE: 2002-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola3.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola3.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 789\n"
         "DATE: 2003-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola4.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola4.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 7891\n"
         "DATE: 2004-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola5.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola5.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 7892\n"
         "DATE: 2005-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola6.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola6.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 7893\n"
         "DATE: 2006-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola7.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola7.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 7894\n"
         "DATE: 2007-02-03 04:05:06\n"
         "--------\n"
@@ -392,72 +398,72 @@ test_source_parse_from_files_filter_by_page2(void **state)
     s = bc_slist_append(s, bc_strdup("bola5.txt"));
     s = bc_slist_append(s, bc_strdup("bola6.txt"));
     s = bc_slist_append(s, bc_strdup("bola7.txt"));
-    bc_trie_t *c = bc_trie_new(free);
-    bc_trie_insert(c, "FILTER_PAGE", bc_strdup("3"));
-    bc_trie_insert(c, "FILTER_PER_PAGE", bc_strdup("2"));
+    bc_hashmap_t *c = bc_hashmap_new(free);
+    bc_hashmap_insert(c, "FILTER_PAGE", bc_strdup("3"));
+    bc_hashmap_insert(c, "FILTER_PER_PAGE", bc_strdup("2"));
     bc_slist_t *t = blogc_source_parse_from_files(c, s, &err);
     assert_null(err);
     assert_non_null(t);
     assert_int_equal(bc_slist_length(t), 2);  // it is enough, no need to look at the items
-    assert_int_equal(bc_trie_size(c), 11);
-    assert_string_equal(bc_trie_lookup(c, "FILENAME_FIRST"), "bola5");
-    assert_string_equal(bc_trie_lookup(c, "FILENAME_LAST"), "bola6");
-    assert_string_equal(bc_trie_lookup(c, "DATE_FIRST"), "2005-02-03 04:05:06");
-    assert_string_equal(bc_trie_lookup(c, "DATE_LAST"), "2006-02-03 04:05:06");
-    assert_string_equal(bc_trie_lookup(c, "FILTER_PAGE"), "3");
-    assert_string_equal(bc_trie_lookup(c, "FILTER_PER_PAGE"), "2");
-    assert_string_equal(bc_trie_lookup(c, "CURRENT_PAGE"), "3");
-    assert_string_equal(bc_trie_lookup(c, "PREVIOUS_PAGE"), "2");
-    assert_string_equal(bc_trie_lookup(c, "NEXT_PAGE"), "4");
-    assert_string_equal(bc_trie_lookup(c, "FIRST_PAGE"), "1");
-    assert_string_equal(bc_trie_lookup(c, "LAST_PAGE"), "4");
-    bc_trie_free(c);
+    assert_int_equal(bc_hashmap_size(c), 11);
+    assert_string_equal(bc_hashmap_lookup(c, "FILENAME_FIRST"), "bola5");
+    assert_string_equal(bc_hashmap_lookup(c, "FILENAME_LAST"), "bola6");
+    assert_string_equal(bc_hashmap_lookup(c, "DATE_FIRST"), "2005-02-03 04:05:06");
+    assert_string_equal(bc_hashmap_lookup(c, "DATE_LAST"), "2006-02-03 04:05:06");
+    assert_string_equal(bc_hashmap_lookup(c, "FILTER_PAGE"), "3");
+    assert_string_equal(bc_hashmap_lookup(c, "FILTER_PER_PAGE"), "2");
+    assert_string_equal(bc_hashmap_lookup(c, "CURRENT_PAGE"), "3");
+    assert_string_equal(bc_hashmap_lookup(c, "PREVIOUS_PAGE"), "2");
+    assert_string_equal(bc_hashmap_lookup(c, "NEXT_PAGE"), "4");
+    assert_string_equal(bc_hashmap_lookup(c, "FIRST_PAGE"), "1");
+    assert_string_equal(bc_hashmap_lookup(c, "LAST_PAGE"), "4");
+    bc_hashmap_free(c);
     bc_slist_free_full(s, free);
-    bc_slist_free_full(t, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(t, (bc_free_func_t) bc_hashmap_free);
 }
 
 
 static void
 test_source_parse_from_files_filter_by_page3(void **state)
 {
-    will_return(__wrap_bc_file_get_contents, "bola1.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola1.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 123\n"
         "DATE: 2001-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola2.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola2.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 456\n"
         "DATE: 2002-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola3.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola3.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 789\n"
         "DATE: 2003-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola4.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola4.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 7891\n"
         "DATE: 2004-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola5.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola5.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 7892\n"
         "DATE: 2005-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola6.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola6.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 7893\n"
         "DATE: 2006-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola7.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola7.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 7894\n"
         "DATE: 2007-02-03 04:05:06\n"
         "--------\n"
@@ -471,75 +477,75 @@ test_source_parse_from_files_filter_by_page3(void **state)
     s = bc_slist_append(s, bc_strdup("bola5.txt"));
     s = bc_slist_append(s, bc_strdup("bola6.txt"));
     s = bc_slist_append(s, bc_strdup("bola7.txt"));
-    bc_trie_t *c = bc_trie_new(free);
-    bc_trie_insert(c, "FILTER_PAGE", bc_strdup("1"));
-    bc_trie_insert(c, "FILTER_PER_PAGE", bc_strdup("2"));
+    bc_hashmap_t *c = bc_hashmap_new(free);
+    bc_hashmap_insert(c, "FILTER_PAGE", bc_strdup("1"));
+    bc_hashmap_insert(c, "FILTER_PER_PAGE", bc_strdup("2"));
     bc_slist_t *t = blogc_source_parse_from_files(c, s, &err);
     assert_null(err);
     assert_non_null(t);
     assert_int_equal(bc_slist_length(t), 2);  // it is enough, no need to look at the items
-    assert_int_equal(bc_trie_size(c), 10);
-    assert_string_equal(bc_trie_lookup(c, "FILENAME_FIRST"), "bola1");
-    assert_string_equal(bc_trie_lookup(c, "FILENAME_LAST"), "bola2");
-    assert_string_equal(bc_trie_lookup(c, "DATE_FIRST"), "2001-02-03 04:05:06");
-    assert_string_equal(bc_trie_lookup(c, "DATE_LAST"), "2002-02-03 04:05:06");
-    assert_string_equal(bc_trie_lookup(c, "FILTER_PAGE"), "1");
-    assert_string_equal(bc_trie_lookup(c, "FILTER_PER_PAGE"), "2");
-    assert_string_equal(bc_trie_lookup(c, "CURRENT_PAGE"), "1");
-    assert_string_equal(bc_trie_lookup(c, "NEXT_PAGE"), "2");
-    assert_string_equal(bc_trie_lookup(c, "FIRST_PAGE"), "1");
-    assert_string_equal(bc_trie_lookup(c, "LAST_PAGE"), "4");
-    bc_trie_free(c);
+    assert_int_equal(bc_hashmap_size(c), 10);
+    assert_string_equal(bc_hashmap_lookup(c, "FILENAME_FIRST"), "bola1");
+    assert_string_equal(bc_hashmap_lookup(c, "FILENAME_LAST"), "bola2");
+    assert_string_equal(bc_hashmap_lookup(c, "DATE_FIRST"), "2001-02-03 04:05:06");
+    assert_string_equal(bc_hashmap_lookup(c, "DATE_LAST"), "2002-02-03 04:05:06");
+    assert_string_equal(bc_hashmap_lookup(c, "FILTER_PAGE"), "1");
+    assert_string_equal(bc_hashmap_lookup(c, "FILTER_PER_PAGE"), "2");
+    assert_string_equal(bc_hashmap_lookup(c, "CURRENT_PAGE"), "1");
+    assert_string_equal(bc_hashmap_lookup(c, "NEXT_PAGE"), "2");
+    assert_string_equal(bc_hashmap_lookup(c, "FIRST_PAGE"), "1");
+    assert_string_equal(bc_hashmap_lookup(c, "LAST_PAGE"), "4");
+    bc_hashmap_free(c);
     bc_slist_free_full(s, free);
-    bc_slist_free_full(t, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(t, (bc_free_func_t) bc_hashmap_free);
 }
 
 
 static void
 test_source_parse_from_files_filter_by_page_and_tag(void **state)
 {
-    will_return(__wrap_bc_file_get_contents, "bola1.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola1.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 123\n"
         "DATE: 2001-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola2.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola2.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 456\n"
         "DATE: 2002-02-03 04:05:06\n"
         "TAGS: chunda\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola3.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola3.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 789\n"
         "DATE: 2003-02-03 04:05:06\n"
         "TAGS: chunda bola\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola4.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola4.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 7891\n"
         "DATE: 2004-02-03 04:05:06\n"
         "TAGS: bola\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola5.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola5.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 7892\n"
         "DATE: 2005-02-03 04:05:06\n"
         "TAGS: chunda\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola6.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola6.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 7893\n"
         "DATE: 2006-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola7.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola7.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 7894\n"
         "DATE: 2007-02-03 04:05:06\n"
         "TAGS: yay chunda\n"
@@ -554,73 +560,73 @@ test_source_parse_from_files_filter_by_page_and_tag(void **state)
     s = bc_slist_append(s, bc_strdup("bola5.txt"));
     s = bc_slist_append(s, bc_strdup("bola6.txt"));
     s = bc_slist_append(s, bc_strdup("bola7.txt"));
-    bc_trie_t *c = bc_trie_new(free);
-    bc_trie_insert(c, "FILTER_TAG", bc_strdup("chunda"));
-    bc_trie_insert(c, "FILTER_PAGE", bc_strdup("2"));
-    bc_trie_insert(c, "FILTER_PER_PAGE", bc_strdup("2"));
+    bc_hashmap_t *c = bc_hashmap_new(free);
+    bc_hashmap_insert(c, "FILTER_TAG", bc_strdup("chunda"));
+    bc_hashmap_insert(c, "FILTER_PAGE", bc_strdup("2"));
+    bc_hashmap_insert(c, "FILTER_PER_PAGE", bc_strdup("2"));
     bc_slist_t *t = blogc_source_parse_from_files(c, s, &err);
     assert_null(err);
     assert_non_null(t);
     assert_int_equal(bc_slist_length(t), 2);  // it is enough, no need to look at the items
-    assert_int_equal(bc_trie_size(c), 11);
-    assert_string_equal(bc_trie_lookup(c, "FILENAME_FIRST"), "bola5");
-    assert_string_equal(bc_trie_lookup(c, "FILENAME_LAST"), "bola7");
-    assert_string_equal(bc_trie_lookup(c, "DATE_FIRST"), "2005-02-03 04:05:06");
-    assert_string_equal(bc_trie_lookup(c, "DATE_LAST"), "2007-02-03 04:05:06");
-    assert_string_equal(bc_trie_lookup(c, "FILTER_TAG"), "chunda");
-    assert_string_equal(bc_trie_lookup(c, "FILTER_PAGE"), "2");
-    assert_string_equal(bc_trie_lookup(c, "FILTER_PER_PAGE"), "2");
-    assert_string_equal(bc_trie_lookup(c, "CURRENT_PAGE"), "2");
-    assert_string_equal(bc_trie_lookup(c, "PREVIOUS_PAGE"), "1");
-    assert_string_equal(bc_trie_lookup(c, "FIRST_PAGE"), "1");
-    assert_string_equal(bc_trie_lookup(c, "LAST_PAGE"), "2");
-    bc_trie_free(c);
+    assert_int_equal(bc_hashmap_size(c), 11);
+    assert_string_equal(bc_hashmap_lookup(c, "FILENAME_FIRST"), "bola5");
+    assert_string_equal(bc_hashmap_lookup(c, "FILENAME_LAST"), "bola7");
+    assert_string_equal(bc_hashmap_lookup(c, "DATE_FIRST"), "2005-02-03 04:05:06");
+    assert_string_equal(bc_hashmap_lookup(c, "DATE_LAST"), "2007-02-03 04:05:06");
+    assert_string_equal(bc_hashmap_lookup(c, "FILTER_TAG"), "chunda");
+    assert_string_equal(bc_hashmap_lookup(c, "FILTER_PAGE"), "2");
+    assert_string_equal(bc_hashmap_lookup(c, "FILTER_PER_PAGE"), "2");
+    assert_string_equal(bc_hashmap_lookup(c, "CURRENT_PAGE"), "2");
+    assert_string_equal(bc_hashmap_lookup(c, "PREVIOUS_PAGE"), "1");
+    assert_string_equal(bc_hashmap_lookup(c, "FIRST_PAGE"), "1");
+    assert_string_equal(bc_hashmap_lookup(c, "LAST_PAGE"), "2");
+    bc_hashmap_free(c);
     bc_slist_free_full(s, free);
-    bc_slist_free_full(t, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(t, (bc_free_func_t) bc_hashmap_free);
 }
 
 
 static void
 test_source_parse_from_files_filter_by_page_invalid(void **state)
 {
-    will_return(__wrap_bc_file_get_contents, "bola1.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola1.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 123\n"
         "DATE: 2001-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola2.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola2.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 456\n"
         "DATE: 2002-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola3.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola3.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 789\n"
         "DATE: 2003-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola4.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola4.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 7891\n"
         "DATE: 2004-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola5.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola5.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 7892\n"
         "DATE: 2005-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola6.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola6.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 7893\n"
         "DATE: 2006-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola7.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola7.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 7894\n"
         "DATE: 2007-02-03 04:05:06\n"
         "--------\n"
@@ -634,71 +640,71 @@ test_source_parse_from_files_filter_by_page_invalid(void **state)
     s = bc_slist_append(s, bc_strdup("bola5.txt"));
     s = bc_slist_append(s, bc_strdup("bola6.txt"));
     s = bc_slist_append(s, bc_strdup("bola7.txt"));
-    bc_trie_t *c = bc_trie_new(free);
-    bc_trie_insert(c, "FILTER_PAGE", bc_strdup("-1"));
-    bc_trie_insert(c, "FILTER_PER_PAGE", bc_strdup("2"));
+    bc_hashmap_t *c = bc_hashmap_new(free);
+    bc_hashmap_insert(c, "FILTER_PAGE", bc_strdup("-1"));
+    bc_hashmap_insert(c, "FILTER_PER_PAGE", bc_strdup("2"));
     bc_slist_t *t = blogc_source_parse_from_files(c, s, &err);
     assert_null(err);
     assert_non_null(t);
     assert_int_equal(bc_slist_length(t), 2);  // it is enough, no need to look at the items
-    assert_int_equal(bc_trie_size(c), 10);
-    assert_string_equal(bc_trie_lookup(c, "FILENAME_FIRST"), "bola1");
-    assert_string_equal(bc_trie_lookup(c, "FILENAME_LAST"), "bola2");
-    assert_string_equal(bc_trie_lookup(c, "DATE_FIRST"), "2001-02-03 04:05:06");
-    assert_string_equal(bc_trie_lookup(c, "DATE_LAST"), "2002-02-03 04:05:06");
-    assert_string_equal(bc_trie_lookup(c, "FILTER_PAGE"), "-1");
-    assert_string_equal(bc_trie_lookup(c, "FILTER_PER_PAGE"), "2");
-    assert_string_equal(bc_trie_lookup(c, "CURRENT_PAGE"), "1");
-    assert_string_equal(bc_trie_lookup(c, "NEXT_PAGE"), "2");
-    assert_string_equal(bc_trie_lookup(c, "FIRST_PAGE"), "1");
-    assert_string_equal(bc_trie_lookup(c, "LAST_PAGE"), "4");
-    bc_trie_free(c);
+    assert_int_equal(bc_hashmap_size(c), 10);
+    assert_string_equal(bc_hashmap_lookup(c, "FILENAME_FIRST"), "bola1");
+    assert_string_equal(bc_hashmap_lookup(c, "FILENAME_LAST"), "bola2");
+    assert_string_equal(bc_hashmap_lookup(c, "DATE_FIRST"), "2001-02-03 04:05:06");
+    assert_string_equal(bc_hashmap_lookup(c, "DATE_LAST"), "2002-02-03 04:05:06");
+    assert_string_equal(bc_hashmap_lookup(c, "FILTER_PAGE"), "-1");
+    assert_string_equal(bc_hashmap_lookup(c, "FILTER_PER_PAGE"), "2");
+    assert_string_equal(bc_hashmap_lookup(c, "CURRENT_PAGE"), "1");
+    assert_string_equal(bc_hashmap_lookup(c, "NEXT_PAGE"), "2");
+    assert_string_equal(bc_hashmap_lookup(c, "FIRST_PAGE"), "1");
+    assert_string_equal(bc_hashmap_lookup(c, "LAST_PAGE"), "4");
+    bc_hashmap_free(c);
     bc_slist_free_full(s, free);
-    bc_slist_free_full(t, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(t, (bc_free_func_t) bc_hashmap_free);
 }
 
 
 static void
 test_source_parse_from_files_filter_by_page_invalid2(void **state)
 {
-    will_return(__wrap_bc_file_get_contents, "bola1.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola1.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 123\n"
         "DATE: 2001-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola2.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola2.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 456\n"
         "DATE: 2002-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola3.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola3.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 789\n"
         "DATE: 2003-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola4.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola4.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 7891\n"
         "DATE: 2004-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola5.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola5.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 7892\n"
         "DATE: 2005-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola6.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola6.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 7893\n"
         "DATE: 2006-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola7.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola7.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 7894\n"
         "DATE: 2007-02-03 04:05:06\n"
         "--------\n"
@@ -712,13 +718,13 @@ test_source_parse_from_files_filter_by_page_invalid2(void **state)
     s = bc_slist_append(s, bc_strdup("bola5.txt"));
     s = bc_slist_append(s, bc_strdup("bola6.txt"));
     s = bc_slist_append(s, bc_strdup("bola7.txt"));
-    bc_trie_t *c = bc_trie_new(free);
-    bc_trie_insert(c, "FILTER_PAGE", bc_strdup("5"));
-    bc_trie_insert(c, "FILTER_PER_PAGE", bc_strdup("2"));
+    bc_hashmap_t *c = bc_hashmap_new(free);
+    bc_hashmap_insert(c, "FILTER_PAGE", bc_strdup("5"));
+    bc_hashmap_insert(c, "FILTER_PER_PAGE", bc_strdup("2"));
     bc_slist_t *t = blogc_source_parse_from_files(c, s, &err);
     assert_null(err);
     assert_null(t);
-    bc_trie_free(c);
+    bc_hashmap_free(c);
     bc_slist_free_full(s, free);
 }
 
@@ -726,19 +732,19 @@ test_source_parse_from_files_filter_by_page_invalid2(void **state)
 static void
 test_source_parse_from_files_without_all_dates(void **state)
 {
-    will_return(__wrap_bc_file_get_contents, "bola1.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola1.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 123\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola2.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola2.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 456\n"
         "DATE: 2002-02-03 04:05:06\n"
         "--------\n"
         "bola"));
-    will_return(__wrap_bc_file_get_contents, "bola3.txt");
-    will_return(__wrap_bc_file_get_contents, bc_strdup(
+    will_return(__wrap_bc_file_map, "bola3.txt");
+    will_return(__wrap_bc_file_map, bc_strdup(
         "ASD: 789\n"
         "DATE: 2003-02-03 04:05:06\n"
         "--------\n"
@@ -748,7 +754,7 @@ test_source_parse_from_files_without_all_dates(void **state)
     s = bc_slist_append(s, bc_strdup("bola1.txt"));
     s = bc_slist_append(s, bc_strdup("bola2.txt"));
     s = bc_slist_append(s, bc_strdup("bola3.txt"));
-    bc_trie_t *c = bc_trie_new(free);
+    bc_hashmap_t *c = bc_hashmap_new(free);
     bc_slist_t *t = blogc_source_parse_from_files(c, s, &err);
     assert_null(t);
     assert_non_null(err);
@@ -757,8 +763,8 @@ test_source_parse_from_files_without_all_dates(void **state)
         "'DATE' variable provided for at least one source file, but not for "
         "all source files. It must be provided for all files.\n");
     bc_error_free(err);
-    assert_int_equal(bc_trie_size(c), 0);
-    bc_trie_free(c);
+    assert_int_equal(bc_hashmap_size(c), 0);
+    bc_hashmap_free(c);
     bc_slist_free_full(s, free);
 }
 
@@ -768,15 +774,72 @@ test_source_parse_from_files_null(void **state)
 {
     bc_error_t *err = NULL;
     bc_slist_t *s = NULL;
-    bc_trie_t *c = bc_trie_new(free);
+    bc_hashmap_t *c = bc_hashmap_new(free);
     bc_slist_t *t = blogc_source_parse_from_files(c, s, &err);
     assert_null(err);
     assert_null(t);
     assert_int_equal(bc_slist_length(t), 0);
-    assert_int_equal(bc_trie_size(c), 0);
-    bc_trie_free(c);
+    assert_int_equal(bc_hashmap_size(c), 0);
+    bc_hashmap_free(c);
     bc_slist_free_full(s, free);
-    bc_slist_free_full(t, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(t, (bc_free_func_t) bc_hashmap_free);
+}
+
+
+static void
+test_source_filter(void **state)
+{
+    bc_hashmap_t *s1 = bc_hashmap_new(free);
+    bc_hashmap_insert(s1, "FILENAME", bc_strdup("bola1"));
+    bc_hashmap_insert(s1, "DATE", bc_strdup("2001-02-03 04:05:06"));
+    bc_hashmap_insert(s1, "TAGS", bc_strdup("chunda"));
+    bc_hashmap_t *s2 = bc_hashmap_new(free);
+    bc_hashmap_insert(s2, "FILENAME", bc_strdup("bola2"));
+    bc_hashmap_insert(s2, "DATE", bc_strdup("2002-02-03 04:05:06"));
+    bc_hashmap_insert(s2, "TAGS", bc_strdup("bola"));
+    bc_hashmap_t *s3 = bc_hashmap_new(free);
+    bc_hashmap_insert(s3, "FILENAME", bc_strdup("bola3"));
+    bc_hashmap_insert(s3, "DATE", bc_strdup("2003-02-03 04:05:06"));
+    bc_hashmap_insert(s3, "TAGS", bc_strdup("chunda bola"));
+    bc_error_t *err = NULL;
+    bc_slist_t *s = NULL;
+    s = bc_slist_append(s, s1);
+    s = bc_slist_append(s, s2);
+    s = bc_slist_append(s, s3);
+    bc_hashmap_t *c = bc_hashmap_new(free);
+    bc_hashmap_insert(c, "FILTER_REVERSE", bc_strdup(""));
+    bc_hashmap_insert(c, "FILTER_TAG", bc_strdup("chunda"));
+    bc_slist_t *t = blogc_source_filter(c, s, &err);
+    assert_null(err);
+    assert_non_null(t);
+    assert_int_equal(bc_slist_length(t), 2);
+    assert_string_equal(bc_hashmap_lookup(t->data, "FILENAME"), "bola3");
+    assert_string_equal(bc_hashmap_lookup(t->next->data, "FILENAME"), "bola1");
+    assert_int_equal(bc_hashmap_size(c), 6);
+    assert_string_equal(bc_hashmap_lookup(c, "FILENAME_FIRST"), "bola3");
+    assert_string_equal(bc_hashmap_lookup(c, "FILENAME_LAST"), "bola1");
+    assert_string_equal(bc_hashmap_lookup(c, "DATE_FIRST"), "2003-02-03 04:05:06");
+    assert_string_equal(bc_hashmap_lookup(c, "DATE_LAST"), "2001-02-03 04:05:06");
+    bc_hashmap_free(c);
+    bc_slist_free(t);
+
+    // sources are borrowed, so they can be filtered again
+    c = bc_hashmap_new(free);
+    bc_hashmap_insert(c, "FILTER_PAGE", bc_strdup("2"));
+    bc_hashmap_insert(c, "FILTER_PER_PAGE", bc_strdup("2"));
+    t = blogc_source_filter(c, s, &err);
+    assert_null(err);
+    assert_non_null(t);
+    assert_int_equal(bc_slist_length(t), 1);
+    assert_string_equal(bc_hashmap_lookup(t->data, "FILENAME"), "bola3");
+    assert_string_equal(bc_hashmap_lookup(c, "CURRENT_PAGE"), "2");
+    assert_string_equal(bc_hashmap_lookup(c, "PREVIOUS_PAGE"), "1");
+    assert_null(bc_hashmap_lookup(c, "NEXT_PAGE"));
+    assert_string_equal(bc_hashmap_lookup(c, "LAST_PAGE"), "2");
+    bc_hashmap_free(c);
+    bc_slist_free(t);
+
+    bc_slist_free_full(s, (bc_free_func_t) bc_hashmap_free);
 }
 
 
@@ -800,6 +863,7 @@ main(void)
         unit_test(test_source_parse_from_files_filter_by_page_invalid2),
         unit_test(test_source_parse_from_files_without_all_dates),
         unit_test(test_source_parse_from_files_null),
+        unit_test(test_source_filter),
     };
     return run_tests(tests);
 }
@@ -77,7 +77,7 @@ test_render_entry(void **state)
         "{% foreach TAGS %}lol {{ FOREACH_ITEM }} haha {% endforeach %}\n"
         "{% foreach TAGS_ASD %}yay{% endforeach %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *l = blogc_template_parse(str, strlen(str), &err);
+    bc_slist_t *l = blogc_template_parse(str, strlen(str), NULL, &err);
     assert_non_null(l);
     assert_null(err);
     bc_slist_t *s = create_sources(1);
@@ -102,7 +102,7 @@ test_render_entry(void **state)
         "lol foo haha lol bar haha lol baz haha \n"
         "\n");
     blogc_template_free_ast(l);
-    bc_slist_free_full(s, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(s, (bc_free_func_t) bc_hashmap_free);
     free(out);
 }
 
@@ -124,7 +124,7 @@ test_render_listing(void **state)
         "{% foreach TAGS_ASD %}yay{% endforeach %}\n"
         "{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *l = blogc_template_parse(str, strlen(str), &err);
+    bc_slist_t *l = blogc_template_parse(str, strlen(str), NULL, &err);
     assert_non_null(l);
     assert_null(err);
     bc_slist_t *s = create_sources(3);
@@ -151,11 +151,65 @@ test_render_listing(void **state)
         "\n"
         "\n");
     blogc_template_free_ast(l);
-    bc_slist_free_full(s, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(s, (bc_free_func_t) bc_hashmap_free);
     free(out);
 }
 
 
+static size_t sink_count = 0;
+
+static void
+mock_sink(const char *str, size_t len, void *user_data)
+{
+    sink_count++;
+    bc_string_append_len(user_data, str, len);
+}
+
+
+static void
+test_render_to_sink(void **state)
+{
+    const char *str =
+        "foo\n"
+        "{% block listing_once %}fuuu{% endblock %}\n"
+        "{% block listing %}\n"
+        "bola: {{ BOLA }} {{ GUDA_2 }}\n"
+        "{% foreach TAGS %}lol {{ FOREACH_ITEM }} {% endforeach %}\n"
+        "{% endblock %}\n";
+    bc_error_t *err = NULL;
+    bc_slist_t *l = blogc_template_parse(str, strlen(str), NULL, &err);
+    assert_non_null(l);
+    assert_null(err);
+    bc_slist_t *s = create_sources(2);
+    assert_non_null(s);
+    bc_string_t *out = bc_string_new();
+    sink_count = 0;
+    blogc_render_to_sink(l, s, NULL, true, mock_sink, out);
+    assert_string_equal(out->str,
+        "foo\n"
+        "fuuu\n"
+        "\n"
+        "bola: asd zx\n"
+        "lol foo lol bar lol baz \n"
+        "\n"
+        "bola: asd2 zx\n"
+        "\n"
+        "\n");
+    // output is streamed in pieces, not as a single string
+    size_t count = sink_count;
+    assert_true(count > 1);
+    char *out2 = blogc_render(l, s, NULL, true);
+    assert_string_equal(out->str, out2);
+    free(out2);
+    blogc_render_to_sink(NULL, s, NULL, true, mock_sink, out);
+    blogc_render_to_sink(l, s, NULL, true, NULL, out);
+    assert_int_equal(sink_count, count);
+    blogc_template_free_ast(l);
+    bc_slist_free_full(s, (bc_free_func_t) bc_hashmap_free);
+    bc_string_free(out, true);
+}
+
+
 static void
 test_render_listing_empty(void **state)
 {
@@ -172,7 +226,7 @@ test_render_listing_empty(void **state)
         "{% foreach TAGS %}lol {{ FOREACH_ITEM }} haha {% endforeach %}\n"
         "{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *l = blogc_template_parse(str, strlen(str), &err);
+    bc_slist_t *l = blogc_template_parse(str, strlen(str), NULL, &err);
     assert_non_null(l);
     assert_null(err);
     char *out = blogc_render(l, NULL, NULL, true);
@@ -199,7 +253,7 @@ test_render_ifdef(void **state)
         "{% endif %}\n"
         "{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *l = blogc_template_parse(str, strlen(str), &err);
+    bc_slist_t *l = blogc_template_parse(str, strlen(str), NULL, &err);
     assert_non_null(l);
     assert_null(err);
     bc_slist_t *s = create_sources(1);
@@ -210,7 +264,7 @@ test_render_ifdef(void **state)
         "\n"
         "\n");
     blogc_template_free_ast(l);
-    bc_slist_free_full(s, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(s, (bc_free_func_t) bc_hashmap_free);
     free(out);
 }
 
@@ -228,7 +282,7 @@ test_render_ifdef2(void **state)
         "{% endif %}\n"
         "{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *l = blogc_template_parse(str, strlen(str), &err);
+    bc_slist_t *l = blogc_template_parse(str, strlen(str), NULL, &err);
     assert_non_null(l);
     assert_null(err);
     bc_slist_t *s = create_sources(1);
@@ -241,7 +295,7 @@ test_render_ifdef2(void **state)
         "\n"
         "\n");
     blogc_template_free_ast(l);
-    bc_slist_free_full(s, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(s, (bc_free_func_t) bc_hashmap_free);
     free(out);
 }
 
@@ -259,7 +313,7 @@ test_render_ifdef3(void **state)
         "{% endif %}\n"
         "{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *l = blogc_template_parse(str, strlen(str), &err);
+    bc_slist_t *l = blogc_template_parse(str, strlen(str), NULL, &err);
     assert_non_null(l);
     assert_null(err);
     bc_slist_t *s = create_sources(1);
@@ -274,7 +328,7 @@ test_render_ifdef3(void **state)
         "\n"
         "\n");
     blogc_template_free_ast(l);
-    bc_slist_free_full(s, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(s, (bc_free_func_t) bc_hashmap_free);
     free(out);
 }
 
@@ -294,7 +348,7 @@ test_render_ifdef4(void **state)
         "{% endif %}\n"
         "{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *l = blogc_template_parse(str, strlen(str), &err);
+    bc_slist_t *l = blogc_template_parse(str, strlen(str), NULL, &err);
     assert_non_null(l);
     assert_null(err);
     bc_slist_t *s = create_sources(1);
@@ -310,7 +364,7 @@ test_render_ifdef4(void **state)
         "\n"
         "\n");
     blogc_template_free_ast(l);
-    bc_slist_free_full(s, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(s, (bc_free_func_t) bc_hashmap_free);
     free(out);
 }
 
@@ -330,7 +384,7 @@ test_render_ifdef5(void **state)
         "{% endif %}\n"
         "{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *l = blogc_template_parse(str, strlen(str), &err);
+    bc_slist_t *l = blogc_template_parse(str, strlen(str), NULL, &err);
     assert_non_null(l);
     assert_null(err);
     bc_slist_t *s = create_sources(1);
@@ -344,7 +398,7 @@ test_render_ifdef5(void **state)
         "\n"
         "\n");
     blogc_template_free_ast(l);
-    bc_slist_free_full(s, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(s, (bc_free_func_t) bc_hashmap_free);
     free(out);
 }
 
@@ -364,7 +418,7 @@ test_render_ifdef6(void **state)
         "{% endif %}\n"
         "{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *l = blogc_template_parse(str, strlen(str), &err);
+    bc_slist_t *l = blogc_template_parse(str, strlen(str), NULL, &err);
     assert_non_null(l);
     assert_null(err);
     bc_slist_t *s = create_sources(1);
@@ -376,7 +430,7 @@ test_render_ifdef6(void **state)
         "\n"
         "\n");
     blogc_template_free_ast(l);
-    bc_slist_free_full(s, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(s, (bc_free_func_t) bc_hashmap_free);
     free(out);
 }
 
@@ -397,7 +451,7 @@ test_render_ifdef7(void **state)
         "{% endif %}\n"
         "{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *l = blogc_template_parse(str, strlen(str), &err);
+    bc_slist_t *l = blogc_template_parse(str, strlen(str), NULL, &err);
     assert_non_null(l);
     assert_null(err);
     bc_slist_t *s = create_sources(1);
@@ -414,7 +468,7 @@ test_render_ifdef7(void **state)
         "\n"
         "\n");
     blogc_template_free_ast(l);
-    bc_slist_free_full(s, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(s, (bc_free_func_t) bc_hashmap_free);
     free(out);
 }
 
@@ -433,7 +487,7 @@ test_render_ifndef(void **state)
         "{% endif %}\n"
         "{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *l = blogc_template_parse(str, strlen(str), &err);
+    bc_slist_t *l = blogc_template_parse(str, strlen(str), NULL, &err);
     assert_non_null(l);
     assert_null(err);
     bc_slist_t *s = create_sources(1);
@@ -449,7 +503,7 @@ test_render_ifndef(void **state)
         "\n"
         "\n");
     blogc_template_free_ast(l);
-    bc_slist_free_full(s, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(s, (bc_free_func_t) bc_hashmap_free);
     free(out);
 }
 
@@ -469,7 +523,7 @@ test_render_if_eq(void **state)
         "{% endif %}\n"
         "{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *l = blogc_template_parse(str, strlen(str), &err);
+    bc_slist_t *l = blogc_template_parse(str, strlen(str), NULL, &err);
     assert_non_null(l);
     assert_null(err);
     bc_slist_t *s = create_sources(1);
@@ -486,7 +540,7 @@ test_render_if_eq(void **state)
         "\n"
         "\n");
     blogc_template_free_ast(l);
-    bc_slist_free_full(s, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(s, (bc_free_func_t) bc_hashmap_free);
     free(out);
 }
 
@@ -506,7 +560,7 @@ test_render_if_neq(void **state)
         "{% endif %}\n"
         "{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *l = blogc_template_parse(str, strlen(str), &err);
+    bc_slist_t *l = blogc_template_parse(str, strlen(str), NULL, &err);
     assert_non_null(l);
     assert_null(err);
     bc_slist_t *s = create_sources(1);
@@ -523,7 +577,7 @@ test_render_if_neq(void **state)
         "\n"
         "\n");
     blogc_template_free_ast(l);
-    bc_slist_free_full(s, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(s, (bc_free_func_t) bc_hashmap_free);
     free(out);
 }
 
@@ -543,7 +597,7 @@ test_render_if_lt(void **state)
         "{% endif %}\n"
         "{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *l = blogc_template_parse(str, strlen(str), &err);
+    bc_slist_t *l = blogc_template_parse(str, strlen(str), NULL, &err);
     assert_non_null(l);
     assert_null(err);
     bc_slist_t *s = create_sources(1);
@@ -560,7 +614,7 @@ test_render_if_lt(void **state)
         "\n"
         "\n");
     blogc_template_free_ast(l);
-    bc_slist_free_full(s, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(s, (bc_free_func_t) bc_hashmap_free);
     free(out);
 }
 
@@ -580,7 +634,7 @@ test_render_if_gt(void **state)
         "{% endif %}\n"
         "{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *l = blogc_template_parse(str, strlen(str), &err);
+    bc_slist_t *l = blogc_template_parse(str, strlen(str), NULL, &err);
     assert_non_null(l);
     assert_null(err);
     bc_slist_t *s = create_sources(1);
@@ -597,7 +651,7 @@ test_render_if_gt(void **state)
         "\n"
         "\n");
     blogc_template_free_ast(l);
-    bc_slist_free_full(s, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(s, (bc_free_func_t) bc_hashmap_free);
     free(out);
 }
 
@@ -619,7 +673,7 @@ test_render_if_lt_eq(void **state)
         "{% endif %}\n"
         "{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *l = blogc_template_parse(str, strlen(str), &err);
+    bc_slist_t *l = blogc_template_parse(str, strlen(str), NULL, &err);
     assert_non_null(l);
     assert_null(err);
     bc_slist_t *s = create_sources(1);
@@ -638,7 +692,7 @@ test_render_if_lt_eq(void **state)
         "\n"
         "\n");
     blogc_template_free_ast(l);
-    bc_slist_free_full(s, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(s, (bc_free_func_t) bc_hashmap_free);
     free(out);
 }
 
@@ -660,7 +714,7 @@ test_render_if_gt_eq(void **state)
         "{% endif %}\n"
         "{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *l = blogc_template_parse(str, strlen(str), &err);
+    bc_slist_t *l = blogc_template_parse(str, strlen(str), NULL, &err);
     assert_non_null(l);
     assert_null(err);
     bc_slist_t *s = create_sources(1);
@@ -679,7 +733,7 @@ test_render_if_gt_eq(void **state)
         "\n"
         "\n");
     blogc_template_free_ast(l);
-    bc_slist_free_full(s, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(s, (bc_free_func_t) bc_hashmap_free);
     free(out);
 }
 
@@ -692,7 +746,7 @@ test_render_foreach(void **state)
         "{% foreach TAGS %} {{ FOREACH_ITEM }} {% endforeach %}\n"
         "{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *l = blogc_template_parse(str, strlen(str), &err);
+    bc_slist_t *l = blogc_template_parse(str, strlen(str), NULL, &err);
     assert_non_null(l);
     assert_null(err);
     bc_slist_t *s = create_sources(1);
@@ -703,7 +757,7 @@ test_render_foreach(void **state)
         " foo  bar  baz \n"
         "\n");
     blogc_template_free_ast(l);
-    bc_slist_free_full(s, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(s, (bc_free_func_t) bc_hashmap_free);
     free(out);
 }
 
@@ -717,7 +771,7 @@ test_render_foreach_if(void **state)
         "{% endif %} {% endforeach %}\n"
         "{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *l = blogc_template_parse(str, strlen(str), &err);
+    bc_slist_t *l = blogc_template_parse(str, strlen(str), NULL, &err);
     assert_non_null(l);
     assert_null(err);
     bc_slist_t *s = create_sources(1);
@@ -728,7 +782,7 @@ test_render_foreach_if(void **state)
         "   bar   \n"
         "\n");
     blogc_template_free_ast(l);
-    bc_slist_free_full(s, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(s, (bc_free_func_t) bc_hashmap_free);
     free(out);
 }
 
@@ -743,7 +797,7 @@ test_render_foreach_if_else(void **state)
         "{% endif %} {% endforeach %}\n"
         "{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *l = blogc_template_parse(str, strlen(str), &err);
+    bc_slist_t *l = blogc_template_parse(str, strlen(str), NULL, &err);
     assert_non_null(l);
     assert_null(err);
     bc_slist_t *s = create_sources(1);
@@ -754,7 +808,7 @@ test_render_foreach_if_else(void **state)
         "foo yay baz \n"
         "\n");
     blogc_template_free_ast(l);
-    bc_slist_free_full(s, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(s, (bc_free_func_t) bc_hashmap_free);
     free(out);
 }
 
@@ -774,21 +828,21 @@ test_render_outside_block(void **state)
         "{{ BOLA }}\n"
         "{% ifndef CHUNDA %}lol{% endif %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *l = blogc_template_parse(str, strlen(str), &err);
+    bc_slist_t *l = blogc_template_parse(str, strlen(str), NULL, &err);
     assert_non_null(l);
     assert_null(err);
     bc_slist_t *s = create_sources(1);
     assert_non_null(s);
-    bc_trie_t *c = bc_trie_new(free);
-    bc_trie_insert(c, "GUDA", bc_strdup("asd"));
+    bc_hashmap_t *c = bc_hashmap_new(free);
+    bc_hashmap_insert(c, "GUDA", bc_strdup("asd"));
     char *out = blogc_render(l, s, c, false);
     assert_string_equal(out,
         "bola\n"
         "\n"
         "lol\n");
-    bc_trie_free(c);
+    bc_hashmap_free(c);
     blogc_template_free_ast(l);
-    bc_slist_free_full(s, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(s, (bc_free_func_t) bc_hashmap_free);
     free(out);
 }
 
@@ -807,14 +861,14 @@ test_render_prefer_local_variable(void **state)
         "{% endif %}\n"
         "{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *l = blogc_template_parse(str, strlen(str), &err);
+    bc_slist_t *l = blogc_template_parse(str, strlen(str), NULL, &err);
     assert_non_null(l);
     assert_null(err);
     bc_slist_t *s = create_sources(1);
     assert_non_null(s);
-    bc_trie_t *c = bc_trie_new(free);
-    bc_trie_insert(c, "GUDA", bc_strdup("hehe"));
-    bc_trie_insert(c, "LOL", bc_strdup("hmm"));
+    bc_hashmap_t *c = bc_hashmap_new(free);
+    bc_hashmap_insert(c, "GUDA", bc_strdup("hehe"));
+    bc_hashmap_insert(c, "LOL", bc_strdup("hmm"));
     char *out = blogc_render(l, s, c, false);
     assert_string_equal(out,
         "\n"
@@ -825,9 +879,9 @@ test_render_prefer_local_variable(void **state)
         "\n"
         "\n"
         "\n");
-    bc_trie_free(c);
+    bc_hashmap_free(c);
     blogc_template_free_ast(l);
-    bc_slist_free_full(s, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(s, (bc_free_func_t) bc_hashmap_free);
     free(out);
 }
 
@@ -843,12 +897,12 @@ test_render_respect_variable_scope(void **state)
         "{% ifdef BOLA %}{{ BOLA }}{% endif %}\n"
         "{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *l = blogc_template_parse(str, strlen(str), &err);
+    bc_slist_t *l = blogc_template_parse(str, strlen(str), NULL, &err);
     assert_non_null(l);
     assert_null(err);
     bc_slist_t *s = create_sources(1);
     assert_non_null(s);
-    bc_trie_t *c = bc_trie_new(free);
+    bc_hashmap_t *c = bc_hashmap_new(free);
     char *out = blogc_render(l, s, c, false);
     assert_string_equal(out,
         "\n"
@@ -857,9 +911,9 @@ test_render_respect_variable_scope(void **state)
         "\n"
         "asd\n"
         "\n");
-    bc_trie_free(c);
+    bc_hashmap_free(c);
     blogc_template_free_ast(l);
-    bc_slist_free_full(s, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(s, (bc_free_func_t) bc_hashmap_free);
     free(out);
 }
 
@@ -875,22 +929,22 @@ test_render_ifcount_bug(void **state)
         "{% endif %}\n"
         "{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *l = blogc_template_parse(str, strlen(str), &err);
+    bc_slist_t *l = blogc_template_parse(str, strlen(str), NULL, &err);
     assert_non_null(l);
     assert_null(err);
     bc_slist_t *s = NULL;
-    s = bc_slist_append(s, bc_trie_new(free));
-    bc_trie_insert(s->data, "TITLE", bc_strdup("bola"));
-    bc_trie_t *c = bc_trie_new(free);
+    s = bc_slist_append(s, bc_hashmap_new(free));
+    bc_hashmap_insert(s->data, "TITLE", bc_strdup("bola"));
+    bc_hashmap_t *c = bc_hashmap_new(free);
     char *out = blogc_render(l, s, c, false);
     assert_string_equal(out,
         "\n"
         "<h3>bola</h3>\n"
         "\n"
         "\n");
-    bc_trie_free(c);
+    bc_hashmap_free(c);
     blogc_template_free_ast(l);
-    bc_slist_free_full(s, (bc_free_func_t) bc_trie_free);
+    bc_slist_free_full(s, (bc_free_func_t) bc_hashmap_free);
     free(out);
 }
 
@@ -898,100 +952,100 @@ test_render_ifcount_bug(void **state)
 static void
 test_get_variable(void **state)
 {
-    bc_trie_t *g = bc_trie_new(free);
-    bc_trie_insert(g, "NAME", bc_strdup("bola"));
-    bc_trie_insert(g, "TITLE", bc_strdup("bola2"));
-    bc_trie_t *l = bc_trie_new(free);
-    bc_trie_insert(l, "NAME", bc_strdup("chunda"));
-    bc_trie_insert(l, "TITLE", bc_strdup("chunda2"));
+    bc_hashmap_t *g = bc_hashmap_new(free);
+    bc_hashmap_insert(g, "NAME", bc_strdup("bola"));
+    bc_hashmap_insert(g, "TITLE", bc_strdup("bola2"));
+    bc_hashmap_t *l = bc_hashmap_new(free);
+    bc_hashmap_insert(l, "NAME", bc_strdup("chunda"));
+    bc_hashmap_insert(l, "TITLE", bc_strdup("chunda2"));
     assert_string_equal(blogc_get_variable("NAME", g, l), "chunda");
     assert_string_equal(blogc_get_variable("TITLE", g, l), "chunda2");
     assert_null(blogc_get_variable("BOLA", g, l));
-    bc_trie_free(g);
-    bc_trie_free(l);
+    bc_hashmap_free(g);
+    bc_hashmap_free(l);
 }
 
 
 static void
 test_get_variable_only_local(void **state)
 {
-    bc_trie_t *g = NULL;
-    bc_trie_t *l = bc_trie_new(free);
-    bc_trie_insert(l, "NAME", bc_strdup("chunda"));
-    bc_trie_insert(l, "TITLE", bc_strdup("chunda2"));
+    bc_hashmap_t *g = NULL;
+    bc_hashmap_t *l = bc_hashmap_new(free);
+    bc_hashmap_insert(l, "NAME", bc_strdup("chunda"));
+    bc_hashmap_insert(l, "TITLE", bc_strdup("chunda2"));
     assert_string_equal(blogc_get_variable("NAME", g, l), "chunda");
     assert_string_equal(blogc_get_variable("TITLE", g, l), "chunda2");
     assert_null(blogc_get_variable("BOLA", g, l));
-    bc_trie_free(l);
+    bc_hashmap_free(l);
 }
 
 
 static void
 test_get_variable_only_global(void **state)
 {
-    bc_trie_t *g = bc_trie_new(free);
-    bc_trie_insert(g, "NAME", bc_strdup("bola"));
-    bc_trie_insert(g, "TITLE", bc_strdup("bola2"));
-    bc_trie_t *l = NULL;
+    bc_hashmap_t *g = bc_hashmap_new(free);
+    bc_hashmap_insert(g, "NAME", bc_strdup("bola"));
+    bc_hashmap_insert(g, "TITLE", bc_strdup("bola2"));
+    bc_hashmap_t *l = NULL;
     assert_string_equal(blogc_get_variable("NAME", g, l), "bola");
     assert_string_equal(blogc_get_variable("TITLE", g, l), "bola2");
     assert_null(blogc_get_variable("BOLA", g, l));
-    bc_trie_free(g);
+    bc_hashmap_free(g);
 }
 
 
 static void
 test_format_date(void **state)
 {
-    bc_trie_t *g = bc_trie_new(free);
-    bc_trie_insert(g, "DATE_FORMAT", bc_strdup("%H -- %M"));
-    bc_trie_t *l = bc_trie_new(free);
-    bc_trie_insert(l, "DATE_FORMAT", bc_strdup("%R"));
+    bc_hashmap_t *g = bc_hashmap_new(free);
+    bc_hashmap_insert(g, "DATE_FORMAT", bc_strdup("%H -- %M"));
+    bc_hashmap_t *l = bc_hashmap_new(free);
+    bc_hashmap_insert(l, "DATE_FORMAT", bc_strdup("%R"));
     char *date = blogc_format_date("2015-01-02 03:04:05", g, l);
     assert_string_equal(date, "03:04");
     free(date);
-    bc_trie_free(g);
-    bc_trie_free(l);
+    bc_hashmap_free(g);
+    bc_hashmap_free(l);
 }
 
 
 static void
 test_format_date_with_global_format(void **state)
 {
-    bc_trie_t *g = bc_trie_new(free);
-    bc_trie_insert(g, "DATE_FORMAT", bc_strdup("%H -- %M"));
-    bc_trie_t *l = bc_trie_new(free);
+    bc_hashmap_t *g = bc_hashmap_new(free);
+    bc_hashmap_insert(g, "DATE_FORMAT", bc_strdup("%H -- %M"));
+    bc_hashmap_t *l = bc_hashmap_new(free);
     char *date = blogc_format_date("2015-01-02 03:04:05", g, l);
     assert_string_equal(date, "03 -- 04");
     free(date);
-    bc_trie_free(g);
-    bc_trie_free(l);
+    bc_hashmap_free(g);
+    bc_hashmap_free(l);
 }
 
 
 static void
 test_format_date_without_format(void **state)
 {
-    bc_trie_t *g = bc_trie_new(free);
-    bc_trie_t *l = bc_trie_new(free);
+    bc_hashmap_t *g = bc_hashmap_new(free);
+    bc_hashmap_t *l = bc_hashmap_new(free);
     char *date = blogc_format_date("2015-01-02 03:04:05", g, l);
     assert_string_equal(date, "2015-01-02 03:04:05");
     free(date);
-    bc_trie_free(g);
-    bc_trie_free(l);
+    bc_hashmap_free(g);
+    bc_hashmap_free(l);
 }
 
 
 static void
 test_format_date_without_date(void **state)
 {
-    bc_trie_t *g = bc_trie_new(free);
-    bc_trie_t *l = bc_trie_new(free);
+    bc_hashmap_t *g = bc_hashmap_new(free);
+    bc_hashmap_t *l = bc_hashmap_new(free);
     char *date = blogc_format_date(NULL, g, l);
     assert_null(date);
     free(date);
-    bc_trie_free(g);
-    bc_trie_free(l);
+    bc_hashmap_free(g);
+    bc_hashmap_free(l);
 }
 
 
@@ -999,13 +1053,13 @@ static void
 test_format_variable(void **state)
 {
     // FIXME: test warnings
-    bc_trie_t *g = bc_trie_new(free);
-    bc_trie_insert(g, "NAME", bc_strdup("bola"));
-    bc_trie_insert(g, "TITLE", bc_strdup("bola2"));
-    bc_trie_t *l = bc_trie_new(free);
-    bc_trie_insert(l, "NAME", bc_strdup("chunda"));
-    bc_trie_insert(l, "TITLE", bc_strdup("chunda2"));
-    bc_trie_insert(l, "SIZE", bc_strdup("1234567890987654321"));
+    bc_hashmap_t *g = bc_hashmap_new(free);
+    bc_hashmap_insert(g, "NAME", bc_strdup("bola"));
+    bc_hashmap_insert(g, "TITLE", bc_strdup("bola2"));
+    bc_hashmap_t *l = bc_hashmap_new(free);
+    bc_hashmap_insert(l, "NAME", bc_strdup("chunda"));
+    bc_hashmap_insert(l, "TITLE", bc_strdup("chunda2"));
+    bc_hashmap_insert(l, "SIZE", bc_strdup("1234567890987654321"));
     char *tmp = blogc_format_variable("NAME", g, l, NULL);
     assert_string_equal(tmp, "chunda");
     free(tmp);
@@ -1023,19 +1077,19 @@ test_format_variable(void **state)
     free(tmp);
     assert_null(blogc_format_variable("SIZE_", g, l, NULL));
     assert_null(blogc_format_variable("BOLA", g, l, NULL));
-    bc_trie_free(g);
-    bc_trie_free(l);
+    bc_hashmap_free(g);
+    bc_hashmap_free(l);
 }
 
 
 static void
 test_format_variable_with_date(void **state)
 {
-    bc_trie_t *g = bc_trie_new(free);
-    bc_trie_insert(g, "DATE", bc_strdup("2010-11-12 13:14:15"));
-    bc_trie_insert(g, "DATE_FORMAT", bc_strdup("%R"));
-    bc_trie_t *l = bc_trie_new(free);
-    bc_trie_insert(l, "DATE", bc_strdup("2011-12-13 14:15:16"));
+    bc_hashmap_t *g = bc_hashmap_new(free);
+    bc_hashmap_insert(g, "DATE", bc_strdup("2010-11-12 13:14:15"));
+    bc_hashmap_insert(g, "DATE_FORMAT", bc_strdup("%R"));
+    bc_hashmap_t *l = bc_hashmap_new(free);
+    bc_hashmap_insert(l, "DATE", bc_strdup("2011-12-13 14:15:16"));
     char *tmp = blogc_format_variable("DATE_FORMATTED", g, l, NULL);
     assert_string_equal(tmp, "14:15");
     free(tmp);
@@ -1045,8 +1099,8 @@ test_format_variable_with_date(void **state)
     tmp = blogc_format_variable("DATE_FORMATTED_10", g, l, NULL);
     assert_string_equal(tmp, "14:15");
     free(tmp);
-    bc_trie_free(g);
-    bc_trie_free(l);
+    bc_hashmap_free(g);
+    bc_hashmap_free(l);
 }
 
 
@@ -1083,31 +1137,31 @@ test_format_variable_foreach_empty(void **state)
 static void
 test_split_list_variable(void **state)
 {
-    bc_trie_t *g = bc_trie_new(free);
-    bc_trie_insert(g, "TAGS", bc_strdup("asd  lol hehe"));
-    bc_trie_t *l = bc_trie_new(free);
-    bc_trie_insert(l, "TAGS", bc_strdup("asd  lol XD"));
+    bc_hashmap_t *g = bc_hashmap_new(free);
+    bc_hashmap_insert(g, "TAGS", bc_strdup("asd  lol hehe"));
+    bc_hashmap_t *l = bc_hashmap_new(free);
+    bc_hashmap_insert(l, "TAGS", bc_strdup("asd  lol XD"));
     bc_slist_t *tmp = blogc_split_list_variable("TAGS", g, l);
     assert_string_equal(tmp->data, "asd");
     assert_string_equal(tmp->next->data, "lol");
     assert_string_equal(tmp->next->next->data, "XD");
     bc_slist_free_full(tmp, free);
-    bc_trie_free(g);
-    bc_trie_free(l);
+    bc_hashmap_free(g);
+    bc_hashmap_free(l);
 }
 
 
 static void
 test_split_list_variable_not_found(void **state)
 {
-    bc_trie_t *g = bc_trie_new(free);
-    bc_trie_insert(g, "TAGS", bc_strdup("asd  lol hehe"));
-    bc_trie_t *l = bc_trie_new(free);
-    bc_trie_insert(l, "TAGS", bc_strdup("asd  lol XD"));
+    bc_hashmap_t *g = bc_hashmap_new(free);
+    bc_hashmap_insert(g, "TAGS", bc_strdup("asd  lol hehe"));
+    bc_hashmap_t *l = bc_hashmap_new(free);
+    bc_hashmap_insert(l, "TAGS", bc_strdup("asd  lol XD"));
     bc_slist_t *tmp = blogc_split_list_variable("TAG", g, l);
     assert_null(tmp);
-    bc_trie_free(g);
-    bc_trie_free(l);
+    bc_hashmap_free(g);
+    bc_hashmap_free(l);
 }
 
 
@@ -1117,6 +1171,7 @@ main(void)
     const UnitTest tests[] = {
         unit_test(test_render_entry),
         unit_test(test_render_listing),
+        unit_test(test_render_to_sink),
         unit_test(test_render_listing_empty),
         unit_test(test_render_ifdef),
         unit_test(test_render_ifdef2),
@@ -27,25 +27,25 @@ test_source_parse(void **state)
         "\n"
         "bola\n";
     bc_error_t *err = NULL;
-    bc_trie_t *source = blogc_source_parse(a, strlen(a), &err);
+    bc_hashmap_t *source = blogc_source_parse(a, strlen(a), &err);
     assert_null(err);
     assert_non_null(source);
-    assert_int_equal(bc_trie_size(source), 7);
-    assert_string_equal(bc_trie_lookup(source, "VAR1"), "asd asd");
-    assert_string_equal(bc_trie_lookup(source, "VAR2"), "123chunda");
-    assert_string_equal(bc_trie_lookup(source, "EXCERPT"),
+    assert_int_equal(bc_hashmap_size(source), 7);
+    assert_string_equal(bc_hashmap_lookup(source, "VAR1"), "asd asd");
+    assert_string_equal(bc_hashmap_lookup(source, "VAR2"), "123chunda");
+    assert_string_equal(bc_hashmap_lookup(source, "EXCERPT"),
         "<h1 id=\"this-is-a-test\">This is a test</h1>\n"
         "<p>bola</p>\n");
-    assert_string_equal(bc_trie_lookup(source, "CONTENT"),
+    assert_string_equal(bc_hashmap_lookup(source, "CONTENT"),
         "<h1 id=\"this-is-a-test\">This is a test</h1>\n"
         "<p>bola</p>\n");
-    assert_string_equal(bc_trie_lookup(source, "RAW_CONTENT"),
+    assert_string_equal(bc_hashmap_lookup(source, "RAW_CONTENT"),
         "# This is a test\n"
         "\n"
         "bola\n");
-    assert_string_equal(bc_trie_lookup(source, "FIRST_HEADER"), "This is a test");
-    assert_string_equal(bc_trie_lookup(source, "DESCRIPTION"), "bola");
-    bc_trie_free(source);
+    assert_string_equal(bc_hashmap_lookup(source, "FIRST_HEADER"), "This is a test");
+    assert_string_equal(bc_hashmap_lookup(source, "DESCRIPTION"), "bola");
+    bc_hashmap_free(source);
 }
 
 
@@ -60,25 +60,25 @@ test_source_parse_crlf(void **state)
         "\r\n"
         "bola\r\n";
     bc_error_t *err = NULL;
-    bc_trie_t *source = blogc_source_parse(a, strlen(a), &err);
+    bc_hashmap_t *source = blogc_source_parse(a, strlen(a), &err);
     assert_null(err);
     assert_non_null(source);
-    assert_int_equal(bc_trie_size(source), 7);
-    assert_string_equal(bc_trie_lookup(source, "VAR1"), "asd asd");
-    assert_string_equal(bc_trie_lookup(source, "VAR2"), "123chunda");
-    assert_string_equal(bc_trie_lookup(source, "EXCERPT"),
+    assert_int_equal(bc_hashmap_size(source), 7);
+    assert_string_equal(bc_hashmap_lookup(source, "VAR1"), "asd asd");
+    assert_string_equal(bc_hashmap_lookup(source, "VAR2"), "123chunda");
+    assert_string_equal(bc_hashmap_lookup(source, "EXCERPT"),
         "<h1 id=\"this-is-a-test\">This is a test</h1>\r\n"
         "<p>bola</p>\r\n");
-    assert_string_equal(bc_trie_lookup(source, "CONTENT"),
+    assert_string_equal(bc_hashmap_lookup(source, "CONTENT"),
         "<h1 id=\"this-is-a-test\">This is a test</h1>\r\n"
         "<p>bola</p>\r\n");
-    assert_string_equal(bc_trie_lookup(source, "RAW_CONTENT"),
+    assert_string_equal(bc_hashmap_lookup(source, "RAW_CONTENT"),
         "# This is a test\r\n"
         "\r\n"
         "bola\r\n");
-    assert_string_equal(bc_trie_lookup(source, "FIRST_HEADER"), "This is a test");
-    assert_string_equal(bc_trie_lookup(source, "DESCRIPTION"), "bola");
-    bc_trie_free(source);
+    assert_string_equal(bc_hashmap_lookup(source, "FIRST_HEADER"), "This is a test");
+    assert_string_equal(bc_hashmap_lookup(source, "DESCRIPTION"), "bola");
+    bc_hashmap_free(source);
 }
 
 
@@ -95,25 +95,25 @@ test_source_parse_with_spaces(void **state)
         "\n"
         "bola\n";
     bc_error_t *err = NULL;
-    bc_trie_t *source = blogc_source_parse(a, strlen(a), &err);
+    bc_hashmap_t *source = blogc_source_parse(a, strlen(a), &err);
     assert_null(err);
     assert_non_null(source);
-    assert_int_equal(bc_trie_size(source), 7);
-    assert_string_equal(bc_trie_lookup(source, "VAR1"), "chunda");
-    assert_string_equal(bc_trie_lookup(source, "BOLA"), "guda");
-    assert_string_equal(bc_trie_lookup(source, "EXCERPT"),
+    assert_int_equal(bc_hashmap_size(source), 7);
+    assert_string_equal(bc_hashmap_lookup(source, "VAR1"), "chunda");
+    assert_string_equal(bc_hashmap_lookup(source, "BOLA"), "guda");
+    assert_string_equal(bc_hashmap_lookup(source, "EXCERPT"),
         "<h1 id=\"this-is-a-test\">This is a test</h1>\n"
         "<p>bola</p>\n");
-    assert_string_equal(bc_trie_lookup(source, "CONTENT"),
+    assert_string_equal(bc_hashmap_lookup(source, "CONTENT"),
         "<h1 id=\"this-is-a-test\">This is a test</h1>\n"
         "<p>bola</p>\n");
-    assert_string_equal(bc_trie_lookup(source, "RAW_CONTENT"),
+    assert_string_equal(bc_hashmap_lookup(source, "RAW_CONTENT"),
         "# This is a test\n"
         "\n"
         "bola\n");
-    assert_string_equal(bc_trie_lookup(source, "FIRST_HEADER"), "This is a test");
-    assert_string_equal(bc_trie_lookup(source, "DESCRIPTION"), "bola");
-    bc_trie_free(source);
+    assert_string_equal(bc_hashmap_lookup(source, "FIRST_HEADER"), "This is a test");
+    assert_string_equal(bc_hashmap_lookup(source, "DESCRIPTION"), "bola");
+    bc_hashmap_free(source);
 }
 
 
@@ -133,21 +133,21 @@ test_source_parse_with_excerpt(void **state)
         "guda\n"
         "yay";
     bc_error_t *err = NULL;
-    bc_trie_t *source = blogc_source_parse(a, strlen(a), &err);
+    bc_hashmap_t *source = blogc_source_parse(a, strlen(a), &err);
     assert_null(err);
     assert_non_null(source);
-    assert_int_equal(bc_trie_size(source), 7);
-    assert_string_equal(bc_trie_lookup(source, "VAR1"), "asd asd");
-    assert_string_equal(bc_trie_lookup(source, "VAR2"), "123chunda");
-    assert_string_equal(bc_trie_lookup(source, "EXCERPT"),
+    assert_int_equal(bc_hashmap_size(source), 7);
+    assert_string_equal(bc_hashmap_lookup(source, "VAR1"), "asd asd");
+    assert_string_equal(bc_hashmap_lookup(source, "VAR2"), "123chunda");
+    assert_string_equal(bc_hashmap_lookup(source, "EXCERPT"),
         "<h1 id=\"this-is-a-test\">This is a test</h1>\n"
         "<p>bola</p>\n");
-    assert_string_equal(bc_trie_lookup(source, "CONTENT"),
+    assert_string_equal(bc_hashmap_lookup(source, "CONTENT"),
         "<h1 id=\"this-is-a-test\">This is a test</h1>\n"
         "<p>bola</p>\n"
         "<p>guda\n"
         "yay</p>\n");
-    assert_string_equal(bc_trie_lookup(source, "RAW_CONTENT"),
+    assert_string_equal(bc_hashmap_lookup(source, "RAW_CONTENT"),
         "# This is a test\n"
         "\n"
         "bola\n"
@@ -156,9 +156,9 @@ test_source_parse_with_excerpt(void **state)
         "\n"
         "guda\n"
         "yay");
-    assert_string_equal(bc_trie_lookup(source, "FIRST_HEADER"), "This is a test");
-    assert_string_equal(bc_trie_lookup(source, "DESCRIPTION"), "bola");
-    bc_trie_free(source);
+    assert_string_equal(bc_hashmap_lookup(source, "FIRST_HEADER"), "This is a test");
+    assert_string_equal(bc_hashmap_lookup(source, "DESCRIPTION"), "bola");
+    bc_hashmap_free(source);
 }
 
 
@@ -174,25 +174,25 @@ test_source_parse_with_first_header(void **state)
         "\n"
         "bola\n";
     bc_error_t *err = NULL;
-    bc_trie_t *source = blogc_source_parse(a, strlen(a), &err);
+    bc_hashmap_t *source = blogc_source_parse(a, strlen(a), &err);
     assert_null(err);
     assert_non_null(source);
-    assert_int_equal(bc_trie_size(source), 7);
-    assert_string_equal(bc_trie_lookup(source, "VAR1"), "asd asd");
-    assert_string_equal(bc_trie_lookup(source, "VAR2"), "123chunda");
-    assert_string_equal(bc_trie_lookup(source, "EXCERPT"),
+    assert_int_equal(bc_hashmap_size(source), 7);
+    assert_string_equal(bc_hashmap_lookup(source, "VAR1"), "asd asd");
+    assert_string_equal(bc_hashmap_lookup(source, "VAR2"), "123chunda");
+    assert_string_equal(bc_hashmap_lookup(source, "EXCERPT"),
         "<h1 id=\"this-is-a-test\">This is a test</h1>\n"
         "<p>bola</p>\n");
-    assert_string_equal(bc_trie_lookup(source, "CONTENT"),
+    assert_string_equal(bc_hashmap_lookup(source, "CONTENT"),
         "<h1 id=\"this-is-a-test\">This is a test</h1>\n"
         "<p>bola</p>\n");
-    assert_string_equal(bc_trie_lookup(source, "RAW_CONTENT"),
+    assert_string_equal(bc_hashmap_lookup(source, "RAW_CONTENT"),
         "# This is a test\n"
         "\n"
         "bola\n");
-    assert_string_equal(bc_trie_lookup(source, "FIRST_HEADER"), "THIS IS CHUNDA!");
-    assert_string_equal(bc_trie_lookup(source, "DESCRIPTION"), "bola");
-    bc_trie_free(source);
+    assert_string_equal(bc_hashmap_lookup(source, "FIRST_HEADER"), "THIS IS CHUNDA!");
+    assert_string_equal(bc_hashmap_lookup(source, "DESCRIPTION"), "bola");
+    bc_hashmap_free(source);
 }
 
 
@@ -208,25 +208,25 @@ test_source_parse_with_description(void **state)
         "\n"
         "bola\n";
     bc_error_t *err = NULL;
-    bc_trie_t *source = blogc_source_parse(a, strlen(a), &err);
+    bc_hashmap_t *source = blogc_source_parse(a, strlen(a), &err);
     assert_null(err);
     assert_non_null(source);
-    assert_int_equal(bc_trie_size(source), 7);
-    assert_string_equal(bc_trie_lookup(source, "VAR1"), "asd asd");
-    assert_string_equal(bc_trie_lookup(source, "VAR2"), "123chunda");
-    assert_string_equal(bc_trie_lookup(source, "EXCERPT"),
+    assert_int_equal(bc_hashmap_size(source), 7);
+    assert_string_equal(bc_hashmap_lookup(source, "VAR1"), "asd asd");
+    assert_string_equal(bc_hashmap_lookup(source, "VAR2"), "123chunda");
+    assert_string_equal(bc_hashmap_lookup(source, "EXCERPT"),
         "<h1 id=\"this-is-a-test\">This is a test</h1>\n"
         "<p>bola</p>\n");
-    assert_string_equal(bc_trie_lookup(source, "CONTENT"),
+    assert_string_equal(bc_hashmap_lookup(source, "CONTENT"),
         "<h1 id=\"this-is-a-test\">This is a test</h1>\n"
         "<p>bola</p>\n");
-    assert_string_equal(bc_trie_lookup(source, "RAW_CONTENT"),
+    assert_string_equal(bc_hashmap_lookup(source, "RAW_CONTENT"),
         "# This is a test\n"
         "\n"
         "bola\n");
-    assert_string_equal(bc_trie_lookup(source, "FIRST_HEADER"), "This is a test");
-    assert_string_equal(bc_trie_lookup(source, "DESCRIPTION"), "huehuehuebrbr");
-    bc_trie_free(source);
+    assert_string_equal(bc_hashmap_lookup(source, "FIRST_HEADER"), "This is a test");
+    assert_string_equal(bc_hashmap_lookup(source, "DESCRIPTION"), "huehuehuebrbr");
+    bc_hashmap_free(source);
 }
 
 
@@ -235,13 +235,13 @@ test_source_parse_config_empty(void **state)
 {
     const char *a = "";
     bc_error_t *err = NULL;
-    bc_trie_t *source = blogc_source_parse(a, strlen(a), &err);
+    bc_hashmap_t *source = blogc_source_parse(a, strlen(a), &err);
     assert_null(source);
     assert_non_null(err);
     assert_int_equal(err->type, BLOGC_ERROR_SOURCE_PARSER);
     assert_string_equal(err->msg, "Your source file is empty.");
     bc_error_free(err);
-    bc_trie_free(source);
+    bc_hashmap_free(source);
 }
 
 
@@ -250,14 +250,14 @@ test_source_parse_config_invalid_key(void **state)
 {
     const char *a = "bola: guda";
     bc_error_t *err = NULL;
-    bc_trie_t *source = blogc_source_parse(a, strlen(a), &err);
+    bc_hashmap_t *source = blogc_source_parse(a, strlen(a), &err);
     assert_non_null(err);
     assert_int_equal(err->type, BLOGC_ERROR_SOURCE_PARSER);
     assert_string_equal(err->msg,
         "Can't find a configuration key or the content separator.\n"
         "Error occurred near line 1, position 1: bola: guda");
     bc_error_free(err);
-    bc_trie_free(source);
+    bc_hashmap_free(source);
 }
 
 
@@ -266,14 +266,14 @@ test_source_parse_config_no_key(void **state)
 {
     const char *a = "BOLa";
     bc_error_t *err = NULL;
-    bc_trie_t *source = blogc_source_parse(a, strlen(a), &err);
+    bc_hashmap_t *source = blogc_source_parse(a, strlen(a), &err);
     assert_non_null(err);
     assert_int_equal(err->type, BLOGC_ERROR_SOURCE_PARSER);
     assert_string_equal(err->msg,
         "Invalid configuration key.\n"
         "Error occurred near line 1, position 4: BOLa");
     bc_error_free(err);
-    bc_trie_free(source);
+    bc_hashmap_free(source);
 }
 
 
@@ -282,14 +282,14 @@ test_source_parse_config_no_key2(void **state)
 {
     const char *a = "BOLA";
     bc_error_t *err = NULL;
-    bc_trie_t *source = blogc_source_parse(a, strlen(a), &err);
+    bc_hashmap_t *source = blogc_source_parse(a, strlen(a), &err);
     assert_non_null(err);
     assert_int_equal(err->type, BLOGC_ERROR_SOURCE_PARSER);
     assert_string_equal(err->msg,
         "Your last configuration key is missing ':' and the value\n"
         "Error occurred near line 1, position 5: BOLA");
     bc_error_free(err);
-    bc_trie_free(source);
+    bc_hashmap_free(source);
 }
 
 
@@ -299,11 +299,11 @@ test_source_parse_config_no_value(void **state)
     // this is a special case, not an error
     const char *a = "BOLA:\r\n";
     bc_error_t *err = NULL;
-    bc_trie_t *source = blogc_source_parse(a, strlen(a), &err);
+    bc_hashmap_t *source = blogc_source_parse(a, strlen(a), &err);
     assert_non_null(source);
     assert_null(err);
-    assert_string_equal(bc_trie_lookup(source, "BOLA"), "");
-    bc_trie_free(source);
+    assert_string_equal(bc_hashmap_lookup(source, "BOLA"), "");
+    bc_hashmap_free(source);
 }
 
 
@@ -312,7 +312,7 @@ test_source_parse_config_no_value2(void **state)
 {
     const char *a = "BOLA:";
     bc_error_t *err = NULL;
-    bc_trie_t *source = blogc_source_parse(a, strlen(a), &err);
+    bc_hashmap_t *source = blogc_source_parse(a, strlen(a), &err);
     assert_null(source);
     assert_non_null(err);
     assert_int_equal(err->type, BLOGC_ERROR_SOURCE_PARSER);
@@ -320,7 +320,7 @@ test_source_parse_config_no_value2(void **state)
         "Configuration value not provided for 'BOLA'.\n"
         "Error occurred near line 1, position 6: BOLA:");
     bc_error_free(err);
-    bc_trie_free(source);
+    bc_hashmap_free(source);
 }
 
 
@@ -329,7 +329,7 @@ test_source_parse_config_reserved_name(void **state)
 {
     const char *a = "FILENAME: asd\r\n";
     bc_error_t *err = NULL;
-    bc_trie_t *source = blogc_source_parse(a, strlen(a), &err);
+    bc_hashmap_t *source = blogc_source_parse(a, strlen(a), &err);
     assert_null(source);
     assert_non_null(err);
     assert_int_equal(err->type, BLOGC_ERROR_SOURCE_PARSER);
@@ -337,7 +337,7 @@ test_source_parse_config_reserved_name(void **state)
         "'FILENAME' variable is forbidden in source files. It will be set "
         "for you by the compiler.");
     bc_error_free(err);
-    bc_trie_free(source);
+    bc_hashmap_free(source);
 }
 
 
@@ -346,7 +346,7 @@ test_source_parse_config_reserved_name2(void **state)
 {
     const char *a = "CONTENT: asd\r\n";
     bc_error_t *err = NULL;
-    bc_trie_t *source = blogc_source_parse(a, strlen(a), &err);
+    bc_hashmap_t *source = blogc_source_parse(a, strlen(a), &err);
     assert_null(source);
     assert_non_null(err);
     assert_int_equal(err->type, BLOGC_ERROR_SOURCE_PARSER);
@@ -354,7 +354,7 @@ test_source_parse_config_reserved_name2(void **state)
         "'CONTENT' variable is forbidden in source files. It will be set "
         "for you by the compiler.");
     bc_error_free(err);
-    bc_trie_free(source);
+    bc_hashmap_free(source);
 }
 
 
@@ -363,7 +363,7 @@ test_source_parse_config_reserved_name3(void **state)
 {
     const char *a = "DATE_FORMATTED: asd\r\n";
     bc_error_t *err = NULL;
-    bc_trie_t *source = blogc_source_parse(a, strlen(a), &err);
+    bc_hashmap_t *source = blogc_source_parse(a, strlen(a), &err);
     assert_null(source);
     assert_non_null(err);
     assert_int_equal(err->type, BLOGC_ERROR_SOURCE_PARSER);
@@ -371,7 +371,7 @@ test_source_parse_config_reserved_name3(void **state)
         "'DATE_FORMATTED' variable is forbidden in source files. It will be set "
         "for you by the compiler.");
     bc_error_free(err);
-    bc_trie_free(source);
+    bc_hashmap_free(source);
 }
 
 
@@ -380,7 +380,7 @@ test_source_parse_config_reserved_name4(void **state)
 {
     const char *a = "DATE_FIRST_FORMATTED: asd\r\n";
     bc_error_t *err = NULL;
-    bc_trie_t *source = blogc_source_parse(a, strlen(a), &err);
+    bc_hashmap_t *source = blogc_source_parse(a, strlen(a), &err);
     assert_null(source);
     assert_non_null(err);
     assert_int_equal(err->type, BLOGC_ERROR_SOURCE_PARSER);
@@ -388,7 +388,7 @@ test_source_parse_config_reserved_name4(void **state)
         "'DATE_FIRST_FORMATTED' variable is forbidden in source files. It will be set "
         "for you by the compiler.");
     bc_error_free(err);
-    bc_trie_free(source);
+    bc_hashmap_free(source);
 }
 
 
@@ -397,7 +397,7 @@ test_source_parse_config_reserved_name5(void **state)
 {
     const char *a = "DATE_LAST_FORMATTED: asd\r\n";
     bc_error_t *err = NULL;
-    bc_trie_t *source = blogc_source_parse(a, strlen(a), &err);
+    bc_hashmap_t *source = blogc_source_parse(a, strlen(a), &err);
     assert_null(source);
     assert_non_null(err);
     assert_int_equal(err->type, BLOGC_ERROR_SOURCE_PARSER);
@@ -405,7 +405,7 @@ test_source_parse_config_reserved_name5(void **state)
         "'DATE_LAST_FORMATTED' variable is forbidden in source files. It will be set "
         "for you by the compiler.");
     bc_error_free(err);
-    bc_trie_free(source);
+    bc_hashmap_free(source);
 }
 
 
@@ -414,7 +414,7 @@ test_source_parse_config_reserved_name6(void **state)
 {
     const char *a = "PAGE_FIRST: asd\r\n";
     bc_error_t *err = NULL;
-    bc_trie_t *source = blogc_source_parse(a, strlen(a), &err);
+    bc_hashmap_t *source = blogc_source_parse(a, strlen(a), &err);
     assert_null(source);
     assert_non_null(err);
     assert_int_equal(err->type, BLOGC_ERROR_SOURCE_PARSER);
@@ -422,7 +422,7 @@ test_source_parse_config_reserved_name6(void **state)
         "'PAGE_FIRST' variable is forbidden in source files. It will be set "
         "for you by the compiler.");
     bc_error_free(err);
-    bc_trie_free(source);
+    bc_hashmap_free(source);
 }
 
 
@@ -431,7 +431,7 @@ test_source_parse_config_reserved_name7(void **state)
 {
     const char *a = "PAGE_PREVIOUS: asd\r\n";
     bc_error_t *err = NULL;
-    bc_trie_t *source = blogc_source_parse(a, strlen(a), &err);
+    bc_hashmap_t *source = blogc_source_parse(a, strlen(a), &err);
     assert_null(source);
     assert_non_null(err);
     assert_int_equal(err->type, BLOGC_ERROR_SOURCE_PARSER);
@@ -439,7 +439,7 @@ test_source_parse_config_reserved_name7(void **state)
         "'PAGE_PREVIOUS' variable is forbidden in source files. It will be set "
         "for you by the compiler.");
     bc_error_free(err);
-    bc_trie_free(source);
+    bc_hashmap_free(source);
 }
 
 
@@ -448,7 +448,7 @@ test_source_parse_config_reserved_name8(void **state)
 {
     const char *a = "PAGE_CURRENT: asd\r\n";
     bc_error_t *err = NULL;
-    bc_trie_t *source = blogc_source_parse(a, strlen(a), &err);
+    bc_hashmap_t *source = blogc_source_parse(a, strlen(a), &err);
     assert_null(source);
     assert_non_null(err);
     assert_int_equal(err->type, BLOGC_ERROR_SOURCE_PARSER);
@@ -456,7 +456,7 @@ test_source_parse_config_reserved_name8(void **state)
         "'PAGE_CURRENT' variable is forbidden in source files. It will be set "
         "for you by the compiler.");
     bc_error_free(err);
-    bc_trie_free(source);
+    bc_hashmap_free(source);
 }
 
 
@@ -465,7 +465,7 @@ test_source_parse_config_reserved_name9(void **state)
 {
     const char *a = "PAGE_NEXT: asd\r\n";
     bc_error_t *err = NULL;
-    bc_trie_t *source = blogc_source_parse(a, strlen(a), &err);
+    bc_hashmap_t *source = blogc_source_parse(a, strlen(a), &err);
     assert_null(source);
     assert_non_null(err);
     assert_int_equal(err->type, BLOGC_ERROR_SOURCE_PARSER);
@@ -473,7 +473,7 @@ test_source_parse_config_reserved_name9(void **state)
         "'PAGE_NEXT' variable is forbidden in source files. It will be set "
         "for you by the compiler.");
     bc_error_free(err);
-    bc_trie_free(source);
+    bc_hashmap_free(source);
 }
 
 
@@ -482,7 +482,7 @@ test_source_parse_config_reserved_name10(void **state)
 {
     const char *a = "PAGE_LAST: asd\r\n";
     bc_error_t *err = NULL;
-    bc_trie_t *source = blogc_source_parse(a, strlen(a), &err);
+    bc_hashmap_t *source = blogc_source_parse(a, strlen(a), &err);
     assert_null(source);
     assert_non_null(err);
     assert_int_equal(err->type, BLOGC_ERROR_SOURCE_PARSER);
@@ -490,7 +490,7 @@ test_source_parse_config_reserved_name10(void **state)
         "'PAGE_LAST' variable is forbidden in source files. It will be set "
         "for you by the compiler.");
     bc_error_free(err);
-    bc_trie_free(source);
+    bc_hashmap_free(source);
 }
 
 
@@ -499,7 +499,7 @@ test_source_parse_config_reserved_name11(void **state)
 {
     const char *a = "BLOGC_VERSION: 1.0\r\n";
     bc_error_t *err = NULL;
-    bc_trie_t *source = blogc_source_parse(a, strlen(a), &err);
+    bc_hashmap_t *source = blogc_source_parse(a, strlen(a), &err);
     assert_null(source);
     assert_non_null(err);
     assert_int_equal(err->type, BLOGC_ERROR_SOURCE_PARSER);
@@ -507,7 +507,7 @@ test_source_parse_config_reserved_name11(void **state)
         "'BLOGC_VERSION' variable is forbidden in source files. It will be set "
         "for you by the compiler.");
     bc_error_free(err);
-    bc_trie_free(source);
+    bc_hashmap_free(source);
 }
 
 
@@ -516,7 +516,7 @@ test_source_parse_config_value_no_line_ending(void **state)
 {
     const char *a = "BOLA: asd";
     bc_error_t *err = NULL;
-    bc_trie_t *source = blogc_source_parse(a, strlen(a), &err);
+    bc_hashmap_t *source = blogc_source_parse(a, strlen(a), &err);
     assert_null(source);
     assert_non_null(err);
     assert_int_equal(err->type, BLOGC_ERROR_SOURCE_PARSER);
@@ -524,7 +524,7 @@ test_source_parse_config_value_no_line_ending(void **state)
         "No line ending after the configuration value for 'BOLA'.\n"
         "Error occurred near line 1, position 10: BOLA: asd");
     bc_error_free(err);
-    bc_trie_free(source);
+    bc_hashmap_free(source);
 }
 
 
@@ -533,7 +533,7 @@ test_source_parse_invalid_separator(void **state)
 {
     const char *a = "BOLA: asd\n---#";
     bc_error_t *err = NULL;
-    bc_trie_t *source = blogc_source_parse(a, strlen(a), &err);
+    bc_hashmap_t *source = blogc_source_parse(a, strlen(a), &err);
     assert_null(source);
     assert_non_null(err);
     assert_int_equal(err->type, BLOGC_ERROR_SOURCE_PARSER);
@@ -541,7 +541,7 @@ test_source_parse_invalid_separator(void **state)
         "Invalid content separator. Must be more than one '-' characters.\n"
         "Error occurred near line 2, position 4: ---#");
     bc_error_free(err);
-    bc_trie_free(source);
+    bc_hashmap_free(source);
 }
 
 
@@ -10,6 +10,7 @@
 #include <stddef.h>
 #include <setjmp.h>
 #include <cmocka.h>
+#include <stdlib.h>
 #include <string.h>
 #include "../../src/common/error.h"
 #include "../../src/common/utils.h"
@@ -60,7 +61,7 @@ test_template_parse(void **state)
         "{%- foreach BOLA %}hahaha{% endforeach %}\n"
         "{% if BOLA == \"1\\\"0\" %}aee{% else %}fffuuuuuuu{% endif %}";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_null(err);
     assert_non_null(ast);
     blogc_assert_template_node(ast, "Test",
@@ -144,7 +145,7 @@ test_template_parse_crlf(void **state)
         "{%- foreach BOLA %}hahaha{% endforeach %}\r\n"
         "{% if BOLA == \"1\\\"0\" %}aee{% else %}fffuuuuuuu{% endif %}";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_null(err);
     assert_non_null(ast);
     blogc_assert_template_node(ast, "Test",
@@ -236,7 +237,7 @@ test_template_parse_html(void **state)
         "    </body>\n"
         "</html>\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_null(err);
     assert_non_null(ast);
     blogc_assert_template_node(ast, "<html>\n    <head>\n        ",
@@ -346,7 +347,7 @@ test_template_parse_ifdef_and_var_outside_block(void **state)
         "{{ BOLA }}\n"
         "{% ifndef CHUNDA %}{{ CHUNDA }}{% endif %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_null(err);
     assert_non_null(ast);
     blogc_assert_template_node(ast, "GUDA", BLOGC_TEMPLATE_NODE_IFDEF);
@@ -393,7 +394,7 @@ test_template_parse_nested_else(void **state)
         "{% endif %}\n"
         "{% endif %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_null(err);
     assert_non_null(ast);
     blogc_assert_template_node(ast, "GUDA", BLOGC_TEMPLATE_NODE_IFDEF);
@@ -440,12 +441,165 @@ test_template_parse_nested_else(void **state)
 }
 
 
+static void
+test_template_parse_jump(void **state)
+{
+    const char *a =
+        "{% block entry %}"
+        "{% ifdef GUDA %}"
+        "{% ifdef BOLA %}asd{% else %}qwe{% endif %}"
+        "{% else %}"
+        "{% foreach CHUNDA %}{% ifdef LOL %}zxc{% endif %}{% endforeach %}"
+        "{% endif %}"
+        "{% endblock %}";
+    bc_error_t *err = NULL;
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
+    assert_null(err);
+    assert_non_null(ast);
+    bc_slist_t *block = ast;
+    bc_slist_t *if1 = block->next;
+    bc_slist_t *if2 = if1->next;
+    bc_slist_t *else2 = if2->next->next;
+    bc_slist_t *endif2 = else2->next->next;
+    bc_slist_t *else1 = endif2->next;
+    bc_slist_t *foreach = else1->next;
+    bc_slist_t *if3 = foreach->next;
+    bc_slist_t *endif3 = if3->next->next;
+    bc_slist_t *endforeach = endif3->next;
+    bc_slist_t *endif1 = endforeach->next;
+    bc_slist_t *endblock = endif1->next;
+    blogc_assert_template_node(block, "entry", BLOGC_TEMPLATE_NODE_BLOCK);
+    blogc_assert_template_node(if1, "GUDA", BLOGC_TEMPLATE_NODE_IFDEF);
+    blogc_assert_template_node(if2, "BOLA", BLOGC_TEMPLATE_NODE_IFDEF);
+    blogc_assert_template_node(else2, NULL, BLOGC_TEMPLATE_NODE_ELSE);
+    blogc_assert_template_node(endif2, NULL, BLOGC_TEMPLATE_NODE_ENDIF);
+    blogc_assert_template_node(else1, NULL, BLOGC_TEMPLATE_NODE_ELSE);
+    blogc_assert_template_node(foreach, "CHUNDA", BLOGC_TEMPLATE_NODE_FOREACH);
+    blogc_assert_template_node(if3, "LOL", BLOGC_TEMPLATE_NODE_IFDEF);
+    blogc_assert_template_node(endif3, NULL, BLOGC_TEMPLATE_NODE_ENDIF);
+    blogc_assert_template_node(endforeach, NULL,
+        BLOGC_TEMPLATE_NODE_ENDFOREACH);
+    blogc_assert_template_node(endif1, NULL, BLOGC_TEMPLATE_NODE_ENDIF);
+    blogc_assert_template_node(endblock, NULL, BLOGC_TEMPLATE_NODE_ENDBLOCK);
+    assert_null(endblock->next);
+    assert_true(((blogc_template_node_t*) block->data)->jump == endblock);
+    assert_true(((blogc_template_node_t*) if1->data)->jump == else1);
+    assert_true(((blogc_template_node_t*) if2->data)->jump == else2);
+    assert_true(((blogc_template_node_t*) else2->data)->jump == endif2);
+    assert_true(((blogc_template_node_t*) else1->data)->jump == endif1);
+    assert_true(((blogc_template_node_t*) foreach->data)->jump == endforeach);
+    assert_true(((blogc_template_node_t*) if3->data)->jump == endif3);
+    assert_null(((blogc_template_node_t*) if2->next->data)->jump);
+    assert_null(((blogc_template_node_t*) endif2->data)->jump);
+    assert_null(((blogc_template_node_t*) endblock->data)->jump);
+    blogc_template_free_ast(ast);
+}
+
+
+static void
+test_template_parse_variable(void **state)
+{
+    blogc_template_variable_t var;
+    blogc_template_parse_variable("TITLE", &var, NULL);
+    assert_null(var.key);
+    assert_int_equal(var.len, -1);
+    assert_int_equal(var.formatter, BLOGC_TEMPLATE_FORMATTER_NONE);
+    assert_false(var.foreach_item);
+    blogc_template_parse_variable("TITLE_12", &var, NULL);
+    assert_string_equal(var.key, "TITLE");
+    assert_int_equal(var.len, 12);
+    assert_int_equal(var.formatter, BLOGC_TEMPLATE_FORMATTER_NONE);
+    assert_false(var.foreach_item);
+    free(var.key);
+    blogc_template_parse_variable("TITLE_", &var, NULL);
+    assert_null(var.key);
+    assert_int_equal(var.len, -1);
+    blogc_template_parse_variable("DATE_FORMATTED", &var, NULL);
+    assert_string_equal(var.key, "DATE");
+    assert_int_equal(var.len, -1);
+    assert_int_equal(var.formatter, BLOGC_TEMPLATE_FORMATTER_DATE);
+    assert_false(var.foreach_item);
+    free(var.key);
+    blogc_template_parse_variable("DATE_FORMATTED_5", &var, NULL);
+    assert_string_equal(var.key, "DATE");
+    assert_int_equal(var.len, 5);
+    assert_int_equal(var.formatter, BLOGC_TEMPLATE_FORMATTER_DATE);
+    free(var.key);
+    blogc_template_parse_variable("TITLE_FORMATTED", &var, NULL);
+    assert_string_equal(var.key, "TITLE");
+    assert_int_equal(var.formatter, BLOGC_TEMPLATE_FORMATTER_UNKNOWN);
+    free(var.key);
+    blogc_template_parse_variable("FOREACH_ITEM", &var, NULL);
+    assert_null(var.key);
+    assert_true(var.foreach_item);
+    blogc_template_parse_variable("FOREACH_ITEM_3", &var, NULL);
+    assert_string_equal(var.key, "FOREACH_ITEM");
+    assert_int_equal(var.len, 3);
+    assert_true(var.foreach_item);
+    free(var.key);
+
+    const char *a = "{% ifdef BOLA_2 %}{{ BOLA_2 }}{% endif %}";
+    bc_error_t *err = NULL;
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
+    assert_null(err);
+    assert_non_null(ast);
+    blogc_template_node_t *node = ast->next->data;
+    assert_int_equal(node->type, BLOGC_TEMPLATE_NODE_VARIABLE);
+    assert_string_equal(node->data[0], "BOLA_2");
+    assert_string_equal(node->var.key, "BOLA");
+    assert_int_equal(node->var.len, 2);
+    node = ast->data;
+    assert_null(node->var.key);
+    blogc_template_free_ast(ast);
+}
+
+
+static void
+test_template_parse_arena(void **state)
+{
+    const char *a =
+        "foo {%- ifdef BOLA_2 %}{{ BOLA_2 }}{% else %}"
+        "{% foreach TAGS %}{{ FOREACH_ITEM }}{% endforeach %}{% endif %}\n";
+    bc_error_t *err = NULL;
+    bc_arena_t *arena = bc_arena_new(64);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), arena, &err);
+    assert_null(err);
+    assert_non_null(ast);
+    blogc_assert_template_node(ast, "foo", BLOGC_TEMPLATE_NODE_CONTENT);
+    blogc_assert_template_node(ast->next, "BOLA_2", BLOGC_TEMPLATE_NODE_IFDEF);
+    blogc_assert_template_node(ast->next->next, "BOLA_2",
+        BLOGC_TEMPLATE_NODE_VARIABLE);
+    blogc_template_node_t *node = ast->next->next->data;
+    assert_string_equal(node->var.key, "BOLA");
+    assert_int_equal(node->var.len, 2);
+    bc_slist_t *tmp = ast->next->next->next;
+    blogc_assert_template_node(tmp, NULL, BLOGC_TEMPLATE_NODE_ELSE);
+    assert_true(((blogc_template_node_t*) ast->next->data)->jump == tmp);
+    blogc_assert_template_node(tmp->next, "TAGS", BLOGC_TEMPLATE_NODE_FOREACH);
+    blogc_assert_template_node(tmp->next->next, "FOREACH_ITEM",
+        BLOGC_TEMPLATE_NODE_VARIABLE);
+    blogc_assert_template_node(tmp->next->next->next, NULL,
+        BLOGC_TEMPLATE_NODE_ENDFOREACH);
+    blogc_assert_template_node(tmp->next->next->next->next, NULL,
+        BLOGC_TEMPLATE_NODE_ENDIF);
+    blogc_assert_template_node(tmp->next->next->next->next->next, "\n",
+        BLOGC_TEMPLATE_NODE_CONTENT);
+    assert_null(tmp->next->next->next->next->next->next);
+    ast = blogc_template_parse("{% ifdef BOLA %}{{ BOLA_2 }}", 28, arena, &err);
+    assert_null(ast);
+    assert_non_null(err);
+    assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
+    bc_error_free(err);
+    bc_arena_free(arena);
+}
+
+
 static void
 test_template_parse_invalid_block_start(void **state)
 {
     const char *a = "{% ASD %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -455,7 +609,7 @@ test_template_parse_invalid_block_start(void **state)
     bc_error_free(err);
     a = "{%-- block entry %}\n";
     err = NULL;
-    ast = blogc_template_parse(a, strlen(a), &err);
+    ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -465,7 +619,7 @@ test_template_parse_invalid_block_start(void **state)
     bc_error_free(err);
     a = "{% block entry --%}\n";
     err = NULL;
-    ast = blogc_template_parse(a, strlen(a), &err);
+    ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -483,7 +637,7 @@ test_template_parse_invalid_block_nested(void **state)
         "{% block entry %}\n"
         "{% block listing %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -501,7 +655,7 @@ test_template_parse_invalid_foreach_nested(void **state)
         "{% foreach A %}\n"
         "{% foreach B %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -517,7 +671,7 @@ test_template_parse_invalid_block_not_open(void **state)
 {
     const char *a = "{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -533,7 +687,7 @@ test_template_parse_invalid_endif_not_open(void **state)
 {
     const char *a = "{% block listing %}{% endif %}{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -550,7 +704,7 @@ test_template_parse_invalid_endif_not_open_inside_block(void **state)
 {
     const char *a = "{% ifdef BOLA %}{% block listing %}{% endif %}{% endblock %}";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -567,7 +721,7 @@ test_template_parse_invalid_else_not_open_inside_block(void **state)
 {
     const char *a = "{% ifdef BOLA %}{% block listing %}{% else %}{% endif %}{% endblock %}";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -584,7 +738,7 @@ test_template_parse_invalid_endforeach_not_open(void **state)
 {
     const char *a = "{% endforeach %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -601,7 +755,7 @@ test_template_parse_invalid_endforeach_not_open_inside_block(void **state)
     const char *a = "{% foreach TAGS %}{% block entry %}{% endforeach %}"
         "{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -619,7 +773,7 @@ test_template_parse_invalid_endforeach_not_open_inside_block2(void **state)
     const char *a = "{% block entry %}{% foreach TAGS %}"
         "{% endforeach %}{% endforeach %}{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -637,7 +791,7 @@ test_template_parse_invalid_endforeach_not_closed_inside_block(void **state)
     const char *a = "{% block entry %}{% foreach TAGS %}{% endblock %}"
         "{% endforeach %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -653,7 +807,7 @@ test_template_parse_invalid_endforeach_not_closed_inside_block2(void **state)
     const char *a = "{% block entry %}{% foreach TAGS %}{% endforeach %}"
         "{% foreach TAGS %}{% endblock %}{% endforeach %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -668,7 +822,7 @@ test_template_parse_invalid_block_name(void **state)
 {
     const char *a = "{% chunda %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -685,7 +839,7 @@ test_template_parse_invalid_block_type_start(void **state)
 {
     const char *a = "{% block ENTRY %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -701,7 +855,7 @@ test_template_parse_invalid_block_type(void **state)
 {
     const char *a = "{% block chunda %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -717,7 +871,7 @@ test_template_parse_invalid_ifdef_start(void **state)
 {
     const char *a = "{% block entry %}{% ifdef guda %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -734,7 +888,7 @@ test_template_parse_invalid_foreach_start(void **state)
 {
     const char *a = "{% block entry %}{% foreach guda %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -751,7 +905,7 @@ test_template_parse_invalid_ifdef_variable(void **state)
 {
     const char *a = "{% block entry %}{% ifdef BoLA %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -768,7 +922,7 @@ test_template_parse_invalid_ifdef_variable2(void **state)
 {
     const char *a = "{% block entry %}{% ifdef 0123 %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -785,7 +939,7 @@ test_template_parse_invalid_foreach_variable(void **state)
 {
     const char *a = "{% block entry %}{% foreach BoLA %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -802,7 +956,7 @@ test_template_parse_invalid_foreach_variable2(void **state)
 {
     const char *a = "{% block entry %}{% foreach 0123 %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -819,7 +973,7 @@ test_template_parse_invalid_if_operator(void **state)
 {
     const char *a = "{% block entry %}{% if BOLA = \"asd\" %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -836,7 +990,7 @@ test_template_parse_invalid_if_operand(void **state)
 {
     const char *a = "{% block entry %}{% if BOLA == asd %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -853,7 +1007,7 @@ test_template_parse_invalid_if_operand2(void **state)
 {
     const char *a = "{% block entry %}{% if BOLA == \"asd %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -870,7 +1024,7 @@ test_template_parse_invalid_if_operand3(void **state)
 {
     const char *a = "{% block entry %}{% if BOLA == 0123 %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -887,7 +1041,7 @@ test_template_parse_invalid_else1(void **state)
 {
     const char *a = "{% else %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -903,7 +1057,7 @@ test_template_parse_invalid_else2(void **state)
 {
     const char *a = "{% if BOLA == \"123\" %}{% if GUDA == \"1\" %}{% else %}{% else %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -927,7 +1081,7 @@ test_template_parse_invalid_else3(void **state)
         "{% else %}\n"
         "{% else %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -943,7 +1097,7 @@ test_template_parse_invalid_block_end(void **state)
 {
     const char *a = "{% block entry }}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -959,7 +1113,7 @@ test_template_parse_invalid_variable_name(void **state)
 {
     const char *a = "{% block entry %}{{ bola }}{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -976,7 +1130,7 @@ test_template_parse_invalid_variable_name2(void **state)
 {
     const char *a = "{% block entry %}{{ Bola }}{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -993,7 +1147,7 @@ test_template_parse_invalid_variable_name3(void **state)
 {
     const char *a = "{% block entry %}{{ 0123 }}{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -1010,7 +1164,7 @@ test_template_parse_invalid_variable_end(void **state)
 {
     const char *a = "{% block entry %}{{ BOLA %}{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -1027,7 +1181,7 @@ test_template_parse_invalid_close(void **state)
 {
     const char *a = "{% block entry %%\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -1043,7 +1197,7 @@ test_template_parse_invalid_close2(void **state)
 {
     const char *a = "{% block entry %}{{ BOLA }%{% endblock %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -1060,7 +1214,7 @@ test_template_parse_invalid_endif_not_closed(void **state)
 {
     const char *a = "{% block entry %}{% endblock %}{% ifdef BOLA %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -1075,7 +1229,7 @@ test_template_parse_invalid_endif_not_closed_inside_block(void **state)
 {
     const char *a = "{% block listing %}{% ifdef BOLA %}{% endblock %}{% endif %}";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -1091,7 +1245,7 @@ test_template_parse_invalid_else_not_closed_inside_block(void **state)
 {
     const char *a = "{% block listing %}{% ifdef BOLA %}{% else %}{% endblock %}{% endif %}";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -1107,7 +1261,7 @@ test_template_parse_invalid_block_not_closed(void **state)
 {
     const char *a = "{% block entry %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -1121,7 +1275,7 @@ test_template_parse_invalid_foreach_not_closed(void **state)
 {
     const char *a = "{% foreach ASD %}\n";
     bc_error_t *err = NULL;
-    bc_slist_t *ast = blogc_template_parse(a, strlen(a), &err);
+    bc_slist_t *ast = blogc_template_parse(a, strlen(a), NULL, &err);
     assert_non_null(err);
     assert_null(ast);
     assert_int_equal(err->type, BLOGC_ERROR_TEMPLATE_PARSER);
@@ -1139,6 +1293,9 @@ main(void)
         unit_test(test_template_parse_html),
         unit_test(test_template_parse_ifdef_and_var_outside_block),
         unit_test(test_template_parse_nested_else),
+        unit_test(test_template_parse_jump),
+        unit_test(test_template_parse_variable),
+        unit_test(test_template_parse_arena),
         unit_test(test_template_parse_invalid_block_start),
         unit_test(test_template_parse_invalid_block_nested),
         unit_test(test_template_parse_invalid_foreach_nested),
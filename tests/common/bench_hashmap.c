@@ -0,0 +1,135 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+// micro-benchmark comparing bc_trie_t and bc_hashmap_t, using keys that look
+// like the variables of a typical source file. not run by `make check`, use
+// `make bench-hashmap`.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../../src/common/utils.h"
+
+#define ROUNDS 20000
+#define LOOKUPS 50
+
+static const char *keys[] = {
+    "TITLE", "DATE", "DATE_FORMATTED", "FILENAME", "CONTENT", "RAW_CONTENT",
+    "EXCERPT", "DESCRIPTION", "FIRST_HEADER", "TAGS", "AUTHOR_NAME",
+    "AUTHOR_EMAIL", "SITE_TITLE", "SITE_TAGLINE", "BASE_DOMAIN", "BASE_URL",
+    "DATE_FORMAT", "FILTER_PAGE", "FILTER_PER_PAGE", "FILTER_TAG",
+    "MAKE_SLUG", "MAKE_TYPE", "MAKE_TAG", "MAKE_ENV", "LOCALE", "PAGE_TITLE",
+    "PREVIOUS_PAGE", "NEXT_PAGE", "LAST_PAGE", "CURRENT_PAGE",
+};
+#define NUM_KEYS (sizeof(keys) / sizeof(keys[0]))
+
+
+static double
+now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static void
+count_item(const char *key, void *data, void *user_data)
+{
+    (*(size_t*) user_data)++;
+}
+
+
+static void
+report(const char *name, double trie, double hashmap, size_t ops)
+{
+    printf("%-8s %10.1f ns/op %10.1f ns/op %8.2fx\n", name,
+        trie * 1e9 / ops, hashmap * 1e9 / ops, trie / hashmap);
+}
+
+
+int
+main(int argc, char **argv)
+{
+    size_t found = 0;
+    size_t counted = 0;
+    double t;
+
+    // insert
+    t = now();
+    for (size_t r = 0; r < ROUNDS; r++) {
+        bc_trie_t *trie = bc_trie_new(NULL);
+        for (size_t i = 0; i < NUM_KEYS; i++)
+            bc_trie_insert(trie, keys[i], (void*) keys[i]);
+        bc_trie_free(trie);
+    }
+    double trie_insert = now() - t;
+
+    t = now();
+    for (size_t r = 0; r < ROUNDS; r++) {
+        bc_hashmap_t *map = bc_hashmap_new(NULL);
+        for (size_t i = 0; i < NUM_KEYS; i++)
+            bc_hashmap_insert(map, keys[i], (void*) keys[i]);
+        bc_hashmap_free(map);
+    }
+    double hashmap_insert = now() - t;
+
+    bc_trie_t *trie = bc_trie_new(NULL);
+    bc_hashmap_t *map = bc_hashmap_new(NULL);
+    for (size_t i = 0; i < NUM_KEYS; i++) {
+        bc_trie_insert(trie, keys[i], (void*) keys[i]);
+        bc_hashmap_insert(map, keys[i], (void*) keys[i]);
+    }
+
+    // lookup, hits and misses
+    t = now();
+    for (size_t r = 0; r < ROUNDS * LOOKUPS / NUM_KEYS; r++) {
+        for (size_t i = 0; i < NUM_KEYS; i++) {
+            found += bc_trie_lookup(trie, keys[i]) != NULL;
+            found += bc_trie_lookup(trie, "MISSING_VARIABLE") != NULL;
+        }
+    }
+    double trie_lookup = now() - t;
+
+    t = now();
+    for (size_t r = 0; r < ROUNDS * LOOKUPS / NUM_KEYS; r++) {
+        for (size_t i = 0; i < NUM_KEYS; i++) {
+            found += bc_hashmap_lookup(map, keys[i]) != NULL;
+            found += bc_hashmap_lookup(map, "MISSING_VARIABLE") != NULL;
+        }
+    }
+    double hashmap_lookup = now() - t;
+
+    // foreach
+    t = now();
+    for (size_t r = 0; r < ROUNDS; r++)
+        bc_trie_foreach(trie, count_item, &counted);
+    double trie_foreach = now() - t;
+
+    t = now();
+    for (size_t r = 0; r < ROUNDS; r++)
+        bc_hashmap_foreach(map, count_item, &counted);
+    double hashmap_foreach = now() - t;
+
+    bc_trie_free(trie);
+    bc_hashmap_free(map);
+
+    size_t lookups = 2 * NUM_KEYS * (ROUNDS * LOOKUPS / NUM_KEYS);
+
+    printf("%zu keys, %d rounds\n\n", NUM_KEYS, ROUNDS);
+    printf("%-8s %16s %16s %9s\n", "", "trie", "hashmap", "speedup");
+    report("insert", trie_insert, hashmap_insert, ROUNDS * NUM_KEYS);
+    report("lookup", trie_lookup, hashmap_lookup, lookups);
+    report("foreach", trie_foreach, hashmap_foreach, ROUNDS * NUM_KEYS);
+
+    // keep the compiler from dropping the loops
+    if (found != lookups || counted != 2 * ROUNDS * NUM_KEYS)
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,293 @@
+/*
+ * blogc: A blog compiler.
+ * Copyright (C) 2014-2017 Rafael G. Martins <rafael@rafaelmartins.eng.br>
+ *
+ * This program can be distributed under the terms of the BSD License.
+ * See the file LICENSE.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../../src/common/file.h"
+#include "../../src/common/utils.h"
+
+static bc_string_t *written = NULL;
+
+
+ssize_t
+__wrap_write(int fd, const void *buf, size_t count)
+{
+    assert_int_equal(fd, 42);
+    ssize_t rv = mock_type(ssize_t);
+    if (rv < 0) {
+        errno = mock_type(int);
+        return -1;
+    }
+    if (rv > count)
+        rv = count;
+    bc_string_append_len(written, buf, rv);
+    return rv;
+}
+
+
+static char*
+create_file(const char *content, size_t len)
+{
+    char *path = bc_strdup("/tmp/check_file_XXXXXX");
+    int fd = mkstemp(path);
+    assert_int_not_equal(fd, -1);
+    FILE *fp = fdopen(fd, "w");
+    assert_non_null(fp);
+    assert_int_equal(fwrite(content, sizeof(char), len, fp), len);
+    fclose(fp);
+    return path;
+}
+
+
+static void
+test_file_map(void **state)
+{
+    bc_error_t *err = NULL;
+    char *path = create_file("\xEF\xBB\xBF" "bola\nguda\n", 13);
+    bc_file_map_t *map = bc_file_map(path, true, &err);
+    assert_null(err);
+    assert_non_null(map);
+    assert_non_null(map->map);
+    assert_int_equal(map->map_len, 13);
+    assert_null(map->buffer);
+    assert_int_equal(map->len, 10);
+    assert_memory_equal(map->str, "bola\nguda\n", 10);
+    bc_file_map_free(map);
+
+    // without utf8, BOM is kept
+    map = bc_file_map(path, false, &err);
+    assert_null(err);
+    assert_non_null(map);
+    assert_int_equal(map->len, 13);
+    assert_memory_equal(map->str, "\xEF\xBB\xBF" "bola\nguda\n", 13);
+    bc_file_map_free(map);
+    unlink(path);
+    free(path);
+
+    path = create_file("", 0);
+    map = bc_file_map(path, true, &err);
+    assert_null(err);
+    assert_non_null(map);
+    assert_null(map->map);
+    assert_int_equal(map->len, 0);
+    assert_string_equal(map->str, "");
+    bc_file_map_free(map);
+    unlink(path);
+    free(path);
+
+    bc_file_map_free(NULL);
+    assert_null(bc_file_map(NULL, true, &err));
+    assert_null(err);
+}
+
+
+static void
+test_file_map_not_regular(void **state)
+{
+    bc_error_t *err = NULL;
+    bc_file_map_t *map = bc_file_map("/dev/null", true, &err);
+    assert_null(err);
+    assert_non_null(map);
+    assert_null(map->map);
+    assert_non_null(map->buffer);
+    assert_int_equal(map->len, 0);
+    assert_string_equal(map->str, "");
+    bc_file_map_free(map);
+}
+
+
+static void
+test_file_map_error(void **state)
+{
+    bc_error_t *err = NULL;
+    bc_file_map_t *map = bc_file_map("/tmp/check_file_does_not_exist", true,
+        &err);
+    assert_null(map);
+    assert_non_null(err);
+    assert_int_equal(err->type, BC_ERROR_FILE);
+    assert_string_equal(err->msg, "Failed to open file "
+        "(/tmp/check_file_does_not_exist): No such file or directory");
+    bc_error_free(err);
+    err = NULL;
+
+    char *path = create_file("bola\xff", 5);
+    map = bc_file_map(path, true, &err);
+    assert_null(map);
+    assert_non_null(err);
+    assert_int_equal(err->type, BC_ERROR_FILE);
+    char *msg = bc_strdup_printf("File content is not valid UTF-8: %s", path);
+    assert_string_equal(err->msg, msg);
+    free(msg);
+    bc_error_free(err);
+    err = NULL;
+
+    map = bc_file_map(path, false, &err);
+    assert_null(err);
+    assert_non_null(map);
+    assert_int_equal(map->len, 5);
+    bc_file_map_free(map);
+    unlink(path);
+    free(path);
+}
+
+
+static void
+test_file_read(void **state)
+{
+    bc_error_t *err = NULL;
+    char *path = create_file("\xEF\xBB\xBF" "bola\nguda\n", 13);
+    bc_file_map_t *map = bc_file_read(path, true, &err);
+    assert_null(err);
+    assert_non_null(map);
+    assert_null(map->map);
+    assert_non_null(map->buffer);
+    assert_int_equal(map->len, 10);
+    assert_string_equal(map->str, "bola\nguda\n");
+    bc_file_map_free(map);
+    unlink(path);
+    free(path);
+
+    map = bc_file_read("/tmp/check_file_does_not_exist", true, &err);
+    assert_null(map);
+    assert_non_null(err);
+    assert_int_equal(err->type, BC_ERROR_FILE);
+    bc_error_free(err);
+    err = NULL;
+
+    assert_null(bc_file_read(NULL, true, &err));
+    assert_null(err);
+}
+
+
+static void
+test_file_writer(void **state)
+{
+    written = bc_string_new();
+    bc_file_writer_t *w = bc_file_writer_new(42);
+    assert_non_null(w);
+    assert_int_equal(w->fd, 42);
+    assert_int_equal(w->len, 0);
+    assert_int_equal(w->error, 0);
+
+    // nothing is written until the buffer is full or flushed
+    bc_file_writer_write(w, "bola", 4);
+    bc_file_writer_write(w, "guda", 4);
+    bc_file_writer_write(w, NULL, 4);
+    bc_file_writer_write(w, "", 0);
+    assert_int_equal(w->len, 8);
+    assert_string_equal(written->str, "");
+
+    // partial writes and interruptions are retried
+    will_return(__wrap_write, 3);
+    will_return(__wrap_write, -1);
+    will_return(__wrap_write, EINTR);
+    will_return(__wrap_write, 5);
+    assert_true(bc_file_writer_flush(w));
+    assert_int_equal(w->len, 0);
+    assert_string_equal(written->str, "bolaguda");
+
+    assert_true(bc_file_writer_flush(w));
+    assert_string_equal(written->str, "bolaguda");
+
+    bc_file_writer_write(NULL, "bola", 4);
+    assert_false(bc_file_writer_flush(NULL));
+
+    bc_file_writer_free(w);
+    bc_string_free(written, true);
+    written = NULL;
+}
+
+
+static void
+test_file_writer_big(void **state)
+{
+    written = bc_string_new();
+    bc_file_writer_t *w = bc_file_writer_new(42);
+
+    char *big = bc_malloc(BC_FILE_WRITER_BUFFER_SIZE + 1);
+    memset(big, 'a', BC_FILE_WRITER_BUFFER_SIZE + 1);
+
+    // filling the buffer does not write it
+    bc_file_writer_write(w, big, BC_FILE_WRITER_BUFFER_SIZE - 2);
+    bc_file_writer_write(w, "bo", 2);
+    assert_int_equal(w->len, BC_FILE_WRITER_BUFFER_SIZE);
+    assert_int_equal(written->len, 0);
+
+    // overflowing it does
+    will_return(__wrap_write, BC_FILE_WRITER_BUFFER_SIZE);
+    bc_file_writer_write(w, "la", 2);
+    assert_int_equal(w->len, 2);
+    assert_int_equal(written->len, BC_FILE_WRITER_BUFFER_SIZE);
+    assert_string_equal(written->str + BC_FILE_WRITER_BUFFER_SIZE - 2, "bo");
+
+    // data bigger than the buffer is written right away, after the buffer
+    will_return(__wrap_write, 2);
+    will_return(__wrap_write, BC_FILE_WRITER_BUFFER_SIZE + 1);
+    bc_file_writer_write(w, big, BC_FILE_WRITER_BUFFER_SIZE + 1);
+    assert_int_equal(w->len, 0);
+    assert_int_equal(written->len, 2 * BC_FILE_WRITER_BUFFER_SIZE + 3);
+    assert_int_equal(written->str[BC_FILE_WRITER_BUFFER_SIZE], 'l');
+    assert_int_equal(written->str[BC_FILE_WRITER_BUFFER_SIZE + 1], 'a');
+    assert_int_equal(written->str[BC_FILE_WRITER_BUFFER_SIZE + 2], 'a');
+
+    assert_true(bc_file_writer_flush(w));
+
+    free(big);
+    bc_file_writer_free(w);
+    bc_string_free(written, true);
+    written = NULL;
+}
+
+
+static void
+test_file_writer_error(void **state)
+{
+    written = bc_string_new();
+    bc_file_writer_t *w = bc_file_writer_new(42);
+
+    bc_file_writer_write(w, "bola", 4);
+    will_return(__wrap_write, 2);
+    will_return(__wrap_write, -1);
+    will_return(__wrap_write, ENOSPC);
+    assert_false(bc_file_writer_flush(w));
+    assert_int_equal(w->error, ENOSPC);
+    assert_string_equal(written->str, "bo");
+
+    // after an error, everything is ignored
+    bc_file_writer_write(w, "guda", 4);
+    assert_int_equal(w->len, 0);
+    assert_false(bc_file_writer_flush(w));
+    assert_string_equal(written->str, "bo");
+
+    bc_file_writer_free(w);
+    bc_string_free(written, true);
+    written = NULL;
+}
+
+
+int
+main(void)
+{
+    const UnitTest tests[] = {
+        unit_test(test_file_map),
+        unit_test(test_file_map_not_regular),
+        unit_test(test_file_map_error),
+        unit_test(test_file_read),
+        unit_test(test_file_writer),
+        unit_test(test_file_writer_big),
+        unit_test(test_file_writer_error),
+    };
+    return run_tests(tests);
+}
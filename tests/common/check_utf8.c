@@ -12,6 +12,7 @@
 #include <cmocka.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include "../../src/common/utf8.h"
 #include "../../src/common/utils.h"
@@ -72,6 +73,126 @@ test_utf8_invalid_str(void **state)
 }
 
 
+// straightforward validator, following RFC 3629, used as reference for the
+// differential test below.
+static bool
+reference_validate(const uint8_t *str, size_t len)
+{
+    size_t i = 0;
+    while (i < len) {
+        size_t n;
+        uint32_t cp;
+        uint32_t min;
+        if (str[i] < 0x80) {
+            i++;
+            continue;
+        }
+        else if ((str[i] & 0xe0) == 0xc0) {
+            n = 1;
+            cp = str[i] & 0x1f;
+            min = 0x80;
+        }
+        else if ((str[i] & 0xf0) == 0xe0) {
+            n = 2;
+            cp = str[i] & 0x0f;
+            min = 0x800;
+        }
+        else if ((str[i] & 0xf8) == 0xf0) {
+            n = 3;
+            cp = str[i] & 0x07;
+            min = 0x10000;
+        }
+        else {
+            return false;
+        }
+        if (i + n >= len)
+            return false;
+        for (size_t j = 1; j <= n; j++) {
+            if ((str[i + j] & 0xc0) != 0x80)
+                return false;
+            cp = (cp << 6) | (str[i + j] & 0x3f);
+        }
+        if (cp < min || cp > 0x10ffff || (cp >= 0xd800 && cp <= 0xdfff))
+            return false;
+        i += n + 1;
+    }
+    return true;
+}
+
+
+static size_t
+append_codepoint(uint8_t *buf, uint32_t cp)
+{
+    if (cp < 0x80) {
+        buf[0] = cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        buf[0] = 0xc0 | (cp >> 6);
+        buf[1] = 0x80 | (cp & 0x3f);
+        return 2;
+    }
+    if (cp < 0x10000) {
+        buf[0] = 0xe0 | (cp >> 12);
+        buf[1] = 0x80 | ((cp >> 6) & 0x3f);
+        buf[2] = 0x80 | (cp & 0x3f);
+        return 3;
+    }
+    buf[0] = 0xf0 | (cp >> 18);
+    buf[1] = 0x80 | ((cp >> 12) & 0x3f);
+    buf[2] = 0x80 | ((cp >> 6) & 0x3f);
+    buf[3] = 0x80 | (cp & 0x3f);
+    return 4;
+}
+
+
+static void
+test_utf8_validate_random(void **state)
+{
+    // mostly ASCII runs of varying lengths, to exercise the block fast path,
+    // mixed with valid sequences, broken sequences and random bytes.
+    uint8_t buf[512];
+    srand(42);
+    for (size_t iter = 0; iter < 20000; iter++) {
+        size_t len = 0;
+        while (len < sizeof(buf) - 80) {
+            int kind = rand() % 10;
+            if (kind < 4) {
+                size_t run = rand() % 70;
+                for (size_t i = 0; i < run; i++)
+                    buf[len++] = rand() % 0x80;
+            }
+            else if (kind < 7) {
+                uint32_t cp = rand() % 0x110000;
+                if (cp >= 0xd800 && cp <= 0xdfff)
+                    cp = 0x20ac;
+                len += append_codepoint(buf + len, cp);
+            }
+            else if (kind < 8) {
+                // truncated sequence
+                uint8_t tmp[4];
+                size_t n = append_codepoint(tmp, 0x80 + rand() % 0x10ff80);
+                size_t m = rand() % n;
+                memcpy(buf + len, tmp, m);
+                len += m;
+            }
+            else if (kind < 9) {
+                buf[len++] = 0x80 + rand() % 0x80;
+            }
+            else {
+                break;
+            }
+            if (iter % 2 == 0 && rand() % 4 == 0)
+                break;  // keep some buffers short
+        }
+        for (size_t off = 0; off < 4 && off <= len; off++) {
+            assert_int_equal(bc_utf8_validate(buf + off, len - off),
+                reference_validate(buf + off, len - off));
+        }
+    }
+}
+
+
 static void
 test_utf8_skip_bom(void **state)
 {
@@ -95,6 +216,7 @@ main(void)
         unit_test(test_utf8_invalid),
         unit_test(test_utf8_valid_str),
         unit_test(test_utf8_invalid_str),
+        unit_test(test_utf8_validate_random),
         unit_test(test_utf8_skip_bom),
     };
     return run_tests(tests);
@@ -307,6 +307,31 @@ test_string_new(void **state)
 }
 
 
+static void
+test_string_new_sized(void **state)
+{
+    bc_string_t *str = bc_string_new_sized(0);
+    assert_non_null(str);
+    assert_string_equal(str->str, "");
+    assert_int_equal(str->len, 0);
+    assert_int_equal(str->allocated_len, BC_STRING_CHUNK_SIZE);
+    assert_null(bc_string_free(str, true));
+    str = bc_string_new_sized(BC_STRING_CHUNK_SIZE);
+    assert_non_null(str);
+    assert_string_equal(str->str, "");
+    assert_int_equal(str->len, 0);
+    assert_int_equal(str->allocated_len, BC_STRING_CHUNK_SIZE * 2);
+    for (int i = 0; i < BC_STRING_CHUNK_SIZE; i++)
+        str = bc_string_append_c(str, 'c');
+    assert_int_equal(str->len, BC_STRING_CHUNK_SIZE);
+    assert_int_equal(str->allocated_len, BC_STRING_CHUNK_SIZE * 2);
+    assert_null(bc_string_free(str, true));
+    str = bc_string_new_sized(1000);
+    assert_int_equal(str->allocated_len, BC_STRING_CHUNK_SIZE * 8);
+    assert_null(bc_string_free(str, true));
+}
+
+
 static void
 test_string_free(void **state)
 {
@@ -519,7 +544,7 @@ test_string_append_c(void **state)
         "ccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc"
         "cccccccccccccccccccccccccccccccccccccccccccccccccccc");
     assert_int_equal(str->len, 604);
-    assert_int_equal(str->allocated_len, BC_STRING_CHUNK_SIZE * 5);
+    assert_int_equal(str->allocated_len, BC_STRING_CHUNK_SIZE * 8);
     assert_null(bc_string_free(str, true));
     assert_null(bc_string_append_c(NULL, 0));
 }
@@ -988,6 +1013,283 @@ test_trie_inserted_after_prefix(void **state)
 }
 
 
+static void
+test_hashmap_new(void **state)
+{
+    bc_hashmap_t *map = bc_hashmap_new(free);
+    assert_non_null(map);
+    assert_null(map->entries);
+    assert_null(map->buckets);
+    assert_int_equal(map->len, 0);
+    assert_int_equal(map->num_buckets, 0);
+    assert_true(map->free_func == free);
+    bc_hashmap_free(map);
+}
+
+
+static void
+test_hashmap_insert(void **state)
+{
+    bc_hashmap_t *map = bc_hashmap_new(free);
+
+    bc_hashmap_insert(map, "bola", bc_strdup("guda"));
+    assert_int_equal(map->len, 1);
+    assert_int_equal(map->num_buckets, 16);
+    assert_string_equal(map->entries[0].key, "bola");
+    assert_string_equal(map->entries[0].data, "guda");
+    assert_int_equal(map->entries[0].hash, bc_hashmap_hash("bola"));
+    assert_int_equal(map->buckets[bc_hashmap_hash("bola") & 15], 1);
+
+    bc_hashmap_insert(map, "chu", bc_strdup("nda"));
+    bc_hashmap_insert(map, "bola", bc_strdup("asdf"));
+    bc_hashmap_insert(map, "bo", NULL);
+    assert_int_equal(map->len, 2);
+    assert_string_equal(map->entries[0].key, "bola");
+    assert_string_equal(map->entries[0].data, "asdf");
+    assert_string_equal(map->entries[1].key, "chu");
+    assert_string_equal(map->entries[1].data, "nda");
+
+    bc_hashmap_free(map);
+
+    map = NULL;
+    bc_hashmap_insert(map, "bola", NULL);
+    assert_null(map);
+}
+
+
+static void
+test_hashmap_insert_resize(void **state)
+{
+    bc_hashmap_t *map = bc_hashmap_new(free);
+
+    for (size_t i = 0; i < 1000; i++) {
+        char *key = bc_strdup_printf("KEY_%zu", i);
+        bc_hashmap_insert(map, key, bc_strdup_printf("%zu", i));
+        free(key);
+    }
+    assert_int_equal(bc_hashmap_size(map), 1000);
+    assert_int_equal(map->num_buckets, 2048);
+
+    for (size_t i = 0; i < 1000; i++) {
+        char *key = bc_strdup_printf("KEY_%zu", i);
+        char *value = bc_strdup_printf("%zu", i);
+        assert_string_equal(bc_hashmap_lookup(map, key), value);
+        assert_string_equal(map->entries[i].key, key);
+        free(key);
+        free(value);
+    }
+    assert_null(bc_hashmap_lookup(map, "KEY_1000"));
+
+    bc_hashmap_free(map);
+}
+
+
+static void
+test_hashmap_keep_data(void **state)
+{
+    bc_hashmap_t *map = bc_hashmap_new(NULL);
+
+    char *t1 = "guda";
+    char *t2 = "nda";
+
+    bc_hashmap_insert(map, "bola", t1);
+    bc_hashmap_insert(map, "chu", t2);
+    bc_hashmap_insert(map, "bola", t2);
+
+    bc_hashmap_free(map);
+
+    assert_string_equal(t1, "guda");
+    assert_string_equal(t2, "nda");
+}
+
+
+static void
+test_hashmap_lookup(void **state)
+{
+    bc_hashmap_t *map = bc_hashmap_new(free);
+
+    assert_null(bc_hashmap_lookup(map, "bola"));
+
+    bc_hashmap_insert(map, "chu", bc_strdup("nda"));
+    bc_hashmap_insert(map, "bola", bc_strdup("guda"));
+    bc_hashmap_insert(map, "bote", bc_strdup("aba"));
+    bc_hashmap_insert(map, "bo", bc_strdup("haha"));
+    bc_hashmap_insert(map, "copa", bc_strdup("bu"));
+    bc_hashmap_insert(map, "b", bc_strdup("c"));
+    bc_hashmap_insert(map, "", bc_strdup("empty"));
+
+    assert_string_equal(bc_hashmap_lookup(map, "bola"), "guda");
+    assert_string_equal(bc_hashmap_lookup(map, "chu"), "nda");
+    assert_string_equal(bc_hashmap_lookup(map, "bote"), "aba");
+    assert_string_equal(bc_hashmap_lookup(map, "bo"), "haha");
+    assert_string_equal(bc_hashmap_lookup(map, "copa"), "bu");
+    assert_string_equal(bc_hashmap_lookup(map, "b"), "c");
+    assert_string_equal(bc_hashmap_lookup(map, ""), "empty");
+
+    assert_null(bc_hashmap_lookup(map, "arcoiro"));
+    assert_null(bc_hashmap_lookup(map, "bol"));
+    assert_null(bc_hashmap_lookup(map, NULL));
+
+    bc_hashmap_free(map);
+
+    assert_null(bc_hashmap_lookup(NULL, "bola"));
+}
+
+
+static void
+test_hashmap_size(void **state)
+{
+    bc_hashmap_t *map = bc_hashmap_new(free);
+
+    assert_int_equal(bc_hashmap_size(map), 0);
+
+    bc_hashmap_insert(map, "bola", bc_strdup("guda"));
+    bc_hashmap_insert(map, "chu", bc_strdup("nda"));
+    bc_hashmap_insert(map, "bote", bc_strdup("aba"));
+    bc_hashmap_insert(map, "bo", bc_strdup("haha"));
+    bc_hashmap_insert(map, "bo", bc_strdup("hehe"));
+
+    assert_int_equal(bc_hashmap_size(map), 4);
+    assert_int_equal(bc_hashmap_size(NULL), 0);
+
+    bc_hashmap_free(map);
+}
+
+
+static char *expected_hashmap_keys[] = {"chu", "bola", "bote", "bo", "copa", "b",
+    "test", "testa"};
+static char *expected_hashmap_datas[] = {"nda", "guda", "aba", "hehe", "bu", "c",
+    "asd", "lol"};
+
+static void
+mock_hashmap_foreach(const char *key, void *data, void *user_data)
+{
+    assert_string_equal(user_data, "foo");
+    assert_string_equal(key, expected_hashmap_keys[counter]);
+    assert_string_equal((char*) data, expected_hashmap_datas[counter++]);
+}
+
+
+static void
+test_hashmap_foreach(void **state)
+{
+    bc_hashmap_t *map = bc_hashmap_new(free);
+
+    bc_hashmap_insert(map, "chu", bc_strdup("nda"));
+    bc_hashmap_insert(map, "bola", bc_strdup("guda"));
+    bc_hashmap_insert(map, "bote", bc_strdup("aba"));
+    bc_hashmap_insert(map, "bo", bc_strdup("haha"));
+    bc_hashmap_insert(map, "copa", bc_strdup("bu"));
+    bc_hashmap_insert(map, "b", bc_strdup("c"));
+    bc_hashmap_insert(map, "test", bc_strdup("asd"));
+    bc_hashmap_insert(map, "testa", bc_strdup("lol"));
+    bc_hashmap_insert(map, "bo", bc_strdup("hehe"));
+
+    // insertion order
+    counter = 0;
+    bc_hashmap_foreach(map, mock_hashmap_foreach, "foo");
+    bc_hashmap_foreach(NULL, mock_hashmap_foreach, "foo");
+    bc_hashmap_foreach(map, NULL, "foo");
+    bc_hashmap_foreach(NULL, NULL, "foo");
+    assert_int_equal(counter, 8);
+
+    bc_hashmap_free(map);
+}
+
+
+static void
+test_arena_alloc(void **state)
+{
+    bc_arena_t *arena = bc_arena_new(256);
+    assert_non_null(arena);
+    assert_null(arena->blocks);
+    assert_int_equal(arena->block_size, 256);
+
+    char *a = bc_arena_alloc(arena, 10);
+    assert_non_null(a);
+    assert_non_null(arena->blocks);
+    assert_null(arena->blocks->next);
+    assert_int_equal(arena->blocks->len, 16);
+    assert_int_equal(arena->blocks->allocated_len, 256);
+    char *b = bc_arena_alloc(arena, 16);
+    assert_true(b == a + 16);
+    assert_int_equal(arena->blocks->len, 32);
+
+    // big allocations go to a block of their own, after the current one
+    bc_arena_block_t *current = arena->blocks;
+    char *c = bc_arena_alloc(arena, 1000);
+    assert_non_null(c);
+    assert_true(arena->blocks == current);
+    assert_non_null(arena->blocks->next);
+    assert_int_equal(arena->blocks->next->len, 1008);
+    assert_int_equal(arena->blocks->len, 32);
+
+    // current block is full, start a new one
+    for (size_t i = 0; i < 14; i++)
+        bc_arena_alloc(arena, 16);
+    assert_true(arena->blocks == current);
+    assert_int_equal(arena->blocks->len, 256);
+    bc_arena_alloc(arena, 1);
+    assert_true(arena->blocks->next == current);
+    assert_int_equal(arena->blocks->len, 16);
+
+    bc_arena_free(arena);
+    bc_arena_free(NULL);
+
+    arena = bc_arena_new(0);
+    assert_int_equal(arena->block_size, 4096);
+    bc_arena_free(arena);
+
+    // without an arena, memory comes from the heap
+    a = bc_arena_alloc(NULL, 10);
+    assert_non_null(a);
+    free(a);
+}
+
+
+static void
+test_arena_strdup(void **state)
+{
+    bc_arena_t *arena = bc_arena_new(0);
+    char *str = bc_arena_strdup(arena, "bola");
+    assert_string_equal(str, "bola");
+    str = bc_arena_strndup(arena, "bolaguda", 4);
+    assert_string_equal(str, "bola");
+    str = bc_arena_strndup(arena, "bola", 10);
+    assert_string_equal(str, "bola");
+    str = bc_arena_strdup(arena, "");
+    assert_string_equal(str, "");
+    assert_null(bc_arena_strdup(arena, NULL));
+    assert_null(bc_arena_strndup(arena, NULL, 10));
+    bc_arena_free(arena);
+    str = bc_arena_strndup(NULL, "bolaguda", 4);
+    assert_string_equal(str, "bola");
+    free(str);
+}
+
+
+static void
+test_arena_slist_append(void **state)
+{
+    bc_arena_t *arena = bc_arena_new(0);
+    bc_slist_t *l = NULL;
+    l = bc_arena_slist_append(arena, l, bc_arena_strdup(arena, "bola"));
+    assert_non_null(l);
+    assert_string_equal(l->data, "bola");
+    assert_null(l->next);
+    l = bc_arena_slist_append(arena, l, bc_arena_strdup(arena, "guda"));
+    assert_non_null(l);
+    assert_string_equal(l->data, "bola");
+    assert_string_equal(l->next->data, "guda");
+    assert_null(l->next->next);
+    assert_int_equal(bc_slist_length(l), 2);
+    bc_arena_free(arena);
+    l = bc_arena_slist_append(NULL, NULL, bc_strdup("bola"));
+    assert_string_equal(l->data, "bola");
+    bc_slist_free_full(l, free);
+}
+
+
 static void
 test_shell_quote(void **state)
 {
@@ -1044,6 +1346,7 @@ main(void)
 
         // string
         unit_test(test_string_new),
+        unit_test(test_string_new_sized),
         unit_test(test_string_free),
         unit_test(test_string_dup),
         unit_test(test_string_append_len),
@@ -1062,6 +1365,20 @@ main(void)
         unit_test(test_trie_foreach),
         unit_test(test_trie_inserted_after_prefix),
 
+        // hashmap
+        unit_test(test_hashmap_new),
+        unit_test(test_hashmap_insert),
+        unit_test(test_hashmap_insert_resize),
+        unit_test(test_hashmap_keep_data),
+        unit_test(test_hashmap_lookup),
+        unit_test(test_hashmap_size),
+        unit_test(test_hashmap_foreach),
+
+        // arena
+        unit_test(test_arena_alloc),
+        unit_test(test_arena_strdup),
+        unit_test(test_arena_slist_append),
+
         // shell
         unit_test(test_shell_quote),
     };